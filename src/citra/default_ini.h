@@ -91,6 +91,26 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether to run each emulated CPU core on its own host thread (requires the JIT).
+# Guest timing is only synchronized at slice boundaries in this mode, so it is not deterministic.
+# 0 (default): Off, 1: On
+parallel_cpu_cores =
+
+# Whether the JIT should access guest memory through a host memory mapping (requires the JIT).
+# Only supported on Linux hosts with 4KiB pages, other hosts silently use the regular path.
+# 0 (default): Off, 1: On
+use_cpu_fastmem =
+
+# Whether to remember which code the JIT compiled and compile it again when the title next boots.
+# Reduces stuttering early in a session at the cost of a longer startup (requires the JIT).
+# 0 (default): Off, 1: On
+use_disk_jit_cache =
+
+# Whether to skip ahead to the next event when a thread keeps polling the kernel without progress.
+# Saves host CPU time in busy-wait loops, but may change timing-sensitive behaviour.
+# 0 (default): Off, 1: On
+skip_idle_spin =
+
 # Change the Clock Frequency of the emulated 3DS CPU.
 # Underclocking can increase the performance of the game at the risk of freezing.
 # Overclocking may fix lag that happens on console, but also comes with the risk of freezing.
@@ -118,6 +138,11 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether the shader JIT compiles new shaders on a background thread, running them with the
+# interpreter until they are ready. Avoids stutter when shaders are first used.
+# 0 (default): Off, 1: On
+async_shader_jit =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -136,6 +161,16 @@ resolution_factor =
 # 0: None, 1: Anime4K, 2: Bicubic, 3: Nearest Neighbor, 4: ScaleForce, 5: xBRZ
 texture_filter =
 
+# Whether textures uploaded with identical data at different addresses are copied from a single
+# upload on the GPU instead of being decoded and uploaded again.
+# 0 (default): Off, 1: On
+deduplicate_surfaces =
+
+# Whether the output of display transfers is downloaded from the GPU ahead of time, so that reading
+# it back from the CPU only waits for the download to complete.
+# 0 (default): Off, 1: On
+async_surface_downloads =
+
 # Limits the speed of the game to run no faster than this value as a percentage of target speed.
 # Will not have an effect if unthrottled is enabled.
 # 5 - 995: Speed limit as a percentage of target game speed. 0 for unthrottled. 100 (default)
@@ -358,6 +393,10 @@ gdbstub_port=24689
 # 0 (default): Off, 1: On
 renderer_debug =
 
+# Sample the guest PC periodically and write folded stacks for flamegraphs to the log directory
+# 0 (default): Off, 1: On
+enable_guest_profiler =
+
 # To LLE a service module add "LLE\<module name>=true"
 
 [WebService]
@@ -0,0 +1,342 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#include "audio_core/sink_details.h"
+#include "citra_headless/emu_window_headless.h"
+#include "common/detached_tasks.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "common/settings.h"
+#include "common/string_util.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/applets/default_applets.h"
+#include "core/perf_stats.h"
+#include "core/telemetry_session.h"
+#include "input_common/main.h"
+#include "video_core/gpu.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+
+#include <shellapi.h>
+#endif
+
+namespace {
+
+/// Number of system frames to run when neither a frame count nor a guest time is specified
+constexpr u64 DefaultFrameCount = 600;
+/// Width of a single frametime histogram bucket, in milliseconds
+constexpr double HistogramBucketMs = 1.0;
+/// Number of histogram buckets; slower frames are counted as overflow
+constexpr std::size_t HistogramBuckets = 100;
+
+void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <filename>\n"
+                 "-n, --frames=NUMBER  Run for NUMBER system frames (default 600)\n"
+                 "-t, --time=SECONDS   Run for SECONDS of emulated time\n"
+                 "-o, --output=FILE    Write the JSON report to FILE instead of stdout\n"
+                 "-i, --interpreter    Use the CPU interpreter instead of the JIT\n"
+                 "-h, --help           Display this help and exit\n"
+                 "-v, --version        Output version information and exit\n";
+}
+
+void PrintVersion() {
+    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+nlohmann::json MakeReport(Core::System& system, u64 frames, double wall_seconds,
+                          double guest_seconds) {
+    const auto results = system.GetAndResetPerfStats();
+    std::vector<double> frametimes = system.perf_stats->GetFrametimeHistory();
+
+    std::vector<u64> histogram(HistogramBuckets);
+    u64 overflow = 0;
+    for (const double frametime : frametimes) {
+        const auto bucket = static_cast<std::size_t>(frametime / HistogramBucketMs);
+        if (bucket < HistogramBuckets) {
+            histogram[bucket]++;
+        } else {
+            overflow++;
+        }
+    }
+    while (!histogram.empty() && histogram.back() == 0) {
+        histogram.pop_back();
+    }
+
+    std::sort(frametimes.begin(), frametimes.end());
+
+    nlohmann::json report;
+    report["version"] = fmt::format("{}-{}", Common::g_scm_branch, Common::g_scm_desc);
+    report["cpu_jit"] = Settings::values.use_cpu_jit.GetValue();
+    report["frames"] = frames;
+    report["wall_time_s"] = wall_seconds;
+    report["guest_time_s"] = guest_seconds;
+    report["system_fps"] = results.system_fps;
+    report["game_fps"] = results.game_fps;
+    report["emulation_speed"] = results.emulation_speed * 100.0;
+    report["frametime_ms"] = {
+        {"mean", system.perf_stats->GetMeanFrametime()},
+        {"min", frametimes.empty() ? 0.0 : frametimes.front()},
+        {"max", frametimes.empty() ? 0.0 : frametimes.back()},
+        {"p50", Percentile(frametimes, 0.50)},
+        {"p90", Percentile(frametimes, 0.90)},
+        {"p99", Percentile(frametimes, 0.99)},
+    };
+    report["frametime_histogram"] = {
+        {"bucket_ms", HistogramBucketMs},
+        {"counts", histogram},
+        {"overflow", overflow},
+    };
+    return report;
+}
+
+} // Anonymous namespace
+
+/// Application entry point
+int main(int argc, char** argv) {
+    Common::Log::Initialize();
+    Common::Log::SetColorConsoleBackendEnabled(true);
+    Common::Log::Start();
+    Common::DetachedTasks detached_tasks;
+    int option_index = 0;
+    u64 frame_count = 0;
+    double guest_seconds = 0.0;
+    bool use_interpreter = false;
+    std::string output_path;
+    std::string filepath;
+
+    char* endarg;
+#ifdef _WIN32
+    int argc_w;
+    auto argv_w = CommandLineToArgvW(GetCommandLineW(), &argc_w);
+
+    if (argv_w == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to get command line arguments");
+        return -1;
+    }
+#endif
+
+    static struct option long_options[] = {
+        {"frames", required_argument, 0, 'n'},
+        {"time", required_argument, 0, 't'},
+        {"output", required_argument, 0, 'o'},
+        {"interpreter", no_argument, 0, 'i'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "n:t:o:ihv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'n':
+                errno = 0;
+                frame_count = std::strtoull(optarg, &endarg, 0);
+                if (endarg == optarg || frame_count == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--frames");
+                    exit(1);
+                }
+                break;
+            case 't':
+                errno = 0;
+                guest_seconds = std::strtod(optarg, &endarg);
+                if (endarg == optarg || guest_seconds <= 0.0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--time");
+                    exit(1);
+                }
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'i':
+                use_interpreter = true;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+#ifdef _WIN32
+            filepath = Common::UTF16ToUTF8(argv_w[optind]);
+#else
+            filepath = argv[optind];
+#endif
+            optind++;
+        }
+    }
+
+#ifdef _WIN32
+    LocalFree(argv_w);
+#endif
+
+    MicroProfileOnThreadCreate("EmuThread");
+    SCOPE_EXIT({ MicroProfileShutdown(); });
+
+    if (filepath.empty()) {
+        LOG_CRITICAL(Frontend, "Failed to load ROM: No ROM specified");
+        return -1;
+    }
+
+    if (frame_count == 0 && guest_seconds == 0.0) {
+        frame_count = DefaultFrameCount;
+    }
+
+    // Run as fast as the host allows, without presenting anything or producing audio.
+    Settings::values.graphics_api = Settings::GraphicsAPI::Software;
+    Settings::values.output_type = AudioCore::SinkType::Null;
+    Settings::values.frame_limit = 0;
+    Settings::values.use_cpu_jit = !use_interpreter;
+    Settings::values.use_gdbstub = false;
+
+    auto& system = Core::System::GetInstance();
+    system.ApplySettings();
+
+    // Register frontend applets
+    Frontend::RegisterDefaultApplets(system);
+
+    InputCommon::Init();
+
+    EmuWindow_Headless emu_window;
+
+    LOG_INFO(Frontend, "Citra Version: {} | {}-{}", Common::g_build_fullname, Common::g_scm_branch,
+             Common::g_scm_desc);
+    Settings::LogSettings();
+
+    const Core::System::ResultStatus load_result{system.Load(emu_window, filepath)};
+
+    switch (load_result) {
+    case Core::System::ResultStatus::ErrorGetLoader:
+        LOG_CRITICAL(Frontend, "Failed to obtain loader for {}!", filepath);
+        return -1;
+    case Core::System::ResultStatus::ErrorLoader:
+        LOG_CRITICAL(Frontend, "Failed to load ROM!");
+        return -1;
+    case Core::System::ResultStatus::ErrorLoader_ErrorEncrypted:
+        LOG_CRITICAL(Frontend, "The game that you are trying to load must be decrypted before "
+                               "being used with Citra.");
+        return -1;
+    case Core::System::ResultStatus::ErrorLoader_ErrorInvalidFormat:
+        LOG_CRITICAL(Frontend, "Error while loading ROM: The ROM format is not supported.");
+        return -1;
+    case Core::System::ResultStatus::ErrorNotInitialized:
+        LOG_CRITICAL(Frontend, "CPUCore not initialized");
+        return -1;
+    case Core::System::ResultStatus::ErrorSystemMode:
+        LOG_CRITICAL(Frontend, "Failed to determine system mode!");
+        return -1;
+    case Core::System::ResultStatus::Success:
+        break; // Expected case
+    default:
+        LOG_ERROR(Frontend, "Error while loading ROM: {}", system.GetStatusDetails());
+        break;
+    }
+
+    system.TelemetrySession().AddField(Common::Telemetry::FieldType::App, "Frontend", "Headless");
+
+    std::atomic_bool stop_run;
+    system.GPU().Renderer().Rasterizer()->LoadDiskResources(stop_run, nullptr);
+
+    // Measure from the first emulated frame, so that loading time is not included.
+    const u64 start_frame = system.perf_stats->GetFrameCount();
+    const s64 start_time_us = system.CoreTiming().GetGlobalTimeUs().count();
+    const s64 guest_time_us = static_cast<s64>(guest_seconds * 1000000.0);
+    const auto start_wall = std::chrono::steady_clock::now();
+    (void)system.GetAndResetPerfStats();
+
+    const auto frames_run = [&] {
+        return system.perf_stats->GetFrameCount() - start_frame;
+    };
+    const auto guest_time_run = [&] {
+        return system.CoreTiming().GetGlobalTimeUs().count() - start_time_us;
+    };
+
+    int exit_code = 0;
+    bool running = true;
+    while (running) {
+        if (frame_count != 0 && frames_run() >= frame_count) {
+            break;
+        }
+        if (guest_time_us != 0 && guest_time_run() >= guest_time_us) {
+            break;
+        }
+
+        const auto result = system.RunLoop();
+        switch (result) {
+        case Core::System::ResultStatus::ShutdownRequested:
+            running = false;
+            break;
+        case Core::System::ResultStatus::Success:
+            break;
+        default:
+            LOG_ERROR(Frontend, "Error in main run loop: {}", result, system.GetStatusDetails());
+            running = false;
+            exit_code = -1;
+            break;
+        }
+    }
+
+    const double wall_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_wall).count();
+    const auto report = MakeReport(system, frames_run(), wall_seconds,
+                                   static_cast<double>(guest_time_run()) / 1000000.0);
+
+    if (output_path.empty()) {
+        std::cout << report.dump(4) << std::endl;
+    } else {
+        FileUtil::IOFile file(output_path, "w");
+        if (!file.IsOpen() || file.WriteString(report.dump(4)) == 0) {
+            LOG_CRITICAL(Frontend, "Failed to write report to {}", output_path);
+            exit_code = -1;
+        }
+    }
+
+    InputCommon::Shutdown();
+
+    system.Shutdown();
+
+    detached_tasks.WaitForAllTasks();
+    return exit_code;
+}
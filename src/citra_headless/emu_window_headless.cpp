@@ -0,0 +1,19 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "citra_headless/emu_window_headless.h"
+#include "core/3ds.h"
+
+class DummyContext : public Frontend::GraphicsContext {};
+
+EmuWindow_Headless::EmuWindow_Headless() {
+    UpdateCurrentFramebufferLayout(Core::kScreenTopWidth,
+                                   Core::kScreenTopHeight + Core::kScreenBottomHeight);
+}
+
+EmuWindow_Headless::~EmuWindow_Headless() = default;
+
+std::unique_ptr<Frontend::GraphicsContext> EmuWindow_Headless::CreateSharedContext() const {
+    return std::make_unique<DummyContext>();
+}
@@ -0,0 +1,21 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include "core/frontend/emu_window.h"
+
+/**
+ * Window that presents nothing and polls no input. Used by the headless frontend to drive the
+ * software renderer without any display server.
+ */
+class EmuWindow_Headless : public Frontend::EmuWindow {
+public:
+    EmuWindow_Headless();
+    ~EmuWindow_Headless() override;
+
+    void PollEvents() override {}
+    std::unique_ptr<GraphicsContext> CreateSharedContext() const override;
+};
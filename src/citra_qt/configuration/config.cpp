@@ -457,6 +457,10 @@ void Config::ReadCoreValues() {
 
     if (global) {
         ReadBasicSetting(Settings::values.use_cpu_jit);
+        ReadBasicSetting(Settings::values.parallel_cpu_cores);
+        ReadBasicSetting(Settings::values.use_cpu_fastmem);
+        ReadBasicSetting(Settings::values.use_disk_jit_cache);
+        ReadBasicSetting(Settings::values.skip_idle_spin);
         ReadBasicSetting(Settings::values.delay_start_for_lle_modules);
     }
 
@@ -492,6 +496,7 @@ void Config::ReadDebuggingValues() {
     ReadBasicSetting(Settings::values.gdbstub_port);
     ReadBasicSetting(Settings::values.renderer_debug);
     ReadBasicSetting(Settings::values.dump_command_buffers);
+    ReadBasicSetting(Settings::values.enable_guest_profiler);
 
     qt_config->beginGroup(QStringLiteral("LLE"));
     for (const auto& service_module : Service::service_module_map) {
@@ -663,9 +668,12 @@ void Config::ReadRendererValues() {
 
     ReadGlobalSetting(Settings::values.texture_filter);
     ReadGlobalSetting(Settings::values.texture_sampling);
+    ReadGlobalSetting(Settings::values.deduplicate_surfaces);
+    ReadGlobalSetting(Settings::values.async_surface_downloads);
 
     if (global) {
         ReadBasicSetting(Settings::values.use_shader_jit);
+        ReadBasicSetting(Settings::values.async_shader_jit);
     }
 
     qt_config->endGroup();
@@ -995,6 +1003,10 @@ void Config::SaveCoreValues() {
 
     if (global) {
         WriteBasicSetting(Settings::values.use_cpu_jit);
+        WriteBasicSetting(Settings::values.parallel_cpu_cores);
+        WriteBasicSetting(Settings::values.use_cpu_fastmem);
+        WriteBasicSetting(Settings::values.use_disk_jit_cache);
+        WriteBasicSetting(Settings::values.skip_idle_spin);
         WriteBasicSetting(Settings::values.delay_start_for_lle_modules);
     }
 
@@ -1024,6 +1036,7 @@ void Config::SaveDebuggingValues() {
     WriteBasicSetting(Settings::values.use_gdbstub);
     WriteBasicSetting(Settings::values.gdbstub_port);
     WriteBasicSetting(Settings::values.renderer_debug);
+    WriteBasicSetting(Settings::values.enable_guest_profiler);
 
     qt_config->beginGroup(QStringLiteral("LLE"));
     for (const auto& service_module : Settings::values.lle_modules) {
@@ -1163,10 +1176,13 @@ void Config::SaveRendererValues() {
 
     WriteGlobalSetting(Settings::values.texture_filter);
     WriteGlobalSetting(Settings::values.texture_sampling);
+    WriteGlobalSetting(Settings::values.deduplicate_surfaces);
+    WriteGlobalSetting(Settings::values.async_surface_downloads);
 
     if (global) {
         WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit.GetValue(),
                      true);
+        WriteBasicSetting(Settings::values.async_shader_jit);
     }
 
     qt_config->endGroup();
@@ -120,6 +120,7 @@ void ConfigureGraphics::SetConfiguration() {
 
     if (Settings::IsConfiguringGlobal()) {
         ui->toggle_shader_jit->setChecked(Settings::values.use_shader_jit.GetValue());
+        ui->toggle_async_shader_jit->setChecked(Settings::values.async_shader_jit.GetValue());
     }
 }
 
@@ -147,6 +148,7 @@ void ConfigureGraphics::ApplyConfiguration() {
 
     if (Settings::IsConfiguringGlobal()) {
         Settings::values.use_shader_jit = ui->toggle_shader_jit->isChecked();
+        Settings::values.async_shader_jit = ui->toggle_async_shader_jit->isChecked();
     }
 }
 
@@ -174,6 +176,7 @@ void ConfigureGraphics::SetupPerGameUI() {
     }
 
     ui->toggle_shader_jit->setVisible(false);
+    ui->toggle_async_shader_jit->setVisible(false);
 
     ConfigurationShared::SetColoredComboBox(
         ui->graphics_api_combo, ui->graphics_api_group,
@@ -0,0 +1,129 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "common/assert.h"
+#include "common/error.h"
+#include "common/host_memory.h"
+#include "common/logging/log.h"
+
+namespace Common {
+
+#if defined(__linux__)
+
+namespace {
+
+// Views are mapped at the granularity of emulated pages, so the host page size must match.
+constexpr long REQUIRED_HOST_PAGE_SIZE = 0x1000;
+
+int CreateBackingFile(std::size_t size) {
+#ifdef SYS_memfd_create
+    const int fd = static_cast<int>(syscall(SYS_memfd_create, "HostMemory", 0));
+    if (fd == -1) {
+        LOG_WARNING(Common_Memory, "memfd_create failed: {}", GetLastErrorMsg());
+        return -1;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        LOG_WARNING(Common_Memory, "ftruncate failed: {}", GetLastErrorMsg());
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+} // Anonymous namespace
+
+HostMemory::HostMemory(std::size_t backing_size_, bool mirrorable) : backing_size{backing_size_} {
+    if (mirrorable && sysconf(_SC_PAGESIZE) == REQUIRED_HOST_PAGE_SIZE) {
+        fd = CreateBackingFile(backing_size);
+    }
+    if (fd != -1) {
+        void* const base = mmap(nullptr, backing_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base != MAP_FAILED) {
+            backing_base = static_cast<u8*>(base);
+            return;
+        }
+        LOG_WARNING(Common_Memory, "Failed to map backing memory: {}", GetLastErrorMsg());
+        close(fd);
+        fd = -1;
+    }
+    fallback = std::make_unique<u8[]>(backing_size);
+    backing_base = fallback.get();
+}
+
+HostMemory::~HostMemory() {
+    if (fd == -1) {
+        return;
+    }
+    munmap(backing_base, backing_size);
+    close(fd);
+}
+
+std::unique_ptr<HostMemory::View> HostMemory::CreateView(std::size_t view_size) {
+    if (fd == -1) {
+        return nullptr;
+    }
+    void* const base =
+        mmap(nullptr, view_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        LOG_WARNING(Common_Memory, "Failed to reserve {:#x} bytes: {}", view_size,
+                    GetLastErrorMsg());
+        return nullptr;
+    }
+    return std::unique_ptr<View>(new View(fd, static_cast<u8*>(base), view_size));
+}
+
+HostMemory::View::~View() {
+    munmap(base, size);
+}
+
+void HostMemory::View::Map(std::size_t view_offset, std::size_t backing_offset,
+                           std::size_t length) {
+    ASSERT(view_offset + length <= size);
+    void* const result = mmap(base + view_offset, length, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_FIXED, fd, static_cast<off_t>(backing_offset));
+    ASSERT_MSG(result != MAP_FAILED, "mmap failed: {}", GetLastErrorMsg());
+}
+
+void HostMemory::View::Unmap(std::size_t view_offset, std::size_t length) {
+    ASSERT(view_offset + length <= size);
+    void* const result = mmap(base + view_offset, length, PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    ASSERT_MSG(result != MAP_FAILED, "mmap failed: {}", GetLastErrorMsg());
+}
+
+#else
+
+HostMemory::HostMemory(std::size_t backing_size_, bool)
+    : backing_size{backing_size_}, fallback{std::make_unique<u8[]>(backing_size_)} {
+    backing_base = fallback.get();
+}
+
+HostMemory::~HostMemory() = default;
+
+std::unique_ptr<HostMemory::View> HostMemory::CreateView(std::size_t) {
+    return nullptr;
+}
+
+HostMemory::View::~View() = default;
+
+void HostMemory::View::Map(std::size_t, std::size_t, std::size_t) {
+    UNREACHABLE();
+}
+
+void HostMemory::View::Unmap(std::size_t, std::size_t) {
+    UNREACHABLE();
+}
+
+#endif
+
+} // namespace Common
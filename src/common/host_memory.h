@@ -0,0 +1,89 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A block of host memory that, when supported by the host, can additionally be mapped into any
+ * number of reserved virtual address ranges ("views"). Writes through a view are visible through
+ * the backing pointer and vice versa, which allows laying out an emulated address space so that
+ * the JIT can access guest memory with a single host load or store.
+ */
+class HostMemory {
+public:
+    /**
+     * Allocates the backing memory.
+     * @param backing_size Size of the backing memory in bytes.
+     * @param mirrorable Whether views are requested. If the host does not support them the memory
+     *                   is still allocated, but CreateView will always return nullptr.
+     */
+    explicit HostMemory(std::size_t backing_size, bool mirrorable);
+    ~HostMemory();
+
+    HostMemory(const HostMemory&) = delete;
+    HostMemory& operator=(const HostMemory&) = delete;
+
+    /// Reserved virtual address range into which parts of the backing memory can be mapped.
+    class View {
+    public:
+        ~View();
+
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+
+        /// Returns the base of the reserved range.
+        u8* BasePointer() const noexcept {
+            return base;
+        }
+
+        /// Maps `length` bytes of the backing memory at `backing_offset` to `view_offset`.
+        void Map(std::size_t view_offset, std::size_t backing_offset, std::size_t length);
+
+        /// Makes `length` bytes at `view_offset` inaccessible again.
+        void Unmap(std::size_t view_offset, std::size_t length);
+
+    private:
+        friend class HostMemory;
+        View(int fd_, u8* base_, std::size_t size_) : fd{fd_}, base{base_}, size{size_} {}
+
+        int fd;
+        u8* base;
+        std::size_t size;
+    };
+
+    /// Reserves a view of the given size. Returns nullptr if views are unsupported.
+    std::unique_ptr<View> CreateView(std::size_t view_size);
+
+    u8* BackingBasePointer() noexcept {
+        return backing_base;
+    }
+
+    const u8* BackingBasePointer() const noexcept {
+        return backing_base;
+    }
+
+    /// Returns true if the pointer lies within the backing memory.
+    bool Contains(const u8* pointer) const noexcept {
+        return pointer >= backing_base && pointer < backing_base + backing_size;
+    }
+
+    /// Returns true if views can be created.
+    bool IsMirrorable() const noexcept {
+        return fd != -1;
+    }
+
+private:
+    std::size_t backing_size;
+    u8* backing_base = nullptr;
+    int fd = -1;
+    std::unique_ptr<u8[]> fallback;
+};
+
+} // namespace Common
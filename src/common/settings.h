@@ -430,6 +430,10 @@ struct Values {
 
     // Core
     Setting<bool> use_cpu_jit{true, "use_cpu_jit"};
+    Setting<bool> parallel_cpu_cores{false, "parallel_cpu_cores"};
+    Setting<bool> use_cpu_fastmem{false, "use_cpu_fastmem"};
+    Setting<bool> use_disk_jit_cache{false, "use_disk_jit_cache"};
+    Setting<bool> skip_idle_spin{false, "skip_idle_spin"};
     SwitchableSetting<s32, true> cpu_clock_percentage{100, 5, 400, "cpu_clock_percentage"};
     SwitchableSetting<bool> is_new_3ds{true, "is_new_3ds"};
     SwitchableSetting<bool> lle_applets{false, "lle_applets"};
@@ -474,11 +478,14 @@ struct Values {
     SwitchableSetting<bool> shaders_accurate_mul{true, "shaders_accurate_mul"};
     SwitchableSetting<bool> use_vsync_new{true, "use_vsync_new"};
     Setting<bool> use_shader_jit{true, "use_shader_jit"};
+    Setting<bool> async_shader_jit{false, "async_shader_jit"};
     SwitchableSetting<u32, true> resolution_factor{1, 0, 10, "resolution_factor"};
     SwitchableSetting<u16, true> frame_limit{100, 0, 1000, "frame_limit"};
     SwitchableSetting<TextureFilter> texture_filter{TextureFilter::None, "texture_filter"};
     SwitchableSetting<TextureSampling> texture_sampling{TextureSampling::GameControlled,
                                                         "texture_sampling"};
+    SwitchableSetting<bool> deduplicate_surfaces{false, "deduplicate_surfaces"};
+    SwitchableSetting<bool> async_surface_downloads{false, "async_surface_downloads"};
 
     SwitchableSetting<LayoutOption> layout_option{LayoutOption::Default, "layout_option"};
     SwitchableSetting<bool> swap_screen{false, "swap_screen"};
@@ -537,6 +544,7 @@ struct Values {
     bool record_frame_times;
     std::unordered_map<std::string, bool> lle_modules;
     Setting<bool> delay_start_for_lle_modules{true, "delay_start_for_lle_modules"};
+    Setting<bool> enable_guest_profiler{false, "enable_guest_profiler"};
     Setting<bool> use_gdbstub{false, "use_gdbstub"};
     Setting<u16> gdbstub_port{24689, "gdbstub_port"};
 
@@ -7,6 +7,7 @@
 // a simple lockless thread-safe,
 // single reader, single writer queue
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
@@ -186,4 +187,74 @@ private:
     SPSCQueue<T, with_stop_token> spsc_queue;
     std::mutex write_lock;
 };
+
+// a bounded lock-free and allocation-free,
+// single reader, multiple writer ring
+//
+// Each cell carries a sequence number that tells writers whether it is free for the current lap
+// and the reader whether it has been published. Writing fails instead of blocking when the ring is
+// full, so writers must provide their own fallback.
+
+template <typename T, std::size_t Capacity>
+class LockFreeMPSCQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+public:
+    LockFreeMPSCQueue() {
+        for (std::size_t i = 0; i < Capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename... Args>
+    bool TryEmplace(Args&&... args) {
+        std::size_t pos = write_index.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & (Capacity - 1)];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                // The cell is free for this lap, try to claim it
+                if (write_index.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The reader has not released this cell yet, so the ring is full
+                return false;
+            } else {
+                // Another writer claimed the cell first
+                pos = write_index.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = T{std::forward<Args>(args)...};
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // not thread-safe, must only be called by the reader
+    bool TryPop(T& t) {
+        Cell& cell = cells[read_index & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != read_index + 1) {
+            return false;
+        }
+
+        t = std::move(cell.data);
+        cell.sequence.store(read_index + Capacity, std::memory_order_release);
+        ++read_index;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic_size_t sequence;
+        T data;
+    };
+
+    alignas(128) std::atomic_size_t write_index{0};
+    alignas(128) std::size_t read_index{0};
+    std::array<Cell, Capacity> cells;
+};
 } // namespace Common
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
 #include <boost/serialization/shared_ptr.hpp>
@@ -186,6 +187,20 @@ public:
     /// Prepare core for thread reschedule (if needed to correctly handle state)
     virtual void PrepareReschedule() = 0;
 
+    /**
+     * Asks the core to report its PC and LR to the guest profiler the next time it stops.
+     * Unlike PrepareReschedule, this may be called from any thread.
+     */
+    virtual void RequestProfilerSample() {
+        profiler_sample_requested.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * Asks the core to pick up a downcount lowered by another core while it runs on its own host
+     * thread. May be called from any thread.
+     */
+    virtual void RequestSliceUpdate() {}
+
     Core::Timing::Timer& GetTimer() {
         return *timer;
     }
@@ -198,14 +213,22 @@ public:
         return id;
     }
 
-protected:
-    // This us used for serialization. Returning nullptr is valid if page tables are not used.
+    // This us used for serialization, and to check whether cores share an address space.
+    // Returning nullptr is valid if page tables are not used.
     virtual std::shared_ptr<Memory::PageTable> GetPageTable() const = 0;
 
+protected:
+    /// Returns whether the guest profiler requested a sample, and clears the request
+    bool TakeProfilerSampleRequest() {
+        return profiler_sample_requested.load(std::memory_order_relaxed) &&
+               profiler_sample_requested.exchange(false, std::memory_order_relaxed);
+    }
+
     std::shared_ptr<Core::Timing::Timer> timer;
 
 private:
     u32 id;
+    std::atomic_bool profiler_sample_requested{false};
 
     friend class boost::serialization::access;
 
@@ -3,17 +3,22 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <optional>
 #include <dynarmic/interface/A32/a32.h>
 #include <dynarmic/interface/optimization_flags.h>
 #include "common/assert.h"
 #include "common/microprofile.h"
+#include "common/settings.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
+#include "core/arm/dynarmic/arm_dynarmic_block_cache.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
 #include "core/arm/dynarmic/arm_exclusive_monitor.h"
 #include "core/arm/dynarmic/arm_tick_counts.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/guest_profiler.h"
+#include "core/hle/kernel/process.h"
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
 
@@ -26,41 +31,53 @@ public:
     ~DynarmicUserCallbacks() = default;
 
     std::uint8_t MemoryRead8(VAddr vaddr) override {
+        const auto lock = parent.system.LockCore(parent);
         return memory.Read8(vaddr);
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
+        const auto lock = parent.system.LockCore(parent);
         return memory.Read16(vaddr);
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
+        const auto lock = parent.system.LockCore(parent);
         return memory.Read32(vaddr);
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
+        const auto lock = parent.system.LockCore(parent);
         return memory.Read64(vaddr);
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
+        const auto lock = parent.system.LockCore(parent);
         memory.Write8(vaddr, value);
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
+        const auto lock = parent.system.LockCore(parent);
         memory.Write16(vaddr, value);
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
+        const auto lock = parent.system.LockCore(parent);
         memory.Write32(vaddr, value);
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
+        const auto lock = parent.system.LockCore(parent);
         memory.Write64(vaddr, value);
     }
 
     bool MemoryWriteExclusive8(u32 vaddr, u8 value, u8 expected) override {
+        const auto lock = parent.system.LockCore(parent);
         return memory.WriteExclusive8(vaddr, value, expected);
     }
     bool MemoryWriteExclusive16(u32 vaddr, u16 value, u16 expected) override {
+        const auto lock = parent.system.LockCore(parent);
         return memory.WriteExclusive16(vaddr, value, expected);
     }
     bool MemoryWriteExclusive32(u32 vaddr, u32 value, u32 expected) override {
+        const auto lock = parent.system.LockCore(parent);
         return memory.WriteExclusive32(vaddr, value, expected);
     }
     bool MemoryWriteExclusive64(u32 vaddr, u64 value, u64 expected) override {
+        const auto lock = parent.system.LockCore(parent);
         return memory.WriteExclusive64(vaddr, value, expected);
     }
 
@@ -70,11 +87,28 @@ public:
                         pc, MemoryReadCode(pc).value(), num_instructions);
     }
 
+    std::optional<std::uint32_t> MemoryReadCode(VAddr vaddr) override {
+        // Code is fetched while compiling, without the core lock. Besides guest memory, it only
+        // touches the block cache, which serializes itself against invalidations from other cores.
+        // The JIT only compiles when dispatching to a missing block, so a fetch of the current PC
+        // is the first instruction of a new block.
+        if (parent.block_cache && vaddr == (parent.jit->Regs()[15] & ~3U)) {
+            parent.block_cache->Record({
+                .pc = parent.jit->Regs()[15],
+                .cpsr = parent.jit->Cpsr(),
+                .fpscr = parent.jit->Fpscr(),
+            });
+        }
+        return memory.Read32(vaddr);
+    }
+
     void CallSVC(std::uint32_t swi) override {
+        const auto lock = parent.system.LockCore(parent);
         svc_context.CallSVC(swi);
     }
 
     void ExceptionRaised(VAddr pc, Dynarmic::A32::Exception exception) override {
+        const auto lock = parent.system.LockCore(parent);
         switch (exception) {
         case Dynarmic::A32::Exception::UndefinedInstruction:
         case Dynarmic::A32::Exception::UnpredictableInstruction:
@@ -131,12 +165,32 @@ ARM_Dynarmic::ARM_Dynarmic(Core::System& system_, Memory::MemorySystem& memory_,
 ARM_Dynarmic::~ARM_Dynarmic() = default;
 
 MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
+MICROPROFILE_DEFINE(ARM_Jit_Replay, "ARM JIT", "Replay Block Cache", MP_RGB(255, 128, 64));
 
 void ARM_Dynarmic::Run() {
     ASSERT(memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
-    jit->Run();
+    if (!block_cache_resolved) {
+        ResolveBlockCache();
+    }
+    if (block_cache && block_cache->IsReplayRequested()) {
+        ReplayBlockCache();
+    }
+
+    running_jit.store(jit, std::memory_order_release);
+    while (true) {
+        const auto halt_reason = jit->Run();
+        if (TakeProfilerSampleRequest()) {
+            RecordProfilerSample();
+        }
+        // Resume if the profiler or a slice update was the only reason to stop and the slice
+        // isn't over yet. Resuming reads the ticks left in the slice again.
+        if (halt_reason != Dynarmic::HaltReason::UserDefined3 || timer->GetDowncount() <= 0) {
+            break;
+        }
+    }
+    running_jit.store(nullptr, std::memory_order_release);
 }
 
 void ARM_Dynarmic::Step() {
@@ -253,14 +307,43 @@ void ARM_Dynarmic::PrepareReschedule() {
     }
 }
 
+void ARM_Dynarmic::RequestProfilerSample() {
+    ARM_Interface::RequestProfilerSample();
+    // JITs are kept until the core is destroyed, so a stale pointer is still safe to halt; the
+    // pending halt is then simply consumed the next time that JIT runs.
+    if (auto* running = running_jit.load(std::memory_order_acquire)) {
+        running->HaltExecution(Dynarmic::HaltReason::UserDefined3);
+    }
+}
+
+void ARM_Dynarmic::RequestSliceUpdate() {
+    if (auto* running = running_jit.load(std::memory_order_acquire)) {
+        running->HaltExecution(Dynarmic::HaltReason::UserDefined3);
+    }
+}
+
+void ARM_Dynarmic::RecordProfilerSample() {
+    if (auto* profiler = system.GetGuestProfiler()) {
+        profiler->RecordSample(current_page_table.get(), GetPC(), GetReg(14));
+    }
+}
+
 void ARM_Dynarmic::ClearInstructionCache() {
     for (const auto& j : jits) {
         j.second->ClearCache();
     }
+    for (const auto& [page_table, cache] : block_caches) {
+        if (cache) {
+            cache->InvalidateAll();
+        }
+    }
 }
 
 void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
     jit->InvalidateCacheRange(start_address, length);
+    if (block_cache) {
+        block_cache->Invalidate(start_address, length);
+    }
 }
 
 void ARM_Dynarmic::ClearExclusiveState() {
@@ -273,6 +356,10 @@ std::shared_ptr<Memory::PageTable> ARM_Dynarmic::GetPageTable() const {
 
 void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
     current_page_table = page_table;
+    const auto cache_iter = block_caches.find(current_page_table);
+    block_cache_resolved = cache_iter != block_caches.end();
+    block_cache = block_cache_resolved ? cache_iter->second.get() : nullptr;
+
     ThreadContext ctx{};
     if (jit) {
         SaveContext(ctx);
@@ -298,11 +385,64 @@ void ARM_Dynarmic::ServeBreak() {
     GDBStub::SendTrap(thread, 5);
 }
 
+void ARM_Dynarmic::ResolveBlockCache() {
+    // Other cores look up the block cache when invalidating code ranges from HLE code.
+    const auto lock = system.LockCore(*this);
+    block_cache_resolved = true;
+
+    std::unique_ptr<DynarmicBlockCache> cache;
+    if (Settings::values.use_disk_jit_cache && current_page_table) {
+        for (const auto& process : system.Kernel().GetProcessList()) {
+            if (process->vm_manager.page_table == current_page_table &&
+                process->codeset->program_id != 0) {
+                cache = std::make_unique<DynarmicBlockCache>(
+                    *current_page_table, process->codeset->program_id, GetID());
+                break;
+            }
+        }
+    }
+    block_cache = cache.get();
+    block_caches.emplace(current_page_table, std::move(cache));
+}
+
+void ARM_Dynarmic::ReplayBlockCache() {
+    MICROPROFILE_SCOPE(ARM_Jit_Replay);
+
+    const auto entries = block_cache->TakeReplayableEntries();
+    if (entries.empty()) {
+        return;
+    }
+
+    ThreadContext ctx{};
+    SaveContext(ctx);
+    bool reschedule_requested = false;
+    for (const auto& entry : entries) {
+        jit->Regs()[15] = entry.pc;
+        jit->SetCpsr(entry.cpsr);
+        jit->SetFpscr(entry.fpscr);
+        // Dynarmic looks up, and if needed compiles, the block at the current location before it
+        // checks for a pending halt, so this compiles the block without executing guest code.
+        jit->HaltExecution(Dynarmic::HaltReason::UserDefined2);
+        const auto halt_reason = jit->Run();
+        reschedule_requested |= Dynarmic::Has(halt_reason, Dynarmic::HaltReason::UserDefined1);
+    }
+    LoadContext(ctx);
+    if (reschedule_requested) {
+        jit->HaltExecution();
+    }
+
+    LOG_INFO(Core_ARM11, "Compiled {} cached blocks on core {}", entries.size(), GetID());
+}
+
 std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit() {
     Dynarmic::A32::UserConfig config;
     config.callbacks = cb.get();
     if (current_page_table) {
         config.page_table = &current_page_table->GetPointerArray();
+        if (current_page_table->fastmem_view) {
+            config.fastmem_pointer =
+                reinterpret_cast<uintptr_t>(current_page_table->fastmem_view->BasePointer());
+        }
     }
     config.coprocessors[15] = std::make_shared<DynarmicCP15>(cp15_state);
     config.define_unpredictable_behaviour = true;
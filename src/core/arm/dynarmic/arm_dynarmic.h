@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <dynarmic/interface/A32/a32.h>
@@ -18,6 +19,7 @@ class MemorySystem;
 
 namespace Core {
 
+class DynarmicBlockCache;
 class DynarmicUserCallbacks;
 class DynarmicExclusiveMonitor;
 class ExclusiveMonitor;
@@ -50,6 +52,8 @@ public:
     void LoadContext(const ThreadContext& ctx) override;
 
     void PrepareReschedule() override;
+    void RequestProfilerSample() override;
+    void RequestSliceUpdate() override;
 
     void ClearInstructionCache() override;
     void InvalidateCacheRange(u32 start_address, std::size_t length) override;
@@ -61,6 +65,9 @@ protected:
 
 private:
     void ServeBreak();
+    void ResolveBlockCache();
+    void ReplayBlockCache();
+    void RecordProfilerSample();
 
     friend class DynarmicUserCallbacks;
     Core::System& system;
@@ -73,8 +80,14 @@ private:
     Core::DynarmicExclusiveMonitor& exclusive_monitor;
 
     Dynarmic::A32::Jit* jit = nullptr;
+    /// The JIT executing guest code, if any. Read by the guest profiler from its own thread.
+    std::atomic<Dynarmic::A32::Jit*> running_jit{nullptr};
     std::shared_ptr<Memory::PageTable> current_page_table = nullptr;
     std::map<std::shared_ptr<Memory::PageTable>, std::unique_ptr<Dynarmic::A32::Jit>> jits;
+
+    DynarmicBlockCache* block_cache = nullptr;
+    bool block_cache_resolved = false;
+    std::map<std::shared_ptr<Memory::PageTable>, std::unique_ptr<DynarmicBlockCache>> block_caches;
 };
 
 } // namespace Core
@@ -0,0 +1,187 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/arm/dynarmic/arm_dynarmic_block_cache.h"
+#include "core/memory.h"
+
+namespace Core {
+
+namespace {
+constexpr u32 BlockCacheMagic = 0x4342434A; // "JCBC"
+constexpr u32 BlockCacheVersion = 2;
+} // Anonymous namespace
+
+DynarmicBlockCache::DynarmicBlockCache(Memory::PageTable& page_table_, u64 program_id_,
+                                       u32 core_id_)
+    : page_table{page_table_}, program_id{program_id_}, core_id{core_id_} {
+    Load();
+}
+
+DynarmicBlockCache::~DynarmicBlockCache() {
+    Save();
+}
+
+void DynarmicBlockCache::Record(Entry entry) {
+    // Blocks that only differ in the condition flags or the cumulative exception bits decode the
+    // same way.
+    entry.cpsr &= CpsrDecodeMask;
+    entry.fpscr &= FpscrDecodeMask;
+
+    std::scoped_lock lock{mutex};
+    const u32 page = entry.pc >> Memory::CITRA_PAGE_BITS;
+    auto it = recorded.find(page);
+    if (it == recorded.end()) {
+        const auto hash = HashPage(page);
+        if (!hash) {
+            return;
+        }
+        it = recorded.emplace(page, Page{*hash, {}}).first;
+    }
+
+    auto& entries = it->second.entries;
+    if (std::find(entries.begin(), entries.end(), entry) == entries.end()) {
+        entries.push_back(entry);
+        dirty = true;
+    }
+}
+
+void DynarmicBlockCache::Invalidate(u32 start_address, std::size_t length) {
+    std::scoped_lock lock{mutex};
+    replay_requested = true;
+    const u32 first_page = start_address >> Memory::CITRA_PAGE_BITS;
+    const u32 last_page = static_cast<u32>((start_address + length - 1) >> Memory::CITRA_PAGE_BITS);
+    auto it = recorded.lower_bound(first_page);
+    while (it != recorded.end() && it->first <= last_page) {
+        Revalidate(it++);
+    }
+}
+
+void DynarmicBlockCache::InvalidateAll() {
+    std::scoped_lock lock{mutex};
+    replay_requested = true;
+    for (auto it = recorded.begin(); it != recorded.end();) {
+        Revalidate(it++);
+    }
+}
+
+std::vector<DynarmicBlockCache::Entry> DynarmicBlockCache::TakeReplayableEntries() {
+    std::scoped_lock lock{mutex};
+    replay_requested = false;
+    std::vector<Entry> entries;
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (HashPage(it->first) != it->second.hash) {
+            ++it;
+            continue;
+        }
+        entries.insert(entries.end(), it->second.entries.begin(), it->second.entries.end());
+        it = pending.erase(it);
+    }
+    return entries;
+}
+
+void DynarmicBlockCache::Save() {
+    std::scoped_lock lock{mutex};
+    if (!dirty) {
+        return;
+    }
+    dirty = false;
+
+    // Entries that could not be replayed this session are kept for the next one.
+    auto pages = recorded;
+    pages.insert(pending.begin(), pending.end());
+
+    const std::string path = GetFilePath();
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Core_ARM11, "Failed to create JIT cache directory for {}", path);
+        return;
+    }
+    FileUtil::IOFile file(path, "wb");
+    bool success = file.WriteObject(BlockCacheMagic) == 1 &&
+                   file.WriteObject(BlockCacheVersion) == 1 &&
+                   file.WriteObject(static_cast<u32>(pages.size())) == 1;
+    for (auto it = pages.begin(); success && it != pages.end(); ++it) {
+        const auto& entries = it->second.entries;
+        success = file.WriteObject(it->first) == 1 && file.WriteObject(it->second.hash) == 1 &&
+                  file.WriteObject(static_cast<u32>(entries.size())) == 1 &&
+                  file.WriteArray(entries.data(), entries.size()) == entries.size();
+    }
+    if (!success) {
+        LOG_ERROR(Core_ARM11, "Failed to write JIT cache {}", path);
+        file.Close();
+        FileUtil::Delete(path);
+    }
+}
+
+std::string DynarmicBlockCache::GetFilePath() const {
+    return fmt::format("{}jit" DIR_SEP "{:016X}.core{}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), program_id, core_id);
+}
+
+void DynarmicBlockCache::Load() {
+    const std::string path = GetFilePath();
+    if (!FileUtil::Exists(path)) {
+        return;
+    }
+
+    FileUtil::IOFile file(path, "rb");
+    u32 magic{};
+    u32 version{};
+    u32 num_pages{};
+    if (file.ReadBytes(&magic, sizeof(u32)) != sizeof(u32) || magic != BlockCacheMagic ||
+        file.ReadBytes(&version, sizeof(u32)) != sizeof(u32) || version != BlockCacheVersion ||
+        file.ReadBytes(&num_pages, sizeof(u32)) != sizeof(u32)) {
+        LOG_WARNING(Core_ARM11, "Ignoring incompatible JIT cache {}", path);
+        return;
+    }
+
+    for (u32 i = 0; i < num_pages; ++i) {
+        u32 page{};
+        Page data{};
+        u32 num_entries{};
+        if (file.ReadBytes(&page, sizeof(u32)) != sizeof(u32) ||
+            file.ReadBytes(&data.hash, sizeof(u64)) != sizeof(u64) ||
+            file.ReadBytes(&num_entries, sizeof(u32)) != sizeof(u32) ||
+            num_entries > Memory::CITRA_PAGE_SIZE / 2) {
+            LOG_WARNING(Core_ARM11, "JIT cache {} is corrupted", path);
+            pending.clear();
+            return;
+        }
+        data.entries.resize(num_entries);
+        if (file.ReadArray(data.entries.data(), num_entries) != num_entries) {
+            LOG_WARNING(Core_ARM11, "JIT cache {} is corrupted", path);
+            pending.clear();
+            return;
+        }
+        pending.emplace(page, std::move(data));
+    }
+    replay_requested = true;
+
+    LOG_INFO(Core_ARM11, "Loaded JIT cache for {:016X} with {} code pages", program_id,
+             pending.size());
+}
+
+std::optional<u64> DynarmicBlockCache::HashPage(u32 page) const {
+    const u8* pointer = page_table.GetPointerArray()[page];
+    if (!pointer) {
+        return std::nullopt;
+    }
+    return Common::ComputeHash64(pointer, Memory::CITRA_PAGE_SIZE);
+}
+
+void DynarmicBlockCache::Revalidate(std::map<u32, Page>::iterator it) {
+    const auto hash = HashPage(it->first);
+    if (hash == it->second.hash) {
+        return;
+    }
+    recorded.erase(it);
+    dirty = true;
+}
+
+} // namespace Core
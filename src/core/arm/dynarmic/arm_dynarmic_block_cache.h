@@ -0,0 +1,101 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Memory {
+struct PageTable;
+}
+
+namespace Core {
+
+/**
+ * Persistent record of the blocks a dynarmic instance compiled for one title. On the next boot of
+ * the same title the recorded entry points can be compiled up front, before the guest reaches
+ * them, instead of while the game is running.
+ *
+ * Entries are grouped by guest code page and keyed by a hash of the page contents. An entry is only
+ * replayed when its page still hashes to the recorded value, so stale entries (patched code,
+ * relocated CROs) are skipped rather than compiled.
+ *
+ * Blocks are recorded by the thread of the owning core while it compiles, without holding the core
+ * lock, while HLE code running on any core may invalidate ranges. All accesses to the recorded
+ * entries are serialized by an internal mutex.
+ */
+class DynarmicBlockCache {
+public:
+    /// CPSR bits that select how instructions are decoded: mode, T, E and the IT state.
+    static constexpr u32 CpsrDecodeMask = 0x0600FE3F;
+    /// FPSCR bits that are part of a block's location: AHP, DN, FZ, RMode, Stride and Len.
+    static constexpr u32 FpscrDecodeMask = 0x07F70000;
+
+    /// Location descriptor of a compiled block.
+    struct Entry {
+        u32 pc;
+        u32 cpsr;
+        u32 fpscr;
+
+        auto operator<=>(const Entry&) const = default;
+    };
+
+    DynarmicBlockCache(Memory::PageTable& page_table, u64 program_id, u32 core_id);
+    ~DynarmicBlockCache();
+
+    /// Records a block that the JIT compiled. The CPSR and FPSCR of the entry are masked with
+    /// CpsrDecodeMask and FpscrDecodeMask.
+    void Record(Entry entry);
+
+    /// Drops the recorded entries of pages in the range whose contents changed.
+    void Invalidate(u32 start_address, std::size_t length);
+
+    /// Drops the recorded entries of all pages whose contents changed.
+    void InvalidateAll();
+
+    /// Returns true if loaded entries are waiting to be replayed and guest code may have changed
+    /// since the last attempt.
+    bool IsReplayRequested() const {
+        std::scoped_lock lock{mutex};
+        return replay_requested && !pending.empty();
+    }
+
+    /// Removes and returns the loaded entries whose page currently matches the recorded hash.
+    std::vector<Entry> TakeReplayableEntries();
+
+    /// Writes the recorded entries to disk.
+    void Save();
+
+private:
+    struct Page {
+        u64 hash;
+        std::vector<Entry> entries;
+    };
+
+    std::string GetFilePath() const;
+    void Load();
+
+    /// Returns the hash of the page contents, or nullopt if the page is not backed by memory.
+    std::optional<u64> HashPage(u32 page) const;
+
+    /// Re-hashes a recorded page and drops its entries if the contents changed.
+    void Revalidate(std::map<u32, Page>::iterator it);
+
+    Memory::PageTable& page_table;
+    u64 program_id;
+    u32 core_id;
+    mutable std::mutex mutex;
+    bool dirty = false;
+    bool replay_requested = false;
+
+    std::map<u32, Page> recorded;
+    std::map<u32, Page> pending;
+};
+
+} // namespace Core
@@ -11,6 +11,8 @@
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/guest_profiler.h"
+#include "core/memory.h"
 
 namespace Core {
 
@@ -32,7 +34,7 @@ void ARM_DynCom::Step() {
 }
 
 void ARM_DynCom::ClearInstructionCache() {
-    state->instruction_cache.clear();
+    state->instruction_cache.Clear();
     trans_cache_buf_top = 0;
 }
 
@@ -102,6 +104,14 @@ void ARM_DynCom::ExecuteInstructions(u64 num_instructions) {
     if (timer) {
         timer->AddTicks(ticks_executed);
     }
+    // The interpreter can't be interrupted from other threads, so samples are taken per slice.
+    // It always runs on the current page table, as it does not keep one of its own.
+    if (TakeProfilerSampleRequest()) {
+        if (auto* profiler = system.GetGuestProfiler()) {
+            profiler->RecordSample(system.Memory().GetCurrentPageTable().get(), GetPC(),
+                                   GetReg(14));
+        }
+    }
     state->ServeBreak();
 }
 
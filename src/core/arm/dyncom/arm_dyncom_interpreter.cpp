@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <optional>
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -839,7 +840,34 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
     return inst_size;
 }
 
-static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
+/// Maximum number of unconditional branches followed while translating a single block.
+constexpr unsigned MAX_FOLLOWED_BRANCHES = 8;
+
+// Positions of the immediate branches in arm_instruction_trans, counted from its end. The last ARM
+// entry is bbl, followed by the five Thumb branch entries that DecodeThumbInstruction indexes the
+// same way.
+/// ARM B/BL, bits 25-27 = 0b101, with a signed 24-bit word offset in bits 0-23
+constexpr unsigned BBL_INDEX_FROM_END = 6;
+/// Thumb unconditional B, bits 11-15 = 0b11100, with a signed 11-bit halfword offset in bits 0-10
+constexpr unsigned B_2_THUMB_INDEX_FROM_END = 5;
+
+/// Returns the target of an unconditional immediate branch that stays in the current instruction
+/// set, or nullopt if the instruction is anything else.
+static std::optional<u32> GetStaticBranchTarget(const arm_inst* inst_base, u32 addr) {
+    const auto table_length = static_cast<unsigned>(arm_instruction_trans_len);
+    if (inst_base->idx == table_length - BBL_INDEX_FROM_END &&
+        inst_base->cond == ConditionCode::AL) {
+        const auto* inst_cream = reinterpret_cast<const bbl_inst*>(inst_base->component);
+        return addr + 8 + inst_cream->signed_immed_24;
+    }
+    if (inst_base->idx == table_length - B_2_THUMB_INDEX_FROM_END) {
+        const auto* inst_cream = reinterpret_cast<const b_2_thumb*>(inst_base->component);
+        return addr + 4 + inst_cream->imm;
+    }
+    return std::nullopt;
+}
+
+static int InterpreterTranslateBlock(ARMul_State* cpu, u32& block, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     // Decode instruction, get index
@@ -848,31 +876,48 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
     // Save start addr of basicblock in CreamCache
     ARM_INST_PTR inst_base = nullptr;
     TransExtData ret = TransExtData::NON_BRANCH;
-    bb_start = trans_cache_buf_top;
+    const std::size_t bb_start = trans_cache_buf_top;
 
     u32 phys_addr = addr;
     u32 pc_start = cpu->Reg[15];
 
+    // Unconditional immediate branches are followed, so that their target is translated into the
+    // same superblock and executed without going through the dispatcher. Breakpoints are only
+    // looked up on dispatch, so this is disabled while the GDB server is enabled.
+    const bool follow_branches = !GDBStub::IsServerEnabled();
+    unsigned followed_branches = 0;
+
     while (ret == TransExtData::NON_BRANCH) {
+        const u32 inst_addr = phys_addr;
         u32 inst_size = InterpreterTranslateInstruction(cpu, phys_addr, inst_base);
         phys_addr += inst_size;
 
+        if (follow_branches && followed_branches < MAX_FOLLOWED_BRANCHES) {
+            if (const auto target = GetStaticBranchTarget(inst_base, inst_addr)) {
+                inst_base->br = TransExtData::NON_BRANCH;
+                phys_addr = *target;
+                followed_branches++;
+                continue;
+            }
+        }
+
         if ((phys_addr & 0xfff) == 0) {
             inst_base->br = TransExtData::END_OF_PAGE;
         }
         ret = inst_base->br;
     };
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    block =
+        cpu->instruction_cache.Insert(TranslationCache::MakeKey(pc_start, cpu->TFlag), bb_start);
 
     return KEEP_GOING;
 }
 
-static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
+static int InterpreterTranslateSingle(ARMul_State* cpu, u32& block, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     ARM_INST_PTR inst_base = nullptr;
-    bb_start = trans_cache_buf_top;
+    const std::size_t bb_start = trans_cache_buf_top;
 
     u32 phys_addr = addr;
     u32 pc_start = cpu->Reg[15];
@@ -883,7 +928,8 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    block =
+        cpu->instruction_cache.Insert(TranslationCache::MakeKey(pc_start, cpu->TFlag), bb_start);
 
     return KEEP_GOING;
 }
@@ -1626,6 +1672,10 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
 
     std::size_t ptr;
 
+    // Last dispatched block, used to chain it to its successor
+    u32 block = TranslationCache::NO_BLOCK;
+    u32 block_generation = 0;
+
     LOAD_NZCVT;
 DISPATCH : {
     if (!cpu->NirqSig) {
@@ -1639,17 +1689,36 @@ DISPATCH : {
     else
         cpu->Reg[15] &= 0xfffffffc;
 
-    // Find the cached instruction cream, otherwise translate it...
-    auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
-    if (itr != cpu->instruction_cache.end()) {
-        ptr = itr->second;
-    } else if (cpu->NumInstrsToExecute != 1) {
-        if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
-    } else {
-        if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+    // Follow the link of the previous block if it leads here, otherwise find the cached
+    // instruction cream or translate it and link the previous block to it.
+    TranslationCache& cache = cpu->instruction_cache;
+    const u32 block_key = TranslationCache::MakeKey(cpu->Reg[15], cpu->TFlag);
+    const bool can_link =
+        block != TranslationCache::NO_BLOCK && block_generation == cache.Generation();
+    u32 next_block = TranslationCache::NO_BLOCK;
+    if (can_link && cache.GetBlock(block).link_key == block_key) {
+        next_block = cache.GetBlock(block).link_block;
+    }
+    if (next_block == TranslationCache::NO_BLOCK) {
+        next_block = cache.Find(block_key);
+        if (next_block == TranslationCache::NO_BLOCK) {
+            if (cpu->NumInstrsToExecute != 1) {
+                if (InterpreterTranslateBlock(cpu, next_block, cpu->Reg[15]) == FETCH_EXCEPTION)
+                    goto END;
+            } else {
+                if (InterpreterTranslateSingle(cpu, next_block, cpu->Reg[15]) == FETCH_EXCEPTION)
+                    goto END;
+            }
+        }
+        if (can_link) {
+            TranslationCache::Block& previous = cache.GetBlock(block);
+            previous.link_key = block_key;
+            previous.link_block = next_block;
+        }
     }
+    block = next_block;
+    block_generation = cache.Generation();
+    ptr = cache.GetBlock(block).offset;
 
 #ifndef ANDROID
     // Find breakpoint if one exists within the block
@@ -1769,7 +1838,8 @@ BBL_INST : {
         }
         SET_PC;
         INC_PC(sizeof(bbl_inst));
-        goto DISPATCH;
+        FETCH_INST;
+        GOTO_NEXT_INST;
     }
     cpu->Reg[15] += cpu->GetInstructionSize();
     INC_PC(sizeof(bbl_inst));
@@ -4323,7 +4393,8 @@ B_2_THUMB : {
     b_2_thumb* inst_cream = (b_2_thumb*)inst_base->component;
     cpu->Reg[15] = cpu->Reg[15] + 4 + inst_cream->imm;
     INC_PC(sizeof(b_2_thumb));
-    goto DISPATCH;
+    FETCH_INST;
+    GOTO_NEXT_INST;
 }
 B_COND_THUMB : {
     b_cond_thumb* inst_cream = (b_cond_thumb*)inst_base->component;
@@ -0,0 +1,116 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Index of the blocks translated by the interpreter. Blocks are looked up by their entry key (the
+ * guest PC with the Thumb flag in bit 0) through an open addressing hash table, which is much
+ * cheaper on the dispatch path than std::unordered_map.
+ *
+ * Each block additionally remembers the block that followed it the last time it was executed.
+ * The interpreter checks this link first, which chains hot blocks together without a lookup.
+ */
+class TranslationCache {
+public:
+    static constexpr u32 NO_BLOCK = 0xFFFFFFFF;
+
+    struct Block {
+        std::size_t offset;         ///< Offset of the first instruction in trans_cache_buf
+        u32 link_key = 0;           ///< Entry key of the last successor
+        u32 link_block = NO_BLOCK;  ///< Index of the last successor
+    };
+
+    TranslationCache() {
+        Clear();
+    }
+
+    static u32 MakeKey(u32 pc, u32 thumb) {
+        return pc | thumb;
+    }
+
+    /// Returns the index of the block with the given entry key, or NO_BLOCK.
+    u32 Find(u32 key) const {
+        for (std::size_t i = Hash(key);; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.block == NO_BLOCK || slot.key == key) {
+                return slot.block;
+            }
+        }
+    }
+
+    /// Adds or replaces the block with the given entry key and returns its index.
+    u32 Insert(u32 key, std::size_t offset) {
+        if ((blocks.size() + 1) * 2 > slots.size()) {
+            Rehash(slots.size() * 2);
+        }
+        const auto index = static_cast<u32>(blocks.size());
+        blocks.push_back({offset});
+        Place(key, index);
+        return index;
+    }
+
+    Block& GetBlock(u32 index) {
+        return blocks[index];
+    }
+
+    /// Counts how often the cache was cleared, so that stale block indices can be detected.
+    u32 Generation() const {
+        return generation;
+    }
+
+    void Clear() {
+        blocks.clear();
+        slots.assign(INITIAL_CAPACITY, Slot{});
+        mask = INITIAL_CAPACITY - 1;
+        shift = 32 - std::countr_zero(INITIAL_CAPACITY);
+        ++generation;
+    }
+
+private:
+    static constexpr std::size_t INITIAL_CAPACITY = 0x1000;
+
+    struct Slot {
+        u32 key = 0;
+        u32 block = NO_BLOCK;
+    };
+
+    /// Fibonacci hashing, taking the top bits of the product.
+    std::size_t Hash(u32 key) const {
+        return static_cast<std::size_t>(static_cast<u32>(key * 0x9E3779B1U) >> shift);
+    }
+
+    void Place(u32 key, u32 index) {
+        for (std::size_t i = Hash(key);; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (slot.block == NO_BLOCK || slot.key == key) {
+                slot = {key, index};
+                return;
+            }
+        }
+    }
+
+    void Rehash(std::size_t capacity) {
+        std::vector<Slot> old_slots(capacity, Slot{});
+        std::swap(slots, old_slots);
+        mask = capacity - 1;
+        shift = 32 - std::countr_zero(capacity);
+        for (const Slot& slot : old_slots) {
+            if (slot.block != NO_BLOCK) {
+                Place(slot.key, slot.block);
+            }
+        }
+    }
+
+    std::vector<Slot> slots;
+    std::vector<Block> blocks;
+    std::size_t mask = 0;
+    int shift = 0;
+    u32 generation = 0;
+};
@@ -2,8 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <utility>
+#include <boost/container/small_vector.hpp>
 #include <boost/serialization/array.hpp>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/hle/hle.h"
@@ -27,6 +30,7 @@
 #include "core/frontend/image_interface.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/global.h"
+#include "core/guest_profiler.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
@@ -206,27 +210,31 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
             max_slice = std::min(max_slice, cpu_core->GetTimer().GetMaxSliceLength());
         }
-        for (auto& cpu_core : cpu_cores) {
-            cpu_core->GetTimer().SetNextSlice(max_slice);
-            auto start_ticks = cpu_core->GetTimer().GetTicks();
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer().GetDowncount());
-            running_core = cpu_core.get();
-            kernel->SetRunningCPU(running_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer().Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        if (CanRunCoresParallel(tight_loop)) {
+            RunCoresParallel(max_slice);
+        } else {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                auto start_ticks = cpu_core->GetTimer().GetTicks();
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer().GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    if (tight_loop) {
+                        cpu_core->Run();
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
+                max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
             }
-            max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
         }
     }
 
@@ -385,6 +393,103 @@ void System::Reschedule() {
     }
 }
 
+System::CoreLock::CoreLock(System& system_, ARM_Interface& core_)
+    : system{&system_}, core{&core_}, lock{system_.core_mutex} {
+    if (system->running_core != core) {
+        system->running_core = core;
+        system->kernel->SetRunningCPU(core);
+    }
+}
+
+System::CoreLock::~CoreLock() {
+    if (system) {
+        system->SyncSliceEnd(*core);
+    }
+}
+
+System::CoreLock System::LockCore(ARM_Interface& core) {
+    if (!parallel_cores_active.load(std::memory_order_relaxed)) {
+        return {};
+    }
+    return CoreLock{*this, core};
+}
+
+void System::SyncSliceEnd(ARM_Interface& core) {
+    // An event scheduled while the lock was held may have ended the slice of this core early. The
+    // serial loop would then only give the following cores the ticks this one ran, so the other
+    // cores are stopped at the same tick to keep all of them at the same global time.
+    const s64 slice_end = core.GetTimer().GetSliceEnd();
+    if (slice_end >= parallel_slice_end) {
+        return;
+    }
+    parallel_slice_end = slice_end;
+    for (auto& cpu_core : cpu_cores) {
+        if (cpu_core.get() != &core && cpu_core->GetTimer().LimitSliceEnd(slice_end)) {
+            cpu_core->RequestSliceUpdate();
+        }
+    }
+}
+
+bool System::CanRunCoresParallel(bool tight_loop) const {
+    if (!core_workers || !tight_loop || GDBStub::IsServerEnabled()) {
+        return false;
+    }
+    // Every core must run in the same address space, otherwise taking the lock from another core
+    // would swap the current memory page table from under a running JIT.
+    const auto page_table = cpu_cores[0]->GetPageTable();
+    return std::all_of(cpu_cores.begin(), cpu_cores.end(), [&](const auto& cpu_core) {
+        return cpu_core->GetPageTable() == page_table;
+    });
+}
+
+void System::RunCoresParallel(s64 max_slice) {
+    boost::container::small_vector<ARM_Interface*, 4> idle_cores;
+    {
+        // Hold the lock while setting up the slice so that cores already started can't observe
+        // the kernel with another core marked as running.
+        std::scoped_lock lock{core_mutex};
+        parallel_cores_active = true;
+        parallel_slice_end = std::numeric_limits<s64>::max();
+        for (auto& cpu_core : cpu_cores) {
+            cpu_core->GetTimer().SetNextSlice(max_slice);
+            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks (parallel)", cpu_core->GetID(),
+                      cpu_core->GetTimer().GetDowncount());
+            running_core = cpu_core.get();
+            kernel->SetRunningCPU(running_core);
+            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                idle_cores.push_back(cpu_core.get());
+                PrepareReschedule();
+                continue;
+            }
+            core_workers->QueueWork([core = cpu_core.get()] { core->Run(); });
+        }
+    }
+
+    // The slice end is the synchronization barrier. Cores that end their slice early stop the
+    // others at the same tick (see SyncSliceEnd), so they all leave it at the same global time,
+    // short of the few ticks the JIT may overshoot by.
+    core_workers->WaitForRequests();
+    parallel_cores_active = false;
+
+    // Idle cores only skip ahead to where the running cores stopped
+    if (idle_cores.size() != cpu_cores.size()) {
+        s64 slice_end = std::numeric_limits<s64>::max();
+        for (const auto& cpu_core : cpu_cores) {
+            if (std::find(idle_cores.begin(), idle_cores.end(), cpu_core.get()) ==
+                idle_cores.end()) {
+                slice_end = std::min(slice_end, static_cast<s64>(cpu_core->GetTimer().GetTicks()));
+            }
+        }
+        for (ARM_Interface* idle_core : idle_cores) {
+            idle_core->GetTimer().LimitSliceEnd(slice_end);
+        }
+    }
+    for (ARM_Interface* idle_core : idle_cores) {
+        idle_core->GetTimer().Idle();
+    }
+}
+
 System::ResultStatus System::Init(Frontend::EmuWindow& emu_window,
                                   Frontend::EmuWindow* secondary_window,
                                   Kernel::MemoryMode memory_mode,
@@ -423,9 +528,20 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window,
     }
     running_core = cpu_cores[0].get();
 
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+    if (Settings::values.use_cpu_jit && Settings::values.parallel_cpu_cores && num_cores > 1) {
+        LOG_INFO(Core, "Running {} CPU cores on separate host threads", num_cores);
+        core_workers = std::make_unique<Common::ThreadWorker>(num_cores, "CPUCore");
+    }
+#endif
+
     kernel->SetCPUs(cpu_cores);
     kernel->SetRunningCPU(cpu_cores[0].get());
 
+    if (Settings::values.enable_guest_profiler) {
+        guest_profiler = std::make_unique<GuestProfiler>(*this);
+    }
+
     const auto audio_emulation = Settings::values.audio_emulation.GetValue();
     if (audio_emulation == Settings::AudioEmulation::HLE) {
         dsp_core = std::make_unique<AudioCore::DspHle>(*this);
@@ -459,8 +575,14 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window,
 
     custom_tex_manager = std::make_unique<VideoCore::CustomTexManager>(*this);
 
+    // The shader JIT keeps its on-disk cache per title, titles without a program id get none.
+    u64 program_id{};
+    if (app_loader->ReadProgramId(program_id) != Loader::ResultStatus::Success) {
+        program_id = 0;
+    }
+
     auto gsp = service_manager->GetService<Service::GSP::GSP_GPU>("gsp::Gpu");
-    gpu = std::make_unique<VideoCore::GPU>(*this, emu_window, secondary_window);
+    gpu = std::make_unique<VideoCore::GPU>(*this, emu_window, secondary_window, program_id);
     gpu->SetInterruptHandler(
         [gsp](Service::GSP::InterruptId interrupt_id) { gsp->SignalInterrupt(interrupt_id); });
 
@@ -580,6 +702,9 @@ void System::Shutdown(bool is_deserializing) {
     // Shutdown emulation session
     is_powered_on = false;
 
+    // Written out now, while the processes it symbolizes against are still alive
+    guest_profiler.reset();
+
     gpu.reset();
     if (!is_deserializing) {
         GDBStub::Shutdown();
@@ -594,6 +719,7 @@ void System::Shutdown(bool is_deserializing) {
     archive_manager.reset();
     service_manager.reset();
     dsp_core.reset();
+    core_workers.reset();
     kernel.reset();
     cpu_cores.clear();
     exclusive_monitor.reset();
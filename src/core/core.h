@@ -11,6 +11,7 @@
 #include <boost/optional.hpp>
 #include <boost/serialization/version.hpp>
 #include "common/common_types.h"
+#include "common/thread_worker.h"
 #include "core/arm/arm_interface.h"
 #include "core/cheats/cheats.h"
 #include "core/hle/service/apt/applet_manager.h"
@@ -72,6 +73,7 @@ class AppLoader;
 namespace Core {
 
 class ARM_Interface;
+class GuestProfiler;
 class TelemetrySession;
 class ExclusiveMonitor;
 class Timing;
@@ -176,6 +178,32 @@ public:
     /// Prepare the core emulation for a reschedule
     void PrepareReschedule();
 
+    /// Lock held by a core running on its own host thread while it is outside of guest code
+    class CoreLock {
+    public:
+        CoreLock() = default;
+        explicit CoreLock(System& system, ARM_Interface& core);
+        ~CoreLock();
+
+        CoreLock(const CoreLock&) = delete;
+        CoreLock& operator=(const CoreLock&) = delete;
+
+    private:
+        System* system = nullptr;
+        ARM_Interface* core = nullptr;
+        std::unique_lock<std::mutex> lock;
+    };
+
+    /**
+     * Serializes access to the kernel and HLE state from a CPU core running on its own host
+     * thread, and marks that core as the running one while the lock is held. When the core ended
+     * its slice early while holding the lock, the other cores end theirs at the same time once it
+     * is released. Returns an empty lock when the cores are being executed serially on the
+     * emulation thread.
+     * @param core The core that is about to leave guest code (SVC, slow memory access, ...).
+     */
+    [[nodiscard]] CoreLock LockCore(ARM_Interface& core);
+
     [[nodiscard]] PerfStats::Results GetAndResetPerfStats();
 
     [[nodiscard]] PerfStats::Results GetLastPerfStats();
@@ -288,6 +316,11 @@ public:
         return video_dumper;
     }
 
+    /// Gets the guest profiler, or nullptr if it is not enabled
+    [[nodiscard]] GuestProfiler* GetGuestProfiler() const {
+        return guest_profiler.get();
+    }
+
     std::unique_ptr<PerfStats> perf_stats;
     FrameLimiter frame_limiter;
 
@@ -372,6 +405,18 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /**
+     * Runs every core for max_slice ticks, each on its own host thread. Only valid while all
+     * cores share one address space, which keeps the current memory page table stable.
+     */
+    void RunCoresParallel(s64 max_slice);
+
+    /// Returns true if the synchronized cores may be run concurrently this slice
+    [[nodiscard]] bool CanRunCoresParallel(bool tight_loop) const;
+
+    /// Makes the other cores running in parallel end their slice no later than this core
+    void SyncSliceEnd(ARM_Interface& core);
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -379,6 +424,15 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Host threads used to run the cores in parallel, if enabled
+    std::unique_ptr<Common::ThreadWorker> core_workers;
+    /// Guards kernel and HLE state while cores are running in parallel
+    std::mutex core_mutex;
+    /// True while RunCoresParallel is executing guest code on the core workers
+    std::atomic_bool parallel_cores_active{};
+    /// Earliest tick at which a core running in parallel ends its slice, guarded by core_mutex
+    s64 parallel_slice_end{};
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
@@ -388,6 +442,9 @@ private:
     /// Telemetry session for this emulation session
     std::unique_ptr<Core::TelemetrySession> telemetry_session;
 
+    /// Sampling profiler for guest code, if enabled
+    std::unique_ptr<GuestProfiler> guest_profiler;
+
     std::unique_ptr<VideoCore::GPU> gpu;
 
     /// Service manager
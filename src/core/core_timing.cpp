@@ -3,9 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <bit>
 #include <random>
 #include <tuple>
 #include "common/assert.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/settings.h"
 #include "core/core_timing.h"
@@ -21,6 +23,245 @@ bool Timing::Event::operator<(const Timing::Event& right) const {
     return std::tie(time, fifo_order) < std::tie(right.time, right.fifo_order);
 }
 
+std::size_t Timing::EventQueue::EventKeyHash::operator()(const EventKey& key) const noexcept {
+    return static_cast<std::size_t>(
+        Common::HashCombine(reinterpret_cast<std::uintptr_t>(key.type), key.user_data));
+}
+
+Timing::EventQueue::EventQueue() {
+    slot_heads.fill(INVALID_NODE);
+}
+
+void Timing::EventQueue::Link(u32 index) {
+    Node& node = nodes[index];
+    // Events scheduled in the past are kept in the cursor's slot, they still sort by their time.
+    const s64 time = std::max(node.event.time, cursor);
+
+    std::size_t slot = OVERFLOW_SLOT;
+    for (std::size_t level = 0; level < NUM_LEVELS; ++level) {
+        const std::size_t window_shift = LevelShift(level) + SLOT_BITS;
+        if ((time >> window_shift) == (cursor >> window_shift)) {
+            const std::size_t slot_index = (time >> LevelShift(level)) & (WHEEL_SLOTS - 1);
+            occupied[level] |= 1ULL << slot_index;
+            slot = level * WHEEL_SLOTS + slot_index;
+            break;
+        }
+    }
+
+    node.slot = static_cast<u32>(slot);
+    node.prev = INVALID_NODE;
+    node.next = slot_heads[slot];
+    if (node.next != INVALID_NODE) {
+        nodes[node.next].prev = index;
+    }
+    slot_heads[slot] = index;
+}
+
+void Timing::EventQueue::Unlink(u32 index) {
+    const Node& node = nodes[index];
+    if (node.prev != INVALID_NODE) {
+        nodes[node.prev].next = node.next;
+    } else {
+        slot_heads[node.slot] = node.next;
+        if (node.next == INVALID_NODE && node.slot != OVERFLOW_SLOT) {
+            occupied[node.slot / WHEEL_SLOTS] &= ~(1ULL << (node.slot % WHEEL_SLOTS));
+        }
+    }
+    if (node.next != INVALID_NODE) {
+        nodes[node.next].prev = node.prev;
+    }
+}
+
+void Timing::EventQueue::Erase(u32 index) {
+    Unlink(index);
+
+    const Node& node = nodes[index];
+    if (node.key_prev != INVALID_NODE) {
+        nodes[node.key_prev].key_next = node.key_next;
+    } else {
+        const EventKey key{node.event.type, node.event.user_data};
+        if (node.key_next != INVALID_NODE) {
+            key_heads[key] = node.key_next;
+        } else {
+            key_heads.erase(key);
+        }
+    }
+    if (node.key_next != INVALID_NODE) {
+        nodes[node.key_next].key_prev = node.key_prev;
+    }
+
+    if (cached_front == index) {
+        cached_front = INVALID_NODE;
+    }
+    free_nodes.push_back(index);
+    --count;
+}
+
+void Timing::EventQueue::MoveCursor(s64 target) {
+    const s64 old_cursor = cursor;
+    if (target <= old_cursor) {
+        return;
+    }
+    cursor = target;
+
+    // Whenever the cursor enters a new slot of a level, the events in that slot now belong to a
+    // finer level. Slots that were skipped over can't hold anything, as no event is earlier than
+    // target. Go from coarse to fine so that cascaded events get cascaded again if needed.
+    const auto relink_slot = [this](std::size_t slot) {
+        u32 index = slot_heads[slot];
+        slot_heads[slot] = INVALID_NODE;
+        if (slot != OVERFLOW_SLOT) {
+            occupied[slot / WHEEL_SLOTS] &= ~(1ULL << (slot % WHEEL_SLOTS));
+        }
+        while (index != INVALID_NODE) {
+            const u32 next = nodes[index].next;
+            Link(index);
+            index = next;
+        }
+    };
+
+    const std::size_t top_shift = LevelShift(NUM_LEVELS);
+    if ((old_cursor >> top_shift) != (target >> top_shift)) {
+        relink_slot(OVERFLOW_SLOT);
+    }
+    for (std::size_t level = NUM_LEVELS - 1; level > 0; --level) {
+        const std::size_t shift = LevelShift(level);
+        if ((old_cursor >> shift) != (target >> shift)) {
+            relink_slot(level * WHEEL_SLOTS + ((target >> shift) & (WHEEL_SLOTS - 1)));
+        }
+    }
+}
+
+const Timing::Event& Timing::EventQueue::front() {
+    ASSERT(count != 0);
+    if (cached_front != INVALID_NODE) {
+        return nodes[cached_front].event;
+    }
+
+    while (occupied[0] == 0) {
+        s64 target = std::numeric_limits<s64>::max();
+        const auto level = std::find_if(occupied.begin(), occupied.end(),
+                                        [](u64 bits) { return bits != 0; });
+        if (level != occupied.end()) {
+            // Jump to the start of the first occupied slot of the lowest non-empty level
+            const std::size_t shift =
+                LevelShift(static_cast<std::size_t>(std::distance(occupied.begin(), level)));
+            const s64 window = (cursor >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+            target = window + (static_cast<s64>(std::countr_zero(*level)) << shift);
+        } else {
+            for (u32 index = slot_heads[OVERFLOW_SLOT]; index != INVALID_NODE;
+                 index = nodes[index].next) {
+                target = std::min(target, nodes[index].event.time);
+            }
+        }
+        MoveCursor(target);
+    }
+
+    // The first occupied level 0 slot holds the earliest event, pick it by (time, fifo_order)
+    const std::size_t slot = std::countr_zero(occupied[0]);
+    u32 best = slot_heads[slot];
+    for (u32 index = nodes[best].next; index != INVALID_NODE; index = nodes[index].next) {
+        if (nodes[index].event < nodes[best].event) {
+            best = index;
+        }
+    }
+    cached_front = best;
+    return nodes[best].event;
+}
+
+Timing::Event Timing::EventQueue::pop_front() {
+    front();
+    const u32 index = cached_front;
+    Event event = nodes[index].event;
+    Erase(index);
+    return event;
+}
+
+void Timing::EventQueue::push(const Event& event) {
+    u32 index;
+    if (!free_nodes.empty()) {
+        index = free_nodes.back();
+        free_nodes.pop_back();
+    } else {
+        index = static_cast<u32>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Node& node = nodes[index];
+    node.event = event;
+
+    // Chain the node with the other events sharing its type and user data
+    const auto [it, inserted] = key_heads.try_emplace(EventKey{event.type, event.user_data}, index);
+    node.key_prev = INVALID_NODE;
+    node.key_next = inserted ? INVALID_NODE : it->second;
+    if (!inserted) {
+        nodes[it->second].key_prev = index;
+        it->second = index;
+    }
+
+    Link(index);
+    ++count;
+
+    if (cached_front != INVALID_NODE && event < nodes[cached_front].event) {
+        cached_front = index;
+    }
+}
+
+void Timing::EventQueue::Remove(const TimingEventType* type, std::uintptr_t user_data) {
+    const auto it = key_heads.find(EventKey{type, user_data});
+    if (it == key_heads.end()) {
+        return;
+    }
+    u32 index = it->second;
+    while (index != INVALID_NODE) {
+        const u32 next = nodes[index].key_next;
+        Erase(index);
+        index = next;
+    }
+}
+
+void Timing::EventQueue::RemoveAll(const TimingEventType* type) {
+    std::vector<std::uintptr_t> user_datas;
+    for (const auto& [key, head] : key_heads) {
+        if (key.type == type) {
+            user_datas.push_back(key.user_data);
+        }
+    }
+    for (const std::uintptr_t user_data : user_datas) {
+        Remove(type, user_data);
+    }
+}
+
+void Timing::EventQueue::AdvanceTo(s64 now) {
+    if (count != 0) {
+        now = std::min(now, front().time);
+    }
+    MoveCursor(now);
+}
+
+std::vector<Timing::Event> Timing::EventQueue::ToVector() const {
+    std::vector<Event> events;
+    events.reserve(count);
+    for (const u32 head : slot_heads) {
+        for (u32 index = head; index != INVALID_NODE; index = nodes[index].next) {
+            events.push_back(nodes[index].event);
+        }
+    }
+    std::sort(events.begin(), events.end());
+    return events;
+}
+
+void Timing::EventQueue::clear() {
+    nodes.clear();
+    free_nodes.clear();
+    slot_heads.fill(INVALID_NODE);
+    occupied.fill(0);
+    key_heads.clear();
+    cursor = 0;
+    cached_front = INVALID_NODE;
+    count = 0;
+}
+
 Timing::Timing(std::size_t num_cores, u32 cpu_clock_percentage, s64 override_base_ticks) {
     // Generate non-zero base tick count to simulate time the system ran before launching the game.
     // This accounts for games that rely on the system tick to seed randomness.
@@ -29,6 +270,7 @@ Timing::Timing(std::size_t num_cores, u32 cpu_clock_percentage, s64 override_bas
     timers.resize(num_cores);
     for (std::size_t i = 0; i < num_cores; ++i) {
         timers[i] = std::make_shared<Timer>(base_ticks);
+        timers[i]->event_types = &event_types_by_id;
     }
     UpdateClockSpeed(cpu_clock_percentage);
     current_timer = timers[0].get();
@@ -54,7 +296,11 @@ TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback ca
     // we want event type names to remain unique so that we can use them for serialization.
     auto info = event_types.emplace(name, TimingEventType{});
     TimingEventType* event_type = &info.first->second;
-    event_type->name = &info.first->first;
+    if (info.second) {
+        event_type->name = &info.first->first;
+        event_type->id = static_cast<u32>(event_types_by_id.size());
+        event_types_by_id.push_back(event_type);
+    }
     if (callback != nullptr) {
         event_type->callback = callback;
     }
@@ -83,8 +329,8 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
         // of MAX_SLICE_LENGTH * 2 cycles into the future.
         cycles_into_future = std::max(static_cast<s64>(MAX_SLICE_LENGTH * 2), cycles_into_future);
 
-        timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
-                                   user_data, event_type});
+        timer->PushPendingEvent(static_cast<s64>(timer->GetTicks() + cycles_into_future),
+                                event_type, user_data);
     } else {
         s64 timeout = timer->GetTicks() + cycles_into_future;
         if (current_timer == timer) {
@@ -92,12 +338,10 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
             if (!timer->is_timer_sane)
                 timer->ForceExceptionCheck(cycles_into_future);
 
-            timer->event_queue.emplace_back(
-                Event{timeout, timer->event_fifo_id++, user_data, event_type});
-            std::push_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+            timer->event_queue.push(Event{timeout, timer->event_fifo_id++, user_data, event_type});
         } else {
-            timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
-                                       user_data, event_type});
+            timer->PushPendingEvent(static_cast<s64>(timer->GetTicks() + cycles_into_future),
+                                    event_type, user_data);
         }
     }
 }
@@ -106,16 +350,8 @@ void Timing::UnscheduleEvent(const TimingEventType* event_type, std::uintptr_t u
     if (event_queue_locked) {
         return;
     }
-    for (auto timer : timers) {
-        auto itr = std::remove_if(
-            timer->event_queue.begin(), timer->event_queue.end(),
-            [&](const Event& e) { return e.type == event_type && e.user_data == user_data; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+    for (auto& timer : timers) {
+        timer->event_queue.Remove(event_type, user_data);
     }
     // TODO:remove events from ts_queue
 }
@@ -124,15 +360,8 @@ void Timing::RemoveEvent(const TimingEventType* event_type) {
     if (event_queue_locked) {
         return;
     }
-    for (auto timer : timers) {
-        auto itr = std::remove_if(timer->event_queue.begin(), timer->event_queue.end(),
-                                  [&](const Event& e) { return e.type == event_type; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+    for (auto& timer : timers) {
+        timer->event_queue.RemoveAll(event_type);
     }
     // TODO:remove events from ts_queue
 }
@@ -163,20 +392,19 @@ std::shared_ptr<Timing::Timer> Timing::GetTimer(std::size_t cpu_id) {
 
 Timing::Timer::Timer(s64 base_ticks) : executed_ticks(base_ticks) {}
 
-Timing::Timer::~Timer() {
-    MoveEvents();
-}
+Timing::Timer::~Timer() = default;
 
 u64 Timing::Timer::GetTicks() const {
-    u64 ticks = static_cast<u64>(executed_ticks);
+    u64 ticks = static_cast<u64>(executed_ticks.load(std::memory_order_relaxed));
     if (!is_timer_sane) {
-        ticks += slice_length - downcount;
+        ticks += slice_length.load(std::memory_order_relaxed) -
+                 downcount.load(std::memory_order_relaxed);
     }
     return ticks;
 }
 
 void Timing::Timer::AddTicks(u64 ticks) {
-    downcount -= static_cast<u64>(ticks * cpu_clock_scale);
+    downcount.fetch_sub(static_cast<s64>(ticks * cpu_clock_scale), std::memory_order_relaxed);
 }
 
 u64 Timing::Timer::GetIdleTicks() const {
@@ -184,26 +412,69 @@ u64 Timing::Timer::GetIdleTicks() const {
 }
 
 void Timing::Timer::ForceExceptionCheck(s64 cycles) {
-    cycles = std::max<s64>(0, cycles);
-    if (downcount > cycles) {
-        slice_length -= downcount - cycles;
-        downcount = cycles;
+    LowerDowncount(std::max<s64>(0, cycles));
+}
+
+s64 Timing::Timer::GetSliceEnd() const {
+    return executed_ticks.load(std::memory_order_relaxed) +
+           slice_length.load(std::memory_order_relaxed);
+}
+
+bool Timing::Timer::LimitSliceEnd(s64 end_ticks) {
+    return LowerDowncount(std::max<s64>(0, end_ticks - static_cast<s64>(GetTicks())));
+}
+
+bool Timing::Timer::LowerDowncount(s64 cycles) {
+    // The owning core may be subtracting executed ticks from the downcount at the same time
+    s64 current = downcount.load(std::memory_order_relaxed);
+    while (current > cycles &&
+           !downcount.compare_exchange_weak(current, cycles, std::memory_order_relaxed)) {
+    }
+    if (current <= cycles) {
+        return false;
+    }
+    slice_length.fetch_sub(current - cycles, std::memory_order_relaxed);
+    return true;
+}
+
+void Timing::Timer::PushPendingEvent(s64 time, const TimingEventType* type,
+                                     std::uintptr_t user_data) {
+    const PendingEvent pending{time, user_data, type->id};
+    if (ts_queue.TryEmplace(pending)) {
+        return;
     }
+
+    std::scoped_lock lock{overflow_mutex};
+    overflow_events.push_back(pending);
+    has_overflow_events.store(true, std::memory_order_release);
 }
 
 void Timing::Timer::MoveEvents() {
-    for (Event ev; ts_queue.Pop(ev);) {
-        ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    const auto move_event = [this](const PendingEvent& pending) {
+        event_queue.push(Event{pending.time, event_fifo_id++, pending.user_data,
+                               (*event_types)[pending.type_id]});
+    };
+
+    for (PendingEvent pending; ts_queue.TryPop(pending);) {
+        move_event(pending);
+    }
+
+    if (has_overflow_events.load(std::memory_order_acquire)) {
+        std::scoped_lock lock{overflow_mutex};
+        for (const PendingEvent& pending : overflow_events) {
+            move_event(pending);
+        }
+        overflow_events.clear();
+        has_overflow_events.store(false, std::memory_order_relaxed);
     }
 }
 
-s64 Timing::Timer::GetMaxSliceLength() const {
-    const auto& next_event = event_queue.begin();
-    if (next_event != event_queue.end()) {
-        ASSERT(next_event->time - executed_ticks > 0);
-        return next_event->time - executed_ticks;
+s64 Timing::Timer::GetMaxSliceLength() {
+    if (!event_queue.empty()) {
+        const Event& next_event = event_queue.front();
+        const s64 ticks = executed_ticks.load(std::memory_order_relaxed);
+        ASSERT(next_event.time - ticks > 0);
+        return next_event.time - ticks;
     }
     return MAX_SLICE_LENGTH;
 }
@@ -211,47 +482,49 @@ s64 Timing::Timer::GetMaxSliceLength() const {
 void Timing::Timer::Advance() {
     MoveEvents();
 
-    s64 cycles_executed = slice_length - downcount;
+    s64 cycles_executed =
+        slice_length.load(std::memory_order_relaxed) - downcount.load(std::memory_order_relaxed);
     idled_cycles = 0;
-    executed_ticks += cycles_executed;
-    slice_length = 0;
-    downcount = 0;
+    const s64 ticks =
+        executed_ticks.fetch_add(cycles_executed, std::memory_order_relaxed) + cycles_executed;
+    slice_length.store(0, std::memory_order_relaxed);
+    downcount.store(0, std::memory_order_relaxed);
 
     is_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= executed_ticks) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+    while (!event_queue.empty() && event_queue.front().time <= ticks) {
+        Event evt = event_queue.pop_front();
         if (evt.type->callback != nullptr) {
-            evt.type->callback(evt.user_data, static_cast<int>(executed_ticks - evt.time));
+            evt.type->callback(evt.user_data, static_cast<int>(ticks - evt.time));
         } else {
             LOG_ERROR(Core, "Event '{}' has no callback", *evt.type->name);
         }
     }
+    event_queue.AdvanceTo(ticks);
 
     is_timer_sane = false;
 }
 
 void Timing::Timer::SetNextSlice(s64 max_slice_length) {
-    slice_length = max_slice_length;
+    s64 length = max_slice_length;
 
     // Still events left (scheduled in the future)
     if (!event_queue.empty()) {
-        slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - executed_ticks, max_slice_length));
+        length = static_cast<int>(
+            std::min<s64>(event_queue.front().time - executed_ticks.load(std::memory_order_relaxed),
+                          max_slice_length));
     }
 
-    downcount = slice_length;
+    slice_length.store(length, std::memory_order_relaxed);
+    downcount.store(length, std::memory_order_relaxed);
 }
 
 void Timing::Timer::Idle() {
-    idled_cycles += downcount;
-    downcount = 0;
+    idled_cycles += downcount.exchange(0, std::memory_order_relaxed);
 }
 
 s64 Timing::Timer::GetDowncount() const {
-    return downcount;
+    return downcount.load(std::memory_order_relaxed);
 }
 
 } // namespace Core
@@ -17,9 +17,12 @@
  *   ScheduleEvent(periodInCycles - cyclesLate, callback, "whatever")
  */
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <limits>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -137,6 +140,8 @@ using TimedCallback = std::function<void(std::uintptr_t user_data, int cycles_la
 struct TimingEventType {
     TimedCallback callback;
     const std::string* name;
+    /// Index of this type in the event type table of the Timing that registered it
+    u32 id;
 };
 
 class Timing {
@@ -175,6 +180,107 @@ public:
         BOOST_SERIALIZATION_SPLIT_MEMBER()
     };
 
+    /**
+     * Hierarchical timing wheel holding the pending events of a timer.
+     *
+     * Events are bucketed by absolute time into NUM_LEVELS levels of WHEEL_SLOTS slots, each level
+     * WHEEL_SLOTS times coarser than the one below it. Level k only holds events that share the
+     * cursor's level k + 1 window, so the first occupied slot of the lowest non-empty level always
+     * contains the earliest event. Coarse slots are cascaded down lazily when the cursor reaches
+     * them, and events too far in the future for the top level are kept in an overflow list.
+     *
+     * Insertion and removal are O(1). Events are additionally chained by (type, user_data) so
+     * that UnscheduleEvent only touches the events it removes. Ordering is by (time, fifo_order),
+     * exactly like the binary heap this replaces.
+     */
+    class EventQueue {
+    public:
+        EventQueue();
+
+        [[nodiscard]] bool empty() const {
+            return count == 0;
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return count;
+        }
+
+        /// Returns the earliest pending event. The queue must not be empty.
+        const Event& front();
+
+        /// Removes and returns the earliest pending event. The queue must not be empty.
+        Event pop_front();
+
+        void push(const Event& event);
+
+        /// Removes all events matching the given type and user data.
+        void Remove(const TimingEventType* type, std::uintptr_t user_data);
+
+        /// Removes all events of the given type.
+        void RemoveAll(const TimingEventType* type);
+
+        /// Moves the wheel cursor forward to now, or to the earliest event if that comes first.
+        void AdvanceTo(s64 now);
+
+        /// Returns all pending events sorted by (time, fifo_order).
+        [[nodiscard]] std::vector<Event> ToVector() const;
+
+        void clear();
+
+    private:
+        static constexpr u32 INVALID_NODE = std::numeric_limits<u32>::max();
+        static constexpr std::size_t SLOT_BITS = 6;
+        static constexpr std::size_t WHEEL_SLOTS = 1ULL << SLOT_BITS;
+        static constexpr std::size_t NUM_LEVELS = 5;
+        /// Width of a level 0 slot in ticks (2^8 = 256 ticks, just under 1us)
+        static constexpr std::size_t GRANULARITY_BITS = 8;
+        static constexpr std::size_t OVERFLOW_SLOT = NUM_LEVELS * WHEEL_SLOTS;
+
+        struct Node {
+            Event event;
+            u32 prev;
+            u32 next;
+            u32 key_prev;
+            u32 key_next;
+            u32 slot;
+        };
+
+        struct EventKey {
+            const TimingEventType* type;
+            std::uintptr_t user_data;
+
+            bool operator==(const EventKey& other) const {
+                return type == other.type && user_data == other.user_data;
+            }
+        };
+
+        struct EventKeyHash {
+            std::size_t operator()(const EventKey& key) const noexcept;
+        };
+
+        static constexpr std::size_t LevelShift(std::size_t level) {
+            return GRANULARITY_BITS + level * SLOT_BITS;
+        }
+
+        /// Links a node into the slot matching its time relative to the cursor
+        void Link(u32 index);
+        /// Unlinks a node from its slot, leaving the key chain untouched
+        void Unlink(u32 index);
+        /// Unlinks a node from its slot and key chain and returns it to the free list
+        void Erase(u32 index);
+        /// Moves the cursor to target, which must not be later than any pending event
+        void MoveCursor(s64 target);
+
+        std::vector<Node> nodes;
+        std::vector<u32> free_nodes;
+        std::array<u32, OVERFLOW_SLOT + 1> slot_heads;
+        std::array<u64, NUM_LEVELS> occupied{};
+        std::unordered_map<EventKey, u32, EventKeyHash> key_heads;
+        s64 cursor = 0;
+        u32 cached_front = INVALID_NODE;
+        std::size_t count = 0;
+    };
+
     // currently Service::HID::pad_update_ticks is the smallest interval for an event that gets
     // always scheduled. Therfore we use this as orientation for the MAX_SLICE_LENGTH
     // For performance bigger slice length are desired, though this will lead to cores desync
@@ -188,7 +294,7 @@ public:
         Timer(s64 base_ticks = 0);
         ~Timer();
 
-        s64 GetMaxSliceLength() const;
+        s64 GetMaxSliceLength();
 
         void Advance();
 
@@ -205,19 +311,47 @@ public:
 
         void ForceExceptionCheck(s64 cycles);
 
+        /// Returns the tick at which the current slice ends
+        s64 GetSliceEnd() const;
+
+        /**
+         * Ends the slice at end_ticks if it would end later. May be called by another core while
+         * this one runs on its own host thread.
+         * @return True if the slice was shortened
+         */
+        bool LimitSliceEnd(s64 end_ticks);
+
         void MoveEvents();
 
     private:
         friend class Timing;
-        // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-        // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-        // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-        // accommodated by the standard adaptor class.
-        std::vector<Event> event_queue;
+
+        /// Compact event record queued from other threads, resolved by MoveEvents
+        struct PendingEvent {
+            s64 time;
+            std::uintptr_t user_data;
+            u32 type_id;
+        };
+
+        static constexpr std::size_t PENDING_EVENT_CAPACITY = 1024;
+
+        /// Lowers the downcount to cycles if it is higher, returns true if it was lowered
+        bool LowerDowncount(s64 cycles);
+
+        /// Queues an event to be moved into the event queue by the emu thread. Thread-safe.
+        void PushPendingEvent(s64 time, const TimingEventType* type, std::uintptr_t user_data);
+
+        EventQueue event_queue;
         u64 event_fifo_id = 0;
         // the queue for storing the events from other threads threadsafe until they will be added
         // to the event_queue by the emu thread
-        Common::MPSCQueue<Event> ts_queue;
+        Common::LockFreeMPSCQueue<PendingEvent, PENDING_EVENT_CAPACITY> ts_queue;
+        // Events that did not fit into ts_queue. Only used if the emu thread stalls for long.
+        std::mutex overflow_mutex;
+        std::vector<PendingEvent> overflow_events;
+        std::atomic_bool has_overflow_events{false};
+        // Event types of the owning Timing, indexed by id
+        const std::vector<TimingEventType*>* event_types = nullptr;
         // Are we in a function that has been called from Advance()
         // If events are sheduled from a function that gets called from Advance(),
         // don't change slice_length and downcount.
@@ -227,9 +361,11 @@ public:
         // downcount for that slice.
         bool is_timer_sane = true;
 
-        s64 slice_length = MAX_SLICE_LENGTH;
-        s64 downcount = MAX_SLICE_LENGTH;
-        s64 executed_ticks = 0;
+        // While cores run in parallel, other cores read these to get the ticks of this timer and
+        // lower the downcount to end the slice together with them, see LimitSliceEnd.
+        std::atomic<s64> slice_length{MAX_SLICE_LENGTH};
+        std::atomic<s64> downcount{MAX_SLICE_LENGTH};
+        std::atomic<s64> executed_ticks{0};
         u64 idled_cycles = 0;
 
         // Stores a scaling for the internal clockspeed. Changing this number results in
@@ -239,12 +375,31 @@ public:
         template <class Archive>
         void serialize(Archive& ar, const unsigned int) {
             MoveEvents();
-            ar& event_queue;
+            // The pending events are stored as a plain vector, as they were when the queue was a
+            // binary heap, so that existing savestates stay compatible.
+            std::vector<Event> events;
+            if (Archive::is_saving::value) {
+                events = event_queue.ToVector();
+            }
+            s64 slice_length_ = slice_length.load(std::memory_order_relaxed);
+            s64 downcount_ = downcount.load(std::memory_order_relaxed);
+            s64 executed_ticks_ = executed_ticks.load(std::memory_order_relaxed);
+            ar& events;
             ar& event_fifo_id;
-            ar& slice_length;
-            ar& downcount;
-            ar& executed_ticks;
+            ar& slice_length_;
+            ar& downcount_;
+            ar& executed_ticks_;
             ar& idled_cycles;
+            if (Archive::is_loading::value) {
+                slice_length.store(slice_length_, std::memory_order_relaxed);
+                downcount.store(downcount_, std::memory_order_relaxed);
+                executed_ticks.store(executed_ticks_, std::memory_order_relaxed);
+                event_queue.clear();
+                event_queue.AdvanceTo(executed_ticks_);
+                for (const Event& event : events) {
+                    event_queue.push(event);
+                }
+            }
         }
         friend class boost::serialization::access;
     };
@@ -297,6 +452,8 @@ private:
     // unordered_map stores each element separately as a linked list node so pointers to
     // elements remain stable regardless of rehashes/resizing.
     std::unordered_map<std::string, TimingEventType> event_types = {};
+    // Registered event types indexed by TimingEventType::id
+    std::vector<TimingEventType*> event_types_by_id;
 
     std::vector<std::shared_ptr<Timer>> timers;
     Timer* current_timer = nullptr;
@@ -311,6 +468,9 @@ private:
         ar& timers;
         ar& current_timer;
         if (Archive::is_loading::value) {
+            for (auto& timer : timers) {
+                timer->event_types = &event_types_by_id;
+            }
             event_queue_locked = true;
         }
     }
@@ -0,0 +1,142 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <ctime>
+#include <map>
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/guest_profiler.h"
+#include "core/hle/kernel/process.h"
+
+namespace Core {
+
+namespace {
+
+/// Returns a frame name for addr that is safe to use in a folded stack
+std::string Symbolize(const Kernel::CodeSet* codeset, VAddr addr) {
+    std::string name;
+    if (codeset) {
+        const auto& code = codeset->CodeSegment();
+        if (const auto* symbol = codeset->FindSymbol(addr)) {
+            name = symbol->name;
+        } else if (addr >= code.addr && addr - code.addr < code.size) {
+            name = fmt::format("{}+{:#x}", codeset->name, addr - code.addr);
+        }
+    }
+    if (name.empty()) {
+        name = fmt::format("{:#010x}", addr);
+    }
+    // Semicolons separate frames and spaces separate the count in the folded format
+    std::replace(name.begin(), name.end(), ';', ':');
+    std::replace(name.begin(), name.end(), ' ', '_');
+    return name;
+}
+
+} // Anonymous namespace
+
+std::size_t GuestProfiler::SampleKeyHash::operator()(const SampleKey& key) const noexcept {
+    return static_cast<std::size_t>(
+        Common::HashCombine(reinterpret_cast<std::uintptr_t>(key.page_table),
+                            (static_cast<u64>(key.pc) << 32) | key.lr));
+}
+
+GuestProfiler::GuestProfiler(System& system_) : system{system_} {
+    for (u32 i = 0; i < system.GetNumCores(); ++i) {
+        cores.push_back(&system.GetCore(i));
+    }
+    sampler_thread = std::thread([this] { SamplerThread(); });
+    LOG_INFO(Core, "Guest profiler started, sampling every {} us", SampleInterval.count());
+}
+
+GuestProfiler::~GuestProfiler() {
+    shutdown_event.Set();
+    sampler_thread.join();
+
+    std::string folded = GetFoldedStacks();
+    if (folded.empty()) {
+        return;
+    }
+
+    u64 program_id = 0;
+    if (const auto process = system.Kernel().GetCurrentProcess()) {
+        program_id = process->codeset->program_id;
+    }
+    const std::time_t t = std::time(nullptr);
+    const std::string& path = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
+    // %F Date format expanded is "%Y-%m-%d"
+    const std::string filename =
+        fmt::format("{}/{:%F-%H-%M-%S}_{:016X}.folded", path, *std::localtime(&t), program_id);
+    FileUtil::IOFile file(filename, "w");
+    if (file.WriteString(folded) != folded.size()) {
+        LOG_ERROR(Core, "Failed to write guest profile to {}", filename);
+        return;
+    }
+    LOG_INFO(Core, "Wrote guest profile to {}", filename);
+}
+
+void GuestProfiler::RecordSample(const Memory::PageTable* page_table, u32 pc, u32 lr) {
+    std::scoped_lock lock{samples_mutex};
+    samples[SampleKey{page_table, pc, lr}]++;
+}
+
+std::string GuestProfiler::GetFoldedStacks() const {
+    std::unordered_map<const Memory::PageTable*, const Kernel::Process*> processes;
+    for (const auto& process : system.Kernel().GetProcessList()) {
+        processes.emplace(process->vm_manager.page_table.get(), process.get());
+    }
+
+    // Different addresses within a function fold into the same stack
+    std::map<std::string, u64> stacks;
+    {
+        std::scoped_lock lock{samples_mutex};
+        for (const auto& [key, count] : samples) {
+            const auto iter = processes.find(key.page_table);
+            const Kernel::Process* process = iter != processes.end() ? iter->second : nullptr;
+            const Kernel::CodeSet* codeset = process ? process->codeset.get() : nullptr;
+
+            std::string stack = "unknown";
+            if (codeset) {
+                stack = codeset->name.empty() ? fmt::format("{:016X}", codeset->program_id)
+                                              : codeset->name;
+            }
+            std::replace(stack.begin(), stack.end(), ';', ':');
+            std::replace(stack.begin(), stack.end(), ' ', '_');
+
+            // The low bit of LR holds the Thumb state
+            const std::string function = Symbolize(codeset, key.pc);
+            const std::string caller = Symbolize(codeset, key.lr & ~1U);
+            if (caller != function) {
+                stack += ';' + caller;
+            }
+            stack += ';' + function;
+            stacks[stack] += count;
+        }
+    }
+
+    std::string folded;
+    for (const auto& [stack, count] : stacks) {
+        folded += fmt::format("{} {}\n", stack, count);
+    }
+    return folded;
+}
+
+void GuestProfiler::SamplerThread() {
+    Common::SetCurrentThreadName("GuestProfiler");
+
+    auto sample_time = std::chrono::steady_clock::now();
+    while (!shutdown_event.WaitUntil(sample_time)) {
+        sample_time += SampleInterval;
+        for (auto* core : cores) {
+            core->RequestProfilerSample();
+        }
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,77 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/thread.h"
+
+namespace Memory {
+struct PageTable;
+}
+
+namespace Core {
+
+class ARM_Interface;
+class System;
+
+/**
+ * Sampling profiler that attributes host time to guest code. A host thread periodically asks every
+ * CPU core for a sample, which the core answers the next time it stops by reporting its PC and LR.
+ * When the profiler is destroyed, the samples are symbolized against the loaded code sets and
+ * written to the log directory as folded stacks, which flamegraph tools can read directly.
+ */
+class GuestProfiler {
+public:
+    /// Interval between two samples of the same core, in host time
+    static constexpr std::chrono::microseconds SampleInterval{1000};
+
+    explicit GuestProfiler(System& system);
+    ~GuestProfiler();
+
+    /// Records a sample. Called by the cores when they answer a request, from any host thread.
+    void RecordSample(const Memory::PageTable* page_table, u32 pc, u32 lr);
+
+    /**
+     * Returns the samples as folded stacks: one "process;caller;function count" line per stack.
+     * The caller is derived from LR, so it is only exact for leaf functions.
+     */
+    std::string GetFoldedStacks() const;
+
+private:
+    struct SampleKey {
+        const Memory::PageTable* page_table;
+        u32 pc;
+        u32 lr;
+
+        bool operator==(const SampleKey& other) const {
+            return page_table == other.page_table && pc == other.pc && lr == other.lr;
+        }
+    };
+
+    struct SampleKeyHash {
+        std::size_t operator()(const SampleKey& key) const noexcept;
+    };
+
+    void SamplerThread();
+
+    System& system;
+    std::vector<ARM_Interface*> cores;
+
+    mutable std::mutex samples_mutex;
+    std::unordered_map<SampleKey, u64, SampleKeyHash> samples;
+
+    Common::Event shutdown_event;
+    // Note: always keep the thread declaration at the end so that other objects are initialized
+    // before this!
+    std::thread sampler_thread;
+};
+
+} // namespace Core
@@ -80,6 +80,21 @@ std::shared_ptr<CodeSet> KernelSystem::CreateCodeSet(std::string name, u64 progr
 CodeSet::CodeSet(KernelSystem& kernel) : Object(kernel) {}
 CodeSet::~CodeSet() {}
 
+const CodeSet::Symbol* CodeSet::FindSymbol(VAddr addr) const {
+    auto iter = std::upper_bound(
+        symbols.begin(), symbols.end(), addr,
+        [](VAddr value, const Symbol& symbol) { return value < symbol.addr; });
+    if (iter == symbols.begin()) {
+        return nullptr;
+    }
+    --iter;
+    // Symbols without a size extend up to the next symbol
+    if (iter->size != 0 && addr - iter->addr >= iter->size) {
+        return nullptr;
+    }
+    return &*iter;
+}
+
 template <class Archive>
 void CodeSet::serialize(Archive& ar, const unsigned int) {
     ar& boost::serialization::base_object<Object>(*this);
@@ -118,6 +118,19 @@ public:
     /// Title ID corresponding to the process
     u64 program_id;
 
+    struct Symbol {
+        VAddr addr;
+        u32 size;
+        std::string name;
+    };
+
+    /// Function symbols sorted by address, when the executable provides them. These are only used
+    /// for diagnostics, so they are not serialized.
+    std::vector<Symbol> symbols;
+
+    /// Returns the function symbol containing addr, or nullptr if there is none
+    const Symbol* FindSymbol(VAddr addr) const;
+
 private:
     friend class boost::serialization::access;
     template <class Archive>
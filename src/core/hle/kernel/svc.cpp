@@ -4,11 +4,13 @@
 
 #include <algorithm>
 #include <array>
+#include <utility>
 #include <fmt/format.h>
 #include "common/archives.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/scm_rev.h"
+#include "common/settings.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -364,6 +366,28 @@ private:
     u32 GetReg(std::size_t n);
     void SetReg(std::size_t n, u32 value);
 
+    // Idle loop detection
+
+    /// Number of consecutive polls from the same place, without any change to the guest state in
+    /// between, after which the thread is considered idle.
+    static constexpr u32 IdleSpinThreshold = 4;
+
+    /// Marks the current SVC as a poll that returned without making progress.
+    void MarkSpinning() {
+        spinning = true;
+    }
+
+    /// Fast-forwards the core to its next event if the current thread is only spinning.
+    void DetectIdleSpin();
+
+    bool spinning = false;
+    u32 spin_thread_id = 0;
+    u32 spin_pc = 0;
+    u32 spin_count = 0;
+    u64 spin_ticks = 0;
+    u64 spin_tick_delta = 0;
+    std::array<u32, 15> spin_regs{};
+
     // SVC interfaces
 
     Result ControlMemory(u32* out_addr, u32 addr0, u32 addr1, u32 size, u32 operation,
@@ -735,7 +759,10 @@ Result SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
               object->GetTypeName(), object->GetName(), nano_seconds);
 
     if (object->ShouldWait(thread)) {
-        R_UNLESS(nano_seconds != 0, ResultTimeout);
+        if (nano_seconds == 0) {
+            MarkSpinning();
+            return ResultTimeout;
+        }
 
         thread->wait_objects = {object};
         object->AddWaitingThread(SharedFrom(thread));
@@ -799,7 +826,10 @@ Result SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle_cou
 
         // If a timeout value of 0 was provided, just return the Timeout error code instead of
         // suspending the thread.
-        R_UNLESS(nano_seconds != 0, ResultTimeout);
+        if (nano_seconds == 0) {
+            MarkSpinning();
+            return ResultTimeout;
+        }
 
         // Put the thread to sleep
         thread->status = ThreadStatus::WaitSynchAll;
@@ -841,7 +871,10 @@ Result SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle_cou
 
         // If a timeout value of 0 was provided, just return the Timeout error code instead of
         // suspending the thread.
-        R_UNLESS(nano_seconds != 0, ResultTimeout);
+        if (nano_seconds == 0) {
+            MarkSpinning();
+            return ResultTimeout;
+        }
 
         // Put the thread to sleep
         thread->status = ThreadStatus::WaitSynchAny;
@@ -1525,6 +1558,7 @@ void SVC::SleepThread(s64 nanoseconds) {
     // Don't attempt to yield execution if there are no available threads to run,
     // this way we avoid a useless reschedule to the idle thread.
     if (nanoseconds == 0 && !thread_manager.HaveReadyThreads()) {
+        MarkSpinning();
         return;
     }
 
@@ -2253,6 +2287,48 @@ void SVC::CallSVC(u32 immediate) {
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function {}(..)", info->name);
         }
     }
+
+    if (std::exchange(spinning, false) && Settings::values.skip_idle_spin.GetValue()) {
+        DetectIdleSpin();
+    } else {
+        spin_count = 0;
+    }
+}
+
+void SVC::DetectIdleSpin() {
+    ThreadManager& thread_manager = kernel.GetCurrentThreadManager();
+    Core::ARM_Interface& core = system.GetRunningCore();
+    const u32 thread_id = thread_manager.GetCurrentThread()->GetThreadId();
+    const u32 pc = core.GetPC();
+
+    // The guest only counts as stuck if every iteration of its loop looks the same: it took as
+    // many ticks as the previous one and left the registers, which hold the polled values, alone.
+    std::array<u32, 15> regs;
+    for (std::size_t i = 0; i < regs.size(); ++i) {
+        regs[i] = core.GetReg(static_cast<int>(i));
+    }
+    const u64 ticks = core.GetTimer().GetTicks();
+    const u64 tick_delta = ticks - spin_ticks;
+    const bool unchanged = thread_id == spin_thread_id && pc == spin_pc &&
+                           tick_delta == spin_tick_delta && regs == spin_regs;
+    spin_thread_id = thread_id;
+    spin_pc = pc;
+    spin_ticks = ticks;
+    spin_tick_delta = tick_delta;
+    spin_regs = regs;
+    if (!unchanged) {
+        spin_count = 0;
+    }
+
+    // A thread that keeps polling from the same place while nothing else on this core can run
+    // will not observe any change until the next event fires, so skip ahead to it instead of
+    // spinning through the rest of the slice.
+    if (++spin_count < IdleSpinThreshold || thread_manager.HaveReadyThreads()) {
+        return;
+    }
+    LOG_TRACE(Kernel_SVC, "thread {} is idle spinning at pc={:08X}", thread_id, pc);
+    core.GetTimer().Idle();
+    system.PrepareReschedule();
 }
 
 SVC::SVC(Core::System& system) : system(system), kernel(system.Kernel()), memory(system.Memory()) {}
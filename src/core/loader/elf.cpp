@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <string>
@@ -82,6 +83,11 @@ enum ElfSectionFlags {
     SHF_MASKPROC = 0xF0000000,
 };
 
+// Symbol types
+#define STT_NOTYPE 0
+#define STT_OBJECT 1
+#define STT_FUNC 2
+
 // Segment types
 #define PT_NULL 0
 #define PT_LOAD 1
@@ -200,6 +206,7 @@ public:
         return (u32)(header->e_flags);
     }
     std::shared_ptr<CodeSet> LoadInto(Core::System& system, u32 vaddr);
+    void LoadSymbols(CodeSet& codeset, u32 base_addr) const;
 
     int GetNumSegments() const {
         return (int)(header->e_phnum);
@@ -335,11 +342,44 @@ std::shared_ptr<CodeSet> ElfReader::LoadInto(Core::System& system, u32 vaddr) {
     codeset->entrypoint = base_addr + header->e_entry;
     codeset->memory = std::move(program_image);
 
+    LoadSymbols(*codeset, base_addr);
+
     LOG_DEBUG(Loader, "Done loading.");
 
     return codeset;
 }
 
+void ElfReader::LoadSymbols(CodeSet& codeset, u32 base_addr) const {
+    for (int i = 0; i < GetNumSections(); i++) {
+        const Elf32_Shdr& section = sections[i];
+        if (section.sh_type != SHT_SYMTAB || section.sh_link >= header->e_shnum) {
+            continue;
+        }
+
+        const auto* symbols = reinterpret_cast<const Elf32_Sym*>(GetSectionDataPtr(i));
+        const auto* names = reinterpret_cast<const char*>(GetSectionDataPtr(section.sh_link));
+        if (!symbols || !names) {
+            continue;
+        }
+
+        const std::size_t count = section.sh_size / sizeof(Elf32_Sym);
+        for (std::size_t j = 0; j < count; j++) {
+            const Elf32_Sym& symbol = symbols[j];
+            if ((symbol.st_info & 0xF) != STT_FUNC || symbol.st_value == 0 ||
+                symbol.st_name >= sections[section.sh_link].sh_size) {
+                continue;
+            }
+            // The low bit of the value marks Thumb functions
+            codeset.symbols.push_back(CodeSet::Symbol{base_addr + (symbol.st_value & ~1U),
+                                                      symbol.st_size, names + symbol.st_name});
+        }
+    }
+
+    std::sort(codeset.symbols.begin(), codeset.symbols.end(),
+              [](const auto& a, const auto& b) { return a.addr < b.addr; });
+    LOG_DEBUG(Loader, "Loaded {} function symbols", codeset.symbols.size());
+}
+
 SectionID ElfReader::GetSectionByName(const char* name, int firstSection) const {
     for (int i = firstSection; i < header->e_shnum; i++) {
         const char* secname = GetSectionName(i);
@@ -4,6 +4,7 @@
 
 #include <array>
 #include <cstring>
+#include <optional>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include "audio_core/dsp_interface.h"
@@ -34,6 +35,9 @@ void PageTable::Clear() {
     pointers.raw.fill(nullptr);
     pointers.refs.fill(MemoryRef());
     attributes.fill(PageType::Unmapped);
+    if (fastmem_view) {
+        fastmem_view->Unmap(0, PAGE_TABLE_NUM_ENTRIES * CITRA_PAGE_SIZE);
+    }
 }
 
 class RasterizerCacheMarker {
@@ -86,11 +90,18 @@ private:
 
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time
-    // if they are std::array which would exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    // FCRAM, VRAM and the N3DS extra RAM share one host allocation, so that with fastmem a single
+    // view can mirror any of them into an emulated address space.
+    static constexpr std::size_t FCRAM_OFFSET = 0;
+    static constexpr std::size_t VRAM_OFFSET = FCRAM_OFFSET + Memory::FCRAM_N3DS_SIZE;
+    static constexpr std::size_t N3DS_EXTRA_RAM_OFFSET = VRAM_OFFSET + Memory::VRAM_SIZE;
+    static constexpr std::size_t HOST_MEMORY_SIZE =
+        N3DS_EXTRA_RAM_OFFSET + Memory::N3DS_EXTRA_RAM_SIZE;
+
+    Common::HostMemory host_memory;
+    u8* const fcram;
+    u8* const vram;
+    u8* const n3ds_extra_ram;
 
     Core::System& system;
     std::shared_ptr<PageTable> current_page_table = nullptr;
@@ -109,13 +120,13 @@ public:
     const u8* GetPtr(Region r) const {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram;
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram;
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram;
         default:
             UNREACHABLE();
         }
@@ -124,13 +135,13 @@ public:
     u8* GetPtr(Region r) {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram;
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram;
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram;
         default:
             UNREACHABLE();
         }
@@ -155,6 +166,59 @@ public:
         return system.GetRunningCore().GetPC();
     }
 
+    /// Returns the offset of the page into the host memory if it can be mapped in a fastmem view.
+    std::optional<std::size_t> GetFastmemOffset(const u8* page_pointer) const {
+        if (!page_pointer || !host_memory.Contains(page_pointer)) {
+            return std::nullopt;
+        }
+        const auto offset =
+            static_cast<std::size_t>(page_pointer - host_memory.BackingBasePointer());
+        if ((offset & CITRA_PAGE_MASK) != 0) {
+            return std::nullopt;
+        }
+        return offset;
+    }
+
+    /// Brings the fastmem view of the page table in sync with its pointers for the given pages.
+    void SyncFastmemView(PageTable& page_table, u32 first_page, u32 num_pages) {
+        if (!page_table.fastmem_view) {
+            return;
+        }
+        const auto& pointers = page_table.GetPointerArray();
+        const u32 end = first_page + num_pages;
+        u32 page = first_page;
+        while (page != end) {
+            const auto offset = GetFastmemOffset(pointers[page]);
+
+            // Coalesce runs of pages that are contiguous in the host memory into a single mapping
+            u32 run_end = page + 1;
+            while (run_end != end) {
+                const auto next = GetFastmemOffset(pointers[run_end]);
+                const bool contiguous =
+                    offset ? next == *offset + (run_end - page) * CITRA_PAGE_SIZE : !next;
+                if (!contiguous) {
+                    break;
+                }
+                ++run_end;
+            }
+
+            const std::size_t view_offset = static_cast<std::size_t>(page) * CITRA_PAGE_SIZE;
+            const std::size_t length = static_cast<std::size_t>(run_end - page) * CITRA_PAGE_SIZE;
+            if (offset) {
+                page_table.fastmem_view->Map(view_offset, *offset, length);
+            } else {
+                page_table.fastmem_view->Unmap(view_offset, length);
+            }
+            page = run_end;
+        }
+    }
+
+    void CreateFastmemView(PageTable& page_table) {
+        page_table.fastmem_view =
+            host_memory.CreateView(static_cast<std::size_t>(PAGE_TABLE_NUM_ENTRIES) *
+                                   CITRA_PAGE_SIZE);
+    }
+
     template <bool UNSAFE>
     void ReadBlockImpl(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
                        const std::size_t size) {
@@ -163,6 +227,7 @@ public:
         std::size_t remaining_size = size;
         std::size_t page_index = src_addr >> CITRA_PAGE_BITS;
         std::size_t page_offset = src_addr & CITRA_PAGE_MASK;
+        [[maybe_unused]] std::size_t flushed_end = 0;
 
         while (remaining_size > 0) {
             const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
@@ -188,8 +253,13 @@ public:
             }
             case PageType::RasterizerCachedMemory: {
                 if constexpr (!UNSAFE) {
-                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                                 FlushMode::Flush);
+                    if (size - remaining_size >= flushed_end) {
+                        const std::size_t run_size =
+                            RasterizerCachedRunSize(page_table, current_vaddr, remaining_size);
+                        RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(run_size),
+                                                     FlushMode::Flush);
+                        flushed_end = size - remaining_size + run_size;
+                    }
                 }
                 std::memcpy(dest_buffer, GetPointerForRasterizerCache(current_vaddr), copy_amount);
                 break;
@@ -212,6 +282,7 @@ public:
         std::size_t remaining_size = size;
         std::size_t page_index = dest_addr >> CITRA_PAGE_BITS;
         std::size_t page_offset = dest_addr & CITRA_PAGE_MASK;
+        [[maybe_unused]] std::size_t invalidated_end = 0;
 
         while (remaining_size > 0) {
             const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
@@ -236,8 +307,13 @@ public:
             }
             case PageType::RasterizerCachedMemory: {
                 if constexpr (!UNSAFE) {
-                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                                 FlushMode::Invalidate);
+                    if (size - remaining_size >= invalidated_end) {
+                        const std::size_t run_size =
+                            RasterizerCachedRunSize(page_table, current_vaddr, remaining_size);
+                        RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(run_size),
+                                                     FlushMode::Invalidate);
+                        invalidated_end = size - remaining_size + run_size;
+                    }
                 }
                 std::memcpy(GetPointerForRasterizerCache(current_vaddr), src_buffer, copy_amount);
                 break;
@@ -253,6 +329,120 @@ public:
         }
     }
 
+    /**
+     * Returns how many bytes starting at vaddr, up to max_size, lie in consecutive rasterizer
+     * cached pages. Block accesses use this to flush or invalidate a whole run at once instead of
+     * calling into the rasterizer once per page.
+     */
+    std::size_t RasterizerCachedRunSize(const PageTable& page_table, VAddr vaddr,
+                                        std::size_t max_size) const {
+        std::size_t page_index = vaddr >> CITRA_PAGE_BITS;
+        std::size_t run_size = std::min<std::size_t>(CITRA_PAGE_SIZE - (vaddr & CITRA_PAGE_MASK),
+                                                     max_size);
+        while (run_size < max_size && ++page_index < PAGE_TABLE_NUM_ENTRIES &&
+               page_table.attributes[page_index] == PageType::RasterizerCachedMemory) {
+            run_size = std::min<std::size_t>(run_size + CITRA_PAGE_SIZE, max_size);
+        }
+        return run_size;
+    }
+
+    // Slow path handlers for accesses that miss the page pointer table. They are looked up by the
+    // type of the accessed page, so Read/Write dispatch with a single indirect call.
+
+    template <typename T>
+    static T ReadUnmapped(Impl& impl, VAddr vaddr) {
+        // Custom Luma3ds mapping
+        if (vaddr & (1 << 31)) {
+            const PAddr paddr = (vaddr & ~(1 << 31));
+            if ((paddr & 0xF0000000) == Memory::FCRAM_PADDR) { // Check FCRAM region
+                T value;
+                std::memcpy(&value, impl.fcram + (paddr - Memory::FCRAM_PADDR), sizeof(T));
+                return value;
+            } else if ((paddr & 0xF0000000) == 0x10000000 &&
+                       paddr >= Memory::IO_AREA_PADDR) { // Check MMIO region
+                return impl.system.GPU().ReadReg(static_cast<VAddr>(paddr) -
+                                                 Memory::IO_AREA_PADDR + 0x1EC00000);
+            }
+        }
+
+        LOG_ERROR(HW_Memory, "unmapped Read{} @ 0x{:08X} at PC 0x{:08X}", sizeof(T) * 8, vaddr,
+                  impl.GetPC());
+        return 0;
+    }
+
+    template <typename T>
+    static T ReadMemory(Impl&, VAddr vaddr) {
+        ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
+        return T{};
+    }
+
+    template <typename T>
+    static T ReadRasterizerCached(Impl& impl, VAddr vaddr) {
+        impl.RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Flush);
+
+        T value;
+        std::memcpy(&value, impl.GetPointerForRasterizerCache(vaddr), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    static void WriteUnmapped(Impl& impl, VAddr vaddr, T data) {
+        // Custom Luma3ds mapping
+        if (vaddr & (1 << 31)) {
+            const PAddr paddr = (vaddr & ~(1 << 31));
+            if ((paddr & 0xF0000000) == Memory::FCRAM_PADDR) { // Check FCRAM region
+                std::memcpy(impl.fcram + (paddr - Memory::FCRAM_PADDR), &data, sizeof(T));
+                return;
+            } else if ((paddr & 0xF0000000) == 0x10000000 &&
+                       paddr >= Memory::IO_AREA_PADDR) { // Check MMIO region
+                ASSERT(sizeof(data) == sizeof(u32));
+                impl.system.GPU().WriteReg(static_cast<VAddr>(paddr) - Memory::IO_AREA_PADDR +
+                                               0x1EC00000,
+                                           static_cast<u32>(data));
+                return;
+            }
+        }
+
+        LOG_ERROR(HW_Memory, "unmapped Write{} 0x{:08X} @ 0x{:08X} at PC 0x{:08X}",
+                  sizeof(data) * 8, (u32)data, vaddr, impl.GetPC());
+    }
+
+    template <typename T>
+    static void WriteMemory(Impl&, VAddr vaddr, T) {
+        ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
+    }
+
+    template <typename T>
+    static void WriteRasterizerCached(Impl& impl, VAddr vaddr, T data) {
+        impl.RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
+        std::memcpy(impl.GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
+    }
+
+    static constexpr std::size_t NUM_PAGE_TYPES =
+        static_cast<std::size_t>(PageType::RasterizerCachedMemory) + 1;
+
+    template <typename T>
+    using ReadHandler = T (*)(Impl&, VAddr);
+
+    template <typename T>
+    using WriteHandler = void (*)(Impl&, VAddr, T);
+
+    /// Slow path read handlers, indexed by PageType
+    template <typename T>
+    static constexpr std::array<ReadHandler<T>, NUM_PAGE_TYPES> read_handlers{
+        &ReadUnmapped<T>,
+        &ReadMemory<T>,
+        &ReadRasterizerCached<T>,
+    };
+
+    /// Slow path write handlers, indexed by PageType
+    template <typename T>
+    static constexpr std::array<WriteHandler<T>, NUM_PAGE_TYPES> write_handlers{
+        &WriteUnmapped<T>,
+        &WriteMemory<T>,
+        &WriteRasterizerCached<T>,
+    };
+
     MemoryRef GetPointerForRasterizerCache(VAddr addr) const {
         if (addr >= LINEAR_HEAP_VADDR && addr < LINEAR_HEAP_VADDR_END) {
             return {fcram_mem, addr - LINEAR_HEAP_VADDR};
@@ -319,13 +509,19 @@ private:
     void serialize(Archive& ar, const unsigned int file_version) {
         bool save_n3ds_ram = Settings::values.is_new_3ds.GetValue();
         ar& save_n3ds_ram;
-        ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
+        ar& boost::serialization::make_binary_object(vram, Memory::VRAM_SIZE);
         ar& boost::serialization::make_binary_object(
-            fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
+            fcram, save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
         ar& boost::serialization::make_binary_object(
-            n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+            n3ds_extra_ram, save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
         ar& cache_marker;
         ar& page_table_list;
+        if (Archive::is_loading::value) {
+            for (auto& page_table : page_table_list) {
+                CreateFastmemView(*page_table);
+                SyncFastmemView(*page_table, 0, PAGE_TABLE_NUM_ENTRIES);
+            }
+        }
         // dsp is set from Core::System at startup
         ar& current_page_table;
         ar& fcram_mem;
@@ -363,7 +559,12 @@ private:
 };
 
 MemorySystem::Impl::Impl(Core::System& system_)
-    : system{system_}, fcram_mem(std::make_shared<BackingMemImpl<Region::FCRAM>>(*this)),
+    : host_memory{HOST_MEMORY_SIZE, Settings::values.use_cpu_jit.GetValue() &&
+                                        Settings::values.use_cpu_fastmem.GetValue()},
+      fcram{host_memory.BackingBasePointer() + FCRAM_OFFSET},
+      vram{host_memory.BackingBasePointer() + VRAM_OFFSET},
+      n3ds_extra_ram{host_memory.BackingBasePointer() + N3DS_EXTRA_RAM_OFFSET}, system{system_},
+      fcram_mem(std::make_shared<BackingMemImpl<Region::FCRAM>>(*this)),
       vram_mem(std::make_shared<BackingMemImpl<Region::VRAM>>(*this)),
       n3ds_extra_ram_mem(std::make_shared<BackingMemImpl<Region::N3DS>>(*this)),
       dsp_mem(std::make_shared<BackingMemImpl<Region::DSP>>(*this)) {}
@@ -400,6 +601,7 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
                                      FlushMode::FlushAndInvalidate);
     }
 
+    const u32 first_page = base;
     u32 end = base + size;
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
@@ -417,6 +619,8 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
         if (memory != nullptr && memory.GetSize() > CITRA_PAGE_SIZE)
             memory += CITRA_PAGE_SIZE;
     }
+
+    impl->SyncFastmemView(page_table, first_page, size);
 }
 
 void MemorySystem::MapMemoryRegion(PageTable& page_table, VAddr base, u32 size, MemoryRef target) {
@@ -437,6 +641,7 @@ MemoryRef MemorySystem::GetPointerForRasterizerCache(VAddr addr) const {
 }
 
 void MemorySystem::RegisterPageTable(std::shared_ptr<PageTable> page_table) {
+    impl->CreateFastmemView(*page_table);
     impl->page_table_list.push_back(page_table);
 }
 
@@ -457,42 +662,8 @@ T MemorySystem::Read(const VAddr vaddr) {
         return value;
     }
 
-    // Custom Luma3ds mapping
-    // Is there a more efficient way to do this?
-    if (vaddr & (1 << 31)) {
-        PAddr paddr = (vaddr & ~(1 << 31));
-        if ((paddr & 0xF0000000) == Memory::FCRAM_PADDR) { // Check FCRAM region
-            T value;
-            std::memcpy(&value, GetFCRAMPointer(paddr - Memory::FCRAM_PADDR), sizeof(T));
-            return value;
-        } else if ((paddr & 0xF0000000) == 0x10000000 &&
-                   paddr >= Memory::IO_AREA_PADDR) { // Check MMIO region
-            return impl->system.GPU().ReadReg(static_cast<VAddr>(paddr) - Memory::IO_AREA_PADDR +
-                                              0x1EC00000);
-        }
-    }
-
-    PageType type = impl->current_page_table->attributes[vaddr >> CITRA_PAGE_BITS];
-    switch (type) {
-    case PageType::Unmapped:
-        LOG_ERROR(HW_Memory, "unmapped Read{} @ 0x{:08X} at PC 0x{:08X}", sizeof(T) * 8, vaddr,
-                  impl->GetPC());
-        return 0;
-    case PageType::Memory:
-        ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
-        break;
-    case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Flush);
-
-        T value;
-        std::memcpy(&value, GetPointerForRasterizerCache(vaddr), sizeof(T));
-        return value;
-    }
-    default:
-        UNREACHABLE();
-    }
-
-    return T{};
+    const PageType type = impl->current_page_table->attributes[vaddr >> CITRA_PAGE_BITS];
+    return Impl::read_handlers<T>[static_cast<std::size_t>(type)](*impl, vaddr);
 }
 
 template <typename T>
@@ -504,40 +675,8 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
         return;
     }
 
-    // Custom Luma3ds mapping
-    // Is there a more efficient way to do this?
-    if (vaddr & (1 << 31)) {
-        PAddr paddr = (vaddr & ~(1 << 31));
-        if ((paddr & 0xF0000000) == Memory::FCRAM_PADDR) { // Check FCRAM region
-            std::memcpy(GetFCRAMPointer(paddr - Memory::FCRAM_PADDR), &data, sizeof(T));
-            return;
-        } else if ((paddr & 0xF0000000) == 0x10000000 &&
-                   paddr >= Memory::IO_AREA_PADDR) { // Check MMIO region
-            ASSERT(sizeof(data) == sizeof(u32));
-            impl->system.GPU().WriteReg(static_cast<VAddr>(paddr) - Memory::IO_AREA_PADDR +
-                                            0x1EC00000,
-                                        static_cast<u32>(data));
-            return;
-        }
-    }
-
-    PageType type = impl->current_page_table->attributes[vaddr >> CITRA_PAGE_BITS];
-    switch (type) {
-    case PageType::Unmapped:
-        LOG_ERROR(HW_Memory, "unmapped Write{} 0x{:08X} @ 0x{:08X} at PC 0x{:08X}",
-                  sizeof(data) * 8, (u32)data, vaddr, impl->GetPC());
-        return;
-    case PageType::Memory:
-        ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
-        break;
-    case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
-        std::memcpy(GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
-        break;
-    }
-    default:
-        UNREACHABLE();
-    }
+    const PageType type = impl->current_page_table->attributes[vaddr >> CITRA_PAGE_BITS];
+    Impl::write_handlers<T>[static_cast<std::size_t>(type)](*impl, vaddr, data);
 }
 
 template <typename T>
@@ -723,6 +862,26 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
     u32 num_pages = ((start + size - 1) >> CITRA_PAGE_BITS) - (start >> CITRA_PAGE_BITS) + 1;
     PAddr paddr = start;
 
+    // Runs of changed pages, so that the fastmem views are updated with one call per run
+    struct FastmemRun {
+        PageTable* page_table;
+        u32 first_page;
+        u32 num_pages;
+    };
+    std::vector<FastmemRun> fastmem_runs;
+    const auto add_fastmem_page = [&](PageTable& page_table, u32 page) {
+        if (!page_table.fastmem_view) {
+            return;
+        }
+        for (FastmemRun& run : fastmem_runs) {
+            if (run.page_table == &page_table && run.first_page + run.num_pages == page) {
+                ++run.num_pages;
+                return;
+            }
+        }
+        fastmem_runs.push_back({&page_table, page, 1});
+    };
+
     for (unsigned i = 0; i < num_pages; ++i, paddr += CITRA_PAGE_SIZE) {
         for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
             impl->cache_marker.Mark(vaddr, cached);
@@ -739,6 +898,7 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                     case PageType::Memory:
                         page_type = PageType::RasterizerCachedMemory;
                         page_table->pointers[vaddr >> CITRA_PAGE_BITS] = nullptr;
+                        add_fastmem_page(*page_table, vaddr >> CITRA_PAGE_BITS);
                         break;
                     default:
                         UNREACHABLE();
@@ -754,6 +914,7 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         page_type = PageType::Memory;
                         page_table->pointers[vaddr >> CITRA_PAGE_BITS] =
                             GetPointerForRasterizerCache(vaddr & ~CITRA_PAGE_MASK);
+                        add_fastmem_page(*page_table, vaddr >> CITRA_PAGE_BITS);
                         break;
                     }
                     default:
@@ -763,6 +924,10 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
             }
         }
     }
+
+    for (const FastmemRun& run : fastmem_runs) {
+        impl->SyncFastmemView(*run.page_table, run.first_page, run.num_pages);
+    }
 }
 
 u8 MemorySystem::Read8(const VAddr addr) {
@@ -840,6 +1005,7 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
     std::size_t remaining_size = size;
     std::size_t page_index = dest_addr >> CITRA_PAGE_BITS;
     std::size_t page_offset = dest_addr & CITRA_PAGE_MASK;
+    std::size_t invalidated_end = 0;
 
     while (remaining_size > 0) {
         const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
@@ -862,8 +1028,13 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Invalidate);
+            if (size - remaining_size >= invalidated_end) {
+                const std::size_t run_size =
+                    impl->RasterizerCachedRunSize(page_table, current_vaddr, remaining_size);
+                RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(run_size),
+                                             FlushMode::Invalidate);
+                invalidated_end = size - remaining_size + run_size;
+            }
             std::memset(GetPointerForRasterizerCache(current_vaddr), 0, copy_amount);
             break;
         }
@@ -889,6 +1060,7 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
     std::size_t remaining_size = size;
     std::size_t page_index = src_addr >> CITRA_PAGE_BITS;
     std::size_t page_offset = src_addr & CITRA_PAGE_MASK;
+    std::size_t flushed_end = 0;
 
     while (remaining_size > 0) {
         const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
@@ -911,8 +1083,13 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
+            if (size - remaining_size >= flushed_end) {
+                const std::size_t run_size =
+                    impl->RasterizerCachedRunSize(page_table, current_vaddr, remaining_size);
+                RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(run_size),
+                                             FlushMode::Flush);
+                flushed_end = size - remaining_size + run_size;
+            }
             WriteBlock(dest_process, dest_addr, GetPointerForRasterizerCache(current_vaddr),
                        copy_amount);
             break;
@@ -930,18 +1107,18 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
 }
 
 u32 MemorySystem::GetFCRAMOffset(const u8* pointer) const {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return static_cast<u32>(pointer - impl->fcram.get());
+    ASSERT(pointer >= impl->fcram && pointer <= impl->fcram + Memory::FCRAM_N3DS_SIZE);
+    return static_cast<u32>(pointer - impl->fcram);
 }
 
 u8* MemorySystem::GetFCRAMPointer(std::size_t offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 const u8* MemorySystem::GetFCRAMPointer(std::size_t offset) const {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
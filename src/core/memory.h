@@ -5,10 +5,12 @@
 #pragma once
 #include <array>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/vector.hpp>
 #include "common/common_types.h"
+#include "common/host_memory.h"
 #include "common/memory_ref.h"
 
 namespace Kernel {
@@ -96,6 +98,13 @@ struct PageTable {
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
 
+    /**
+     * Host view mirroring this address space, used by the JIT to access guest memory directly.
+     * Only pages of type `Memory` whose pointer lies in the emulated RAM are mapped in it, any
+     * other access faults and is handled by the regular memory callbacks. May be null.
+     */
+    std::unique_ptr<Common::HostMemory::View> fastmem_view;
+
     std::array<u8*, PAGE_TABLE_NUM_ENTRIES>& GetPointerArray() {
         return pointers.raw;
     }
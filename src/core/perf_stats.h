@@ -9,6 +9,7 @@
 #include <chrono>
 #include <cstddef>
 #include <mutex>
+#include <vector>
 #include "common/common_types.h"
 #include "common/thread.h"
 
@@ -49,6 +50,17 @@ public:
      */
     double GetMeanFrametime() const;
 
+    /**
+     * Returns the number of system frames that ended since the stats were created. Unlike the
+     * performance history, this keeps counting after the history is full.
+     */
+    u64 GetFrameCount() const;
+
+    /**
+     * Returns the recorded frametime values in milliseconds, excluding the boot frames.
+     */
+    std::vector<double> GetFrametimeHistory() const;
+
     /**
      * Gets the ratio between walltime and the emulated time of the previous system frame. This is
      * useful for scaling inputs or outputs moving between the two time domains.
@@ -62,6 +74,8 @@ private:
     u64 title_id{0};
     /// Current index for writing to the perf_history array
     std::size_t current_index{0};
+    /// Total number of system frames ended since creation
+    u64 total_system_frames{0};
     /// Stores an hour of historical frametime data useful for processing and tracking performance
     /// regressions with code changes.
     std::array<double, 216000> perf_history{};
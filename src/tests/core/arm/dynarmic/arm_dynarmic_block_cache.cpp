@@ -0,0 +1,141 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/arm/dynarmic/arm_dynarmic_block_cache.h"
+#include "core/memory.h"
+
+using Entry = Core::DynarmicBlockCache::Entry;
+
+namespace {
+
+constexpr u64 TestProgramId = 0x0004000000B10C00;
+constexpr u32 CodePageA = 0x00100000 >> Memory::CITRA_PAGE_BITS;
+constexpr u32 CodePageB = CodePageA + 1;
+
+constexpr u32 PageAddress(u32 page) {
+    return page << Memory::CITRA_PAGE_BITS;
+}
+
+/// Two pages of guest code, with the cache files kept in a temporary directory
+class BlockCacheFixture {
+public:
+    BlockCacheFixture() : page_table{std::make_unique<Memory::PageTable>()} {
+        page_table->Clear();
+        for (u32 i = 0; i < code.size(); ++i) {
+            code[i].assign(Memory::CITRA_PAGE_SIZE, static_cast<u8>(i + 1));
+            page_table->GetPointerArray()[CodePageA + i] = code[i].data();
+        }
+
+        cache_dir = (std::filesystem::temp_directory_path() / "citra_block_cache_test").string();
+        FileUtil::CreateFullPath(cache_dir + DIR_SEP "jit" DIR_SEP);
+        old_cache_dir = FileUtil::GetUserPath(FileUtil::UserPath::CacheDir);
+        FileUtil::UpdateUserPath(FileUtil::UserPath::CacheDir, cache_dir);
+    }
+
+    ~BlockCacheFixture() {
+        FileUtil::DeleteDirRecursively(cache_dir);
+        FileUtil::UpdateUserPath(FileUtil::UserPath::CacheDir, old_cache_dir);
+    }
+
+    std::unique_ptr<Core::DynarmicBlockCache> MakeCache() {
+        return std::make_unique<Core::DynarmicBlockCache>(*page_table, TestProgramId, 0);
+    }
+
+    std::unique_ptr<Memory::PageTable> page_table;
+    std::array<std::vector<u8>, 2> code;
+
+private:
+    std::string cache_dir;
+    std::string old_cache_dir;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("DynarmicBlockCache round-trips recorded entries", "[core][arm][block_cache]") {
+    BlockCacheFixture fixture;
+
+    const Entry arm_entry{PageAddress(CodePageA) + 0x10, 0x10, 0x00000000};
+    const Entry thumb_entry{PageAddress(CodePageA) + 0x22, 0x30, 0x03000000};
+    {
+        auto cache = fixture.MakeCache();
+        REQUIRE(!cache->IsReplayRequested());
+        cache->Record(arm_entry);
+        cache->Record(thumb_entry);
+
+        // Condition flags and cumulative FPSCR exception bits don't change how a block decodes
+        cache->Record({arm_entry.pc, arm_entry.cpsr | 0xF0000000, arm_entry.fpscr | 0xF000009F});
+        cache->Record({thumb_entry.pc, thumb_entry.cpsr | 0x08000000, thumb_entry.fpscr | 0x1});
+        cache->Save();
+    }
+
+    auto cache = fixture.MakeCache();
+    REQUIRE(cache->IsReplayRequested());
+    const auto entries = cache->TakeReplayableEntries();
+    REQUIRE((entries == std::vector<Entry>{arm_entry, thumb_entry}));
+    REQUIRE(!cache->IsReplayRequested());
+    REQUIRE(cache->TakeReplayableEntries().empty());
+}
+
+TEST_CASE("DynarmicBlockCache only replays pages that still match", "[core][arm][block_cache]") {
+    BlockCacheFixture fixture;
+
+    const Entry entry_a{PageAddress(CodePageA) + 0x40, 0x10, 0};
+    const Entry entry_b{PageAddress(CodePageB) + 0x80, 0x10, 0};
+    {
+        auto cache = fixture.MakeCache();
+        cache->Record(entry_a);
+        cache->Record(entry_b);
+    }
+
+    // The code of page B is not loaded yet when the cache is read back
+    fixture.code[1][0x80] ^= 0xFF;
+    auto cache = fixture.MakeCache();
+    REQUIRE(cache->TakeReplayableEntries() == std::vector<Entry>{entry_a});
+    REQUIRE(!cache->IsReplayRequested());
+
+    // Once the code is restored, the invalidation of its range requests another replay
+    fixture.code[1][0x80] ^= 0xFF;
+    cache->Invalidate(PageAddress(CodePageB), Memory::CITRA_PAGE_SIZE);
+    REQUIRE(cache->IsReplayRequested());
+    REQUIRE(cache->TakeReplayableEntries() == std::vector<Entry>{entry_b});
+}
+
+TEST_CASE("DynarmicBlockCache drops entries of invalidated code", "[core][arm][block_cache]") {
+    BlockCacheFixture fixture;
+
+    const Entry entry_a{PageAddress(CodePageA) + 0x40, 0x10, 0};
+    const Entry entry_b{PageAddress(CodePageB) + 0x80, 0x10, 0};
+    auto cache = fixture.MakeCache();
+    cache->Record(entry_a);
+    cache->Record(entry_b);
+
+    // Ranges whose code did not change keep their entries
+    cache->Invalidate(PageAddress(CodePageA), 2 * Memory::CITRA_PAGE_SIZE);
+    cache->InvalidateAll();
+
+    SECTION("InvalidateCacheRange") {
+        // The range InvalidateCacheRange gets for a patched instruction of page A
+        fixture.code[0][0x44] ^= 0xFF;
+        cache->Invalidate(PageAddress(CodePageA) + 0x44, 4);
+        fixture.code[0][0x44] ^= 0xFF;
+        cache->Save();
+        REQUIRE(fixture.MakeCache()->TakeReplayableEntries() == std::vector<Entry>{entry_b});
+    }
+
+    SECTION("ClearInstructionCache") {
+        fixture.code[1][0x10] ^= 0xFF;
+        cache->InvalidateAll();
+        fixture.code[1][0x10] ^= 0xFF;
+        cache->Save();
+        REQUIRE(fixture.MakeCache()->TakeReplayableEntries() == std::vector<Entry>{entry_a});
+    }
+}
@@ -0,0 +1,147 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/skyeye_common/armstate.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/memory.h"
+
+namespace {
+
+constexpr VAddr CODE_ADDRESS = 0x00100000;
+
+/**
+ * ARM code with unconditional branches the translator follows, a conditional loop it does not
+ * follow, and an interworking branch to Thumb code with a Thumb unconditional branch. The program
+ * ends in a Thumb branch to itself and adds up r0 on the way.
+ */
+constexpr std::array<std::pair<u32, u32>, 20> PROGRAM = {{
+    {0x00, 0xE3A00000}, // mov r0, #0
+    {0x04, 0xEA000001}, // b 0x10
+    {0x08, 0xE2800064}, // add r0, r0, #100
+    {0x0C, 0xE2800064}, // add r0, r0, #100
+    {0x10, 0xE2800001}, // add r0, r0, #1
+    {0x14, 0xEB000009}, // bl 0x40
+    {0x18, 0xE2800002}, // add r0, r0, #2
+    {0x1C, 0xE3A02003}, // mov r2, #3
+    {0x20, 0xE2522001}, // subs r2, r2, #1
+    {0x24, 0x1AFFFFFD}, // bne 0x20
+    {0x28, 0xE28F1051}, // add r1, pc, #0x51
+    {0x2C, 0xE12FFF11}, // bx r1
+    {0x30, 0xE2800064}, // add r0, r0, #100
+    {0x34, 0xE2800064}, // add r0, r0, #100
+    {0x40, 0xE2800004}, // add r0, r0, #4
+    {0x44, 0xE12FFF1E}, // bx lr
+    {0x80, 0xE0013008}, // adds r0, #8; b 0x88
+    {0x84, 0x30403040}, // adds r0, #64; adds r0, #64
+    {0x88, 0xE7FE3010}, // adds r0, #16; b 0x8A
+    {0x8C, 0x30403040}, // adds r0, #64; adds r0, #64
+}};
+constexpr u32 PROGRAM_RESULT = 31;
+/// Instructions executed until the program reaches its final loop
+constexpr u32 PROGRAM_LENGTH = 20;
+
+/// Runs guest code from a page of memory on the interpreter.
+class DynComFixture {
+public:
+    DynComFixture() : page_table{std::make_shared<Memory::PageTable>()} {
+        page_table->Clear();
+        page_table->GetPointerArray()[CODE_ADDRESS >> Memory::CITRA_PAGE_BITS] = code.data();
+        memory.SetCurrentPageTable(page_table);
+        for (const auto& [offset, instruction] : PROGRAM) {
+            WriteCode(offset, instruction);
+        }
+        cpu = std::make_unique<Core::ARM_DynCom>(system, memory, USER32MODE, 0, timer);
+    }
+
+    void WriteCode(u32 offset, u32 instruction) {
+        std::memcpy(code.data() + offset, &instruction, sizeof(instruction));
+    }
+
+    /// Moves the CPU to the start of the program
+    void Reset() {
+        for (int i = 0; i < 15; i++) {
+            cpu->SetReg(i, 0);
+        }
+        cpu->SetPC(CODE_ADDRESS);
+        cpu->SetCPSR(USER32MODE);
+    }
+
+    /// Runs the program from its start for the given number of instructions
+    void Run(u32 num_instructions) {
+        Reset();
+        timer->SetNextSlice(num_instructions);
+        cpu->Run();
+    }
+
+    /// Returns the registers the program changes
+    std::array<u32, 6> GetState() const {
+        return {cpu->GetPC(), cpu->GetCPSR(), cpu->GetReg(0),
+                cpu->GetReg(1), cpu->GetReg(2), cpu->GetReg(14)};
+    }
+
+    std::unique_ptr<Core::ARM_DynCom> cpu;
+
+private:
+    Core::System system;
+    Memory::MemorySystem memory{system};
+    std::shared_ptr<Memory::PageTable> page_table;
+    std::shared_ptr<Core::Timing::Timer> timer = std::make_shared<Core::Timing::Timer>();
+    std::vector<u8> code = std::vector<u8>(Memory::CITRA_PAGE_SIZE);
+};
+
+} // Anonymous namespace
+
+TEST_CASE("ARM_DynCom superblocks match single stepping", "[core][arm][dyncom]") {
+    DynComFixture fixture;
+
+    // Single stepping translates every instruction on its own, without following branches
+    std::vector<std::array<u32, 6>> steps;
+    fixture.Reset();
+    for (u32 i = 0; i < PROGRAM_LENGTH + 8; i++) {
+        fixture.cpu->Step();
+        steps.push_back(fixture.GetState());
+    }
+    REQUIRE(fixture.cpu->GetReg(0) == PROGRAM_RESULT);
+    fixture.cpu->ClearInstructionCache();
+
+    // Stopping after each instruction of the superblocks shows the state the steps went through.
+    // The blocks translated by earlier runs are chained together by the later ones.
+    for (u32 i = 0; i < steps.size(); i++) {
+        fixture.Run(i + 1);
+        REQUIRE(fixture.GetState() == steps[i]);
+    }
+}
+
+TEST_CASE("ARM_DynCom translates code again after InvalidateCacheRange", "[core][arm][dyncom]") {
+    DynComFixture fixture;
+    fixture.Run(PROGRAM_LENGTH);
+    REQUIRE(fixture.cpu->GetReg(0) == PROGRAM_RESULT);
+
+    // Patch the targets of a followed ARM branch and a followed Thumb branch, which were
+    // translated into the superblocks containing the branches
+    fixture.WriteCode(0x10, 0xE2800005); // add r0, r0, #5
+    fixture.WriteCode(0x88, 0xE7FE3020); // adds r0, #32; b 0x8A
+
+    // Without an invalidation the translated code keeps running
+    fixture.Run(PROGRAM_LENGTH);
+    REQUIRE(fixture.cpu->GetReg(0) == PROGRAM_RESULT);
+
+    fixture.cpu->InvalidateCacheRange(CODE_ADDRESS + 0x10, 4);
+    fixture.Run(PROGRAM_LENGTH);
+    REQUIRE(fixture.cpu->GetReg(0) == PROGRAM_RESULT + 4 + 16);
+
+    // Patching code back and forth is picked up each time
+    fixture.WriteCode(0x10, 0xE2800001); // add r0, r0, #1
+    fixture.cpu->InvalidateCacheRange(CODE_ADDRESS + 0x10, 4);
+    fixture.Run(PROGRAM_LENGTH);
+    REQUIRE(fixture.cpu->GetReg(0) == PROGRAM_RESULT + 16);
+}
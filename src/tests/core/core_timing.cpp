@@ -5,8 +5,11 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include <array>
+#include <atomic>
 #include <bitset>
 #include <string>
+#include <thread>
+#include <vector>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -196,4 +199,165 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(MAX_SLICE_LENGTH == timing.GetTimer(0)->GetDowncount());
 }
 
+TEST_CASE("CoreTiming[Unschedule]", "[core]") {
+    Core::Timing timing(1, 100);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+    Core::TimingEventType* cb_c = timing.RegisterEvent("callbackC", CallbackTemplate<2>);
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+
+    timing.ScheduleEvent(100, cb_a, CB_IDS[0], 0);
+    timing.ScheduleEvent(200, cb_b, CB_IDS[1], 0);
+    timing.ScheduleEvent(300, cb_b, CB_IDS[0], 0);
+    timing.ScheduleEvent(400, cb_c, CB_IDS[2], 0);
+    REQUIRE(100 == timing.GetTimer(0)->GetDowncount());
+
+    // Only the events matching both the type and the user data are removed
+    timing.UnscheduleEvent(cb_a, CB_IDS[0]);
+    timing.UnscheduleEvent(cb_b, CB_IDS[0]);
+    timing.UnscheduleEvent(cb_c, CB_IDS[0]);
+
+    AdvanceAndCheck(timing, 1, 200, 0, -100); // cb_b with CB_IDS[1]
+    AdvanceAndCheck(timing, 2, MAX_SLICE_LENGTH);
+}
+
+TEST_CASE("CoreTiming[FarFuture]", "[core]") {
+    Core::Timing timing(1, 100, 0);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+    Core::TimingEventType* cb_c = timing.RegisterEvent("callbackC", CallbackTemplate<2>);
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+
+    // Events far enough apart to land in different levels of the timing wheel and its overflow
+    constexpr s64 near_time = 1000;
+    constexpr s64 mid_time = 1LL << 27;
+    constexpr s64 far_time = 1LL << 41;
+    timing.ScheduleEvent(far_time, cb_c, CB_IDS[2], 0);
+    timing.ScheduleEvent(mid_time, cb_b, CB_IDS[1], 0);
+    timing.ScheduleEvent(near_time, cb_a, CB_IDS[0], 0);
+    REQUIRE(near_time == timing.GetTimer(0)->GetDowncount());
+
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH);
+    REQUIRE(mid_time - near_time == timing.GetTimer(0)->GetMaxSliceLength());
+
+    AdvanceAndCheck(timing, 1, MAX_SLICE_LENGTH, 0, MAX_SLICE_LENGTH - (mid_time - near_time));
+    REQUIRE(far_time - mid_time == timing.GetTimer(0)->GetMaxSliceLength());
+}
+
+namespace ThreadSafeTest {
+static std::atomic<u64> callbacks_ran{0};
+static u64 user_data_sum = 0;
+
+static void Callback(std::uintptr_t user_data, s64) {
+    callbacks_ran++;
+    user_data_sum += user_data;
+}
+} // namespace ThreadSafeTest
+
+TEST_CASE("CoreTiming[ThreadSafeSchedule]", "[core]") {
+    using namespace ThreadSafeTest;
+
+    Core::Timing timing(1, 100, 0);
+
+    Core::TimingEventType* cb = timing.RegisterEvent("callback", Callback);
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+
+    // Enough events to overflow the lock-free ring and take the fallback path
+    constexpr u64 num_threads = 4;
+    constexpr u64 events_per_thread = 1000;
+    std::vector<std::thread> threads;
+    for (u64 i = 0; i < num_threads; i++) {
+        threads.emplace_back([&timing, cb] {
+            for (u64 j = 1; j <= events_per_thread; j++) {
+                timing.ScheduleEvent(0, cb, j, 0, true);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    callbacks_ran = 0;
+    user_data_sum = 0;
+    for (int i = 0; i < 3; i++) {
+        timing.GetTimer(0)->AddTicks(timing.GetTimer(0)->GetDowncount());
+        timing.GetTimer(0)->Advance();
+        timing.GetTimer(0)->SetNextSlice();
+    }
+
+    REQUIRE(callbacks_ran == num_threads * events_per_thread);
+    REQUIRE(user_data_sum == num_threads * events_per_thread * (events_per_thread + 1) / 2);
+}
+
+TEST_CASE("CoreTiming[ParallelSlices]", "[core]") {
+    Core::Timing timing(2, 100, 0);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+
+    // Enter slice 0 on both cores
+    for (std::size_t core = 0; core < 2; core++) {
+        timing.GetTimer(core)->Advance();
+        timing.GetTimer(core)->SetNextSlice();
+    }
+
+    // Both cores run on their own thread, as with parallel CPU cores. Core 0 schedules an event
+    // that ends its slice early and makes core 1 end at the same tick, while core 1 is running.
+    constexpr s64 schedule_time = 500;
+    constexpr s64 event_time = 700;
+    auto timer0 = timing.GetTimer(0);
+    auto timer1 = timing.GetTimer(1);
+    std::atomic_bool slice_limited{false};
+    std::thread core0([&] {
+        while (timer0->GetDowncount() > 0) {
+            if (timer0->GetTicks() == schedule_time) {
+                timing.SetCurrentTimer(0);
+                timing.ScheduleEvent(event_time - schedule_time, cb_a, CB_IDS[0]);
+                REQUIRE(timer1->LimitSliceEnd(timer0->GetSliceEnd()));
+                slice_limited = true;
+            }
+            timer0->AddTicks(10);
+        }
+    });
+    std::thread core1([&] {
+        while (timer1->GetDowncount() > 0) {
+            // Don't run past the new slice end before core 0 gets to shorten the slice
+            if (timer1->GetTicks() >= event_time - 100) {
+                while (!slice_limited) {
+                    std::this_thread::yield();
+                }
+            }
+            timer1->AddTicks(1);
+        }
+    });
+
+    // Joining the threads is the barrier at the end of the slice
+    core0.join();
+    core1.join();
+    REQUIRE(event_time == timer0->GetTicks());
+    REQUIRE(event_time == timer1->GetTicks());
+
+    callbacks_ran_flags = 0;
+    expected_callback = CB_IDS[0];
+    lateness = 0;
+    for (std::size_t core = 0; core < 2; core++) {
+        timing.GetTimer(core)->Advance();
+        timing.GetTimer(core)->SetNextSlice();
+    }
+    REQUIRE(callbacks_ran_flags.test(0));
+    REQUIRE(event_time == timing.GetGlobalTicks());
+    REQUIRE(MAX_SLICE_LENGTH == timer0->GetDowncount());
+    REQUIRE(MAX_SLICE_LENGTH == timer1->GetDowncount());
+}
+
 // TODO: Add tests for multiple timers
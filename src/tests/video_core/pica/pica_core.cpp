@@ -0,0 +1,276 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <nihstro/inline_assembly.h>
+#include "common/settings.h"
+#include "core/core.h"
+#include "core/memory.h"
+#include "video_core/pica/output_vertex.h"
+#include "video_core/pica/pica_core.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/shader/shader_interpreter.h"
+
+namespace {
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+/// Large enough for the draw to be shaded in parallel chunks
+constexpr u32 NUM_INDICES = 3 * 1200;
+constexpr u32 NUM_VERTICES = 2048;
+constexpr u32 INDEX_OFFSET = 0x100000;
+constexpr u32 COMMAND_LIST_OFFSET = 0x200000;
+
+/// Records the position of every vertex of the triangles it receives.
+class RecordingRasterizer final : public VideoCore::RasterizerInterface {
+public:
+    void AddTriangle(const Pica::OutputVertex& v0, const Pica::OutputVertex& v1,
+                     const Pica::OutputVertex& v2) override {
+        positions.push_back(v0.pos);
+        positions.push_back(v1.pos);
+        positions.push_back(v2.pos);
+    }
+    void DrawTriangles() override {}
+    void NotifyPicaRegisterChanged(u32 id) override {}
+    void FlushAll() override {}
+    void FlushRegion(PAddr addr, u32 size) override {}
+    void InvalidateRegion(PAddr addr, u32 size) override {}
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+    void ClearAll(bool flush) override {}
+
+    std::vector<Common::Vec4<Pica::f24>> positions;
+};
+
+std::array<u32, 4> ToBits(const Common::Vec4<Pica::f24>& value) {
+    return {std::bit_cast<u32>(value.x.ToFloat32()), std::bit_cast<u32>(value.y.ToFloat32()),
+            std::bit_cast<u32>(value.z.ToFloat32()), std::bit_cast<u32>(value.w.ToFloat32())};
+}
+
+Common::Vec4<float> VertexData(u32 vertex) {
+    const float value = static_cast<float>(vertex);
+    return {value + 0.25f, value * 0.5f, -value, 1.0f};
+}
+
+/**
+ * Runs indexed draws through PicaCore. The vertex data, index buffer and command list live in
+ * FCRAM, one attribute holds the position, which the vertex shader writes to its first output.
+ */
+class DrawTest {
+public:
+    explicit DrawTest(std::initializer_list<nihstro::InlineAsm> code) {
+        pica = std::make_unique<Pica::PicaCore>(memory, nullptr, 0);
+        pica->BindRasterizer(&rasterizer);
+
+        const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+        for (Pica::ShaderSetup* setup : {&pica->vs_setup, &reference_setup}) {
+            std::transform(shbin.program.begin(), shbin.program.end(),
+                           setup->program_code.begin(), [](const auto& x) { return x.hex; });
+            std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                           setup->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+            setup->MarkProgramCodeDirty();
+            setup->MarkSwizzleDataDirty();
+        }
+
+        auto& regs = pica->regs.internal;
+        auto& attributes = regs.pipeline.vertex_attributes;
+        attributes.base_address.Assign(Memory::FCRAM_PADDR / 16);
+        attributes.format0.Assign(Pica::PipelineRegs::VertexAttributeFormat::FLOAT);
+        attributes.size0.Assign(3);
+        attributes.max_attribute_index.Assign(0);
+        attributes.attribute_loaders[0].data_offset.Assign(0);
+        attributes.attribute_loaders[0].comp0.Assign(0);
+        attributes.attribute_loaders[0].byte_count.Assign(sizeof(Common::Vec4<float>));
+        attributes.attribute_loaders[0].component_count.Assign(1);
+        regs.pipeline.index_array.offset.Assign(INDEX_OFFSET);
+
+        regs.vs.max_input_attribute_index.Assign(0);
+        regs.vs.output_mask.Assign(0b1);
+        regs.rasterizer.vs_output_total.Assign(1);
+        regs.rasterizer.vs_output_attributes[0].raw = 0x03020100;
+
+        for (u32 vertex = 0; vertex < NUM_VERTICES; ++vertex) {
+            const auto data = VertexData(vertex);
+            std::memcpy(GetPointer(vertex * sizeof(data)), &data, sizeof(data));
+        }
+    }
+
+    /// Draws the vertices with the given indices, returns the assembled vertex positions
+    template <typename T>
+    std::vector<Common::Vec4<Pica::f24>> Draw(std::span<const T> indices) {
+        auto& pipeline = pica->regs.internal.pipeline;
+        pipeline.index_array.format.Assign(sizeof(T) == 2 ? decltype(pipeline.index_array)::SHORT
+                                                          : decltype(pipeline.index_array)::BYTE);
+        pipeline.num_vertices = static_cast<u32>(indices.size());
+        std::memcpy(GetPointer(INDEX_OFFSET), indices.data(), indices.size_bytes());
+
+        // Write 1 to trigger_draw_indexed with all bytes enabled
+        const std::array<u32, 2> command_list = {
+            1, static_cast<u32>(PICA_REG_INDEX(pipeline.trigger_draw_indexed)) | (0xF << 16)};
+        std::memcpy(GetPointer(COMMAND_LIST_OFFSET), command_list.data(), sizeof(command_list));
+
+        rasterizer.positions.clear();
+        pica->ProcessCmdList(Memory::FCRAM_PADDR + COMMAND_LIST_OFFSET, sizeof(command_list));
+        return std::move(rasterizer.positions);
+    }
+
+    /**
+     * Shades the vertices one at a time on a single shader unit with the interpreter, with the
+     * circular vertex cache of 64 entries that the vertex loader used to search linearly.
+     */
+    template <typename T>
+    std::vector<Common::Vec4<Pica::f24>> ShadeInOrder(std::span<const T> indices) {
+        constexpr std::size_t VERTEX_CACHE_SIZE = 64;
+        std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
+        std::array<u32, VERTEX_CACHE_SIZE> vertex_cache_ids{};
+        std::array<Common::Vec4<Pica::f24>, VERTEX_CACHE_SIZE> vertex_cache{};
+        std::size_t vertex_cache_pos = 0;
+
+        Pica::Shader::InterpreterEngine interpreter;
+        interpreter.SetupBatch(reference_setup, 0);
+        const auto& config = pica->regs.internal.vs;
+
+        Pica::ShaderUnit shader_unit;
+        std::vector<Common::Vec4<Pica::f24>> positions;
+        for (const u32 vertex : indices) {
+            bool vertex_cache_hit = false;
+            for (std::size_t i = 0; i < VERTEX_CACHE_SIZE; ++i) {
+                if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
+                    positions.push_back(vertex_cache[i]);
+                    vertex_cache_hit = true;
+                    break;
+                }
+            }
+            if (vertex_cache_hit) {
+                continue;
+            }
+
+            const auto data = VertexData(vertex);
+            Pica::AttributeBuffer input{};
+            input[0] = {Pica::f24::FromFloat32(data.x), Pica::f24::FromFloat32(data.y),
+                        Pica::f24::FromFloat32(data.z), Pica::f24::FromFloat32(data.w)};
+            shader_unit.LoadInput(config, input);
+            interpreter.Run(reference_setup, shader_unit);
+
+            Pica::AttributeBuffer output{};
+            shader_unit.WriteOutput(config, output);
+            positions.push_back(output[0]);
+            vertex_cache[vertex_cache_pos] = output[0];
+            vertex_cache_valid[vertex_cache_pos] = true;
+            vertex_cache_ids[vertex_cache_pos] = vertex;
+            vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+        }
+        return positions;
+    }
+
+    template <typename T>
+    void RequireDrawMatchesInOrder(std::span<const T> indices) {
+        const auto positions = Draw(indices);
+        const auto expected = ShadeInOrder(indices);
+        REQUIRE(positions.size() == expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            REQUIRE(ToBits(positions[i]) == ToBits(expected[i]));
+        }
+    }
+
+    /// Sets the serial number of the next vertex PicaCore shades
+    void SetVertexSerial(u32 serial) {
+        pica->vertex_serial = serial;
+    }
+
+private:
+    u8* GetPointer(u32 offset) {
+        return memory.GetPhysicalPointer(Memory::FCRAM_PADDR + offset);
+    }
+
+    Core::System system;
+    Memory::MemorySystem memory{system};
+    RecordingRasterizer rasterizer;
+    std::unique_ptr<Pica::PicaCore> pica;
+    Pica::ShaderSetup reference_setup;
+};
+
+/// Indices that mostly revisit recent vertices, so that the draw has cache hits and misses
+template <typename T>
+std::vector<T> MakeIndices(u32 first_vertex = 0) {
+    constexpr u32 num_vertices = std::min<u32>(NUM_VERTICES, std::numeric_limits<T>::max() + 1);
+    std::vector<T> indices(NUM_INDICES);
+    u32 seed = 1;
+    for (u32 i = 0; i < NUM_INDICES; ++i) {
+        seed = seed * 1103515245 + 12345;
+        indices[i] = static_cast<T>((first_vertex + i / 2 + (seed >> 16) % 24) % num_vertices);
+    }
+    return indices;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("PicaCore shades large draws like a serial vertex loader",
+          "[video_core][pica][pica_core]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_temp_src = SourceRegister::MakeTemporary(0);
+    const auto sh_temp_dest = DestRegister::MakeTemporary(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+    const auto indices = MakeIndices<u16>();
+
+    // Shaded with the interpreter and the JIT
+    const bool use_shader_jit = Settings::values.use_shader_jit.GetValue();
+    for (const bool use_jit : {false, true}) {
+        Settings::values.use_shader_jit.SetValue(use_jit);
+
+        DrawTest isolated({
+            {OpCode::Id::MOV, sh_temp_dest, sh_input},
+            {OpCode::Id::ADD, sh_output, sh_input, sh_temp_src},
+            {OpCode::Id::END},
+        });
+        isolated.RequireDrawMatchesInOrder(std::span<const u16>{indices});
+
+        // Has to be shaded in order, as each vertex reads the temporary of the previous one
+        DrawTest reads_previous({
+            {OpCode::Id::ADD, sh_output, sh_input, sh_temp_src},
+            {OpCode::Id::MOV, sh_temp_dest, sh_input},
+            {OpCode::Id::END},
+        });
+        reads_previous.RequireDrawMatchesInOrder(std::span<const u16>{indices});
+    }
+    Settings::values.use_shader_jit.SetValue(use_shader_jit);
+}
+
+TEST_CASE("PicaCore vertex cache hits like a linear search", "[video_core][pica][pica_core]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+    const auto byte_indices = MakeIndices<u8>();
+    const auto short_indices = MakeIndices<u16>();
+    DrawTest test({
+        {OpCode::Id::MOV, sh_output, sh_input},
+        {OpCode::Id::END},
+    });
+
+    SECTION("8-bit and 16-bit indices") {
+        test.RequireDrawMatchesInOrder(std::span<const u8>{byte_indices});
+        test.RequireDrawMatchesInOrder(std::span<const u16>{short_indices});
+        test.RequireDrawMatchesInOrder(std::span<const u8>{byte_indices});
+    }
+
+    SECTION("serial number wrap") {
+        test.RequireDrawMatchesInOrder(std::span<const u16>{short_indices});
+
+        // Other vertices are shaded right below the wrap, then the serial numbers start over and
+        // must not match the vertices the first draw left in the cache.
+        const auto high_indices = MakeIndices<u16>(NUM_VERTICES / 2);
+        test.SetVertexSerial(std::numeric_limits<u32>::max() - NUM_INDICES);
+        test.RequireDrawMatchesInOrder(std::span<const u16>{high_indices}.first(600));
+        test.RequireDrawMatchesInOrder(std::span<const u16>{short_indices});
+        test.RequireDrawMatchesInOrder(std::span<const u8>{byte_indices});
+    }
+}
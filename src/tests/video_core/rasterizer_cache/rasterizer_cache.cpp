@@ -0,0 +1,298 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <span>
+#include <tuple>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/scope_exit.h"
+#include "common/settings.h"
+#include "core/core.h"
+#include "core/frontend/emu_window.h"
+#include "core/frontend/image_interface.h"
+#include "core/memory.h"
+#include "tests/video_core/rasterizer_cache/surface_helpers.h"
+#include "video_core/custom_textures/custom_tex_manager.h"
+#include "video_core/pica/regs_internal.h"
+#include "video_core/renderer_base.h"
+#include "video_core/renderer_software/sw_texture_runtime.h"
+
+using namespace VideoCore;
+using VideoCore::Test::MakeTiledSurface;
+
+namespace {
+
+class NullWindow final : public Frontend::EmuWindow {
+public:
+    void PollEvents() override {}
+};
+
+class NullRenderer final : public RendererBase {
+public:
+    explicit NullRenderer(Core::System& system, Frontend::EmuWindow& window)
+        : RendererBase{system, window, nullptr} {}
+
+    RasterizerInterface* Rasterizer() override {
+        return nullptr;
+    }
+
+    void SwapBuffers() override {}
+
+    void TryPresent(int timeout_ms, bool is_secondary) override {}
+};
+
+/// Rasterizer cache backed by the CPU texture runtime, along with everything it depends on
+struct HeadlessCache {
+    HeadlessCache() {
+        system.RegisterImageInterface(std::make_shared<Frontend::ImageInterface>());
+        custom_tex_manager = std::make_unique<CustomTexManager>(system);
+        cache = std::make_unique<SwRenderer::RasterizerCache>(memory, *custom_tex_manager, runtime,
+                                                              regs, renderer);
+    }
+
+    Core::System system;
+    Memory::MemorySystem memory{system};
+    NullWindow window;
+    NullRenderer renderer{system, window};
+    Pica::RegsInternal regs{};
+    SwRenderer::TextureRuntime runtime;
+    std::unique_ptr<CustomTexManager> custom_tex_manager;
+    std::unique_ptr<SwRenderer::RasterizerCache> cache;
+};
+
+std::vector<u8> WriteRandomData(Memory::MemorySystem& memory, const SurfaceParams& params) {
+    std::mt19937 rng{params.addr};
+    std::vector<u8> data(params.size);
+    for (u8& byte : data) {
+        byte = static_cast<u8>(rng());
+    }
+    std::memcpy(memory.GetPhysicalPointer(params.addr), data.data(), data.size());
+    return data;
+}
+
+std::vector<u8> ReadData(Memory::MemorySystem& memory, const SurfaceParams& params) {
+    const u8* pointer = memory.GetPhysicalPointer(params.addr);
+    return std::vector<u8>(pointer, pointer + params.size);
+}
+
+/// A request made to the rasterizer cache, replayed to measure the cache on its own
+struct SurfaceRequest {
+    enum class Type {
+        Get,        ///< Looks up the surface, loading it from memory if needed
+        Draw,       ///< Marks the surface as written by the GPU
+        Flush,      ///< Writes the surface region back to memory
+        Invalidate, ///< Discards the cached contents of the region, as a CPU write would
+    };
+
+    Type type;
+    SurfaceParams params;
+};
+
+void Replay(SwRenderer::RasterizerCache& cache, std::span<const SurfaceRequest> trace) {
+    for (const SurfaceRequest& request : trace) {
+        const SurfaceParams& params = request.params;
+        switch (request.type) {
+        case SurfaceRequest::Type::Get:
+            cache.GetSurface(params, ScaleMatch::Ignore, true);
+            break;
+        case SurfaceRequest::Type::Draw:
+            cache.InvalidateRegion(params.addr, params.size,
+                                   cache.GetSurface(params, ScaleMatch::Ignore, true));
+            break;
+        case SurfaceRequest::Type::Flush:
+            cache.FlushRegion(params.addr, params.size);
+            break;
+        case SurfaceRequest::Type::Invalidate:
+            cache.InvalidateRegion(params.addr, params.size);
+            break;
+        }
+    }
+}
+
+/**
+ * Builds the requests of a frame that renders to a few targets in VRAM while sampling textures
+ * from FCRAM. Some of the textures are rewritten by the CPU every frame and the color targets
+ * are flushed as a display transfer would.
+ */
+std::vector<SurfaceRequest> MakeFrameTrace(u32 num_targets, u32 num_textures) {
+    using Type = SurfaceRequest::Type;
+    std::vector<SurfaceRequest> trace;
+
+    std::vector<SurfaceParams> textures;
+    PAddr texture_addr = Memory::FCRAM_PADDR;
+    for (u32 i = 0; i < num_textures; i++) {
+        const PixelFormat format = i % 2 ? PixelFormat::ETC1 : PixelFormat::RGBA4;
+        const u32 size = 64 << (i % 3);
+        textures.push_back(MakeTiledSurface(texture_addr, format, size, size));
+        texture_addr += textures.back().size;
+    }
+
+    PAddr target_addr = Memory::VRAM_PADDR;
+    for (u32 i = 0; i < num_targets; i++) {
+        const SurfaceParams color = MakeTiledSurface(target_addr, PixelFormat::RGBA8, 240, 400);
+        const SurfaceParams depth = MakeTiledSurface(color.end, PixelFormat::D24S8, 240, 400);
+        target_addr = depth.end;
+
+        for (u32 j = 0; j < num_textures; j++) {
+            trace.push_back({Type::Get, textures[(i * 3 + j) % num_textures]});
+        }
+        trace.push_back({Type::Draw, color});
+        trace.push_back({Type::Draw, depth});
+        trace.push_back({Type::Flush, color});
+    }
+    for (u32 i = 0; i < num_textures; i += 4) {
+        trace.push_back({Type::Invalidate, textures[i]});
+    }
+    return trace;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RasterizerCache flushes surfaces written by the GPU", "[video_core][rasterizer_cache]") {
+    HeadlessCache headless;
+    auto& memory = headless.memory;
+    auto& cache = *headless.cache;
+
+    PAddr addr = Memory::VRAM_PADDR;
+    for (const PixelFormat format : {PixelFormat::RGBA8, PixelFormat::RGB8, PixelFormat::RGB565,
+                                     PixelFormat::D16, PixelFormat::D24, PixelFormat::D24S8}) {
+        const SurfaceParams params = MakeTiledSurface(addr, format, 128, 64);
+        addr = params.end;
+
+        const std::vector<u8> expected = WriteRandomData(memory, params);
+        const SurfaceId surface_id = cache.GetSurface(params, ScaleMatch::Ignore, true);
+        REQUIRE(surface_id);
+        cache.InvalidateRegion(params.addr, params.size, surface_id);
+
+        std::memset(memory.GetPhysicalPointer(params.addr), 0, params.size);
+        cache.FlushRegion(params.addr, params.size);
+        INFO(fmt::format("format = {}", PixelFormatAsString(format)));
+        REQUIRE(ReadData(memory, params) == expected);
+    }
+}
+
+TEST_CASE("RasterizerCache copies between overlapping surfaces", "[video_core][rasterizer_cache]") {
+    HeadlessCache headless;
+    auto& memory = headless.memory;
+    auto& cache = *headless.cache;
+
+    const SurfaceParams full = MakeTiledSurface(Memory::VRAM_PADDR, PixelFormat::RGBA8, 64, 64);
+    const SurfaceParams half =
+        MakeTiledSurface(full.addr + full.size / 2, PixelFormat::RGBA8, 64, 32);
+
+    const std::vector<u8> full_data = WriteRandomData(memory, full);
+    cache.InvalidateRegion(full.addr, full.size, cache.GetSurface(full, ScaleMatch::Ignore, true));
+    std::memset(memory.GetPhysicalPointer(full.addr), 0, full.size);
+
+    // The second surface is validated with a copy from the first one, as memory is stale
+    const SurfaceId half_id = cache.GetSurface(half, ScaleMatch::Ignore, true);
+    cache.InvalidateRegion(half.addr, half.size, half_id);
+    cache.FlushRegion(half.addr, half.size);
+
+    const std::vector<u8> expected(full_data.begin() + full.size / 2, full_data.end());
+    REQUIRE(ReadData(memory, half) == expected);
+}
+
+TEST_CASE("RasterizerCache shares uploads of identical data", "[video_core][rasterizer_cache]") {
+    Settings::values.deduplicate_surfaces = true;
+    SCOPE_EXIT({ Settings::values.deduplicate_surfaces = false; });
+
+    HeadlessCache headless;
+    auto& memory = headless.memory;
+    auto& cache = *headless.cache;
+
+    const SurfaceParams first = MakeTiledSurface(Memory::FCRAM_PADDR, PixelFormat::RGBA8, 64, 64);
+    const SurfaceParams second = MakeTiledSurface(first.end, PixelFormat::RGBA8, 64, 64);
+    const SurfaceParams third = MakeTiledSurface(second.end, PixelFormat::RGBA8, 64, 64);
+
+    const std::vector<u8> data = WriteRandomData(memory, first);
+    std::memcpy(memory.GetPhysicalPointer(second.addr), data.data(), data.size());
+    std::memcpy(memory.GetPhysicalPointer(third.addr), data.data(), data.size());
+    cache.GetSurface(first, ScaleMatch::Ignore, true);
+    const SurfaceId second_id = cache.GetSurface(second, ScaleMatch::Ignore, true);
+
+    // Once the first surface is rewritten the third one must not be copied from it
+    const std::vector<u8> new_data(data.rbegin(), data.rend());
+    std::memcpy(memory.GetPhysicalPointer(first.addr), new_data.data(), new_data.size());
+    cache.InvalidateRegion(first.addr, first.size);
+    const SurfaceId first_id = cache.GetSurface(first, ScaleMatch::Ignore, true);
+    const SurfaceId third_id = cache.GetSurface(third, ScaleMatch::Ignore, true);
+
+    // Only the second surface was copied, the others were uploaded
+    REQUIRE(headless.runtime.NumCopies() == 1);
+
+    for (const auto& [params, surface_id, expected] :
+         {std::tuple{first, first_id, new_data}, std::tuple{second, second_id, data},
+          std::tuple{third, third_id, data}}) {
+        cache.InvalidateRegion(params.addr, params.size, surface_id);
+        std::memset(memory.GetPhysicalPointer(params.addr), 0, params.size);
+        cache.FlushRegion(params.addr, params.size);
+        REQUIRE(ReadData(memory, params) == expected);
+    }
+}
+
+TEST_CASE("RasterizerCache flushes from downloads started earlier",
+          "[video_core][rasterizer_cache]") {
+    Settings::values.async_surface_downloads = true;
+    SCOPE_EXIT({ Settings::values.async_surface_downloads = false; });
+
+    HeadlessCache headless;
+    auto& memory = headless.memory;
+    auto& cache = *headless.cache;
+
+    const SurfaceParams first = MakeTiledSurface(Memory::VRAM_PADDR, PixelFormat::RGBA8, 128, 64);
+    const SurfaceParams second = MakeTiledSurface(first.end, PixelFormat::RGB565, 128, 64);
+    const std::vector<u8> first_data = WriteRandomData(memory, first);
+    const std::vector<u8> second_data = WriteRandomData(memory, second);
+    for (const SurfaceParams& params : {first, second}) {
+        cache.InvalidateRegion(params.addr, params.size,
+                               cache.GetSurface(params, ScaleMatch::Ignore, true));
+    }
+    cache.StartDownloads(first.addr, second.end - first.addr);
+
+    // The second surface is rewritten after its download started, so it is downloaded again
+    const std::vector<u8> new_data(second_data.rbegin(), second_data.rend());
+    std::memcpy(memory.GetPhysicalPointer(second.addr), new_data.data(), new_data.size());
+    cache.InvalidateRegion(second.addr, second.size);
+    cache.InvalidateRegion(second.addr, second.size,
+                           cache.GetSurface(second, ScaleMatch::Ignore, true));
+    std::memset(memory.GetPhysicalPointer(first.addr), 0, second.end - first.addr);
+
+    // Only the requested part of the pending download is written back
+    const u32 offset = 1024;
+    const u32 size = 2048;
+    std::vector<u8> partial_data(first.size);
+    std::copy_n(first_data.begin() + offset, size, partial_data.begin() + offset);
+    cache.FlushRegion(first.addr + offset, size);
+    REQUIRE(ReadData(memory, first) == partial_data);
+    REQUIRE(headless.runtime.NumDownloads() == 0);
+
+    // The first surface is written back from its pending download, only the second one waits
+    cache.FlushRegion(first.addr, second.end - first.addr);
+    REQUIRE(ReadData(memory, first) == first_data);
+    REQUIRE(ReadData(memory, second) == new_data);
+    REQUIRE(headless.runtime.NumDownloads() == 1);
+}
+
+TEST_CASE("RasterizerCache benchmark", "[.][benchmark]") {
+    HeadlessCache headless;
+    auto& cache = *headless.cache;
+
+    for (const u32 num_textures : {16U, 256U, 2048U}) {
+        const std::vector<SurfaceRequest> trace = MakeFrameTrace(4, num_textures);
+        Replay(cache, trace);
+        BENCHMARK(fmt::format("Replay frame with {} textures", num_textures)) {
+            Replay(cache, trace);
+            cache.TickFrame();
+            return trace.size();
+        };
+        cache.ClearAll(false);
+    }
+}
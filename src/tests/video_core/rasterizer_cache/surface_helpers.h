@@ -0,0 +1,23 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "video_core/rasterizer_cache/surface_params.h"
+
+namespace VideoCore::Test {
+
+/// Returns the parameters of a tiled surface without mipmaps at addr
+inline SurfaceParams MakeTiledSurface(PAddr addr, PixelFormat format, u32 width, u32 height) {
+    SurfaceParams params;
+    params.addr = addr;
+    params.width = width;
+    params.height = height;
+    params.is_tiled = true;
+    params.pixel_format = format;
+    params.UpdateParams();
+    return params;
+}
+
+} // namespace VideoCore::Test
@@ -0,0 +1,74 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/rasterizer_cache/surface_page_table.h"
+
+using namespace VideoCore;
+
+namespace {
+
+using Region = std::pair<PAddr, u32>;
+
+constexpr PAddr BASE_ADDR = 0x18000000;
+constexpr u32 MEMORY_PAGE_SIZE = 1U << SurfacePageTable::MEMORY_PAGE_BITS;
+
+} // Anonymous namespace
+
+TEST_CASE("SurfacePageTable reports cached memory pages", "[video_core][rasterizer_cache]") {
+    auto table = std::make_unique<SurfacePageTable>();
+    std::vector<Region> cached;
+    std::vector<Region> uncached;
+    const auto update = [&](PAddr addr, u32 size, int delta) {
+        table->UpdateCachedCount(addr, size, delta, [&](PAddr run_addr, u32 run_size, bool now) {
+            (now ? cached : uncached).emplace_back(run_addr, run_size);
+        });
+    };
+
+    // Overlapping regions only report the pages that change state
+    update(BASE_ADDR + 0x100, 2 * MEMORY_PAGE_SIZE, 1);
+    update(BASE_ADDR + MEMORY_PAGE_SIZE, 3 * MEMORY_PAGE_SIZE, 1);
+    const std::vector<Region> expected_cached = {
+        {BASE_ADDR, 3 * MEMORY_PAGE_SIZE},
+        {BASE_ADDR + 3 * MEMORY_PAGE_SIZE, MEMORY_PAGE_SIZE},
+    };
+    REQUIRE(cached == expected_cached);
+
+    update(BASE_ADDR + 0x100, 2 * MEMORY_PAGE_SIZE, -1);
+    const std::vector<Region> expected_uncached = {{BASE_ADDR, MEMORY_PAGE_SIZE}};
+    REQUIRE(uncached == expected_uncached);
+
+    // Clearing reports the pages still covered by a surface
+    auto& surfaces = (*table)[BASE_ADDR >> SurfacePageTable::PAGE_BITS];
+    surfaces.push_back(SurfaceId{2});
+    std::vector<Region> cleared;
+    table->Clear([&](PAddr addr, u32 size) { cleared.emplace_back(addr, size); });
+    const std::vector<Region> expected_cleared = {
+        {BASE_ADDR + MEMORY_PAGE_SIZE, 3 * MEMORY_PAGE_SIZE},
+    };
+    REQUIRE(cleared == expected_cleared);
+    REQUIRE(surfaces.empty());
+}
+
+TEST_CASE("SurfacePageTable tracks dirty memory pages", "[video_core][rasterizer_cache]") {
+    auto table = std::make_unique<SurfacePageTable>();
+    REQUIRE(!table->IsDirty(0, 0xFFFFFFFF));
+
+    table->MarkDirty(BASE_ADDR + 0x10, 0x20);
+    REQUIRE(table->IsDirty(BASE_ADDR + MEMORY_PAGE_SIZE - 1, 1));
+    REQUIRE(!table->IsDirty(BASE_ADDR + MEMORY_PAGE_SIZE, 0x100000));
+    REQUIRE(table->IsDirty(0, 0xFFFFFFFF));
+
+    // Partially covered pages stay dirty if the callback finds GPU written data left in them
+    table->MarkDirty(BASE_ADDR + MEMORY_PAGE_SIZE, 2 * MEMORY_PAGE_SIZE);
+    table->UnmarkDirty(BASE_ADDR + 0x20, 2 * MEMORY_PAGE_SIZE, [](PAddr addr, u32 size) {
+        return addr == BASE_ADDR;
+    });
+    REQUIRE(table->IsDirty(BASE_ADDR, MEMORY_PAGE_SIZE));
+    REQUIRE(!table->IsDirty(BASE_ADDR + MEMORY_PAGE_SIZE, MEMORY_PAGE_SIZE));
+    REQUIRE(!table->IsDirty(BASE_ADDR + 2 * MEMORY_PAGE_SIZE, MEMORY_PAGE_SIZE));
+}
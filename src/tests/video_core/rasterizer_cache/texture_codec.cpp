@@ -0,0 +1,257 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <utility>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "video_core/rasterizer_cache/surface_params.h"
+#include "video_core/rasterizer_cache/texture_codec.h"
+#include "video_core/rasterizer_cache/utils.h"
+#include "tests/video_core/rasterizer_cache/surface_helpers.h"
+
+using namespace VideoCore;
+
+namespace {
+
+constexpr PAddr SURFACE_ADDR = 0x18000000;
+
+SurfaceParams MakeTiledSurface(PixelFormat format, u32 width, u32 height) {
+    return Test::MakeTiledSurface(SURFACE_ADDR, format, width, height);
+}
+
+std::vector<u8> MakeRandomData(std::size_t size) {
+    std::mt19937 rng{1234};
+    std::vector<u8> data(size);
+    for (u8& byte : data) {
+        byte = static_cast<u8>(rng());
+    }
+    return data;
+}
+
+u32 LinearBytesPerPixel(PixelFormat format, bool converted) {
+    return converted ? 4 : GetFormatBytesPerPixel(format);
+}
+
+using ReferenceFunc = void (*)(u32 width, u32 height, std::span<u8> linear_buffer,
+                               std::span<u8> tiled_buffer);
+
+/**
+ * Converts a whole surface between linear and morton tiled layouts one pixel at a time, the way
+ * MortonCopy did before tile rows were converted in bulk.
+ */
+template <bool morton_to_linear, PixelFormat format, bool converted>
+void ReferenceMortonCopy(u32 width, u32 height, std::span<u8> linear_buffer,
+                         std::span<u8> tiled_buffer) {
+    constexpr u32 bytes_per_pixel = GetFormatBpp(format) / 8;
+    constexpr u32 linear_bytes_per_pixel = converted ? 4 : GetFormatBytesPerPixel(format);
+    constexpr u32 tile_size = GetFormatBpp(format) * 64 / 8;
+    constexpr bool is_compressed = format == PixelFormat::ETC1 || format == PixelFormat::ETC1A4;
+    constexpr bool is_4bit = format == PixelFormat::I4 || format == PixelFormat::A4;
+
+    u8* tile = tiled_buffer.data();
+    for (u32 tile_y = 0; tile_y < height; tile_y += 8) {
+        for (u32 tile_x = 0; tile_x < width; tile_x += 8, tile += tile_size) {
+            for (u32 y = 0; y < 8; y++) {
+                for (u32 x = 0; x < 8; x++) {
+                    u8* linear_pixel = linear_buffer.data() +
+                                       ((height - 1 - tile_y - y) * width + tile_x + x) *
+                                           linear_bytes_per_pixel;
+                    u8* tiled_pixel = tile + MortonInterleave(x, y) * bytes_per_pixel;
+                    if constexpr (morton_to_linear && is_compressed) {
+                        DecodePixelETC1<format>(x, y, tile, linear_pixel);
+                    } else if constexpr (morton_to_linear && is_4bit) {
+                        DecodePixel4<format>(x, y, tile, linear_pixel);
+                    } else if constexpr (morton_to_linear) {
+                        DecodePixel<format, converted>(tiled_pixel, linear_pixel);
+                    } else if constexpr (is_4bit) {
+                        EncodePixel4<format>(x, y, linear_pixel, tile);
+                    } else {
+                        EncodePixel<format, converted>(linear_pixel, tiled_pixel);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <bool morton_to_linear, bool converted, std::size_t... indices>
+constexpr std::array<ReferenceFunc, PIXEL_FORMAT_COUNT> MakeReferenceTable(
+    std::index_sequence<indices...>) {
+    return {[] {
+        constexpr auto format = static_cast<PixelFormat>(indices);
+        if constexpr (GetFormatType(format) == SurfaceType::Invalid) {
+            return ReferenceFunc{nullptr};
+        } else {
+            return ReferenceFunc{ReferenceMortonCopy<morton_to_linear, format, converted>};
+        }
+    }()...};
+}
+
+template <bool morton_to_linear, bool converted>
+constexpr auto REFERENCE_TABLE = MakeReferenceTable<morton_to_linear, converted>(
+    std::make_index_sequence<PIXEL_FORMAT_COUNT>{});
+
+} // Anonymous namespace
+
+TEST_CASE("MortonCopy round trip", "[video_core][rasterizer_cache]") {
+    for (u32 index = 0; index < PIXEL_FORMAT_COUNT; index++) {
+        for (const bool converted : {false, true}) {
+            const MortonFunc decode =
+                (converted ? UNSWIZZLE_TABLE_CONVERTED : UNSWIZZLE_TABLE)[index];
+            const MortonFunc encode = (converted ? SWIZZLE_TABLE_CONVERTED : SWIZZLE_TABLE)[index];
+            if (!decode || !encode) {
+                continue;
+            }
+
+            const auto format = static_cast<PixelFormat>(index);
+            const u32 width = 64;
+            const u32 height = 32;
+            const std::vector<u8> tiled = MakeRandomData(width * height * GetFormatBpp(format) / 8);
+            std::vector<u8> linear(width * height * LinearBytesPerPixel(format, converted));
+            std::vector<u8> result(tiled.size());
+
+            std::vector<u8> source = tiled;
+            decode(width, height, 0, static_cast<u32>(tiled.size()), linear, source);
+            encode(width, height, 0, static_cast<u32>(tiled.size()), linear, result);
+            INFO(fmt::format("format = {}, converted = {}", PixelFormatAsString(format),
+                             converted));
+            REQUIRE(result == tiled);
+        }
+    }
+}
+
+TEST_CASE("DecodeTexture splits large surfaces", "[video_core][rasterizer_cache]") {
+    for (const PixelFormat format : {PixelFormat::RGBA8, PixelFormat::RGB565, PixelFormat::ETC1}) {
+        const SurfaceParams params = MakeTiledSurface(format, 1024, 512);
+        std::vector<u8> tiled = MakeRandomData(params.size);
+        std::vector<u8> linear(params.width * params.height * LinearBytesPerPixel(format, false));
+        std::vector<u8> expected(linear.size());
+
+        DecodeTexture(params, params.addr, params.end, tiled, linear);
+        UNSWIZZLE_TABLE[static_cast<u32>(format)](params.width, params.height, 0, params.size,
+                                                  expected, tiled);
+        INFO(fmt::format("format = {}", PixelFormatAsString(format)));
+        REQUIRE(linear == expected);
+    }
+}
+
+TEST_CASE("EncodeTexture splits large unaligned ranges", "[video_core][rasterizer_cache]") {
+    const SurfaceParams params = MakeTiledSurface(PixelFormat::RGBA8, 1024, 512);
+    const u32 start_offset = 1000;
+    const u32 end_offset = params.size - 3000;
+    std::vector<u8> linear = MakeRandomData(params.width * params.height * 4);
+    std::vector<u8> tiled(end_offset - start_offset);
+    std::vector<u8> expected(tiled.size());
+
+    EncodeTexture(params, params.addr + start_offset, params.addr + end_offset, linear, tiled);
+    SWIZZLE_TABLE[static_cast<u32>(PixelFormat::RGBA8)](params.width, params.height, start_offset,
+                                                        end_offset, linear, expected);
+    REQUIRE(tiled == expected);
+}
+
+TEST_CASE("Morton copies match the per-pixel reference", "[video_core][rasterizer_cache]") {
+    for (u32 index = 0; index < PIXEL_FORMAT_COUNT; index++) {
+        for (const bool converted : {false, true}) {
+            const auto format = static_cast<PixelFormat>(index);
+            const SurfaceParams params = MakeTiledSurface(format, 1024, 512);
+            const u32 linear_size =
+                params.width * params.height * LinearBytesPerPixel(format, converted);
+            INFO(fmt::format("format = {}, converted = {}", PixelFormatAsString(format),
+                             converted));
+
+            if ((converted ? UNSWIZZLE_TABLE_CONVERTED : UNSWIZZLE_TABLE)[index]) {
+                std::vector<u8> tiled = MakeRandomData(params.size);
+                std::vector<u8> linear(linear_size);
+                std::vector<u8> expected(linear_size);
+
+                DecodeTexture(params, params.addr, params.end, tiled, linear, converted);
+                (converted ? REFERENCE_TABLE<true, true> : REFERENCE_TABLE<true, false>)[index](
+                    params.width, params.height, expected, tiled);
+                REQUIRE(linear == expected);
+            }
+
+            if ((converted ? SWIZZLE_TABLE_CONVERTED : SWIZZLE_TABLE)[index]) {
+                std::vector<u8> linear = MakeRandomData(linear_size);
+                std::vector<u8> tiled(params.size);
+                std::vector<u8> expected(params.size);
+
+                EncodeTexture(params, params.addr, params.end, linear, tiled, converted);
+                (converted ? REFERENCE_TABLE<false, true> : REFERENCE_TABLE<false, false>)[index](
+                    params.width, params.height, linear, expected);
+                REQUIRE(tiled == expected);
+
+                // Downloads of unaligned ranges only write the bytes in the range.
+                const u32 start_offset = 1000;
+                const u32 end_offset = params.size - 3000;
+                std::vector<u8> range(end_offset - start_offset);
+                EncodeTexture(params, params.addr + start_offset, params.addr + end_offset, linear,
+                              range, converted);
+                REQUIRE(std::equal(range.begin(), range.end(), expected.begin() + start_offset));
+            }
+        }
+    }
+}
+
+TEST_CASE("Morton copies stop at the end of the tiled buffer", "[video_core][rasterizer_cache]") {
+    const SurfaceParams params = MakeTiledSurface(PixelFormat::RGBA8, 1024, 512);
+    const u32 linear_size = params.width * params.height * 4;
+
+    SECTION("Upload") {
+        std::vector<u8> tiled = MakeRandomData(params.size / 2 + 100);
+        std::vector<u8> linear(linear_size);
+        std::vector<u8> expected(linear_size);
+
+        DecodeTexture(params, params.addr, params.end, tiled, linear);
+        UNSWIZZLE_TABLE[static_cast<u32>(PixelFormat::RGBA8)](params.width, params.height, 0,
+                                                              params.size, expected, tiled);
+        REQUIRE(linear == expected);
+    }
+
+    SECTION("Download") {
+        const u32 start_offset = 1000;
+        const u32 end_offset = params.size - 3000;
+        std::vector<u8> linear = MakeRandomData(linear_size);
+        std::vector<u8> tiled((end_offset - start_offset) / 2 + 100);
+        std::vector<u8> expected(tiled.size());
+
+        EncodeTexture(params, params.addr + start_offset, params.addr + end_offset, linear, tiled);
+        SWIZZLE_TABLE[static_cast<u32>(PixelFormat::RGBA8)](params.width, params.height,
+                                                            start_offset, end_offset, linear,
+                                                            expected);
+        REQUIRE(tiled == expected);
+    }
+}
+
+TEST_CASE("Texture codec benchmark", "[.][benchmark]") {
+    for (u32 index = 0; index < PIXEL_FORMAT_COUNT; index++) {
+        const auto format = static_cast<PixelFormat>(index);
+        if (GetFormatType(format) == SurfaceType::Invalid) {
+            continue;
+        }
+
+        const SurfaceParams params = MakeTiledSurface(format, 512, 512);
+        std::vector<u8> tiled = MakeRandomData(params.size);
+        std::vector<u8> linear(params.width * params.height * 4);
+        const std::string name{PixelFormatAsString(format)};
+
+        for (const bool converted : {false, true}) {
+            const std::string suffix = converted ? " converted" : "";
+            if ((converted ? UNSWIZZLE_TABLE_CONVERTED : UNSWIZZLE_TABLE)[index]) {
+                BENCHMARK("Decode " + name + suffix) {
+                    DecodeTexture(params, params.addr, params.end, tiled, linear, converted);
+                    return linear[0];
+                };
+            }
+            if ((converted ? SWIZZLE_TABLE_CONVERTED : SWIZZLE_TABLE)[index]) {
+                BENCHMARK("Encode " + name + suffix) {
+                    EncodeTexture(params, params.addr, params.end, linear, tiled, converted);
+                    return tiled[0];
+                };
+            }
+        }
+    }
+}
@@ -0,0 +1,519 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <span>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/pica/regs_internal.h"
+#include "video_core/renderer_software/sw_fragment_pipeline.h"
+
+using namespace SwRenderer;
+using Pica::FramebufferRegs;
+using Pica::TexturingRegs;
+using TevStageConfig = TexturingRegs::TevStageConfig;
+using Source = TevStageConfig::Source;
+using ColorModifier = TevStageConfig::ColorModifier;
+using AlphaModifier = TevStageConfig::AlphaModifier;
+using Operation = TevStageConfig::Operation;
+
+namespace {
+
+/*
+ * Reference implementation of the fragment operations, as the software rasterizer evaluated them
+ * for every pixel before the pipeline state was resolved up front.
+ */
+
+Common::Vec3<u8> GetColorModifier(ColorModifier factor, const Common::Vec4<u8>& values) {
+    switch (factor) {
+    case ColorModifier::SourceColor:
+        return values.rgb();
+    case ColorModifier::OneMinusSourceColor:
+        return (Common::Vec3<u8>(255, 255, 255) - values.rgb()).Cast<u8>();
+    case ColorModifier::SourceAlpha:
+        return values.aaa();
+    case ColorModifier::OneMinusSourceAlpha:
+        return (Common::Vec3<u8>(255, 255, 255) - values.aaa()).Cast<u8>();
+    case ColorModifier::SourceRed:
+        return values.rrr();
+    case ColorModifier::OneMinusSourceRed:
+        return (Common::Vec3<u8>(255, 255, 255) - values.rrr()).Cast<u8>();
+    case ColorModifier::SourceGreen:
+        return values.ggg();
+    case ColorModifier::OneMinusSourceGreen:
+        return (Common::Vec3<u8>(255, 255, 255) - values.ggg()).Cast<u8>();
+    case ColorModifier::SourceBlue:
+        return values.bbb();
+    case ColorModifier::OneMinusSourceBlue:
+        return (Common::Vec3<u8>(255, 255, 255) - values.bbb()).Cast<u8>();
+    }
+    return {};
+}
+
+u8 GetAlphaModifier(AlphaModifier factor, const Common::Vec4<u8>& values) {
+    switch (factor) {
+    case AlphaModifier::SourceAlpha:
+        return values.a();
+    case AlphaModifier::OneMinusSourceAlpha:
+        return 255 - values.a();
+    case AlphaModifier::SourceRed:
+        return values.r();
+    case AlphaModifier::OneMinusSourceRed:
+        return 255 - values.r();
+    case AlphaModifier::SourceGreen:
+        return values.g();
+    case AlphaModifier::OneMinusSourceGreen:
+        return 255 - values.g();
+    case AlphaModifier::SourceBlue:
+        return values.b();
+    case AlphaModifier::OneMinusSourceBlue:
+        return 255 - values.b();
+    }
+    return 0;
+}
+
+Common::Vec3<u8> ColorCombine(Operation op, std::span<const Common::Vec3<u8>, 3> input) {
+    switch (op) {
+    case Operation::Replace:
+        return input[0];
+    case Operation::Modulate:
+        return ((input[0] * input[1]) / 255).Cast<u8>();
+    case Operation::Add: {
+        auto result = input[0] + input[1];
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        return result.Cast<u8>();
+    }
+    case Operation::AddSigned: {
+        Common::Vec3i result =
+            input[0].Cast<s32>() + input[1].Cast<s32>() - Common::MakeVec<s32>(128, 128, 128);
+        result.r() = std::clamp<s32>(result.r(), 0, 255);
+        result.g() = std::clamp<s32>(result.g(), 0, 255);
+        result.b() = std::clamp<s32>(result.b(), 0, 255);
+        return result.Cast<u8>();
+    }
+    case Operation::Lerp:
+        return ((input[0] * input[2] +
+                 input[1] * (Common::MakeVec<u8>(255, 255, 255) - input[2]).Cast<u8>()) /
+                255)
+            .Cast<u8>();
+    case Operation::Subtract: {
+        auto result = input[0].Cast<s32>() - input[1].Cast<s32>();
+        result.r() = std::max(0, result.r());
+        result.g() = std::max(0, result.g());
+        result.b() = std::max(0, result.b());
+        return result.Cast<u8>();
+    }
+    case Operation::MultiplyThenAdd: {
+        auto result = (input[0] * input[1] + 255 * input[2].Cast<s32>()) / 255;
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        return result.Cast<u8>();
+    }
+    case Operation::AddThenMultiply: {
+        auto result = input[0] + input[1];
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        result = (result * input[2].Cast<s32>()) / 255;
+        return result.Cast<u8>();
+    }
+    case Operation::Dot3_RGB:
+    case Operation::Dot3_RGBA: {
+        s32 result = ((input[0].r() * 2 - 255) * (input[1].r() * 2 - 255) + 128) / 256 +
+                     ((input[0].g() * 2 - 255) * (input[1].g() * 2 - 255) + 128) / 256 +
+                     ((input[0].b() * 2 - 255) * (input[1].b() * 2 - 255) + 128) / 256;
+        result = std::clamp(result, 0, 255);
+        return Common::Vec3{result, result, result}.Cast<u8>();
+    }
+    }
+    return {0, 0, 0};
+}
+
+u8 AlphaCombine(Operation op, const std::array<u8, 3>& input) {
+    switch (op) {
+    case Operation::Replace:
+        return input[0];
+    case Operation::Modulate:
+        return input[0] * input[1] / 255;
+    case Operation::Add:
+        return std::min(255, input[0] + input[1]);
+    case Operation::AddSigned: {
+        auto result = static_cast<s32>(input[0]) + static_cast<s32>(input[1]) - 128;
+        return static_cast<u8>(std::clamp<s32>(result, 0, 255));
+    }
+    case Operation::Lerp:
+        return (input[0] * input[2] + input[1] * (255 - input[2])) / 255;
+    case Operation::Subtract:
+        return std::max(0, static_cast<s32>(input[0]) - static_cast<s32>(input[1]));
+    case Operation::MultiplyThenAdd:
+        return std::min(255, (input[0] * input[1] + 255 * input[2]) / 255);
+    case Operation::AddThenMultiply:
+        return (std::min(255, (input[0] + input[1])) * input[2]) / 255;
+    default:
+        return 0;
+    }
+}
+
+/// Colors a fragment enters the TEV with
+struct TevInputs {
+    std::array<Common::Vec4<u8>, 4> texture_color;
+    Common::Vec4<u8> primary_color;
+    Common::Vec4<u8> primary_fragment_color;
+    Common::Vec4<u8> secondary_fragment_color;
+};
+
+Common::Vec4<u8> GenericTev(const Pica::RegsInternal& regs, const TevInputs& inputs) {
+    const auto tev_stages = regs.texturing.GetTevStages();
+    Common::Vec4<u8> combiner_output = {0, 0, 0, 0};
+    Common::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
+    Common::Vec4<u8> next_combiner_buffer =
+        Common::MakeVec(regs.texturing.tev_combiner_buffer_color.r.Value(),
+                        regs.texturing.tev_combiner_buffer_color.g.Value(),
+                        regs.texturing.tev_combiner_buffer_color.b.Value(),
+                        regs.texturing.tev_combiner_buffer_color.a.Value())
+            .Cast<u8>();
+
+    for (u32 tev_stage_index = 0; tev_stage_index < tev_stages.size(); ++tev_stage_index) {
+        const auto& tev_stage = tev_stages[tev_stage_index];
+        const auto get_source = [&](Source source) -> Common::Vec4<u8> {
+            switch (source) {
+            case Source::PrimaryColor:
+                return inputs.primary_color;
+            case Source::PrimaryFragmentColor:
+                return inputs.primary_fragment_color;
+            case Source::SecondaryFragmentColor:
+                return inputs.secondary_fragment_color;
+            case Source::Texture0:
+                return inputs.texture_color[0];
+            case Source::Texture1:
+                return inputs.texture_color[1];
+            case Source::Texture2:
+                return inputs.texture_color[2];
+            case Source::Texture3:
+                return inputs.texture_color[3];
+            case Source::PreviousBuffer:
+                return combiner_buffer;
+            case Source::Constant:
+                return Common::MakeVec(tev_stage.const_r.Value(), tev_stage.const_g.Value(),
+                                       tev_stage.const_b.Value(), tev_stage.const_a.Value())
+                    .Cast<u8>();
+            case Source::Previous:
+                return combiner_output;
+            default:
+                return {0, 0, 0, 0};
+            }
+        };
+
+        const auto source1 = tev_stage_index == 0 && tev_stage.color_source1 == Source::Previous
+                                 ? tev_stage.color_source3.Value()
+                                 : tev_stage.color_source1.Value();
+        const auto source2 = tev_stage_index == 0 && tev_stage.color_source2 == Source::Previous
+                                 ? tev_stage.color_source3.Value()
+                                 : tev_stage.color_source2.Value();
+        const std::array<Common::Vec3<u8>, 3> color_result = {
+            GetColorModifier(tev_stage.color_modifier1, get_source(source1)),
+            GetColorModifier(tev_stage.color_modifier2, get_source(source2)),
+            GetColorModifier(tev_stage.color_modifier3, get_source(tev_stage.color_source3)),
+        };
+        const Common::Vec3<u8> color_output = ColorCombine(tev_stage.color_op, color_result);
+
+        u8 alpha_output;
+        if (tev_stage.color_op == Operation::Dot3_RGBA) {
+            alpha_output = color_output.x;
+        } else {
+            const std::array<u8, 3> alpha_result = {{
+                GetAlphaModifier(tev_stage.alpha_modifier1, get_source(tev_stage.alpha_source1)),
+                GetAlphaModifier(tev_stage.alpha_modifier2, get_source(tev_stage.alpha_source2)),
+                GetAlphaModifier(tev_stage.alpha_modifier3, get_source(tev_stage.alpha_source3)),
+            }};
+            alpha_output = AlphaCombine(tev_stage.alpha_op, alpha_result);
+        }
+
+        combiner_output[0] = std::min(255U, color_output.r() * tev_stage.GetColorMultiplier());
+        combiner_output[1] = std::min(255U, color_output.g() * tev_stage.GetColorMultiplier());
+        combiner_output[2] = std::min(255U, color_output.b() * tev_stage.GetColorMultiplier());
+        combiner_output[3] = std::min(255U, alpha_output * tev_stage.GetAlphaMultiplier());
+
+        combiner_buffer = next_combiner_buffer;
+        const auto& buffer_input = regs.texturing.tev_combiner_buffer_input;
+        if (buffer_input.TevStageUpdatesCombinerBufferColor(tev_stage_index)) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+        if (buffer_input.TevStageUpdatesCombinerBufferAlpha(tev_stage_index)) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    }
+    return combiner_output;
+}
+
+bool GenericAlphaTest(const Pica::RegsInternal& regs, u8 alpha) {
+    const auto& output_merger = regs.framebuffer.output_merger;
+    if (!output_merger.alpha_test.enable) {
+        return true;
+    }
+    switch (output_merger.alpha_test.func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return false;
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+    case FramebufferRegs::CompareFunc::Equal:
+        return alpha == output_merger.alpha_test.ref;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return alpha != output_merger.alpha_test.ref;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return alpha < output_merger.alpha_test.ref;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return alpha <= output_merger.alpha_test.ref;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return alpha > output_merger.alpha_test.ref;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return alpha >= output_merger.alpha_test.ref;
+    default:
+        return false;
+    }
+}
+
+/// Runs the TEV of the pipeline the same way the software rasterizer does
+Common::Vec4<u8> SpecializedTev(const Pica::RegsInternal& regs, const TevInputs& inputs) {
+    const FragmentPipeline pipeline{FragmentConfig{regs}};
+    std::array<Common::Vec4<u8>, FragmentPipeline::NUM_TEV_SOURCES> sources{};
+    sources[static_cast<u32>(Source::PrimaryColor)] = inputs.primary_color;
+    sources[static_cast<u32>(Source::PrimaryFragmentColor)] = inputs.primary_fragment_color;
+    sources[static_cast<u32>(Source::SecondaryFragmentColor)] = inputs.secondary_fragment_color;
+    for (u32 i = 0; i < inputs.texture_color.size(); i++) {
+        sources[static_cast<u32>(Source::Texture0) + i] = inputs.texture_color[i];
+    }
+    const auto tev_stages = regs.texturing.GetTevStages();
+    const Common::Vec4<u8> combiner_buffer_color =
+        Common::MakeVec(regs.texturing.tev_combiner_buffer_color.r.Value(),
+                        regs.texturing.tev_combiner_buffer_color.g.Value(),
+                        regs.texturing.tev_combiner_buffer_color.b.Value(),
+                        regs.texturing.tev_combiner_buffer_color.a.Value())
+            .Cast<u8>();
+    return pipeline.CombineTev(sources, tev_stages, combiner_buffer_color);
+}
+
+std::array<TevStageConfig*, 6> GetTevStages(Pica::RegsInternal& regs) {
+    auto& texturing = regs.texturing;
+    return {&texturing.tev_stage0, &texturing.tev_stage1, &texturing.tev_stage2,
+            &texturing.tev_stage3, &texturing.tev_stage4, &texturing.tev_stage5};
+}
+
+/// Makes the stage output the result of the previous stage unchanged
+void SetPassthrough(TevStageConfig& stage) {
+    stage.sources_raw = 0;
+    stage.color_source1.Assign(Source::Previous);
+    stage.alpha_source1.Assign(Source::Previous);
+    stage.modifiers_raw = 0;
+    stage.ops_raw = 0;
+    stage.scales_raw = 0;
+}
+
+void SetColor(TevStageConfig& stage, Operation op, std::array<Source, 3> sources,
+              std::array<ColorModifier, 3> modifiers = {}) {
+    stage.color_op.Assign(op);
+    stage.color_source1.Assign(sources[0]);
+    stage.color_source2.Assign(sources[1]);
+    stage.color_source3.Assign(sources[2]);
+    stage.color_modifier1.Assign(modifiers[0]);
+    stage.color_modifier2.Assign(modifiers[1]);
+    stage.color_modifier3.Assign(modifiers[2]);
+}
+
+void SetAlpha(TevStageConfig& stage, Operation op, std::array<Source, 3> sources,
+              std::array<AlphaModifier, 3> modifiers = {}) {
+    stage.alpha_op.Assign(op);
+    stage.alpha_source1.Assign(sources[0]);
+    stage.alpha_source2.Assign(sources[1]);
+    stage.alpha_source3.Assign(sources[2]);
+    stage.alpha_modifier1.Assign(modifiers[0]);
+    stage.alpha_modifier2.Assign(modifiers[1]);
+    stage.alpha_modifier3.Assign(modifiers[2]);
+}
+
+/// Randomizes every stage with valid sources, modifiers and operations
+void RandomizeTev(Pica::RegsInternal& regs, std::mt19937& rng) {
+    constexpr std::array sources = {
+        Source::PrimaryColor, Source::PrimaryFragmentColor, Source::SecondaryFragmentColor,
+        Source::Texture0,     Source::Texture1,             Source::Texture2,
+        Source::Texture3,     Source::PreviousBuffer,       Source::Constant,
+        Source::Previous,
+    };
+    constexpr std::array color_modifiers = {
+        ColorModifier::SourceColor,         ColorModifier::OneMinusSourceColor,
+        ColorModifier::SourceAlpha,         ColorModifier::OneMinusSourceAlpha,
+        ColorModifier::SourceRed,           ColorModifier::OneMinusSourceRed,
+        ColorModifier::SourceGreen,         ColorModifier::OneMinusSourceGreen,
+        ColorModifier::SourceBlue,          ColorModifier::OneMinusSourceBlue,
+    };
+    const auto pick = [&rng](const auto& values) { return values[rng() % values.size()]; };
+    const auto source = [&] { return pick(sources); };
+    const auto color_modifier = [&] { return pick(color_modifiers); };
+    const auto alpha_modifier = [&] { return static_cast<AlphaModifier>(rng() % 8); };
+    const auto operation = [&] { return static_cast<Operation>(rng() % 10); };
+
+    for (TevStageConfig* stage : GetTevStages(regs)) {
+        if (rng() % 4 == 0) {
+            SetPassthrough(*stage);
+            continue;
+        }
+        SetColor(*stage, operation(), {source(), source(), source()},
+                 {color_modifier(), color_modifier(), color_modifier()});
+        SetAlpha(*stage, operation(), {source(), source(), source()},
+                 {alpha_modifier(), alpha_modifier(), alpha_modifier()});
+        stage->const_color = static_cast<u32>(rng());
+        stage->color_scale.Assign(rng() % 4);
+        stage->alpha_scale.Assign(rng() % 4);
+    }
+    auto& texturing = regs.texturing;
+    texturing.tev_combiner_buffer_input.update_mask_rgb.Assign(rng() % 16);
+    texturing.tev_combiner_buffer_input.update_mask_a.Assign(rng() % 16);
+    texturing.tev_combiner_buffer_color.raw = static_cast<u32>(rng());
+}
+
+void RequireTevMatches(const Pica::RegsInternal& regs, std::mt19937& rng) {
+    const auto color = [&rng] {
+        const u32 value = static_cast<u32>(rng());
+        return Common::MakeVec<u8>(value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF,
+                                   value >> 24);
+    };
+    for (u32 i = 0; i < 256; i++) {
+        const TevInputs inputs{
+            .texture_color = {color(), color(), color(), color()},
+            .primary_color = color(),
+            .primary_fragment_color = color(),
+            .secondary_fragment_color = color(),
+        };
+        REQUIRE(SpecializedTev(regs, inputs) == GenericTev(regs, inputs));
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("FragmentPipeline combines like the generic TEV", "[video_core][renderer_software]") {
+    std::mt19937 rng{1234};
+    Pica::RegsInternal regs{};
+    const auto tev_stages = GetTevStages(regs);
+    for (TevStageConfig* stage : tev_stages) {
+        SetPassthrough(*stage);
+    }
+
+    SECTION("Modulated texture") {
+        SetColor(*tev_stages[0], Operation::Modulate, {Source::Texture0, Source::PrimaryColor});
+        SetAlpha(*tev_stages[0], Operation::Modulate, {Source::Texture0, Source::PrimaryColor});
+        RequireTevMatches(regs, rng);
+    }
+
+    SECTION("Previous color in the first stage") {
+        SetColor(*tev_stages[0], Operation::Add,
+                 {Source::Previous, Source::Previous, Source::Texture1});
+        SetAlpha(*tev_stages[0], Operation::Replace, {Source::Previous});
+        RequireTevMatches(regs, rng);
+    }
+
+    SECTION("Combiner buffer with passthrough stages in between") {
+        SetColor(*tev_stages[0], Operation::Lerp,
+                 {Source::Texture0, Source::PrimaryColor, Source::Constant},
+                 {ColorModifier::SourceColor, ColorModifier::OneMinusSourceAlpha,
+                  ColorModifier::SourceAlpha});
+        SetAlpha(*tev_stages[0], Operation::Lerp,
+                 {Source::Texture0, Source::PrimaryColor, Source::Constant});
+        tev_stages[0]->const_color = 0x80402010;
+        SetColor(*tev_stages[2], Operation::Dot3_RGBA, {Source::Previous, Source::PreviousBuffer});
+        tev_stages[2]->color_scale.Assign(1);
+        SetColor(*tev_stages[4], Operation::MultiplyThenAdd,
+                 {Source::Previous, Source::Texture1, Source::PreviousBuffer},
+                 {ColorModifier::OneMinusSourceColor, ColorModifier::SourceGreen,
+                  ColorModifier::SourceBlue});
+        SetAlpha(*tev_stages[4], Operation::AddThenMultiply,
+                 {Source::Previous, Source::PreviousBuffer, Source::Constant},
+                 {AlphaModifier::OneMinusSourceRed, AlphaModifier::SourceAlpha,
+                  AlphaModifier::OneMinusSourceBlue});
+        tev_stages[4]->alpha_scale.Assign(2);
+        regs.texturing.tev_combiner_buffer_input.update_mask_rgb.Assign(0b0101);
+        regs.texturing.tev_combiner_buffer_input.update_mask_a.Assign(0b0011);
+        regs.texturing.tev_combiner_buffer_color.raw = 0x11223344;
+        RequireTevMatches(regs, rng);
+    }
+
+    SECTION("Random stages") {
+        for (u32 i = 0; i < 64; i++) {
+            RandomizeTev(regs, rng);
+            RequireTevMatches(regs, rng);
+        }
+    }
+}
+
+TEST_CASE("FragmentPipeline applies fog like the generic path", "[video_core][renderer_software]") {
+    Pica::RegsInternal regs{};
+    for (const auto fog_mode :
+         {TexturingRegs::FogMode::None, TexturingRegs::FogMode::Fog, TexturingRegs::FogMode::Gas}) {
+        for (const u32 fog_flip : {0, 1}) {
+            regs.texturing.fog_mode.Assign(fog_mode);
+            regs.texturing.fog_flip.Assign(fog_flip);
+            const FragmentPipeline pipeline{FragmentConfig{regs}};
+            REQUIRE(pipeline.fog_enable == (fog_mode == TexturingRegs::FogMode::Fog));
+            if (pipeline.fog_enable) {
+                REQUIRE(pipeline.fog_flip == (fog_flip != 0));
+            }
+        }
+    }
+}
+
+TEST_CASE("FragmentPipeline alpha tests like the generic path",
+          "[video_core][renderer_software]") {
+    Pica::RegsInternal regs{};
+    auto& alpha_test = regs.framebuffer.output_merger.alpha_test;
+    for (const u32 enable : {0, 1}) {
+        for (u32 func = 0; func < 8; func++) {
+            alpha_test.enable.Assign(enable);
+            alpha_test.func.Assign(static_cast<FramebufferRegs::CompareFunc>(func));
+            for (const u32 ref : {0, 1, 127, 128, 254, 255}) {
+                alpha_test.ref.Assign(ref);
+                const FragmentPipeline pipeline{FragmentConfig{regs}};
+                bool matches = true;
+                for (u32 alpha = 0; alpha < 256; alpha++) {
+                    matches &= pipeline.alpha_test(alpha, ref) ==
+                               GenericAlphaTest(regs, static_cast<u8>(alpha));
+                }
+                REQUIRE(matches);
+            }
+        }
+    }
+}
+
+TEST_CASE("FragmentPipelineCache evicts the least recently used pipeline",
+          "[video_core][renderer_software]") {
+    constexpr std::size_t max_pipelines = FragmentPipelineCache::MAX_PIPELINES;
+    std::vector<FragmentConfig> configs;
+    for (u32 i = 0; i <= max_pipelines; i++) {
+        Pica::RegsInternal regs{};
+        auto& buffer_input = regs.texturing.tev_combiner_buffer_input;
+        buffer_input.update_mask_rgb.Assign(i & 0xF);
+        buffer_input.update_mask_a.Assign((i >> 4) & 0xF);
+        regs.texturing.tev_stage0.color_scale.Assign(i >> 8);
+        configs.emplace_back(regs);
+    }
+
+    FragmentPipelineCache cache;
+    const FragmentPipeline* first = &cache.Get(configs[0]);
+    for (u32 i = 1; i < max_pipelines; i++) {
+        cache.Get(configs[i]);
+    }
+
+    // The first pipeline is used again, which leaves the second one as the least recently used
+    REQUIRE(&cache.Get(configs[0]) == first);
+    cache.Get(configs[max_pipelines]);
+    REQUIRE(!cache.Contains(configs[1]));
+    REQUIRE(cache.Contains(configs[0]));
+    REQUIRE(cache.Contains(configs[2]));
+    REQUIRE(cache.Contains(configs[max_pipelines]));
+}
@@ -0,0 +1,384 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/core.h"
+#include "core/memory.h"
+#include "video_core/pica/output_vertex.h"
+#include "video_core/pica/pica_core.h"
+#include "video_core/renderer_software/sw_rasterizer.h"
+
+using namespace SwRenderer;
+using Pica::f24;
+using Pica::FramebufferRegs;
+
+namespace {
+
+/// Width and height of the framebuffer, which spans several screen tiles
+constexpr u32 FB_SIZE = 64;
+constexpr u32 COLOR_OFFSET = 0;
+constexpr u32 DEPTH_OFFSET = 0x10000;
+
+/// Converts a pixel coordinate and a fraction in 16ths of a pixel to 12.4 fixed point
+constexpr u16 Fix(u32 pixel, u32 fraction = 0) {
+    return static_cast<u16>((pixel << 4) + fraction);
+}
+
+/// Encodes a non-zero float as the raw value of a float24 register
+u32 ToFloat24Raw(float value) {
+    const u32 bits = std::bit_cast<u32>(value);
+    const u32 exponent = ((bits >> 23) & 0xFF) - 64;
+    return ((bits >> 31) << 23) | (exponent << 16) | ((bits >> 7) & 0xFFFF);
+}
+
+struct TestVertex {
+    /// Screen position in 12.4 fixed point
+    u16 x;
+    u16 y;
+    float depth;
+};
+
+struct TestTriangle {
+    std::array<TestVertex, 3> vertices;
+    Common::Vec4<u8> color;
+};
+
+Common::Vec4<u8> MakeColor(u32 index) {
+    return {static_cast<u8>(index * 37 + 20), static_cast<u8>(index * 91 + 40),
+            static_cast<u8>(index * 53 + 60), 255};
+}
+
+std::vector<TestTriangle> MakeRandomTriangles(std::mt19937& rng, u32 count, u32 max_size) {
+    std::uniform_int_distribution<u32> position{0, Fix(FB_SIZE)};
+    std::uniform_int_distribution<u32> offset{0, max_size};
+    std::uniform_real_distribution<float> depth{0.0f, 1.0f};
+    std::vector<TestTriangle> triangles;
+    for (u32 i = 0; i < count; i++) {
+        const u32 x = position(rng);
+        const u32 y = position(rng);
+        TestTriangle& triangle = triangles.emplace_back();
+        for (TestVertex& vertex : triangle.vertices) {
+            vertex.x = static_cast<u16>(std::min<u32>(x + offset(rng), Fix(FB_SIZE)));
+            vertex.y = static_cast<u16>(std::min<u32>(y + offset(rng), Fix(FB_SIZE)));
+            vertex.depth = depth(rng);
+        }
+        triangle.color = MakeColor(i);
+    }
+    return triangles;
+}
+
+/// Returns the triangles of a fan around the center, which share their edges with each other
+std::vector<TestTriangle> MakeFan(TestVertex center, std::span<const TestVertex> ring) {
+    std::vector<TestTriangle> triangles;
+    for (std::size_t i = 0; i < ring.size(); i++) {
+        triangles.push_back({{center, ring[i], ring[(i + 1) % ring.size()]},
+                             MakeColor(static_cast<u32>(i))});
+    }
+    return triangles;
+}
+
+/**
+ * Returns the pixels covered by the triangle, found by evaluating the edge functions for every
+ * pixel of its bounding box as the software rasterizer did before it processed 2x2 quads.
+ */
+std::vector<Common::Vec2<u32>> GetCoveredPixels(const TestTriangle& triangle) {
+    std::array<Common::Vec2<Fix12P4>, 3> vtxpos;
+    for (u32 i = 0; i < 3; i++) {
+        vtxpos[i] = {triangle.vertices[i].x, triangle.vertices[i].y};
+    }
+    if (SignedArea(vtxpos[0], vtxpos[1], vtxpos[2]) <= 0) {
+        std::swap(vtxpos[1], vtxpos[2]);
+    }
+
+    const u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x}) & Fix12P4::IntMask();
+    const u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y}) & Fix12P4::IntMask();
+    const u16 max_x = (std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x}) + Fix12P4::FracMask()) &
+                      Fix12P4::IntMask();
+    const u16 max_y = (std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y}) + Fix12P4::FracMask()) &
+                      Fix12P4::IntMask();
+
+    const int bias0 = IsRightSideOrFlatBottomEdge(vtxpos[0], vtxpos[1], vtxpos[2]) ? -1 : 0;
+    const int bias1 = IsRightSideOrFlatBottomEdge(vtxpos[1], vtxpos[2], vtxpos[0]) ? -1 : 0;
+    const int bias2 = IsRightSideOrFlatBottomEdge(vtxpos[2], vtxpos[0], vtxpos[1]) ? -1 : 0;
+
+    std::vector<Common::Vec2<u32>> pixels;
+    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
+        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
+            const s32 w0 = bias0 + SignedArea(vtxpos[1], vtxpos[2], {x, y});
+            const s32 w1 = bias1 + SignedArea(vtxpos[2], vtxpos[0], {x, y});
+            const s32 w2 = bias2 + SignedArea(vtxpos[0], vtxpos[1], {x, y});
+            if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
+                pixels.push_back({static_cast<u32>(x) >> 4, static_cast<u32>(y) >> 4});
+            }
+        }
+    }
+    return pixels;
+}
+
+/**
+ * Draws triangles with the software rasterizer to a framebuffer in FCRAM. The viewport maps the
+ * framebuffer one to one and the triangles are filled with their color by the TEV.
+ */
+class RasterizerTest {
+public:
+    explicit RasterizerTest() {
+        pica = std::make_unique<Pica::PicaCore>(memory, nullptr, 0);
+
+        auto& regs = pica->regs.internal;
+        regs.rasterizer.viewport_size_x.Assign(ToFloat24Raw(FB_SIZE / 2.0f));
+        regs.rasterizer.viewport_size_y.Assign(ToFloat24Raw(FB_SIZE / 2.0f));
+        regs.rasterizer.viewport_depth_range.Assign(ToFloat24Raw(-1.0f));
+        regs.rasterizer.depthmap_enable.Assign(Pica::RasterizerRegs::DepthBuffering::ZBuffering);
+        regs.lighting.disable.Assign(1);
+
+        auto& framebuffer = regs.framebuffer.framebuffer;
+        framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+        framebuffer.depth_format.Assign(FramebufferRegs::DepthFormat::D24S8);
+        framebuffer.color_buffer_address.Assign((Memory::FCRAM_PADDR + COLOR_OFFSET) / 8);
+        framebuffer.depth_buffer_address.Assign((Memory::FCRAM_PADDR + DEPTH_OFFSET) / 8);
+        framebuffer.width.Assign(FB_SIZE);
+        framebuffer.height.Assign(FB_SIZE - 1);
+        framebuffer.allow_color_write.Assign(0xF);
+        framebuffer.allow_depth_stencil_write.Assign(0x3);
+
+        auto& output_merger = regs.framebuffer.output_merger;
+        output_merger.logic_op.Assign(FramebufferRegs::LogicOp::Copy);
+        output_merger.red_enable.Assign(1);
+        output_merger.green_enable.Assign(1);
+        output_merger.blue_enable.Assign(1);
+        output_merger.alpha_enable.Assign(1);
+
+        rasterizer = std::make_unique<RasterizerSoftware>(memory, *pica);
+        fb = std::make_unique<Framebuffer>(memory, regs.framebuffer);
+        fb->Bind();
+        Clear({0, 0, 0, 0}, 0);
+    }
+
+    Pica::RegsInternal& Regs() {
+        return pica->regs.internal;
+    }
+
+    /// Rasterizes the triangles together, in the order given
+    void Draw(std::span<const TestTriangle> triangles) {
+        for (const TestTriangle& triangle : triangles) {
+            std::array<Pica::OutputVertex, 3> vertices{};
+            for (u32 i = 0; i < 3; i++) {
+                const TestVertex& vertex = triangle.vertices[i];
+                const auto to_ndc = [](u16 pos) {
+                    return f24::FromFloat32(pos / 16.0f / (FB_SIZE / 2.0f) - 1.0f);
+                };
+                vertices[i].pos = {to_ndc(vertex.x), to_ndc(vertex.y),
+                                   f24::FromFloat32(-vertex.depth), f24::One()};
+                for (u32 component = 0; component < 4; component++) {
+                    vertices[i].color[component] =
+                        f24::FromFloat32(triangle.color[component] / 255.0f);
+                }
+            }
+            rasterizer->AddTriangle(vertices[0], vertices[1], vertices[2]);
+        }
+        rasterizer->FlushAll();
+    }
+
+    /// Fills the rectangle [x1, x2) x [y1, y2) of the depth buffer like a write by the CPU
+    void ClearDepth(u32 x1, u32 y1, u32 x2, u32 y2, u32 depth) {
+        rasterizer->FlushAndInvalidateRegion(Memory::FCRAM_PADDR + DEPTH_OFFSET,
+                                             FB_SIZE * FB_SIZE * 4);
+        for (u32 y = y1; y < y2; y++) {
+            for (u32 x = x1; x < x2; x++) {
+                fb->SetDepth(x, y, depth);
+            }
+        }
+    }
+
+    void Clear(Common::Vec4<u8> color, u32 depth) {
+        rasterizer->FlushAndInvalidateRegion(Memory::FCRAM_PADDR + COLOR_OFFSET,
+                                             FB_SIZE * FB_SIZE * 4);
+        for (u32 y = 0; y < FB_SIZE; y++) {
+            for (u32 x = 0; x < FB_SIZE; x++) {
+                fb->DrawPixel(x, y, color);
+            }
+        }
+        ClearDepth(0, 0, FB_SIZE, FB_SIZE, depth);
+    }
+
+    Common::Vec4<u8> GetPixel(u32 x, u32 y) const {
+        return fb->GetPixel(x, y);
+    }
+
+    u32 GetDepth(u32 x, u32 y) const {
+        return fb->GetDepth(x, y);
+    }
+
+private:
+    Core::System system;
+    Memory::MemorySystem memory{system};
+    std::unique_ptr<Pica::PicaCore> pica;
+    std::unique_ptr<RasterizerSoftware> rasterizer;
+    std::unique_ptr<Framebuffer> fb;
+};
+
+/// Checks that the rasterizer writes the pixels the per-pixel edge function loop would write
+void RequireSameCoverage(RasterizerTest& test, std::span<const TestTriangle> triangles) {
+    std::vector<Common::Vec4<u8>> expected(FB_SIZE * FB_SIZE);
+    for (const TestTriangle& triangle : triangles) {
+        for (const auto& pixel : GetCoveredPixels(triangle)) {
+            expected[pixel.y * FB_SIZE + pixel.x] = triangle.color;
+        }
+    }
+
+    test.Clear({0, 0, 0, 0}, 0);
+    test.Draw(triangles);
+    for (u32 y = 0; y < FB_SIZE; y++) {
+        for (u32 x = 0; x < FB_SIZE; x++) {
+            REQUIRE(test.GetPixel(x, y) == expected[y * FB_SIZE + x]);
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("GetTileRange covers the bounding box", "[video_core][renderer_software]") {
+    SECTION("Box within a single tile") {
+        const TileRange tiles = GetTileRange(Fix(1), Fix(2), Fix(5), Fix(TILE_SIZE));
+        REQUIRE(tiles.x1 == 0);
+        REQUIRE(tiles.y1 == 0);
+        REQUIRE(tiles.x2 == 1);
+        REQUIRE(tiles.y2 == 1);
+    }
+
+    SECTION("Max edges on a tile boundary are excluded") {
+        const TileRange tiles = GetTileRange(Fix(TILE_SIZE), Fix(TILE_SIZE - 1),
+                                             Fix(3 * TILE_SIZE), Fix(TILE_SIZE + 1));
+        REQUIRE(tiles.x1 == 1);
+        REQUIRE(tiles.y1 == 0);
+        REQUIRE(tiles.x2 == 3);
+        REQUIRE(tiles.y2 == 2);
+    }
+
+    SECTION("Boxes ending within the first pixel do not wrap around") {
+        const TileRange tiles = GetTileRange(0, 0, 15, 8);
+        REQUIRE(tiles.x1 == 0);
+        REQUIRE(tiles.y1 == 0);
+        REQUIRE(tiles.x2 == 0);
+        REQUIRE(tiles.y2 == 0);
+
+        const TileRange first_pixel = GetTileRange(0, 0, Fix(1), Fix(1));
+        REQUIRE(first_pixel.x2 == 1);
+        REQUIRE(first_pixel.y2 == 1);
+    }
+
+    SECTION("Pixels past the tile grid belong to the last tile") {
+        const TileRange tiles = GetTileRange(Fix(1030), Fix(NUM_TILES_Y * TILE_SIZE - 1),
+                                             Fix(2000), Fix(NUM_TILES_Y * TILE_SIZE + 40));
+        REQUIRE(tiles.x1 == NUM_TILES_X - 1);
+        REQUIRE(tiles.y1 == NUM_TILES_Y - 1);
+        REQUIRE(tiles.x2 == NUM_TILES_X);
+        REQUIRE(tiles.y2 == NUM_TILES_Y);
+    }
+}
+
+TEST_CASE("RasterizerSoftware quads cover the same pixels as the per-pixel loop",
+          "[video_core][renderer_software]") {
+    RasterizerTest test;
+
+    SECTION("Fans with edges through pixel centers") {
+        // Vertical, horizontal and diagonal edges pass exactly through pixel centers, where the
+        // fill rules decide which of the two triangles sharing the edge draws the pixel.
+        const std::array<TestVertex, 8> ring = {{
+            {Fix(3, 8), Fix(3, 8)},
+            {Fix(31, 8), Fix(3, 8)},
+            {Fix(60, 8), Fix(3, 8)},
+            {Fix(60, 8), Fix(32, 8)},
+            {Fix(60, 8), Fix(61, 8)},
+            {Fix(31, 8), Fix(61, 8)},
+            {Fix(3, 8), Fix(61, 8)},
+            {Fix(3, 8), Fix(32, 8)},
+        }};
+        RequireSameCoverage(test, MakeFan({Fix(31, 8), Fix(32, 8)}, ring));
+
+        // The same fan wound the other way around
+        std::array<TestVertex, 8> reversed_ring;
+        std::reverse_copy(ring.begin(), ring.end(), reversed_ring.begin());
+        RequireSameCoverage(test, MakeFan({Fix(31, 8), Fix(32, 8)}, reversed_ring));
+    }
+
+    SECTION("Fans with subpixel vertices") {
+        const std::array<TestVertex, 6> ring = {{
+            {Fix(1, 3), Fix(2, 13)},
+            {Fix(32), Fix(0, 5)},
+            {Fix(63, 11), Fix(17, 1)},
+            {Fix(58, 7), Fix(63, 15)},
+            {Fix(29, 9), Fix(47, 2)},
+            {Fix(0), Fix(40, 4)},
+        }};
+        RequireSameCoverage(test, MakeFan({Fix(33, 1), Fix(31, 15)}, ring));
+    }
+
+    SECTION("Random triangles") {
+        std::mt19937 rng{1234};
+        RequireSameCoverage(test, MakeRandomTriangles(rng, 64, Fix(FB_SIZE)));
+        RequireSameCoverage(test, MakeRandomTriangles(rng, 256, Fix(6)));
+        // Slivers narrower than a pixel only cover pixel centers at some positions
+        RequireSameCoverage(test, MakeRandomTriangles(rng, 256, 24));
+    }
+}
+
+TEST_CASE("RasterizerSoftware depth bounds never reject visible fragments",
+          "[video_core][renderer_software]") {
+    RasterizerTest test;
+    std::mt19937 rng{5678};
+    const auto first_batch = MakeRandomTriangles(rng, 128, Fix(24));
+    auto second_batch = MakeRandomTriangles(rng, 128, Fix(24));
+    // Redrawing a triangle at the same depth only passes the depth tests allowing equal depths
+    TestTriangle coplanar{{{{Fix(2, 5), Fix(1, 3), 0.375f},
+                            {Fix(62, 1), Fix(9), 0.375f},
+                            {Fix(20, 7), Fix(63, 2), 0.375f}}},
+                          MakeColor(1)};
+    second_batch.push_back(coplanar);
+    coplanar.color = MakeColor(2);
+    second_batch.push_back(coplanar);
+
+    const auto render = [&](FramebufferRegs::CompareFunc func, bool depth_bounds) {
+        auto& output_merger = test.Regs().framebuffer.output_merger;
+        output_merger.depth_test_enable.Assign(1);
+        output_merger.depth_test_func.Assign(func);
+        output_merger.depth_write_enable.Assign(1);
+        // A stencil test that always passes and keeps the stencil turns the depth bounds off
+        output_merger.stencil_test.enable.Assign(depth_bounds ? 0 : 1);
+        output_merger.stencil_test.func.Assign(FramebufferRegs::CompareFunc::Always);
+
+        // Each draw writes the depth of parts of the blocks the later triangles are tested
+        // against, and the clears do not line up with the blocks either.
+        test.Clear({0, 0, 0, 0}, 0x800000);
+        test.Draw(first_batch);
+        test.ClearDepth(5, 3, 37, 22, 0x100000);
+        test.ClearDepth(40, 30, FB_SIZE, 61, 0xF00000);
+        test.Draw(second_batch);
+
+        std::vector<u32> result;
+        for (u32 y = 0; y < FB_SIZE; y++) {
+            for (u32 x = 0; x < FB_SIZE; x++) {
+                const auto color = test.GetPixel(x, y);
+                result.push_back(color.r() << 24 | color.g() << 16 | color.b() << 8 | color.a());
+                result.push_back(test.GetDepth(x, y));
+            }
+        }
+        return result;
+    };
+
+    for (const auto func :
+         {FramebufferRegs::CompareFunc::LessThan, FramebufferRegs::CompareFunc::LessThanOrEqual,
+          FramebufferRegs::CompareFunc::GreaterThan,
+          FramebufferRegs::CompareFunc::GreaterThanOrEqual}) {
+        REQUIRE(render(func, true) == render(func, false));
+    }
+}
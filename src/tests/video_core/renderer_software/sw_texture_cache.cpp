@@ -0,0 +1,109 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/core.h"
+#include "core/memory.h"
+#include "video_core/renderer_software/sw_texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+
+using namespace SwRenderer;
+using Pica::TexturingRegs;
+using Pica::Texture::TextureInfo;
+
+namespace {
+
+TextureInfo MakeTextureInfo(PAddr addr, u32 size) {
+    TextureInfo info{
+        .physical_address = addr,
+        .width = size,
+        .height = size,
+        .stride = 0,
+        .format = TexturingRegs::TextureFormat::RGBA8,
+    };
+    info.SetDefaultStride();
+    return info;
+}
+
+u32 GetTextureSize(const TextureInfo& info) {
+    return static_cast<u32>(info.stride * info.height / 8);
+}
+
+/// Sets every byte of the texture, so that all texels hold the value in every component
+void FillTexture(Memory::MemorySystem& memory, const TextureInfo& info, u8 value) {
+    std::memset(memory.GetPhysicalPointer(info.physical_address), value, GetTextureSize(info));
+}
+
+Common::Vec4<u8> Texel(u8 value) {
+    return {value, value, value, value};
+}
+
+} // Anonymous namespace
+
+TEST_CASE("TextureCache reuses textures until the CPU writes them",
+          "[video_core][renderer_software]") {
+    Core::System system;
+    Memory::MemorySystem memory{system};
+    TextureCache cache{memory};
+
+    const TextureInfo first = MakeTextureInfo(Memory::FCRAM_PADDR, 64);
+    const TextureInfo second = MakeTextureInfo(first.physical_address + GetTextureSize(first), 64);
+    FillTexture(memory, first, 0x11);
+    FillTexture(memory, second, 0x22);
+    cache.Trim();
+    const DecodedTexture* first_texture = cache.GetTexture(first);
+    const DecodedTexture* second_texture = cache.GetTexture(second);
+    REQUIRE(first_texture->GetTexel(3, 5) == Texel(0x11));
+    REQUIRE(second_texture->GetTexel(60, 1) == Texel(0x22));
+
+    // The next bind gets the decoded textures without reading them from memory again
+    FillTexture(memory, first, 0x33);
+    cache.Trim();
+    REQUIRE(cache.GetTexture(first) == first_texture);
+    REQUIRE(first_texture->GetTexel(3, 5) == Texel(0x11));
+
+    // A CPU write invalidates the textures it overlaps, which are decoded again on the next bind
+    cache.InvalidateRegion(first.physical_address + 0x100, 4);
+    cache.Trim();
+    REQUIRE(cache.GetTexture(first)->GetTexel(3, 5) == Texel(0x33));
+    REQUIRE(cache.GetTexture(second) == second_texture);
+}
+
+TEST_CASE("TextureCache trims the least recently used textures",
+          "[video_core][renderer_software]") {
+    Core::System system;
+    Memory::MemorySystem memory{system};
+    TextureCache cache{memory};
+
+    // The cache holds 64MB of decoded texels, which is 16 textures of 1024x1024
+    std::vector<TextureInfo> infos;
+    PAddr addr = Memory::FCRAM_PADDR;
+    for (u32 i = 0; i < 17; i++) {
+        infos.push_back(MakeTextureInfo(addr, 1024));
+        addr += GetTextureSize(infos.back());
+    }
+
+    std::vector<const DecodedTexture*> textures;
+    for (u32 i = 0; i < 16; i++) {
+        FillTexture(memory, infos[i], static_cast<u8>(i));
+        textures.push_back(cache.GetTexture(infos[i]));
+    }
+    cache.Trim();
+
+    // The first texture is used again, which leaves the second one as the least recently used
+    REQUIRE(cache.GetTexture(infos[0]) == textures[0]);
+    FillTexture(memory, infos[16], 16);
+    cache.GetTexture(infos[16]);
+
+    // Textures kept by the cache are not read from memory again
+    for (const u32 i : {0, 1, 2}) {
+        FillTexture(memory, infos[i], 0xFF);
+    }
+    cache.Trim();
+    REQUIRE(cache.GetTexture(infos[0])->GetTexel(0, 0) == Texel(0));
+    REQUIRE(cache.GetTexture(infos[1])->GetTexel(0, 0) == Texel(0xFF));
+    REQUIRE(cache.GetTexture(infos[2])->GetTexel(0, 0) == Texel(2));
+}
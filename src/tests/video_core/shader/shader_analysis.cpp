@@ -0,0 +1,176 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <catch2/catch_test_macros.hpp>
+#include <nihstro/inline_assembly.h>
+#include "video_core/pica/shader_setup.h"
+#include "video_core/shader/shader_analysis.h"
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+using SwizzlePattern = nihstro::SwizzlePattern;
+
+static std::unique_ptr<Pica::ShaderSetup> CompileShaderSetup(
+    std::initializer_list<nihstro::InlineAsm> code) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    auto shader = std::make_unique<Pica::ShaderSetup>();
+
+    std::transform(shbin.program.begin(), shbin.program.end(), shader->program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   shader->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+
+    return shader;
+}
+
+static std::optional<u16> Analyze(const Pica::ShaderSetup& setup) {
+    return Pica::Shader::AnalyzeIsolation(setup.program_code, setup.swizzle_data, 0);
+}
+
+/// Encodes "cmp input0, lt, lt, input1", whose swizzle pattern is stored in the setup.
+static u32 MakeCompare(Pica::ShaderSetup& setup) {
+    constexpr u32 cmp_operand_desc_id = 16;
+    SwizzlePattern swizzle = {};
+    swizzle.dest_mask = 0b1111;
+    for (int i = 0; i < 4; ++i) {
+        swizzle.SetSelectorSrc1(i, static_cast<SwizzlePattern::Selector>(i));
+        swizzle.SetSelectorSrc2(i, static_cast<SwizzlePattern::Selector>(i));
+    }
+    setup.swizzle_data[cmp_operand_desc_id] = swizzle.hex;
+
+    using CompareOp = nihstro::Instruction::Common::CompareOpType;
+    nihstro::Instruction CMP = {};
+    CMP.opcode = nihstro::OpCode(nihstro::OpCode::Id::CMP);
+    CMP.common.operand_desc_id = cmp_operand_desc_id;
+    CMP.common.src1 = SourceRegister::MakeInput(0);
+    CMP.common.src2 = SourceRegister::MakeInput(1);
+    CMP.common.compare_op.x = CompareOp::LessThan;
+    CMP.common.compare_op.y = CompareOp::LessThan;
+    return CMP.hex;
+}
+
+/// Encodes "ifc cmp.x" whose IF block ends at else_offset, followed by a one instruction ELSE.
+static u32 MakeIfc(u32 else_offset) {
+    nihstro::Instruction IFC = {};
+    IFC.opcode = nihstro::OpCode(nihstro::OpCode::Id::IFC);
+    IFC.flow_control.op = nihstro::Instruction::FlowControlType::JustX;
+    IFC.flow_control.refx = 1;
+    IFC.flow_control.dest_offset = else_offset;
+    IFC.flow_control.num_instructions = 1;
+    return IFC.hex;
+}
+
+TEST_CASE("Isolation of straight-line programs", "[video_core][shader][shader_analysis]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_temp_src = SourceRegister::MakeTemporary(0);
+    const auto sh_temp_dest = DestRegister::MakeTemporary(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    // Temporaries written before they are read
+    auto writes_first = CompileShaderSetup({
+        {OpCode::Id::MOV, sh_temp_dest, sh_input},
+        {OpCode::Id::ADD, sh_output, sh_input, sh_temp_src},
+        {OpCode::Id::END},
+    });
+    REQUIRE(Analyze(*writes_first) == 0b1);
+
+    // A temporary read before it is written sees the previous vertex
+    auto reads_first = CompileShaderSetup({
+        {OpCode::Id::ADD, sh_output, sh_input, sh_temp_src},
+        {OpCode::Id::MOV, sh_temp_dest, sh_input},
+        {OpCode::Id::END},
+    });
+    REQUIRE(Analyze(*reads_first) == std::nullopt);
+
+    // Only the components selected by the swizzle are read
+    auto partial_write = CompileShaderSetup({
+        {OpCode::Id::MOV, sh_temp_dest, "x", sh_input, "xyzw", SourceRegister{}, ""},
+        {OpCode::Id::MOV, sh_output, "xyzw", sh_temp_src, "xxxx", SourceRegister{}, ""},
+        {OpCode::Id::END},
+    });
+    REQUIRE(Analyze(*partial_write) == 0b1);
+
+    auto partial_read = CompileShaderSetup({
+        {OpCode::Id::MOV, sh_temp_dest, "x", sh_input, "xyzw", SourceRegister{}, ""},
+        {OpCode::Id::MOV, sh_output, "xyzw", sh_temp_src, "xyzw", SourceRegister{}, ""},
+        {OpCode::Id::END},
+    });
+    REQUIRE(Analyze(*partial_read) == std::nullopt);
+}
+
+TEST_CASE("Isolation of relative addressing", "[video_core][shader][shader_analysis]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_c0 = SourceRegister::MakeFloat(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    // The address register is left by the previous vertex
+    auto stale_address = CompileShaderSetup({
+        {OpCode::Id::MOV, sh_output, "xyzw", sh_c0, "xyzw", SourceRegister{}, "",
+         nihstro::InlineAsm::RelativeAddress::A1},
+        {OpCode::Id::END},
+    });
+    REQUIRE(Analyze(*stale_address) == std::nullopt);
+
+    auto written_address = CompileShaderSetup({
+        {OpCode::Id::MOVA, DestRegister{}, "x", sh_input, "x", SourceRegister{}, "",
+         nihstro::InlineAsm::RelativeAddress::A1},
+        {OpCode::Id::MOV, sh_output, "xyzw", sh_c0, "xyzw", SourceRegister{}, "",
+         nihstro::InlineAsm::RelativeAddress::A1},
+        {OpCode::Id::END},
+    });
+    REQUIRE(Analyze(*written_address) == 0b1);
+}
+
+TEST_CASE("Isolation of branches", "[video_core][shader][shader_analysis]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_temp_src = SourceRegister::MakeTemporary(0);
+    const auto sh_temp_dest = DestRegister::MakeTemporary(0);
+    const auto sh_output1 = DestRegister::MakeOutput(0);
+    const auto sh_output2 = DestRegister::MakeOutput(1);
+
+    // Both branches write the temporary, only the IF block writes the second output
+    auto both_branches = CompileShaderSetup({
+        {OpCode::Id::NOP}, // cmp
+        {OpCode::Id::NOP}, // ifc cmp.x
+        {OpCode::Id::MOV, sh_temp_dest, sh_input},
+        {OpCode::Id::MOV, sh_output2, sh_input},
+        // else
+        {OpCode::Id::MOV, sh_temp_dest, sh_input},
+        {OpCode::Id::MOV, sh_output1, sh_temp_src},
+        {OpCode::Id::END},
+    });
+    both_branches->program_code[0] = MakeCompare(*both_branches);
+    both_branches->program_code[1] = MakeIfc(4);
+    REQUIRE(Analyze(*both_branches) == 0b1);
+
+    // Vertices taking the ELSE block keep the temporary of the last vertex that took the IF block
+    auto one_branch = CompileShaderSetup({
+        {OpCode::Id::NOP}, // cmp
+        {OpCode::Id::NOP}, // ifc cmp.x
+        {OpCode::Id::MOV, sh_temp_dest, sh_input},
+        // else
+        {OpCode::Id::MOV, sh_output2, sh_input},
+        {OpCode::Id::MOV, sh_output1, sh_input},
+        {OpCode::Id::END},
+    });
+    one_branch->program_code[0] = MakeCompare(*one_branch);
+    one_branch->program_code[1] = MakeIfc(3);
+    REQUIRE(Analyze(*one_branch) == std::nullopt);
+
+    // The condition codes are left by the previous vertex
+    auto stale_condition = CompileShaderSetup({
+        {OpCode::Id::NOP}, // ifc cmp.x
+        {OpCode::Id::MOV, sh_output1, sh_input},
+        // else
+        {OpCode::Id::MOV, sh_output1, sh_input},
+        {OpCode::Id::END},
+    });
+    stale_condition->program_code[0] = MakeIfc(2);
+    REQUIRE(Analyze(*stale_condition) == std::nullopt);
+}
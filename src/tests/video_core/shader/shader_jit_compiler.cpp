@@ -6,6 +6,7 @@
 #if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <memory>
 #include <span>
@@ -13,11 +14,15 @@
 #include <catch2/catch_test_macros.hpp>
 #include <fmt/format.h>
 #include <nihstro/inline_assembly.h>
+#include "common/bit_set.h"
+#include "video_core/pica/regs_shader.h"
 #include "video_core/pica/shader_setup.h"
 #include "video_core/pica/shader_unit.h"
 #include "video_core/shader/shader_interpreter.h"
+#include "video_core/shader/shader_jit.h"
 #if CITRA_ARCH(x86_64)
 #include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/shader/shader_jit_x64_soa_compiler.h"
 #elif CITRA_ARCH(arm64)
 #include "video_core/shader/shader_jit_a64_compiler.h"
 #endif
@@ -702,4 +707,265 @@ TEST_CASE("Source Swizzle", "[video_core][shader][shader_jit]") {
             Common::Vec4f(iota_vec.y, iota_vec.y, iota_vec.y, iota_vec.y));
 }
 
+#if CITRA_ARCH(x86_64)
+static std::array<u32, 4> ToBits(const Common::Vec4<Pica::f24>& value) {
+    return {std::bit_cast<u32>(value.x.ToFloat32()), std::bit_cast<u32>(value.y.ToFloat32()),
+            std::bit_cast<u32>(value.z.ToFloat32()), std::bit_cast<u32>(value.w.ToFloat32())};
+}
+
+/// Returns a shader unit with every register set to a known value
+static Pica::ShaderUnit MakeSeedUnit() {
+    Pica::ShaderUnit seed;
+    seed.address_registers[0] = seed.address_registers[1] = seed.address_registers[2] = 0;
+    seed.conditional_code[0] = seed.conditional_code[1] = false;
+    seed.input.fill(Common::Vec4<Pica::f24>::AssignToAll(Pica::f24::Zero()));
+    seed.output.fill(Common::Vec4<Pica::f24>::AssignToAll(Pica::f24::Zero()));
+    seed.temporary.fill(Common::Vec4<Pica::f24>::AssignToAll(Pica::f24::FromFloat32(0.5f)));
+    return seed;
+}
+
+/// Runs a batch through the SoA shader and each of its vertices through the scalar JIT, starting
+/// from the same shader unit state, and requires bit-identical outputs.
+static void RequireSoAMatchesScalar(const JitShader& shader_jit,
+                                    const Pica::Shader::JitShaderSoA& shader_soa,
+                                    const Pica::ShaderSetup& shader_setup,
+                                    const Pica::ShaderRegs& config,
+                                    std::span<const Pica::AttributeBuffer> inputs) {
+    const Pica::ShaderUnit seed = MakeSeedUnit();
+
+    std::vector<Pica::AttributeBuffer> outputs(inputs.size());
+    Pica::ShaderUnit soa_unit = seed;
+    Pica::Shader::ShaderUnitSoA soa_state;
+    REQUIRE(shader_soa.Run(shader_setup, config, soa_state, soa_unit, inputs, outputs));
+
+    const u32 num_outputs = Common::BitSet<u32>(config.output_mask).Count();
+    for (std::size_t lane = 0; lane < inputs.size(); ++lane) {
+        Pica::ShaderUnit shader_unit = seed;
+        shader_unit.LoadInput(config, inputs[lane]);
+        shader_jit.Run(shader_setup, shader_unit, 0);
+
+        Pica::AttributeBuffer expected{};
+        shader_unit.WriteOutput(config, expected);
+        for (u32 i = 0; i < num_outputs; ++i) {
+            REQUIRE(ToBits(outputs[lane][i]) == ToBits(expected[i]));
+        }
+    }
+}
+
+/**
+ * Runs a batch through JitEngine::RunBatch and the same vertices one after another through the
+ * scalar JIT on a single shader unit, and requires bit-identical outputs and unit state.
+ */
+static void RequireBatchMatchesInOrder(Pica::ShaderSetup& shader_setup,
+                                       const Pica::ShaderRegs& config,
+                                       std::span<const Pica::AttributeBuffer> inputs,
+                                       bool expect_isolated) {
+    Pica::Shader::JitEngine engine{0};
+    engine.SetupBatch(shader_setup, 0);
+    REQUIRE(shader_setup.cached_shader != nullptr);
+    REQUIRE(shader_setup.cached_batch_shader != nullptr);
+    REQUIRE(shader_setup.IsIsolated(config) == expect_isolated);
+
+    const Pica::ShaderUnit seed = MakeSeedUnit();
+    Pica::ShaderUnit batch_unit = seed;
+    std::vector<Pica::AttributeBuffer> outputs(inputs.size());
+    engine.RunBatch(shader_setup, config, batch_unit, inputs, outputs);
+
+    const auto& shader_jit = *static_cast<const JitShader*>(shader_setup.cached_shader);
+    Pica::ShaderUnit shader_unit = seed;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        shader_unit.LoadInput(config, inputs[i]);
+        shader_jit.Run(shader_setup, shader_unit, shader_setup.entry_point);
+
+        Pica::AttributeBuffer expected{};
+        shader_unit.WriteOutput(config, expected);
+        REQUIRE(ToBits(outputs[i][0]) == ToBits(expected[0]));
+    }
+
+    for (std::size_t reg = 0; reg < shader_unit.temporary.size(); ++reg) {
+        REQUIRE(ToBits(batch_unit.temporary[reg]) == ToBits(shader_unit.temporary[reg]));
+    }
+    for (std::size_t i = 0; i < 3; ++i) {
+        REQUIRE(batch_unit.address_registers[i] == shader_unit.address_registers[i]);
+    }
+    for (std::size_t i = 0; i < 2; ++i) {
+        REQUIRE(batch_unit.conditional_code[i] == shader_unit.conditional_code[i]);
+    }
+}
+
+TEST_CASE("SoA Divergent Branches", "[video_core][shader][shader_jit]") {
+    if (!Pica::Shader::JitShaderSoA::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input1 = SourceRegister::MakeInput(0);
+    const auto sh_input2 = SourceRegister::MakeInput(1);
+    const auto sh_c0 = SourceRegister::MakeFloat(0);
+    const auto sh_output1 = DestRegister::MakeOutput(0);
+    const auto sh_output2 = DestRegister::MakeOutput(1);
+
+    auto shader_setup = CompileShaderSetup({
+        // mova a0.x, sh_input1.x
+        {OpCode::Id::MOVA, DestRegister{}, "x", sh_input1, "x", SourceRegister{}, "",
+         nihstro::InlineAsm::RelativeAddress::A1},
+        // mov sh_output1.xyzw, c0[a0.x].xyzw
+        {OpCode::Id::MOV, sh_output1, "xyzw", sh_c0, "xyzw", SourceRegister{}, "",
+         nihstro::InlineAsm::RelativeAddress::A1},
+        {OpCode::Id::NOP}, // cmp sh_input1, lt, lt, sh_input2
+        {OpCode::Id::NOP}, // ifc cmp.x
+        {OpCode::Id::EX2, sh_output2, sh_input2},
+        // else
+        {OpCode::Id::MOV, sh_output2, sh_input1},
+        {OpCode::Id::END},
+    });
+
+    // nihstro does not support the CMP and IFC instructions, so the instruction-binaries must be
+    // manually inserted here:
+    constexpr u32 cmp_operand_desc_id = 16;
+    nihstro::SwizzlePattern swizzle = {};
+    swizzle.dest_mask = 0b1111;
+    swizzle.SetSelectorSrc1(0, SwizzlePattern::Selector::x);
+    swizzle.SetSelectorSrc1(1, SwizzlePattern::Selector::y);
+    swizzle.SetSelectorSrc1(2, SwizzlePattern::Selector::z);
+    swizzle.SetSelectorSrc1(3, SwizzlePattern::Selector::w);
+    swizzle.SetSelectorSrc2(0, SwizzlePattern::Selector::x);
+    swizzle.SetSelectorSrc2(1, SwizzlePattern::Selector::y);
+    swizzle.SetSelectorSrc2(2, SwizzlePattern::Selector::z);
+    swizzle.SetSelectorSrc2(3, SwizzlePattern::Selector::w);
+    shader_setup->swizzle_data[cmp_operand_desc_id] = swizzle.hex;
+
+    using CompareOp = nihstro::Instruction::Common::CompareOpType;
+    nihstro::Instruction CMP = {};
+    CMP.opcode = nihstro::OpCode(nihstro::OpCode::Id::CMP);
+    CMP.common.operand_desc_id = cmp_operand_desc_id;
+    CMP.common.src1 = sh_input1;
+    CMP.common.src2 = sh_input2;
+    CMP.common.compare_op.x = CompareOp::LessThan;
+    CMP.common.compare_op.y = CompareOp::LessThan;
+    shader_setup->program_code[2] = CMP.hex;
+
+    nihstro::Instruction IFC = {};
+    IFC.opcode = nihstro::OpCode(nihstro::OpCode::Id::IFC);
+    IFC.flow_control.op = nihstro::Instruction::FlowControlType::JustX;
+    IFC.flow_control.refx = 1;
+    IFC.flow_control.dest_offset = 5;
+    IFC.flow_control.num_instructions = 1;
+    shader_setup->program_code[3] = IFC.hex;
+
+    for (u32 i = 0; i < 96; ++i) {
+        const auto value = Pica::f24::FromFloat32(static_cast<float>(i) * 0.5f);
+        shader_setup->uniforms.f[i] = {value, value, value, Pica::f24::One()};
+    }
+
+    JitShader shader_jit;
+    shader_jit.Compile(&shader_setup->program_code, &shader_setup->swizzle_data);
+    Pica::Shader::JitShaderSoA shader_soa;
+    shader_soa.Compile(&shader_setup->program_code, &shader_setup->swizzle_data);
+
+    // Lanes whose first input is below the second take the IF block, the others the ELSE block.
+    // Some of the relative uniform indices are out of range.
+    std::array<Pica::AttributeBuffer, Pica::Shader::SOA_LANES> inputs{};
+    for (std::size_t lane = 0; lane < inputs.size(); ++lane) {
+        const float index = static_cast<float>(lane) * 17.0f - 20.0f;
+        inputs[lane][0] = Common::Vec4<Pica::f24>::AssignToAll(Pica::f24::FromFloat32(index));
+        inputs[lane][1] = Common::Vec4<Pica::f24>::AssignToAll(Pica::f24::FromFloat32(50.0f));
+    }
+
+    Pica::ShaderRegs config{};
+    config.max_input_attribute_index.Assign(1);
+    config.input_attribute_to_register_map_low = 0x10;
+    config.output_mask.Assign(0b11);
+
+    for (const std::size_t count : {inputs.size(), std::size_t{3}}) {
+        RequireSoAMatchesScalar(shader_jit, shader_soa, *shader_setup, config,
+                                std::span{inputs.data(), count});
+    }
+}
+
+TEST_CASE("SoA EX2 and LG2", "[video_core][shader][shader_jit]") {
+    if (!Pica::Shader::JitShaderSoA::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output1 = DestRegister::MakeOutput(0);
+    const auto sh_output2 = DestRegister::MakeOutput(1);
+
+    const auto shader_setup = CompileShaderSetup({
+        {OpCode::Id::EX2, sh_output1, sh_input},
+        {OpCode::Id::LG2, sh_output2, sh_input},
+        {OpCode::Id::END},
+    });
+
+    JitShader shader_jit;
+    shader_jit.Compile(&shader_setup->program_code, &shader_setup->swizzle_data);
+    Pica::Shader::JitShaderSoA shader_soa;
+    shader_soa.Compile(&shader_setup->program_code, &shader_setup->swizzle_data);
+
+    Pica::ShaderRegs config{};
+    config.max_input_attribute_index.Assign(0);
+    config.input_attribute_to_register_map_low = 0x0;
+    config.output_mask.Assign(0b11);
+
+    // Edge cases of both approximations, followed by values around the limits of the EX2 clamp
+    constexpr std::array values = {
+        NAN,     INFINITY, -INFINITY, 0.0f,    -0.0f,    -1.0f,   1.0e-30f, 1.0f,
+        4.0f,    64.0f,    1.0e24f,   -800.0f, 800.0f,   0.3f,    -0.3f,    79.7262742773f,
+        127.25f, 128.5f,   129.0f,    -125.5f, -126.75f, -127.0f, -128.5f,  2.5f,
+    };
+    static_assert(values.size() % Pica::Shader::SOA_LANES == 0);
+
+    std::vector<Pica::AttributeBuffer> inputs(values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        inputs[i][0] = Common::Vec4<Pica::f24>::AssignToAll(Pica::f24::FromFloat32(values[i]));
+    }
+
+    for (std::size_t i = 0; i < inputs.size(); i += Pica::Shader::SOA_LANES) {
+        RequireSoAMatchesScalar(shader_jit, shader_soa, *shader_setup, config,
+                                std::span{inputs}.subspan(i, Pica::Shader::SOA_LANES));
+    }
+}
+
+TEST_CASE("SoA Shader Unit State", "[video_core][shader][shader_jit]") {
+    if (!Pica::Shader::JitShaderSoA::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_temp_src = SourceRegister::MakeTemporary(0);
+    const auto sh_temp_dest = DestRegister::MakeTemporary(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    Pica::ShaderRegs config{};
+    config.max_input_attribute_index.Assign(0);
+    config.input_attribute_to_register_map_low = 0x0;
+    config.output_mask.Assign(0b1);
+
+    // Spans two full SoA batches and a partial one
+    std::vector<Pica::AttributeBuffer> inputs(2 * Pica::Shader::SOA_LANES + 3);
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        inputs[i][0] = Common::Vec4<Pica::f24>::AssignToAll(
+            Pica::f24::FromFloat32(static_cast<float>(i) + 1.0f));
+    }
+
+    SECTION("Writes the temporary before reading it") {
+        auto shader_setup = CompileShaderSetup({
+            {OpCode::Id::MOV, sh_temp_dest, sh_input},
+            {OpCode::Id::ADD, sh_output, sh_input, sh_temp_src},
+            {OpCode::Id::END},
+        });
+        RequireBatchMatchesInOrder(*shader_setup, config, inputs, true);
+    }
+
+    SECTION("Reads the temporary left by the previous vertex") {
+        auto shader_setup = CompileShaderSetup({
+            {OpCode::Id::ADD, sh_output, sh_input, sh_temp_src},
+            {OpCode::Id::MOV, sh_temp_dest, sh_input},
+            {OpCode::Id::END},
+        });
+        RequireBatchMatchesInOrder(*shader_setup, config, inputs, false);
+    }
+}
+#endif
+
 #endif // CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
@@ -0,0 +1,157 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "video_core/shader/shader_jit_disk_cache.h"
+
+using Pica::Shader::JitDiskCache;
+
+namespace {
+
+constexpr u64 TestProgramId = 0x0004000000D15C00;
+
+/// Keeps the cache files in a temporary directory
+class DiskCacheFixture {
+public:
+    DiskCacheFixture() {
+        shader_dir = (std::filesystem::temp_directory_path() / "citra_shader_cache_test").string();
+        FileUtil::CreateFullPath(shader_dir + DIR_SEP);
+        old_shader_dir = FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir);
+        FileUtil::UpdateUserPath(FileUtil::UserPath::ShaderDir, shader_dir);
+        path = fmt::format("{}" DIR_SEP "jit" DIR_SEP "{:016X}.bin", shader_dir, TestProgramId);
+    }
+
+    ~DiskCacheFixture() {
+        FileUtil::DeleteDirRecursively(shader_dir);
+        FileUtil::UpdateUserPath(FileUtil::UserPath::ShaderDir, old_shader_dir);
+    }
+
+    std::string path;
+
+private:
+    std::string shader_dir;
+    std::string old_shader_dir;
+};
+
+JitDiskCache::Entry MakeProgram(u32 seed) {
+    JitDiskCache::Entry entry{};
+    for (u32 i = 0; i < 16; ++i) {
+        entry.program_code[i] = seed * 0x9E3779B9 + i;
+        entry.swizzle_data[i] = seed + i;
+    }
+    entry.cache_key = Common::HashCombine(
+        Common::ComputeHash64(&entry.program_code, sizeof(entry.program_code)),
+        Common::ComputeHash64(&entry.swizzle_data, sizeof(entry.swizzle_data)));
+    return entry;
+}
+
+void Store(const JitDiskCache::Entry& program) {
+    JitDiskCache cache{TestProgramId};
+    cache.Save(program.cache_key, program.program_code, program.swizzle_data);
+}
+
+std::vector<u64> LoadKeys() {
+    JitDiskCache cache{TestProgramId};
+    std::vector<u64> keys;
+    for (const auto& entry : cache.Load()) {
+        keys.push_back(entry.cache_key);
+    }
+    return keys;
+}
+
+std::vector<u8> ReadFile(const std::string& path) {
+    std::vector<u8> data(FileUtil::GetSize(path));
+    FileUtil::IOFile file(path, "rb");
+    file.ReadBytes(data.data(), data.size());
+    return data;
+}
+
+void WriteFile(const std::string& path, const std::vector<u8>& data) {
+    FileUtil::IOFile file(path, "wb");
+    file.WriteBytes(data.data(), data.size());
+}
+
+} // Anonymous namespace
+
+TEST_CASE("JitDiskCache stores programs across sessions", "[video_core][shader][disk_cache]") {
+    DiskCacheFixture fixture;
+    const auto program_a = MakeProgram(1);
+    const auto program_b = MakeProgram(2);
+
+    REQUIRE(LoadKeys().empty());
+    Store(program_a);
+    Store(program_b);
+    // Stored again by a later session, it is only loaded once
+    Store(program_a);
+
+    JitDiskCache cache{TestProgramId};
+    const auto entries = cache.Load();
+    REQUIRE(entries.size() == 2);
+    REQUIRE(entries[0].cache_key == program_a.cache_key);
+    REQUIRE(entries[0].program_code == program_a.program_code);
+    REQUIRE(entries[0].swizzle_data == program_a.swizzle_data);
+    REQUIRE(entries[1].cache_key == program_b.cache_key);
+}
+
+TEST_CASE("JitDiskCache discards files of other versions", "[video_core][shader][disk_cache]") {
+    DiskCacheFixture fixture;
+    const auto program = MakeProgram(1);
+    Store(program);
+
+    auto data = ReadFile(fixture.path);
+    u32 version{};
+    std::memcpy(&version, data.data(), sizeof(version));
+
+    SECTION("older version") {
+        const u32 old_version = version - 1;
+        std::memcpy(data.data(), &old_version, sizeof(old_version));
+        WriteFile(fixture.path, data);
+
+        // The file is replaced by an empty one, which new programs are stored to
+        REQUIRE(LoadKeys().empty());
+        REQUIRE(FileUtil::GetSize(fixture.path) == sizeof(version));
+        Store(program);
+        REQUIRE(LoadKeys() == std::vector<u64>{program.cache_key});
+    }
+
+    SECTION("newer version") {
+        const u32 new_version = version + 1;
+        std::memcpy(data.data(), &new_version, sizeof(new_version));
+        WriteFile(fixture.path, data);
+
+        // The file is left for the newer emulator
+        REQUIRE(LoadKeys().empty());
+        REQUIRE(ReadFile(fixture.path) == data);
+    }
+}
+
+TEST_CASE("JitDiskCache discards truncated files", "[video_core][shader][disk_cache]") {
+    DiskCacheFixture fixture;
+    const auto program_a = MakeProgram(1);
+    const auto program_b = MakeProgram(2);
+    Store(program_a);
+    const std::size_t first_entry_end = FileUtil::GetSize(fixture.path);
+    Store(program_b);
+
+    auto data = ReadFile(fixture.path);
+    SECTION("inside an entry") {
+        data.resize(data.size() - 1);
+    }
+    SECTION("inside an entry header") {
+        data.resize(first_entry_end + sizeof(u64));
+    }
+    WriteFile(fixture.path, data);
+
+    REQUIRE(LoadKeys().empty());
+    Store(program_b);
+    REQUIRE(LoadKeys() == std::vector<u64>{program_b.cache_key});
+}
@@ -0,0 +1,171 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/arch.h"
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <span>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <nihstro/inline_assembly.h>
+#include "common/settings.h"
+#include "video_core/pica/regs_shader.h"
+#include "video_core/pica/shader_setup.h"
+#include "video_core/pica/shader_unit.h"
+#include "video_core/shader/shader_interpreter.h"
+#include "video_core/shader/shader_jit.h"
+
+namespace {
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+constexpr u32 NUM_PROGRAMS = 32;
+constexpr u32 NUM_VERTICES = 20;
+
+using Outputs = std::vector<std::array<u32, 4>>;
+
+/// Loads a program that reads the float uniform with the given index, each index gives its own
+/// program. The program is isolated, so that it also runs on the batch shader.
+void LoadProgram(Pica::ShaderSetup& setup, u32 index) {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_uniform = SourceRegister::MakeFloat(index);
+    const auto sh_temp_src = SourceRegister::MakeTemporary(0);
+    const auto sh_temp_dest = DestRegister::MakeTemporary(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary({
+        {OpCode::Id::ADD, sh_temp_dest, sh_input, sh_uniform},
+        {OpCode::Id::MUL, sh_output, sh_temp_src, sh_uniform},
+        {OpCode::Id::END},
+    });
+    setup.program_code.fill(0);
+    setup.swizzle_data.fill(0);
+    std::transform(shbin.program.begin(), shbin.program.end(), setup.program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   setup.swizzle_data.begin(), [](const auto& x) { return x.hex; });
+    setup.MarkProgramCodeDirty();
+    setup.MarkSwizzleDataDirty();
+}
+
+std::array<u32, 4> ToBits(const Common::Vec4<Pica::f24>& value) {
+    return {std::bit_cast<u32>(value.x.ToFloat32()), std::bit_cast<u32>(value.y.ToFloat32()),
+            std::bit_cast<u32>(value.z.ToFloat32()), std::bit_cast<u32>(value.w.ToFloat32())};
+}
+
+/// Shades the vertices one at a time and then as a batch, returns the outputs of both
+Outputs Shade(const Pica::ShaderEngine& engine, const Pica::ShaderSetup& setup,
+              const Pica::ShaderRegs& config) {
+    std::vector<Pica::AttributeBuffer> inputs(NUM_VERTICES);
+    for (u32 vertex = 0; vertex < NUM_VERTICES; ++vertex) {
+        const float value = static_cast<float>(vertex) - 4.5f;
+        inputs[vertex][0] = {Pica::f24::FromFloat32(value), Pica::f24::FromFloat32(value * 0.25f),
+                             Pica::f24::FromFloat32(-value), Pica::f24::One()};
+    }
+
+    Outputs outputs;
+    for (const auto& input : inputs) {
+        Pica::ShaderUnit shader_unit;
+        shader_unit.LoadInput(config, input);
+        engine.Run(setup, shader_unit);
+        Pica::AttributeBuffer output{};
+        shader_unit.WriteOutput(config, output);
+        outputs.push_back(ToBits(output[0]));
+    }
+
+    Pica::ShaderUnit shader_unit;
+    std::vector<Pica::AttributeBuffer> batch_outputs(NUM_VERTICES);
+    engine.RunBatch(setup, config, shader_unit, inputs, batch_outputs);
+    for (const auto& output : batch_outputs) {
+        outputs.push_back(ToBits(output[0]));
+    }
+    return outputs;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("JitEngine runs programs with the interpreter until they are compiled",
+          "[video_core][shader][shader_jit]") {
+    const bool async_shader_jit = Settings::values.async_shader_jit.GetValue();
+    Settings::values.async_shader_jit.SetValue(true);
+
+    Pica::Shader::JitEngine engine{0};
+    Pica::Shader::InterpreterEngine interpreter;
+    Pica::ShaderRegs config{};
+    config.output_mask.Assign(0b1);
+    Pica::ShaderSetup setup;
+    for (u32 i = 0; i < setup.uniforms.f.size(); ++i) {
+        const auto value = Pica::f24::FromFloat32(1.0f + static_cast<float>(i) * 0.125f);
+        setup.uniforms.f[i] = {value, -value, value * value, Pica::f24::One()};
+    }
+
+    // The programs are set up back to back on the same ShaderSetup like PicaCore does, each one
+    // overwrites the code of the previous ones while they are compiled in the background. Until
+    // its compiled code is ready, a program is shaded by the interpreter.
+    std::vector<Outputs> expected(NUM_PROGRAMS);
+    for (u32 i = 0; i < NUM_PROGRAMS; ++i) {
+        LoadProgram(setup, i);
+        interpreter.SetupBatch(setup, 0);
+        expected[i] = Shade(interpreter, setup, config);
+
+        engine.SetupBatch(setup, 0);
+        REQUIRE(Shade(engine, setup, config) == expected[i]);
+
+        setup.cached_shader = nullptr;
+        setup.cached_batch_shader = nullptr;
+        REQUIRE(Shade(engine, setup, config) == expected[i]);
+    }
+
+    // Each program picks up its compiled code once it is ready, which shades it like the
+    // interpreter, and keeps it from then on
+    for (u32 i = 0; i < NUM_PROGRAMS; ++i) {
+        LoadProgram(setup, i);
+        for (u32 attempt = 0;; ++attempt) {
+            engine.SetupBatch(setup, 0);
+            REQUIRE(Shade(engine, setup, config) == expected[i]);
+            if (setup.cached_shader != nullptr) {
+                break;
+            }
+            REQUIRE(attempt < 10000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const void* cached_shader = setup.cached_shader;
+        engine.SetupBatch(setup, 0);
+        REQUIRE(setup.cached_shader == cached_shader);
+    }
+
+    Settings::values.async_shader_jit.SetValue(async_shader_jit);
+}
+
+TEST_CASE("JitEngine uses programs compiled on the spot right away",
+          "[video_core][shader][shader_jit]") {
+    const bool async_shader_jit = Settings::values.async_shader_jit.GetValue();
+    Settings::values.async_shader_jit.SetValue(false);
+
+    Pica::Shader::JitEngine engine{0};
+    Pica::Shader::InterpreterEngine interpreter;
+    Pica::ShaderRegs config{};
+    config.output_mask.Assign(0b1);
+    Pica::ShaderSetup setup;
+    setup.uniforms.f[3] = {Pica::f24::FromFloat32(2.0f), Pica::f24::FromFloat32(-0.5f),
+                           Pica::f24::Zero(), Pica::f24::One()};
+
+    LoadProgram(setup, 3);
+    interpreter.SetupBatch(setup, 0);
+    const auto expected = Shade(interpreter, setup, config);
+    engine.SetupBatch(setup, 0);
+    REQUIRE(setup.cached_shader != nullptr);
+    REQUIRE(Shade(engine, setup, config) == expected);
+
+    Settings::values.async_shader_jit.SetValue(async_shader_jit);
+}
+
+#endif // CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
@@ -39,9 +39,9 @@ struct GPU::Impl {
     Service::GSP::InterruptHandler signal_interrupt;
 
     explicit Impl(Core::System& system, Frontend::EmuWindow& emu_window,
-                  Frontend::EmuWindow* secondary_window)
+                  Frontend::EmuWindow* secondary_window, u64 program_id)
         : timing{system.CoreTiming()}, system{system}, memory{system.Memory()},
-          debug_context{Pica::g_debug_context}, pica{memory, debug_context},
+          debug_context{Pica::g_debug_context}, pica{memory, debug_context, program_id},
           renderer{VideoCore::CreateRenderer(emu_window, secondary_window, pica, system)},
           rasterizer{renderer->Rasterizer()}, sw_blitter{std::make_unique<SwRenderer::SwBlitter>(
                                                   memory, rasterizer)} {}
@@ -49,8 +49,8 @@ struct GPU::Impl {
 };
 
 GPU::GPU(Core::System& system, Frontend::EmuWindow& emu_window,
-         Frontend::EmuWindow* secondary_window)
-    : impl{std::make_unique<Impl>(system, emu_window, secondary_window)} {
+         Frontend::EmuWindow* secondary_window, u64 program_id)
+    : impl{std::make_unique<Impl>(system, emu_window, secondary_window, program_id)} {
     impl->vblank_event = impl->timing.RegisterEvent(
         "GPU::VBlankCallback",
         [this](uintptr_t user_data, s64 cycles_late) { VBlankCallback(user_data, cycles_late); });
@@ -44,7 +44,7 @@ class RendererBase;
 class GPU {
 public:
     explicit GPU(Core::System& system, Frontend::EmuWindow& emu_window,
-                 Frontend::EmuWindow* secondary_window);
+                 Frontend::EmuWindow* secondary_window, u64 program_id);
     ~GPU();
 
     /// Sets the function to call for signalling GSP interrupts.
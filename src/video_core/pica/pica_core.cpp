@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <limits>
+#include <thread>
 #include "common/arch.h"
 #include "common/archives.h"
 #include "common/microprofile.h"
@@ -19,6 +22,18 @@ namespace Pica {
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+/// Number of vertices shaded at once by the vertex shader engine
+constexpr u32 VERTEX_BATCH_SIZE = 32;
+/// Number of vertices shaded at once when the batch is split across the vertex shader workers
+constexpr u32 PARALLEL_VERTEX_BATCH_SIZE = 512;
+/// Minimum number of vertices of a draw for it to be shaded by the vertex shader workers
+constexpr u32 PARALLEL_VERTEX_THRESHOLD = 1024;
+/// Number of most recently shaded vertices that are reused by indexed draws
+constexpr u32 VERTEX_CACHE_SIZE = 64;
+/// Number of shaded vertices kept around, the cached ones plus the batch being shaded
+constexpr u32 VERTEX_RING_SIZE = 1024;
+static_assert(PARALLEL_VERTEX_BATCH_SIZE + VERTEX_CACHE_SIZE <= VERTEX_RING_SIZE);
+
 using namespace DebugUtils;
 
 union CommandHeader {
@@ -30,11 +45,13 @@ union CommandHeader {
 };
 static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect size!");
 
-PicaCore::PicaCore(Memory::MemorySystem& memory_, std::shared_ptr<DebugContext> debug_context_)
+PicaCore::PicaCore(Memory::MemorySystem& memory_, std::shared_ptr<DebugContext> debug_context_,
+                   u64 program_id)
     : memory{memory_}, debug_context{std::move(debug_context_)}, geometry_pipeline{regs.internal,
                                                                                    gs_unit,
                                                                                    gs_setup},
-      shader_engine{CreateEngine(Settings::values.use_shader_jit.GetValue())} {
+      shader_engine{CreateEngine(Settings::values.use_shader_jit.GetValue(), program_id)},
+      vs_batch_inputs(VERTEX_RING_SIZE), vs_batch_outputs(VERTEX_RING_SIZE) {
     InitializeRegs();
 
     const auto submit_vertex = [this](const AttributeBuffer& buffer) {
@@ -138,7 +155,9 @@ void PicaCore::WriteInternalReg(u32 id, u32 value, u32 mask) {
     // TODO: Figure out how register masking acts on e.g. vs.uniform_setup.set_value
     const u32 old_value = regs.internal.reg_array[id];
     const u32 write_mask = ExpandBitsToBytes[mask];
-    regs.internal.reg_array[id] = (old_value & ~write_mask) | (value & write_mask);
+    const u32 new_value = (old_value & ~write_mask) | (value & write_mask);
+    rasterizer->NotifyPicaRegisterWrite(id, new_value);
+    regs.internal.reg_array[id] = new_value;
 
     // Track register write.
     DebugUtils::OnPicaRegWrite(id, mask, regs.internal.reg_array[id]);
@@ -542,48 +561,140 @@ void PicaCore::LoadVertices(bool is_indexed) {
     const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
     const bool index_u16 = index_info.format != 0;
 
-    // Simple circular-replacement vertex cache
-    const std::size_t VERTEX_CACHE_SIZE = 64;
-    std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
-    std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-    std::array<AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-    u32 vertex_cache_pos = 0;
+    // Shaded vertices are numbered in order, and their outputs are kept in a ring buffer indexed
+    // by that number. A vertex hits the cache if it is among the last VERTEX_CACHE_SIZE vertices
+    // shaded during this draw, which the direct-mapped table of serial numbers tells without
+    // scanning the cache. Serial numbers of earlier draws are below first_serial and never match.
+    // The table grows to cover the largest index format used so far, zero never matches either.
+    if (is_indexed) {
+        const std::size_t num_indices = index_u16 ? std::numeric_limits<u16>::max() + 1
+                                                  : std::numeric_limits<u8>::max() + 1;
+        if (vertex_cache_serials.size() < num_indices) {
+            vertex_cache_serials.resize(num_indices);
+        }
+    }
+    if (vertex_serial > std::numeric_limits<u32>::max() - pipeline.num_vertices) {
+        std::fill(vertex_cache_serials.begin(), vertex_cache_serials.end(), 0);
+        vertex_serial = 1;
+    }
+    const u32 first_serial = vertex_serial;
+    u32 next_serial = first_serial;
+    u32 cache_hits = 0;
+
+    // Vertices that miss the cache are shaded in batches, which lets the shader engine process
+    // several of them at once. Submitting vertices to the geometry pipeline is deferred until the
+    // batch has been shaded, so that they are still submitted in order. Large draws use bigger
+    // batches, which are split into chunks that are shaded in parallel.
+    const bool use_workers = pipeline.num_vertices >= PARALLEL_VERTEX_THRESHOLD &&
+                             std::thread::hardware_concurrency() > 1;
+    if (use_workers && !vs_workers) {
+        vs_workers = std::make_unique<Common::StatefulThreadWorker<ShaderUnit>>(
+            std::thread::hardware_concurrency() - 1, "VertexShader workers",
+            [](std::size_t) { return ShaderUnit{}; });
+    }
+    const u32 max_batch_size = use_workers ? PARALLEL_VERTEX_BATCH_SIZE : VERTEX_BATCH_SIZE;
+    std::array<u32, PARALLEL_VERTEX_BATCH_SIZE * 2> submit_queue;
+    std::size_t submit_size = 0;
+    u32 batch_start = next_serial;
 
     // Compile the vertex shader for this batch.
     ShaderUnit shader_unit;
-    AttributeBuffer vs_output;
     shader_engine->SetupBatch(vs_setup, regs.internal.vs.main_offset);
 
+    // Vertices can only be shaded out of order if the shader never reads state that the
+    // previous vertex left in the shader unit.
+    vs_setup.AnalyzeProgram();
+    const bool split_batches = use_workers && vs_setup.IsIsolated(regs.internal.vs);
+
     // Setup geometry pipeline in case we are using a geometry shader.
     geometry_pipeline.Reconfigure();
     geometry_pipeline.Setup(shader_engine.get());
     ASSERT(!geometry_pipeline.NeedIndexInput() || is_indexed);
 
+    const auto run_chunk = [this](ShaderUnit& unit, u32 serial, u32 count) {
+        // The vertices are shaded in two parts if they wrap around the end of the ring buffer.
+        const auto run = [&](u32 position, u32 size) {
+            shader_engine->RunBatch(vs_setup, regs.internal.vs, unit,
+                                    std::span{vs_batch_inputs.data() + position, size},
+                                    std::span{vs_batch_outputs.data() + position, size});
+        };
+        const u32 position = serial % VERTEX_RING_SIZE;
+        const u32 head = std::min(count, VERTEX_RING_SIZE - position);
+        run(position, head);
+        if (head < count) {
+            run(0, count - head);
+        }
+    };
+
+    const auto flush_batch = [&] {
+        // Invoke the vertex shader for the batched vertices. When the shader is isolated, each
+        // worker shades a chunk with its own shader unit, while this thread takes care of the
+        // last one. Worker units start from the state this thread's unit has at the start of the
+        // batch, which carries the input registers the attribute loader does not overwrite. As
+        // an isolated shader writes the same registers for every vertex, this thread's unit ends
+        // up in the state it would have after shading the whole batch in order. The outputs are
+        // written to their own slots, so no reordering is needed once all chunks are done.
+        const u32 batch_size = next_serial - batch_start;
+        const u32 num_chunks =
+            split_batches
+                ? std::min<u32>((batch_size + VERTEX_BATCH_SIZE - 1) / VERTEX_BATCH_SIZE,
+                                static_cast<u32>(vs_workers->NumWorkers()) + 1)
+                : 1;
+        if (num_chunks > 1) {
+            const ShaderUnit batch_unit = shader_unit;
+            const u32 chunk_size = (batch_size + num_chunks - 1) / num_chunks;
+            const u32 last_offset = (batch_size - 1) / chunk_size * chunk_size;
+            for (u32 offset = 0; offset < last_offset; offset += chunk_size) {
+                const u32 serial = batch_start + offset;
+                vs_workers->QueueWork(
+                    [&run_chunk, &batch_unit, serial, chunk_size](ShaderUnit* unit) {
+                        *unit = batch_unit;
+                        run_chunk(*unit, serial, chunk_size);
+                    });
+            }
+            run_chunk(shader_unit, batch_start + last_offset, batch_size - last_offset);
+            vs_workers->WaitForRequests();
+        } else if (batch_size > 0) {
+            run_chunk(shader_unit, batch_start, batch_size);
+        }
+
+        // Send to geometry pipeline
+        for (std::size_t i = 0; i < submit_size; ++i) {
+            geometry_pipeline.SubmitVertex(vs_batch_outputs[submit_queue[i] % VERTEX_RING_SIZE]);
+        }
+
+        batch_start = next_serial;
+        submit_size = 0;
+    };
+
     for (u32 index = 0; index < pipeline.num_vertices; ++index) {
         // Indexed rendering doesn't use the start offset
         const u32 vertex = is_indexed
                                ? (index_u16 ? index_address_16[index] : index_address_8[index])
                                : (index + pipeline.vertex_offset);
 
-        bool vertex_cache_hit = false;
+        bool cache_hit = false;
+        u32 serial = next_serial;
         if (is_indexed) {
             if (geometry_pipeline.NeedIndexInput()) {
                 geometry_pipeline.SubmitIndex(vertex);
                 continue;
             }
 
-            for (u32 i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                    vs_output = vertex_cache[i];
-                    vertex_cache_hit = true;
-                    break;
-                }
+            const u32 cached_serial = vertex_cache_serials[vertex];
+            cache_hit =
+                cached_serial >= first_serial && next_serial - cached_serial <= VERTEX_CACHE_SIZE;
+            if (cache_hit) {
+                serial = cached_serial;
+                cache_hits++;
+            } else {
+                vertex_cache_serials[vertex] = serial;
             }
         }
 
-        if (!vertex_cache_hit) {
+        if (!cache_hit) {
             // Initialize data for the current vertex
-            AttributeBuffer input;
+            AttributeBuffer& input = vs_batch_inputs[serial % VERTEX_RING_SIZE];
             loader.LoadVertex(base_address, index, vertex, input, input_default_attributes);
 
             // Record vertex processing to the debugger.
@@ -592,22 +703,21 @@ void PicaCore::LoadVertices(bool is_indexed) {
                                        std::addressof(input));
             }
 
-            // Invoke the vertex shader for this vertex.
-            shader_unit.LoadInput(regs.internal.vs, input);
-            shader_engine->Run(vs_setup, shader_unit);
-            shader_unit.WriteOutput(regs.internal.vs, vs_output);
-
-            // Cache the vertex when doing indexed rendering.
-            if (is_indexed) {
-                vertex_cache[vertex_cache_pos] = vs_output;
-                vertex_cache_valid[vertex_cache_pos] = true;
-                vertex_cache_ids[vertex_cache_pos] = vertex;
-                vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
-            }
+            next_serial++;
         }
 
-        // Send to geometry pipeline
-        geometry_pipeline.SubmitVertex(vs_output);
+        submit_queue[submit_size++] = serial;
+        if (next_serial - batch_start == max_batch_size || submit_size == submit_queue.size()) {
+            flush_batch();
+        }
+    }
+
+    flush_batch();
+    vertex_serial = next_serial;
+
+    if (is_indexed) {
+        MICROPROFILE_META_CPU("Vertex cache hits", static_cast<int>(cache_hits));
+        MICROPROFILE_META_CPU("Vertex cache misses", static_cast<int>(next_serial - first_serial));
     }
 }
 
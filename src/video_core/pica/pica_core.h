@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "common/thread_worker.h"
 #include "core/hle/service/gsp/gsp_interrupt.h"
 #include "video_core/pica/geometry_pipeline.h"
 #include "video_core/pica/packed_attribute.h"
@@ -29,7 +30,8 @@ class ShaderEngine;
 
 class PicaCore {
 public:
-    explicit PicaCore(Memory::MemorySystem& memory, std::shared_ptr<DebugContext> debug_context_);
+    explicit PicaCore(Memory::MemorySystem& memory, std::shared_ptr<DebugContext> debug_context_,
+                      u64 program_id);
     ~PicaCore();
 
     void BindRasterizer(VideoCore::RasterizerInterface* rasterizer);
@@ -251,6 +253,10 @@ public:
     Fog fog{};
     AttributeBuffer input_default_attributes{};
     ImmediateModeState immediate{};
+    /// Serial number of the vertex each index was last shaded as, see LoadVertices
+    std::vector<u32> vertex_cache_serials;
+    /// Serial number the next shaded vertex gets
+    u32 vertex_serial{1};
 
 private:
     friend class boost::serialization::access;
@@ -280,6 +286,10 @@ private:
     PrimitiveAssembler primitive_assembler;
     CommandList cmd_list;
     std::unique_ptr<ShaderEngine> shader_engine;
+    std::vector<AttributeBuffer> vs_batch_inputs;
+    std::vector<AttributeBuffer> vs_batch_outputs;
+    /// Created by the first draw large enough to be shaded in parallel
+    std::unique_ptr<Common::StatefulThreadWorker<ShaderUnit>> vs_workers;
 };
 
 #define GPU_REG_INDEX(field_name) (offsetof(Pica::PicaCore::Regs, field_name) / sizeof(u32))
@@ -8,6 +8,7 @@
 #include "common/logging/log.h"
 #include "video_core/pica/regs_shader.h"
 #include "video_core/pica/shader_setup.h"
+#include "video_core/shader/shader_analysis.h"
 
 namespace Pica {
 
@@ -62,4 +63,19 @@ u64 ShaderSetup::GetSwizzleDataHash() {
     return swizzle_data_hash;
 }
 
+void ShaderSetup::AnalyzeProgram() {
+    const u64 program_hash = Common::HashCombine(
+        Common::HashCombine(GetProgramCodeHash(), GetSwizzleDataHash()), entry_point);
+    if (program_analyzed && program_hash == analyzed_program_hash) {
+        return;
+    }
+    isolated_outputs = Shader::AnalyzeIsolation(program_code, swizzle_data, entry_point);
+    analyzed_program_hash = program_hash;
+    program_analyzed = true;
+}
+
+bool ShaderSetup::IsIsolated(const ShaderRegs& config) const {
+    return isolated_outputs && (config.output_mask & ~u32{*isolated_outputs}) == 0;
+}
+
 } // namespace Pica
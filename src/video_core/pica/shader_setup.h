@@ -73,6 +73,16 @@ public:
         swizzle_data_hash_dirty = true;
     }
 
+    /// Checks whether the program at entry_point is isolated, unless it was already checked.
+    void AnalyzeProgram();
+
+    /**
+     * Returns true if the analyzed program never reads state that an earlier vertex left in the
+     * shader unit and writes every output enabled in config, so that vertices may be shaded out
+     * of order or on different shader units.
+     */
+    bool IsIsolated(const ShaderRegs& config) const;
+
 public:
     Uniforms uniforms;
     PackedAttribute uniform_queue;
@@ -80,12 +90,16 @@ public:
     SwizzleData swizzle_data{};
     u32 entry_point{};
     const void* cached_shader{};
+    const void* cached_batch_shader{};
 
 private:
     bool program_code_hash_dirty{true};
     bool swizzle_data_hash_dirty{true};
     u64 program_code_hash{0xDEADC0DE};
     u64 swizzle_data_hash{0xDEADC0DE};
+    u64 analyzed_program_hash{};
+    bool program_analyzed{};
+    std::optional<u16> isolated_outputs;
 
     friend class boost::serialization::access;
     template <class Archive>
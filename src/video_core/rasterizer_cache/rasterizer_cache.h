@@ -4,10 +4,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <type_traits>
 #include <boost/container/small_vector.hpp>
 #include <boost/range/iterator_range.hpp>
 #include "common/alignment.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
@@ -40,7 +42,9 @@ RasterizerCache<T>::RasterizerCache(Memory::MemorySystem& memory_,
       renderer{renderer_}, resolution_scale_factor{renderer.GetResolutionScaleFactor()},
       filter{Settings::values.texture_filter.GetValue()},
       dump_textures{Settings::values.dump_textures.GetValue()},
-      use_custom_textures{Settings::values.custom_textures.GetValue()} {
+      use_custom_textures{Settings::values.custom_textures.GetValue()},
+      deduplicate_surfaces{Settings::values.deduplicate_surfaces.GetValue()},
+      async_downloads{Settings::values.async_surface_downloads.GetValue()} {
     using TextureConfig = Pica::TexturingRegs::TextureConfig;
 
     // Create null handles for all cached resources
@@ -95,6 +99,19 @@ void RasterizerCache<T>::TickFrame() {
         UnregisterAll();
     }
 
+    const bool new_deduplicate_surfaces = Settings::values.deduplicate_surfaces.GetValue();
+    if (deduplicate_surfaces != new_deduplicate_surfaces) [[unlikely]] {
+        deduplicate_surfaces = new_deduplicate_surfaces;
+        shared_surfaces.clear();
+    }
+
+    const bool new_async_downloads = Settings::values.async_surface_downloads.GetValue();
+    if (async_downloads != new_async_downloads) [[unlikely]] {
+        async_downloads = new_async_downloads;
+        pending_downloads.clear();
+        pending_download_size = 0;
+    }
+
     const u32 scale_factor = renderer.GetResolutionScaleFactor();
     const bool resolution_scale_changed = resolution_scale_factor != scale_factor;
     const bool use_custom_texture_changed =
@@ -326,6 +343,7 @@ bool RasterizerCache<T>::AccelerateDisplayTransfer(const Pica::DisplayTransferCo
     runtime.BlitTextures(src_surface, dst_surface, texture_blit);
 
     InvalidateRegion(dst_params.addr, dst_params.size, dst_surface_id);
+    StartDownloads(dst_params.addr, dst_params.size);
     return true;
 }
 
@@ -792,15 +810,7 @@ void RasterizerCache<T>::ForEachSurfaceInRegion(PAddr addr, std::size_t size, Fu
     static constexpr bool BOOL_BREAK = std::is_same_v<FuncReturn, bool>;
     boost::container::small_vector<SurfaceId, 8> surfaces;
     ForEachPage(addr, size, [this, &surfaces, addr, size, func](u64 page) {
-        const auto it = page_table.find(page);
-        if (it == page_table.end()) {
-            if constexpr (BOOL_BREAK) {
-                return false;
-            } else {
-                return;
-            }
-        }
-        for (const SurfaceId surface_id : it->second) {
+        for (const SurfaceId surface_id : page_table[page]) {
             Surface& surface = slot_surfaces[surface_id];
             if (True(surface.flags & SurfaceFlagBits::Picked)) {
                 continue;
@@ -978,7 +988,9 @@ void RasterizerCache<T>::ValidateSurface(SurfaceId surface_id, PAddr addr, u32 s
 
         FlushRegion(params.addr, params.size);
         if (!use_custom_textures || !UploadCustomSurface(surface_id, interval)) {
-            UploadSurface(surface, interval);
+            if (!deduplicate_surfaces || !UploadSharedSurface(surface_id, interval)) {
+                UploadSurface(surface, interval);
+            }
         }
         notify_validated(params.GetInterval());
     }
@@ -1026,6 +1038,61 @@ void RasterizerCache<T>::UploadSurface(Surface& surface, SurfaceInterval interva
     surface.Upload(upload, staging);
 }
 
+template <class T>
+bool RasterizerCache<T>::UploadSharedSurface(SurfaceId surface_id, SurfaceInterval interval) {
+    Surface& surface = slot_surfaces[surface_id];
+    // Upscaled textures may hold filtered or rendered contents that differ from a fresh upload.
+    const bool is_shareable = surface.res_scale == 1 && surface.levels == 1 &&
+                              interval == surface.GetInterval() &&
+                              False(surface.flags & SurfaceFlagBits::Custom) &&
+                              False(surface.flags & SurfaceFlagBits::RenderTarget);
+    if (!is_shareable) {
+        return false;
+    }
+
+    MemoryRef source_ptr = memory.GetPhysicalRef(surface.addr);
+    if (!source_ptr) [[unlikely]] {
+        return false;
+    }
+
+    // Identical guest data with the same layout always decodes to the same pixels, so hash the
+    // guest data directly instead of decoding it first.
+    const auto upload_data = source_ptr.GetWriteBytes(surface.size);
+    u64 hash = Common::ComputeHash64(upload_data.data(), upload_data.size());
+    for (const u64 value : {u64{surface.width}, u64{surface.height}, u64{surface.stride},
+                            u64{surface.is_tiled}, static_cast<u64>(surface.pixel_format)}) {
+        hash = Common::HashCombine(hash, value);
+    }
+
+    // Surfaces own their textures, so writes to either one after the copy stay private to it.
+    // Any modification of the source bumps its tick and the copy is no longer possible.
+    const auto it = shared_surfaces.find(hash);
+    if (it != shared_surfaces.end()) {
+        const auto [shared_id, tick] = it->second;
+        Surface& shared_surface = slot_surfaces[shared_id];
+        if (shared_surface.modification_tick == tick && shared_surface.res_scale == 1) {
+            const TextureCopy copy = {
+                .src_level = 0,
+                .dst_level = 0,
+                .src_offset = {0, 0},
+                .dst_offset = {0, 0},
+                .extent = {surface.width, surface.height},
+            };
+            if (runtime.CopyTextures(shared_surface, surface, copy)) {
+                return true;
+            }
+        }
+    }
+
+    UploadSurface(surface, interval);
+
+    // The caller marks the interval valid right after, which bumps the tick once.
+    surface.content_hash = hash;
+    shared_surfaces.insert_or_assign(hash,
+                                     SharedSurface{surface_id, surface.modification_tick + 1});
+    return true;
+}
+
 template <class T>
 u64 RasterizerCache<T>::ComputeHash(const SurfaceParams& load_info, std::span<u8> upload_data) {
     if (!custom_tex_manager.UseNewHash()) {
@@ -1118,6 +1185,39 @@ void RasterizerCache<T>::DownloadSurface(Surface& surface, SurfaceInterval inter
                   runtime.NeedsConversion(surface.pixel_format));
 }
 
+template <class T>
+bool RasterizerCache<T>::FinishDownload(SurfaceId surface_id, SurfaceInterval interval) {
+    if (pending_downloads.empty()) {
+        return false;
+    }
+
+    const Surface& surface = slot_surfaces[surface_id];
+    const auto it = std::ranges::find_if(pending_downloads, [&](const PendingDownload& pending) {
+        return pending.surface_id == surface_id &&
+               pending.modification_tick == surface.modification_tick &&
+               boost::icl::contains(pending.interval, interval);
+    });
+    if (it == pending_downloads.end()) {
+        return false;
+    }
+
+    MICROPROFILE_SCOPE(RasterizerCache_DownloadSurface);
+    runtime.WaitDownload(it->fence, it->staging);
+
+    const u32 flush_start = boost::icl::first(interval);
+    const u32 flush_end = boost::icl::last_next(interval);
+    MemoryRef dest_ptr = memory.GetPhysicalRef(flush_start);
+    if (!dest_ptr) [[unlikely]] {
+        return true;
+    }
+
+    const SurfaceParams download_info = surface.FromInterval(it->interval);
+    const auto download_dest = dest_ptr.GetWriteBytes(flush_end - flush_start);
+    EncodeTexture(download_info, flush_start, flush_end, it->staging.mapped, download_dest,
+                  runtime.NeedsConversion(surface.pixel_format));
+    return true;
+}
+
 template <class T>
 void RasterizerCache<T>::DownloadFillSurface(Surface& surface, SurfaceInterval interval) {
     const u32 flush_start = boost::icl::first(interval);
@@ -1183,7 +1283,9 @@ bool RasterizerCache<T>::ValidateByReinterpretation(Surface& surface, SurfacePar
     // If there's a surface with invalid format it means the region was cleared
     // so we don't want to skip validation in that case.
     const bool has_invalid = IntervalHasInvalidPixelFormat(params, interval);
-    const bool is_gpu_modified = boost::icl::contains(dirty_regions, interval);
+    const bool is_gpu_modified =
+        page_table.IsDirty(boost::icl::first(interval), boost::icl::length(interval)) &&
+        boost::icl::contains(dirty_regions, interval);
     return !has_invalid && is_gpu_modified;
 }
 
@@ -1205,31 +1307,24 @@ bool RasterizerCache<T>::IntervalHasInvalidPixelFormat(const SurfaceParams& para
 
 template <class T>
 void RasterizerCache<T>::ClearAll(bool flush) {
-    const auto flush_interval = PageMap::interval_type::right_open(0x0, 0xFFFFFFFF);
     // Force flush all surfaces from the cache
     if (flush) {
         FlushRegion(0x0, 0xFFFFFFFF);
     }
-    // Unmark all of the marked pages
-    for (auto& pair : RangeFromInterval(cached_pages, flush_interval)) {
-        const auto interval = pair.first & flush_interval;
 
-        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::CITRA_PAGE_BITS;
-        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::CITRA_PAGE_BITS;
-        const u32 interval_size = interval_end_addr - interval_start_addr;
-
-        memory.RasterizerMarkRegionCached(interval_start_addr, interval_size, false);
-    }
-
-    // Remove the whole cache without really looking at it.
-    cached_pages -= flush_interval;
+    // Unmark all of the marked pages and remove the whole cache without really looking at it.
+    page_table.Clear([this](PAddr addr, u32 size) {
+        memory.RasterizerMarkRegionCached(addr, size, false);
+    });
     dirty_regions.clear();
-    page_table.clear();
+    shared_surfaces.clear();
+    pending_downloads.clear();
+    pending_download_size = 0;
 }
 
 template <class T>
 void RasterizerCache<T>::FlushRegion(PAddr addr, u32 size, SurfaceId flush_surface_id) {
-    if (size == 0) [[unlikely]] {
+    if (size == 0 || !page_table.IsDirty(addr, size)) {
         return;
     }
 
@@ -1266,12 +1361,80 @@ void RasterizerCache<T>::FlushRegion(PAddr addr, u32 size, SurfaceId flush_surfa
             if (boost::icl::is_empty(download_interval)) {
                 continue;
             }
-            DownloadSurface(surface, download_interval);
+            if (!FinishDownload(surface_id, download_interval)) {
+                DownloadSurface(surface, download_interval);
+            }
         }
     }
 
     // Reset dirty regions
     dirty_regions -= flushed_intervals;
+    for (const SurfaceInterval& interval : flushed_intervals) {
+        UpdateDirtyPages(interval);
+    }
+}
+
+template <class T>
+void RasterizerCache<T>::StartDownloads(PAddr addr, u32 size) {
+    // Staging mappings are only valid until the buffer wraps around to them, so the downloads
+    // kept pending are limited to a quarter of it, which leaves room for alignment and wrapping.
+    const u32 staging_limit = runtime.DownloadStagingSize() / 4;
+    if (!async_downloads || staging_limit == 0 || size == 0 || !page_table.IsDirty(addr, size)) {
+        return;
+    }
+
+    std::erase_if(pending_downloads, [this](const PendingDownload& pending) {
+        return slot_surfaces[pending.surface_id].modification_tick != pending.modification_tick;
+    });
+    if (pending_downloads.empty()) {
+        pending_download_size = 0;
+    }
+
+    const SurfaceInterval start_interval(addr, addr + size);
+    for (const auto& [region, surface_id] : RangeFromInterval(dirty_regions, start_interval)) {
+        Surface& surface = slot_surfaces[surface_id];
+        if (surface.type == SurfaceType::Fill) {
+            continue;
+        }
+
+        const auto interval = region & start_interval;
+        const u32 start_level = surface.LevelOf(interval.lower());
+        const u32 end_level = surface.LevelOf(interval.upper());
+        for (u32 level = start_level; level <= end_level; level++) {
+            const auto download_interval = interval & surface.LevelInterval(level);
+            if (boost::icl::is_empty(download_interval)) {
+                continue;
+            }
+
+            const SurfaceParams download_info = surface.FromInterval(download_interval);
+            const u32 download_size =
+                download_info.width * download_info.height * surface.GetInternalBytesPerPixel();
+            if (download_size > staging_limit) {
+                continue;
+            }
+            if (pending_download_size + download_size > staging_limit) {
+                pending_downloads.clear();
+                pending_download_size = 0;
+            }
+
+            const auto staging = runtime.FindDownloadStaging(download_size);
+            const BufferTextureCopy download = {
+                .buffer_offset = staging.offset,
+                .buffer_size = staging.size,
+                .texture_rect = surface.GetSubRect(download_info),
+                .texture_level = level,
+            };
+            const u64 fence = surface.DownloadAsync(download, staging);
+            pending_downloads.push_back({
+                .surface_id = surface_id,
+                .interval = download_interval,
+                .modification_tick = surface.modification_tick,
+                .staging = staging,
+                .fence = fence,
+            });
+            pending_download_size += download_size;
+        }
+    }
 }
 
 template <class T>
@@ -1317,8 +1480,10 @@ void RasterizerCache<T>::InvalidateRegion(PAddr addr, u32 size, SurfaceId region
 
     if (region_owner_id) {
         dirty_regions.set({invalid_interval, region_owner_id});
-    } else {
+        page_table.MarkDirty(addr, size);
+    } else if (page_table.IsDirty(addr, size)) {
         dirty_regions.erase(invalid_interval);
+        UpdateDirtyPages(invalid_interval);
     }
 
     for (const SurfaceId surface_id : remove_surfaces) {
@@ -1368,21 +1533,25 @@ void RasterizerCache<T>::UnregisterSurface(SurfaceId surface_id) {
     surface.flags &= ~SurfaceFlagBits::Registered;
     UpdatePagesCachedCount(surface.addr, surface.size, -1);
     ForEachPage(surface.addr, surface.size, [this, surface_id](u64 page) {
-        const auto page_it = page_table.find(page);
-        if (page_it == page_table.end()) {
-            ASSERT_MSG(false, "Unregistering unregistered page=0x{:x}", page << CITRA_PAGEBITS);
-            return;
-        }
-        std::vector<SurfaceId>& surfaces = page_it.value();
+        auto& surfaces = page_table[page];
         const auto vector_it = std::find(surfaces.begin(), surfaces.end(), surface_id);
         if (vector_it == surfaces.end()) {
             ASSERT_MSG(false, "Unregistering unregistered surface in page=0x{:x}",
-                       page << CITRA_PAGEBITS);
+                       page << SurfacePageTable::PAGE_BITS);
             return;
         }
         surfaces.erase(vector_it);
     });
 
+    std::erase_if(pending_downloads, [surface_id](const PendingDownload& pending) {
+        return pending.surface_id == surface_id;
+    });
+
+    if (const auto it = shared_surfaces.find(surface.content_hash);
+        it != shared_surfaces.end() && it->second.surface_id == surface_id) {
+        shared_surfaces.erase(it);
+    }
+
     if (surface.type != SurfaceType::Fill) {
         RemoveTextureCubeFace(surface_id);
         sentenced.emplace_back(surface_id, frame_tick);
@@ -1395,11 +1564,11 @@ void RasterizerCache<T>::UnregisterSurface(SurfaceId surface_id) {
 template <class T>
 void RasterizerCache<T>::UnregisterAll() {
     FlushAll();
-    for (auto& [page, surfaces] : page_table) {
+    page_table.ForEachOccupiedPage([this](u64 page, auto& surfaces) {
         while (!surfaces.empty()) {
             UnregisterSurface(surfaces.back());
         }
-    }
+    });
     runtime.Finish();
     frame_tick += runtime.RemoveThreshold();
     RunGarbageCollector();
@@ -1407,38 +1576,22 @@ void RasterizerCache<T>::UnregisterAll() {
 
 template <class T>
 void RasterizerCache<T>::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
-    const u32 num_pages =
-        ((addr + size - 1) >> Memory::CITRA_PAGE_BITS) - (addr >> Memory::CITRA_PAGE_BITS) + 1;
-    const u32 page_start = addr >> Memory::CITRA_PAGE_BITS;
-    const u32 page_end = page_start + num_pages;
-
-    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
-    // subtract after iterating
-    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
-    if (delta > 0) {
-        cached_pages.add({pages_interval, delta});
-    }
-
-    for (const auto& pair : RangeFromInterval(cached_pages, pages_interval)) {
-        const auto interval = pair.first & pages_interval;
-        const int count = pair.second;
-
-        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::CITRA_PAGE_BITS;
-        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::CITRA_PAGE_BITS;
-        const u32 interval_size = interval_end_addr - interval_start_addr;
-
-        if (delta > 0 && count == delta) {
-            memory.RasterizerMarkRegionCached(interval_start_addr, interval_size, true);
-        } else if (delta < 0 && count == -delta) {
-            memory.RasterizerMarkRegionCached(interval_start_addr, interval_size, false);
-        } else {
-            ASSERT(count >= 0);
-        }
-    }
+    static_assert(SurfacePageTable::MEMORY_PAGE_BITS == Memory::CITRA_PAGE_BITS);
+    page_table.UpdateCachedCount(addr, size, delta,
+                                 [this](PAddr region_addr, u32 region_size, bool cached) {
+                                     memory.RasterizerMarkRegionCached(region_addr, region_size,
+                                                                       cached);
+                                 });
+}
 
-    if (delta < 0) {
-        cached_pages.add({pages_interval, delta});
-    }
+template <class T>
+void RasterizerCache<T>::UpdateDirtyPages(SurfaceInterval interval) {
+    page_table.UnmarkDirty(boost::icl::first(interval), boost::icl::length(interval),
+                           [this](PAddr addr, u32 size) {
+                               const SurfaceInterval page_interval{addr, addr + size};
+                               const auto range = dirty_regions.equal_range(page_interval);
+                               return range.first != range.second;
+                           });
 }
 
 } // namespace VideoCore
@@ -11,12 +11,13 @@
 #include <unordered_map>
 #include <vector>
 #include <boost/icl/interval_map.hpp>
-#include <tsl/robin_map.h>
 
 #include "video_core/rasterizer_cache/framebuffer_base.h"
 #include "video_core/rasterizer_cache/sampler_params.h"
+#include "video_core/rasterizer_cache/surface_page_table.h"
 #include "video_core/rasterizer_cache/surface_params.h"
 #include "video_core/rasterizer_cache/texture_cube.h"
+#include "video_core/rasterizer_cache/utils.h"
 
 namespace Memory {
 class MemorySystem;
@@ -59,9 +60,6 @@ class RendererBase;
 
 template <class T>
 class RasterizerCache {
-    /// Address shift for caching surfaces into a hash table
-    static constexpr u64 CITRA_PAGEBITS = 18;
-
     using Runtime = typename T::Runtime;
     using Sampler = typename T::Sampler;
     using Surface = typename T::Surface;
@@ -73,7 +71,6 @@ class RasterizerCache {
                                                 boost::icl::inter_section, SurfaceInterval>;
 
     using SurfaceRect_Tuple = std::pair<SurfaceId, Common::Rectangle<u32>>;
-    using PageMap = boost::icl::interval_map<u32, int>;
 
 public:
     explicit RasterizerCache(Memory::MemorySystem& memory, CustomTexManager& custom_tex_manager,
@@ -127,6 +124,10 @@ public:
     /// Write any cached resources overlapping the region back to memory (if dirty)
     void FlushRegion(PAddr addr, u32 size, SurfaceId flush_surface = {});
 
+    /// Starts downloading the GPU written data of the region, so that a later flush of it only
+    /// has to wait for the download to complete
+    void StartDownloads(PAddr addr, u32 size);
+
     /// Mark region as being invalidated by region_owner (nullptr if 3DS memory)
     void InvalidateRegion(PAddr addr, u32 size, SurfaceId region_owner = {});
 
@@ -141,8 +142,9 @@ private:
     template <typename Func>
     void ForEachPage(PAddr addr, std::size_t size, Func&& func) {
         static constexpr bool RETURNS_BOOL = std::is_same_v<std::invoke_result<Func, u64>, bool>;
-        const u64 page_end = (addr + size - 1) >> CITRA_PAGEBITS;
-        for (u64 page = addr >> CITRA_PAGEBITS; page <= page_end; ++page) {
+        constexpr u32 page_bits = SurfacePageTable::PAGE_BITS;
+        const u64 page_end = (addr + size - 1) >> page_bits;
+        for (u64 page = addr >> page_bits; page <= page_end; ++page) {
             if constexpr (RETURNS_BOOL) {
                 if (func(page)) {
                     break;
@@ -183,9 +185,17 @@ private:
     /// Uploads a custom texture identified with hash to the target surface
     bool UploadCustomSurface(SurfaceId surface_id, SurfaceInterval interval);
 
+    /// Copies the surface from a surface loaded from identical guest data, uploading it otherwise.
+    /// Returns false if the interval cannot be shared with other surfaces.
+    bool UploadSharedSurface(SurfaceId surface_id, SurfaceInterval interval);
+
     /// Copies pixel data in interval from the host GPU surface to the guest VRAM
     void DownloadSurface(Surface& surface, SurfaceInterval interval);
 
+    /// Copies pixel data in interval from a download of the surface started earlier to the guest
+    /// VRAM. Returns false if no such download is pending.
+    bool FinishDownload(SurfaceId surface_id, SurfaceInterval interval);
+
     /// Downloads a fill surface to guest VRAM
     void DownloadFillSurface(Surface& surface, SurfaceInterval interval);
 
@@ -211,28 +221,48 @@ private:
     /// Increase/decrease the number of surface in pages touching the specified region
     void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
 
+    /// Updates the dirty pages of the interval after GPU written data was removed from it
+    void UpdateDirtyPages(SurfaceInterval interval);
+
 private:
+    struct SharedSurface {
+        SurfaceId surface_id;
+        u64 modification_tick;
+    };
+
+    struct PendingDownload {
+        SurfaceId surface_id;
+        SurfaceInterval interval;
+        u64 modification_tick;
+        StagingData staging;
+        u64 fence;
+    };
+
     Memory::MemorySystem& memory;
     CustomTexManager& custom_tex_manager;
     Runtime& runtime;
     Pica::RegsInternal& regs;
     RendererBase& renderer;
     std::unordered_map<TextureCubeConfig, TextureCube> texture_cube_cache;
-    tsl::robin_pg_map<u64, std::vector<SurfaceId>, Common::IdentityHash<u64>> page_table;
+    SurfacePageTable page_table;
     std::unordered_map<FramebufferParams, FramebufferId> framebuffers;
     std::unordered_map<SamplerParams, SamplerId> samplers;
+    std::unordered_map<u64, SharedSurface> shared_surfaces;
     std::list<std::pair<SurfaceId, u64>> sentenced;
+    std::vector<PendingDownload> pending_downloads;
+    u32 pending_download_size{};
     Common::SlotVector<Surface> slot_surfaces;
     Common::SlotVector<Sampler> slot_samplers;
     Common::SlotVector<Framebuffer> slot_framebuffers;
     SurfaceMap dirty_regions;
-    PageMap cached_pages;
     u32 resolution_scale_factor;
     u64 frame_tick{};
     FramebufferParams fb_params;
     Settings::TextureFilter filter;
     bool dump_textures;
     bool use_custom_textures;
+    bool deduplicate_surfaces;
+    bool async_downloads;
 };
 
 } // namespace VideoCore
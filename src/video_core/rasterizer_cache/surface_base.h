@@ -90,6 +90,7 @@ public:
     u32 fill_size = 0;
     std::array<u8, 4> fill_data;
     u64 modification_tick = 1;
+    u64 content_hash = 0;
 };
 
 } // namespace VideoCore
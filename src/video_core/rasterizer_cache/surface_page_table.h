@@ -0,0 +1,185 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <boost/container/small_vector.hpp>
+#include "common/assert.h"
+#include "common/common_types.h"
+#include "video_core/rasterizer_cache/slot_id.h"
+
+namespace VideoCore {
+
+/**
+ * Flat index of the physical address space used by the rasterizer cache. Each page owns a small
+ * inline vector with the surfaces that overlap it. Finer grained memory pages count the surfaces
+ * covering them and remember whether they hold data written by the GPU that was not flushed yet.
+ * All lookups index arrays directly, keeping the cost of a draw independent of how many surfaces
+ * are alive.
+ */
+class SurfacePageTable {
+public:
+    /// Address shift of the pages holding surfaces
+    static constexpr u32 PAGE_BITS = 18;
+    /// Address shift of the memory pages, matches Memory::CITRA_PAGE_BITS
+    static constexpr u32 MEMORY_PAGE_BITS = 12;
+
+    static constexpr std::size_t NUM_PAGES = 1ULL << (32 - PAGE_BITS);
+    static constexpr std::size_t NUM_MEMORY_PAGES = 1ULL << (32 - MEMORY_PAGE_BITS);
+    static constexpr std::size_t MEMORY_PAGES_PER_PAGE = 1ULL << (PAGE_BITS - MEMORY_PAGE_BITS);
+
+    using Surfaces = boost::container::small_vector<SurfaceId, 4>;
+
+    SurfacePageTable()
+        : pages(NUM_PAGES), cached_counts(NUM_MEMORY_PAGES), dirty_bits(NUM_MEMORY_PAGES / 64) {}
+
+    /// Returns the surfaces overlapping the page
+    [[nodiscard]] Surfaces& operator[](u64 page) noexcept {
+        return pages[page];
+    }
+
+    /// Iterates over all pages that hold surfaces. func may modify the table.
+    template <typename Func>
+    void ForEachOccupiedPage(Func&& func) {
+        for (u64 page = 0; page < NUM_PAGES; page++) {
+            if (!pages[page].empty()) {
+                func(page, pages[page]);
+            }
+        }
+    }
+
+    /**
+     * Adds delta to the number of surfaces covering each memory page of the region. Runs of
+     * consecutive pages that become covered or uncovered are reported with func(addr, size, cached)
+     */
+    template <typename Func>
+    void UpdateCachedCount(PAddr addr, u32 size, int delta, Func&& func) {
+        const u64 page_start = addr >> MEMORY_PAGE_BITS;
+        const u64 page_end = ((static_cast<u64>(addr) + size - 1) >> MEMORY_PAGE_BITS) + 1;
+        u64 run_start = page_start;
+        u64 run_end = page_start;
+        const auto flush_run = [&] {
+            if (run_start != run_end) {
+                func(static_cast<PAddr>(run_start << MEMORY_PAGE_BITS),
+                     static_cast<u32>((run_end - run_start) << MEMORY_PAGE_BITS), delta > 0);
+            }
+        };
+        for (u64 page = page_start; page < page_end; page++) {
+            const int count = cached_counts[page] + delta;
+            ASSERT(count >= 0 && count <= std::numeric_limits<u16>::max());
+            cached_counts[page] = static_cast<u16>(count);
+            const bool changed = delta > 0 ? count == delta : count == 0;
+            if (!changed) {
+                continue;
+            }
+            if (page != run_end) {
+                flush_run();
+                run_start = page;
+            }
+            run_end = page + 1;
+        }
+        flush_run();
+    }
+
+    /// Reports every run of covered memory pages with func(addr, size) and resets the table
+    template <typename Func>
+    void Clear(Func&& func) {
+        ForEachOccupiedPage([&](u64 page, Surfaces& surfaces) {
+            const u64 memory_page_start = page * MEMORY_PAGES_PER_PAGE;
+            const u64 memory_page_end = memory_page_start + MEMORY_PAGES_PER_PAGE;
+            u64 memory_page = memory_page_start;
+            while (memory_page < memory_page_end) {
+                if (cached_counts[memory_page] == 0) {
+                    memory_page++;
+                    continue;
+                }
+                const u64 run_start = memory_page;
+                while (memory_page < memory_page_end && cached_counts[memory_page] != 0) {
+                    memory_page++;
+                }
+                func(static_cast<PAddr>(run_start << MEMORY_PAGE_BITS),
+                     static_cast<u32>((memory_page - run_start) << MEMORY_PAGE_BITS));
+            }
+            std::fill_n(cached_counts.begin() + memory_page_start, MEMORY_PAGES_PER_PAGE, 0);
+            surfaces.clear();
+        });
+        std::ranges::fill(dirty_bits, 0);
+    }
+
+    /// Returns true if any memory page of the region holds data written by the GPU
+    [[nodiscard]] bool IsDirty(PAddr addr, u32 size) const noexcept {
+        if (size == 0) {
+            return false;
+        }
+        const u64 page_start = addr >> MEMORY_PAGE_BITS;
+        const u64 page_end = ((static_cast<u64>(addr) + size - 1) >> MEMORY_PAGE_BITS) + 1;
+        const u64 word_start = page_start / 64;
+        const u64 word_end = (page_end - 1) / 64;
+        for (u64 word = word_start; word <= word_end; word++) {
+            u64 bits = dirty_bits[word];
+            if (word == word_start) {
+                bits &= ~0ULL << (page_start % 64);
+            }
+            if (word == word_end && page_end % 64 != 0) {
+                bits &= ~(~0ULL << (page_end % 64));
+            }
+            if (bits != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Marks the memory pages of the region as holding data written by the GPU
+    void MarkDirty(PAddr addr, u32 size) noexcept {
+        ForEachMemoryPage(addr, size, [this](u64 page) { SetDirty(page, true); });
+    }
+
+    /**
+     * Updates the memory pages of a region after its GPU written data was flushed or discarded.
+     * is_dirty(page_addr, page_size) is asked for the pages only partially covered by the region.
+     */
+    template <typename Func>
+    void UnmarkDirty(PAddr addr, u32 size, Func&& is_dirty) {
+        const u64 region_end = static_cast<u64>(addr) + size;
+        ForEachMemoryPage(addr, size, [&](u64 page) {
+            const u64 page_addr = page << MEMORY_PAGE_BITS;
+            const u64 page_end = page_addr + (1ULL << MEMORY_PAGE_BITS);
+            const bool covered = page_addr >= addr && page_end <= region_end;
+            SetDirty(page, !covered && is_dirty(static_cast<PAddr>(page_addr),
+                                                static_cast<u32>(1U << MEMORY_PAGE_BITS)));
+        });
+    }
+
+private:
+    template <typename Func>
+    static void ForEachMemoryPage(PAddr addr, u32 size, Func&& func) {
+        if (size == 0) {
+            return;
+        }
+        const u64 page_end = (static_cast<u64>(addr) + size - 1) >> MEMORY_PAGE_BITS;
+        for (u64 page = addr >> MEMORY_PAGE_BITS; page <= page_end; page++) {
+            func(page);
+        }
+    }
+
+    void SetDirty(u64 page, bool dirty) noexcept {
+        const u64 mask = 1ULL << (page % 64);
+        if (dirty) {
+            dirty_bits[page / 64] |= mask;
+        } else {
+            dirty_bits[page / 64] &= ~mask;
+        }
+    }
+
+private:
+    std::vector<Surfaces> pages;
+    std::vector<u16> cached_counts;
+    std::vector<u64> dirty_bits;
+};
+
+} // namespace VideoCore
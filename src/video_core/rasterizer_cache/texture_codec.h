@@ -196,6 +196,21 @@ constexpr void EncodePixel4(u32 x, u32 y, const u8* source_pixel, u8* dest_tile_
     }
 }
 
+/// Returns true if DecodePixel and EncodePixel copy the pixels of the format unchanged
+template <PixelFormat format, bool converted>
+constexpr bool IsPixelCopy() {
+    constexpr bool always_converted =
+        format == PixelFormat::IA8 || format == PixelFormat::RG8 || format == PixelFormat::I8 ||
+        format == PixelFormat::A8 || format == PixelFormat::IA4 || format == PixelFormat::D24S8;
+    constexpr bool needs_conversion =
+        converted && (format == PixelFormat::RGBA8 || format == PixelFormat::RGB8 ||
+                      format == PixelFormat::RGB565 || format == PixelFormat::RGB5A1 ||
+                      format == PixelFormat::RGBA4 || format == PixelFormat::D24);
+    constexpr u32 linear_bytes_per_pixel = converted ? 4 : GetFormatBytesPerPixel(format);
+    return !always_converted && !needs_conversion &&
+           GetFormatBpp(format) / 8 == linear_bytes_per_pixel;
+}
+
 template <bool morton_to_linear, PixelFormat format, bool converted>
 constexpr void MortonCopyTile(u32 stride, std::span<u8> tile_buffer, std::span<u8> linear_buffer) {
     constexpr u32 bytes_per_pixel = GetFormatBpp(format) / 8;
@@ -203,25 +218,51 @@ constexpr void MortonCopyTile(u32 stride, std::span<u8> tile_buffer, std::span<u
     constexpr bool is_compressed = format == PixelFormat::ETC1 || format == PixelFormat::ETC1A4;
     constexpr bool is_4bit = format == PixelFormat::I4 || format == PixelFormat::A4;
 
-    for (u32 y = 0; y < 8; y++) {
-        for (u32 x = 0; x < 8; x++) {
-            const auto tiled_pixel = tile_buffer.subspan(
-                VideoCore::MortonInterleave(x, y) * bytes_per_pixel, bytes_per_pixel);
-            const auto linear_pixel = linear_buffer.subspan(
-                ((7 - y) * stride + x) * linear_bytes_per_pixel, linear_bytes_per_pixel);
-            if constexpr (morton_to_linear) {
-                if constexpr (is_compressed) {
-                    DecodePixelETC1<format>(x, y, tile_buffer.data(), linear_pixel.data());
-                } else if constexpr (is_4bit) {
-                    DecodePixel4<format>(x, y, tile_buffer.data(), linear_pixel.data());
+    if constexpr (is_compressed || is_4bit) {
+        for (u32 y = 0; y < 8; y++) {
+            for (u32 x = 0; x < 8; x++) {
+                u8* linear_pixel =
+                    linear_buffer.data() + ((7 - y) * stride + x) * linear_bytes_per_pixel;
+                if constexpr (!morton_to_linear) {
+                    EncodePixel4<format>(x, y, linear_pixel, tile_buffer.data());
+                } else if constexpr (is_compressed) {
+                    DecodePixelETC1<format>(x, y, tile_buffer.data(), linear_pixel);
                 } else {
-                    DecodePixel<format, converted>(tiled_pixel.data(), linear_pixel.data());
+                    DecodePixel4<format>(x, y, tile_buffer.data(), linear_pixel);
                 }
-            } else {
-                if constexpr (is_4bit) {
-                    EncodePixel4<format>(x, y, linear_pixel.data(), tile_buffer.data());
+            }
+        }
+    } else {
+        // In Morton order the pixels of a tile row are stored as four pairs of horizontally
+        // adjacent pixels. Each row is gathered from (or scattered to) its pairs in a single pass,
+        // and converted with a fixed-length loop over the row that the compiler can vectorize.
+        // Pixels that are copied unchanged skip the row buffer altogether.
+        constexpr bool is_copy = IsPixelCopy<format, converted>();
+        constexpr u32 pair_size = 2 * bytes_per_pixel;
+        std::array<u8, 8 * bytes_per_pixel> row_buffer;
+
+        for (u32 y = 0; y < 8; y++) {
+            u8* linear_row = linear_buffer.data() + (7 - y) * stride * linear_bytes_per_pixel;
+            u8* tiled_row = is_copy ? linear_row : row_buffer.data();
+            if constexpr (!morton_to_linear && !is_copy) {
+                for (u32 x = 0; x < 8; x++) {
+                    EncodePixel<format, converted>(linear_row + x * linear_bytes_per_pixel,
+                                                   tiled_row + x * bytes_per_pixel);
+                }
+            }
+            for (u32 x = 0; x < 8; x += 2) {
+                u8* tiled_pair =
+                    tile_buffer.data() + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
+                if constexpr (morton_to_linear) {
+                    std::memcpy(tiled_row + x * bytes_per_pixel, tiled_pair, pair_size);
                 } else {
-                    EncodePixel<format, converted>(linear_pixel.data(), tiled_pixel.data());
+                    std::memcpy(tiled_pair, tiled_row + x * bytes_per_pixel, pair_size);
+                }
+            }
+            if constexpr (morton_to_linear && !is_copy) {
+                for (u32 x = 0; x < 8; x++) {
+                    DecodePixel<format, converted>(tiled_row + x * bytes_per_pixel,
+                                                   linear_row + x * linear_bytes_per_pixel);
                 }
             }
         }
@@ -277,6 +318,7 @@ static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 en
     u32 y = (begin_pixel_index / (width * 8)) * 8;
     u32 linear_offset = ((height - 8 - y) * width + x) * aligned_bytes_per_pixel;
     u32 tiled_offset = 0;
+    const u32 tile_buffer_size = static_cast<u32>(tiled_buffer.size());
 
     const auto linear_next_tile = [&] {
         x = (x + 8) % width;
@@ -299,7 +341,8 @@ static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 en
         MortonCopyTile<morton_to_linear, format, converted>(width, tmp_buf, linear_data);
 
         std::memcpy(tiled_buffer.data(), tmp_buf.data() + start_offset - aligned_down_start_offset,
-                    std::min(aligned_start_offset, end_offset) - start_offset);
+                    std::min(std::min(aligned_start_offset, end_offset) - start_offset,
+                             tile_buffer_size));
 
         tiled_offset += aligned_start_offset - start_offset;
         linear_next_tile();
@@ -307,10 +350,9 @@ static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 en
 
     // If the copy spans multiple tiles, copy the fully aligned tiles in between.
     if (aligned_start_offset < aligned_end_offset) {
-        const u32 tile_buffer_size = static_cast<u32>(tiled_buffer.size());
         const u32 buffer_end =
             std::min(tiled_offset + aligned_end_offset - aligned_start_offset, tile_buffer_size);
-        while (tiled_offset < buffer_end) {
+        while (tiled_offset + tile_size <= buffer_end) {
             auto linear_data = linear_buffer.subspan(linear_offset, linear_tile_stride);
             auto tiled_data = tiled_buffer.subspan(tiled_offset, tile_size);
             MortonCopyTile<morton_to_linear, format, converted>(width, tiled_data, linear_data);
@@ -321,12 +363,13 @@ static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 en
 
     // If during a texture download the end coordinate is not tile aligned, swizzle
     // the tile affected to a temporary buffer and copy the part we are interested in
-    if (end_offset > std::max(aligned_start_offset, aligned_end_offset) && !morton_to_linear) {
+    if (end_offset > std::max(aligned_start_offset, aligned_end_offset) && !morton_to_linear &&
+        tiled_offset < tile_buffer_size) {
         std::array<u8, tile_size> tmp_buf;
         auto linear_data = linear_buffer.subspan(linear_offset, linear_tile_stride);
         MortonCopyTile<morton_to_linear, format, converted>(width, tmp_buf, linear_data);
         std::memcpy(tiled_buffer.data() + tiled_offset, tmp_buf.data(),
-                    end_offset - aligned_end_offset);
+                    std::min(end_offset - aligned_end_offset, tile_buffer_size - tiled_offset));
     }
 }
 
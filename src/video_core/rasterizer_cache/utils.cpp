@@ -2,12 +2,74 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <thread>
+#include "common/thread_worker.h"
 #include "video_core/rasterizer_cache/surface_params.h"
 #include "video_core/rasterizer_cache/texture_codec.h"
 #include "video_core/rasterizer_cache/utils.h"
 
 namespace VideoCore {
 
+namespace {
+
+/// Amount of tiled data above which a texture is converted by several threads
+constexpr u32 PARALLEL_MORTON_THRESHOLD = 256 * 1024;
+
+/// Minimum amount of tiled data converted by each thread
+constexpr u32 MIN_MORTON_CHUNK_SIZE = 64 * 1024;
+
+Common::ThreadWorker& GetMortonWorkers() {
+    static Common::ThreadWorker workers{std::max(std::thread::hardware_concurrency(), 2U) - 1,
+                                        "TextureCodec workers"};
+    return workers;
+}
+
+/**
+ * Runs a Morton copy of the tiled data between start_offset and end_offset. Large copies are split
+ * into chunks of whole tiles that are converted in parallel, which is possible as each tile maps
+ * to its own block of pixels in the linear buffer. The tiled buffer may end before end_offset
+ * when the region runs past the end of a memory mapping, in which case only the chunks it covers
+ * are converted.
+ */
+void RunMortonCopy(MortonFunc func, const SurfaceParams& surface_info, u32 start_offset,
+                   u32 end_offset, std::span<u8> linear_buffer, std::span<u8> tiled_buffer) {
+    const u32 size = std::min(end_offset - start_offset, static_cast<u32>(tiled_buffer.size()));
+    const u32 tiled_end = start_offset + size;
+    auto& workers = GetMortonWorkers();
+    const u32 num_chunks = std::min<u32>(size / MIN_MORTON_CHUNK_SIZE,
+                                         static_cast<u32>(workers.NumWorkers()) + 1);
+    if (size < PARALLEL_MORTON_THRESHOLD || num_chunks < 2) {
+        func(surface_info.width, surface_info.height, start_offset, end_offset, linear_buffer,
+             tiled_buffer);
+        return;
+    }
+
+    // Only the first and last chunk may start or end in the middle of a tile.
+    const u32 tile_size = GetFormatBpp(surface_info.pixel_format) * 8;
+    const auto chunk_offset = [&](u32 chunk) {
+        if (chunk == num_chunks) {
+            return end_offset;
+        }
+        return std::max(start_offset,
+                        Common::AlignDown(start_offset + size / num_chunks * chunk, tile_size));
+    };
+    const auto run_chunk = [&](u32 chunk) {
+        const u32 chunk_start = chunk_offset(chunk);
+        const u32 chunk_end = chunk_offset(chunk + 1);
+        func(surface_info.width, surface_info.height, chunk_start, chunk_end, linear_buffer,
+             tiled_buffer.subspan(chunk_start - start_offset,
+                                  std::min(chunk_end, tiled_end) - chunk_start));
+    };
+
+    for (u32 chunk = 1; chunk < num_chunks; chunk++) {
+        workers.QueueWork([&run_chunk, chunk] { run_chunk(chunk); });
+    }
+    run_chunk(0);
+    workers.WaitForRequests();
+}
+
+} // Anonymous namespace
+
 u32 MipLevels(u32 width, u32 height, u32 max_level) {
     u32 levels = 1;
     while (width > 8 && height > 8) {
@@ -28,8 +90,8 @@ void EncodeTexture(const SurfaceParams& surface_info, PAddr start_addr, PAddr en
         const MortonFunc SwizzleImpl =
             (convert ? SWIZZLE_TABLE_CONVERTED : SWIZZLE_TABLE)[func_index];
         if (SwizzleImpl) {
-            SwizzleImpl(surface_info.width, surface_info.height, start_addr - surface_info.addr,
-                        end_addr - surface_info.addr, source, dest);
+            RunMortonCopy(SwizzleImpl, surface_info, start_addr - surface_info.addr,
+                          end_addr - surface_info.addr, source, dest);
             return;
         }
     } else {
@@ -55,7 +117,7 @@ void DecodeTexture(const SurfaceParams& surface_info, PAddr start_addr, PAddr en
         const MortonFunc UnswizzleImpl =
             (convert ? UNSWIZZLE_TABLE_CONVERTED : UNSWIZZLE_TABLE)[func_index];
         if (UnswizzleImpl) {
-            UnswizzleImpl(surface_info.width, surface_info.height, start_addr - surface_info.addr,
+            RunMortonCopy(UnswizzleImpl, surface_info, start_addr - surface_info.addr,
                           end_addr - surface_info.addr, dest, source);
             return;
         }
@@ -42,6 +42,9 @@ public:
     /// Notify rasterizer that the specified PICA register has been changed
     virtual void NotifyPicaRegisterChanged(u32 id) = 0;
 
+    /// Notify rasterizer that the specified PICA register is about to be set to `value`
+    virtual void NotifyPicaRegisterWrite([[maybe_unused]] u32 id, [[maybe_unused]] u32 value) {}
+
     /// Notify rasterizer that all caches should be flushed to 3DS memory
     virtual void FlushAll() = 0;
 
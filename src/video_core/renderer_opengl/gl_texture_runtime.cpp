@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/alignment.h"
+#include "common/literals.h"
 #include "common/scope_exit.h"
 #include "common/settings.h"
 #include "video_core/custom_textures/material.h"
@@ -16,6 +18,7 @@ namespace OpenGL {
 
 namespace {
 
+using namespace Common::Literals;
 using VideoCore::MapType;
 using VideoCore::PixelFormat;
 using VideoCore::SurfaceFlagBits;
@@ -24,6 +27,10 @@ using VideoCore::TextureType;
 
 constexpr GLenum TEMP_UNIT = GL_TEXTURE15;
 
+constexpr u32 DOWNLOAD_BUFFER_SIZE = 16_MiB;
+constexpr GLbitfield DOWNLOAD_BUFFER_FLAGS =
+    GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
 constexpr FormatTuple DEFAULT_TUPLE = {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
 
 static constexpr std::array<FormatTuple, 4> DEPTH_TUPLES = {{
@@ -119,9 +126,24 @@ TextureRuntime::TextureRuntime(const Driver& driver_, VideoCore::RendererBase& r
         draw_fbos[i].Create();
         read_fbos[i].Create();
     }
+
+    // Asynchronous downloads are written by the GPU to a persistently mapped pixel pack buffer
+    if (!driver.IsOpenGLES() && driver.HasArbBufferStorage()) {
+        download_buffer.Create();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, download_buffer.handle);
+        glBufferStorage(GL_PIXEL_PACK_BUFFER, DOWNLOAD_BUFFER_SIZE, nullptr,
+                        DOWNLOAD_BUFFER_FLAGS);
+        download_buffer_ptr = static_cast<u8*>(glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, DOWNLOAD_BUFFER_SIZE, DOWNLOAD_BUFFER_FLAGS));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
 }
 
-TextureRuntime::~TextureRuntime() = default;
+TextureRuntime::~TextureRuntime() {
+    for (const auto& [tick, sync] : download_fences) {
+        glDeleteSync(sync);
+    }
+}
 
 u32 TextureRuntime::RemoveThreshold() {
     return SWAP_CHAIN_SIZE;
@@ -144,6 +166,54 @@ VideoCore::StagingData TextureRuntime::FindStaging(u32 size, bool upload) {
     };
 }
 
+VideoCore::StagingData TextureRuntime::FindDownloadStaging(u32 size) {
+    ASSERT(download_buffer_ptr && size <= DOWNLOAD_BUFFER_SIZE);
+    if (download_buffer_offset + size > DOWNLOAD_BUFFER_SIZE) {
+        download_buffer_offset = 0;
+    }
+    const u32 offset = download_buffer_offset;
+    download_buffer_offset = Common::AlignUp(offset + size, 4U);
+    return VideoCore::StagingData{
+        .size = size,
+        .offset = offset,
+        .mapped = std::span{download_buffer_ptr + offset, size},
+    };
+}
+
+u32 TextureRuntime::DownloadStagingSize() const {
+    return download_buffer_ptr ? DOWNLOAD_BUFFER_SIZE : 0;
+}
+
+void TextureRuntime::WaitDownload(u64 fence, const VideoCore::StagingData& staging) {
+    // Fences are signaled in order, so the ones before the requested fence are removed as well
+    while (!download_fences.empty() && download_fences.front().first <= fence) {
+        const auto [tick, sync] = download_fences.front();
+        if (tick == fence) {
+            GLenum result;
+            do {
+                result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(sync);
+        download_fences.pop_front();
+    }
+}
+
+u64 TextureRuntime::InsertDownloadFence() {
+    while (!download_fences.empty()) {
+        GLint status{};
+        glGetSynciv(download_fences.front().second, GL_SYNC_STATUS, 1, nullptr, &status);
+        if (status != GL_SIGNALED) {
+            break;
+        }
+        glDeleteSync(download_fences.front().second);
+        download_fences.pop_front();
+    }
+    download_fences.emplace_back(++download_fence_tick,
+                                 glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    return download_fence_tick;
+}
+
 const FormatTuple& TextureRuntime::GetFormatTuple(PixelFormat pixel_format) const {
     if (pixel_format == PixelFormat::Invalid) {
         return DEFAULT_TUPLE;
@@ -453,6 +523,20 @@ void Surface::UploadCustom(const VideoCore::Material* material, u32 level) {
 
 void Surface::Download(const VideoCore::BufferTextureCopy& download,
                        const VideoCore::StagingData& staging) {
+    DownloadPixels(download, staging.mapped.data(), static_cast<GLsizei>(staging.mapped.size()));
+}
+
+u64 Surface::DownloadAsync(const VideoCore::BufferTextureCopy& download,
+                           const VideoCore::StagingData& staging) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, runtime->download_buffer.handle);
+    DownloadPixels(download, reinterpret_cast<void*>(static_cast<uintptr_t>(staging.offset)),
+                   static_cast<GLsizei>(staging.size));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return runtime->InsertDownloadFence();
+}
+
+void Surface::DownloadPixels(const VideoCore::BufferTextureCopy& download, void* pixels,
+                             GLsizei buf_size) {
     ASSERT(stride * GetFormatBytesPerPixel(pixel_format) % 4 == 0);
 
     const u32 unscaled_width = download.texture_rect.GetWidth();
@@ -471,7 +555,7 @@ void Surface::Download(const VideoCore::BufferTextureCopy& download,
     }
 
     // Try to download without using an fbo. This should succeed on recent desktop drivers
-    if (DownloadWithoutFbo(download, staging)) {
+    if (DownloadWithoutFbo(download, pixels, buf_size)) {
         return;
     }
 
@@ -485,13 +569,13 @@ void Surface::Download(const VideoCore::BufferTextureCopy& download,
     // Read the pixel data to the staging buffer
     const auto& tuple = runtime->GetFormatTuple(pixel_format);
     glReadPixels(download.texture_rect.left, download.texture_rect.bottom, unscaled_width,
-                 unscaled_height, tuple.format, tuple.type, staging.mapped.data());
+                 unscaled_height, tuple.format, tuple.type, pixels);
 
     glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 }
 
-bool Surface::DownloadWithoutFbo(const VideoCore::BufferTextureCopy& download,
-                                 const VideoCore::StagingData& staging) {
+bool Surface::DownloadWithoutFbo(const VideoCore::BufferTextureCopy& download, void* pixels,
+                                 GLsizei buf_size) {
     if (driver->IsOpenGLES()) {
         return false;
     }
@@ -507,11 +591,10 @@ bool Surface::DownloadWithoutFbo(const VideoCore::BufferTextureCopy& download,
     const bool is_full_download = download.texture_rect == GetRect();
     const bool has_sub_image = driver->HasArbGetTextureSubImage();
     if (has_sub_image) {
-        const GLsizei buf_size = static_cast<GLsizei>(staging.mapped.size());
         glGetTextureSubImage(Handle(0), download.texture_level, download.texture_rect.left,
                              download.texture_rect.bottom, 0, download.texture_rect.GetWidth(),
                              download.texture_rect.GetHeight(), 1, tuple.format, tuple.type,
-                             buf_size, staging.mapped.data());
+                             buf_size, pixels);
         return true;
     } else if (is_full_download) {
         // This should only trigger for full texture downloads in oldish intel drivers
@@ -520,8 +603,7 @@ bool Surface::DownloadWithoutFbo(const VideoCore::BufferTextureCopy& download,
         state.texture_units[0].texture_2d = Handle(0);
         state.Apply();
 
-        glGetTexImage(GL_TEXTURE_2D, download.texture_level, tuple.format, tuple.type,
-                      staging.mapped.data());
+        glGetTexImage(GL_TEXTURE_2D, download.texture_level, tuple.format, tuple.type, pixels);
 
         return true;
     }
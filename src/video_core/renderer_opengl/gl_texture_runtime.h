@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <deque>
 #include "video_core/rasterizer_cache/framebuffer_base.h"
 #include "video_core/rasterizer_cache/rasterizer_cache_base.h"
 #include "video_core/rasterizer_cache/surface_base.h"
@@ -54,6 +55,15 @@ public:
     /// Maps an internal staging buffer of the provided size of pixel uploads/downloads
     VideoCore::StagingData FindStaging(u32 size, bool upload);
 
+    /// Maps an internal staging buffer of the provided size for downloads that are read later
+    VideoCore::StagingData FindDownloadStaging(u32 size);
+
+    /// Returns the size of the staging buffer of asynchronous downloads, zero if not supported
+    u32 DownloadStagingSize() const;
+
+    /// Waits for an asynchronous download to staging to complete
+    void WaitDownload(u64 fence, const VideoCore::StagingData& staging);
+
     /// Returns the OpenGL format tuple associated with the provided pixel format
     const FormatTuple& GetFormatTuple(VideoCore::PixelFormat pixel_format) const;
     const FormatTuple& GetFormatTuple(VideoCore::CustomPixelFormat pixel_format);
@@ -82,10 +92,18 @@ private:
     /// Fills the rectangle of the surface with the value provided, without an fbo.
     bool ClearTextureWithoutFbo(Surface& surface, const VideoCore::TextureClear& clear);
 
+    /// Inserts a fence after the commands recorded so far and returns it
+    u64 InsertDownloadFence();
+
 private:
     const Driver& driver;
     BlitHelper blit_helper;
     std::vector<u8> staging_buffer;
+    OGLBuffer download_buffer;
+    u8* download_buffer_ptr{};
+    u32 download_buffer_offset{};
+    std::deque<std::pair<u64, GLsync>> download_fences;
+    u64 download_fence_tick{};
     std::array<OGLFramebuffer, 3> draw_fbos;
     std::array<OGLFramebuffer, 3> read_fbos;
 };
@@ -123,6 +141,10 @@ public:
     void Download(const VideoCore::BufferTextureCopy& download,
                   const VideoCore::StagingData& staging);
 
+    /// Downloads pixel data to staging without waiting for it, returns the fence to wait on
+    u64 DownloadAsync(const VideoCore::BufferTextureCopy& download,
+                      const VideoCore::StagingData& staging);
+
     /// Attaches a handle of surface to the specified framebuffer target
     void Attach(GLenum target, u32 level, u32 layer, bool scaled = true);
 
@@ -136,9 +158,13 @@ private:
     /// Performs blit between the scaled/unscaled images
     void BlitScale(const VideoCore::TextureBlit& blit, bool up_scale);
 
+    /// Downloads pixel data to pixels, an offset into the pixel pack buffer if one is bound
+    void DownloadPixels(const VideoCore::BufferTextureCopy& download, void* pixels,
+                        GLsizei buf_size);
+
     /// Attempts to download without using an fbo
-    bool DownloadWithoutFbo(const VideoCore::BufferTextureCopy& download,
-                            const VideoCore::StagingData& staging);
+    bool DownloadWithoutFbo(const VideoCore::BufferTextureCopy& download, void* pixels,
+                            GLsizei buf_size);
 
 private:
     const Driver* driver;
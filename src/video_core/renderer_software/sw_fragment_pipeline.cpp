@@ -0,0 +1,551 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "video_core/pica/regs_internal.h"
+#include "video_core/renderer_software/sw_fragment_pipeline.h"
+
+namespace SwRenderer {
+
+namespace {
+
+using Pica::FramebufferRegs;
+using TevStageConfig = Pica::TexturingRegs::TevStageConfig;
+
+Common::Vec3<u8> GetColorModifier(TevStageConfig::ColorModifier factor,
+                                  const Common::Vec4<u8>& values) {
+    using ColorModifier = TevStageConfig::ColorModifier;
+
+    switch (factor) {
+    case ColorModifier::SourceColor:
+        return values.rgb();
+    case ColorModifier::OneMinusSourceColor:
+        return (Common::Vec3<u8>(255, 255, 255) - values.rgb()).Cast<u8>();
+    case ColorModifier::SourceAlpha:
+        return values.aaa();
+    case ColorModifier::OneMinusSourceAlpha:
+        return (Common::Vec3<u8>(255, 255, 255) - values.aaa()).Cast<u8>();
+    case ColorModifier::SourceRed:
+        return values.rrr();
+    case ColorModifier::OneMinusSourceRed:
+        return (Common::Vec3<u8>(255, 255, 255) - values.rrr()).Cast<u8>();
+    case ColorModifier::SourceGreen:
+        return values.ggg();
+    case ColorModifier::OneMinusSourceGreen:
+        return (Common::Vec3<u8>(255, 255, 255) - values.ggg()).Cast<u8>();
+    case ColorModifier::SourceBlue:
+        return values.bbb();
+    case ColorModifier::OneMinusSourceBlue:
+        return (Common::Vec3<u8>(255, 255, 255) - values.bbb()).Cast<u8>();
+    }
+    UNREACHABLE();
+}
+
+u8 GetAlphaModifier(TevStageConfig::AlphaModifier factor, const Common::Vec4<u8>& values) {
+    using AlphaModifier = TevStageConfig::AlphaModifier;
+
+    switch (factor) {
+    case AlphaModifier::SourceAlpha:
+        return values.a();
+    case AlphaModifier::OneMinusSourceAlpha:
+        return 255 - values.a();
+    case AlphaModifier::SourceRed:
+        return values.r();
+    case AlphaModifier::OneMinusSourceRed:
+        return 255 - values.r();
+    case AlphaModifier::SourceGreen:
+        return values.g();
+    case AlphaModifier::OneMinusSourceGreen:
+        return 255 - values.g();
+    case AlphaModifier::SourceBlue:
+        return values.b();
+    case AlphaModifier::OneMinusSourceBlue:
+        return 255 - values.b();
+    }
+    UNREACHABLE();
+}
+
+Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op,
+                              std::span<const Common::Vec3<u8>, 3> input) {
+    using Operation = TevStageConfig::Operation;
+
+    switch (op) {
+    case Operation::Replace:
+        return input[0];
+    case Operation::Modulate:
+        return ((input[0] * input[1]) / 255).Cast<u8>();
+    case Operation::Add: {
+        auto result = input[0] + input[1];
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        return result.Cast<u8>();
+    }
+    case Operation::AddSigned: {
+        // TODO(bunnei): Verify that the color conversion from (float) 0.5f to
+        // (byte) 128 is correct
+        Common::Vec3i result =
+            input[0].Cast<s32>() + input[1].Cast<s32>() - Common::MakeVec<s32>(128, 128, 128);
+        result.r() = std::clamp<s32>(result.r(), 0, 255);
+        result.g() = std::clamp<s32>(result.g(), 0, 255);
+        result.b() = std::clamp<s32>(result.b(), 0, 255);
+        return result.Cast<u8>();
+    }
+    case Operation::Lerp:
+        return ((input[0] * input[2] +
+                 input[1] * (Common::MakeVec<u8>(255, 255, 255) - input[2]).Cast<u8>()) /
+                255)
+            .Cast<u8>();
+    case Operation::Subtract: {
+        auto result = input[0].Cast<s32>() - input[1].Cast<s32>();
+        result.r() = std::max(0, result.r());
+        result.g() = std::max(0, result.g());
+        result.b() = std::max(0, result.b());
+        return result.Cast<u8>();
+    }
+    case Operation::MultiplyThenAdd: {
+        auto result = (input[0] * input[1] + 255 * input[2].Cast<s32>()) / 255;
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        return result.Cast<u8>();
+    }
+    case Operation::AddThenMultiply: {
+        auto result = input[0] + input[1];
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        result = (result * input[2].Cast<s32>()) / 255;
+        return result.Cast<u8>();
+    }
+    case Operation::Dot3_RGB:
+    case Operation::Dot3_RGBA: {
+        // Not fully accurate.  Worst case scenario seems to yield a +/-3 error.  Some HW results
+        // indicate that the per-component computation can't have a higher precision than 1/256,
+        // while dot3_rgb((0x80,g0,b0), (0x7F,g1,b1)) and dot3_rgb((0x80,g0,b0), (0x80,g1,b1)) give
+        // different results.
+        s32 result = ((input[0].r() * 2 - 255) * (input[1].r() * 2 - 255) + 128) / 256 +
+                     ((input[0].g() * 2 - 255) * (input[1].g() * 2 - 255) + 128) / 256 +
+                     ((input[0].b() * 2 - 255) * (input[1].b() * 2 - 255) + 128) / 256;
+        result = std::clamp(result, 0, 255);
+        return Common::Vec3{result, result, result}.Cast<u8>();
+    }
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color combiner operation {}", (int)op);
+        UNIMPLEMENTED();
+        return {0, 0, 0};
+    }
+}
+
+u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
+    switch (op) {
+        using Operation = TevStageConfig::Operation;
+    case Operation::Replace:
+        return input[0];
+    case Operation::Modulate:
+        return input[0] * input[1] / 255;
+    case Operation::Add:
+        return std::min(255, input[0] + input[1]);
+    case Operation::AddSigned: {
+        // TODO(bunnei): Verify that the color conversion from (float) 0.5f to (byte) 128 is correct
+        auto result = static_cast<s32>(input[0]) + static_cast<s32>(input[1]) - 128;
+        return static_cast<u8>(std::clamp<s32>(result, 0, 255));
+    }
+    case Operation::Lerp:
+        return (input[0] * input[2] + input[1] * (255 - input[2])) / 255;
+    case Operation::Subtract:
+        return std::max(0, static_cast<s32>(input[0]) - static_cast<s32>(input[1]));
+    case Operation::MultiplyThenAdd:
+        return std::min(255, (input[0] * input[1] + 255 * input[2]) / 255);
+    case Operation::AddThenMultiply:
+        return (std::min(255, (input[0] + input[1])) * input[2]) / 255;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown alpha combiner operation {}", (int)op);
+        UNIMPLEMENTED();
+        return 0;
+    }
+}
+
+bool Compare(FramebufferRegs::CompareFunc func, u32 lhs, u32 rhs) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return false;
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+    case FramebufferRegs::CompareFunc::Equal:
+        return lhs == rhs;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return lhs != rhs;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return lhs < rhs;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return lhs <= rhs;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return lhs > rhs;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return lhs >= rhs;
+    }
+    UNREACHABLE();
+}
+
+u8 LookupBlendFactor(FramebufferRegs::BlendFactor factor, u32 channel,
+                     const Common::Vec4<u8>& src, const Common::Vec4<u8>& dest,
+                     const Common::Vec4<u8>& blend_const) {
+    DEBUG_ASSERT(channel < 4);
+
+    switch (factor) {
+    case FramebufferRegs::BlendFactor::Zero:
+        return 0;
+    case FramebufferRegs::BlendFactor::One:
+        return 255;
+    case FramebufferRegs::BlendFactor::SourceColor:
+        return src[channel];
+    case FramebufferRegs::BlendFactor::OneMinusSourceColor:
+        return 255 - src[channel];
+    case FramebufferRegs::BlendFactor::DestColor:
+        return dest[channel];
+    case FramebufferRegs::BlendFactor::OneMinusDestColor:
+        return 255 - dest[channel];
+    case FramebufferRegs::BlendFactor::SourceAlpha:
+        return src.a();
+    case FramebufferRegs::BlendFactor::OneMinusSourceAlpha:
+        return 255 - src.a();
+    case FramebufferRegs::BlendFactor::DestAlpha:
+        return dest.a();
+    case FramebufferRegs::BlendFactor::OneMinusDestAlpha:
+        return 255 - dest.a();
+    case FramebufferRegs::BlendFactor::ConstantColor:
+        return blend_const[channel];
+    case FramebufferRegs::BlendFactor::OneMinusConstantColor:
+        return 255 - blend_const[channel];
+    case FramebufferRegs::BlendFactor::ConstantAlpha:
+        return blend_const.a();
+    case FramebufferRegs::BlendFactor::OneMinusConstantAlpha:
+        return 255 - blend_const.a();
+    case FramebufferRegs::BlendFactor::SourceAlphaSaturate:
+        // Returns 1.0 for the alpha channel
+        if (channel == 3) {
+            return 255;
+        }
+        return std::min(src.a(), static_cast<u8>(255 - dest.a()));
+    default:
+        LOG_CRITICAL(HW_GPU, "Unknown blend factor {:x}", factor);
+        UNIMPLEMENTED();
+        break;
+    }
+    return src[channel];
+}
+
+/**
+ * Instantiates `Function` for every possible value of its first argument, an enum of `Bits` bits.
+ * Calling through the returned table runs code where the switch on that value has been resolved
+ * at compile time.
+ */
+template <typename Enum, std::size_t Bits, auto Function, typename Result, typename... Args>
+struct SpecializedTable {
+    template <Enum value>
+    static Result Call(Args... args) {
+        return Function(value, args...);
+    }
+
+    template <std::size_t... values>
+    static constexpr std::array<Result (*)(Args...), sizeof...(values)> Make(
+        std::index_sequence<values...>) {
+        return {&Call<static_cast<Enum>(values)>...};
+    }
+
+    static constexpr auto table = Make(std::make_index_sequence<std::size_t{1} << Bits>{});
+
+    static Result (*Get(Enum value))(Args...) {
+        return table[static_cast<std::size_t>(value)];
+    }
+};
+
+using ColorModifierTable =
+    SpecializedTable<TevStageConfig::ColorModifier, 4, &GetColorModifier, Common::Vec3<u8>,
+                     const Common::Vec4<u8>&>;
+using AlphaModifierTable =
+    SpecializedTable<TevStageConfig::AlphaModifier, 3, &GetAlphaModifier, u8,
+                     const Common::Vec4<u8>&>;
+using ColorCombineTable = SpecializedTable<TevStageConfig::Operation, 4, &ColorCombine,
+                                           Common::Vec3<u8>, std::span<const Common::Vec3<u8>, 3>>;
+using AlphaCombineTable =
+    SpecializedTable<TevStageConfig::Operation, 4, &AlphaCombine, u8, const std::array<u8, 3>&>;
+using CompareTable = SpecializedTable<FramebufferRegs::CompareFunc, 3, &Compare, bool, u32, u32>;
+using BlendFactorTable =
+    SpecializedTable<FramebufferRegs::BlendFactor, 4, &LookupBlendFactor, u8, u32,
+                     const Common::Vec4<u8>&, const Common::Vec4<u8>&, const Common::Vec4<u8>&>;
+
+bool IsPassThroughTevStage(const TevStageConfig& stage) {
+    return (stage.color_op == TevStageConfig::Operation::Replace &&
+            stage.alpha_op == TevStageConfig::Operation::Replace &&
+            stage.color_source1 == TevStageConfig::Source::Previous &&
+            stage.alpha_source1 == TevStageConfig::Source::Previous &&
+            stage.color_modifier1 == TevStageConfig::ColorModifier::SourceColor &&
+            stage.alpha_modifier1 == TevStageConfig::AlphaModifier::SourceAlpha &&
+            stage.GetColorMultiplier() == 1 && stage.GetAlphaMultiplier() == 1);
+}
+
+TevStageConfig::Source ValidateSource(TevStageConfig::Source source) {
+    switch (source) {
+    case TevStageConfig::Source::PrimaryColor:
+    case TevStageConfig::Source::PrimaryFragmentColor:
+    case TevStageConfig::Source::SecondaryFragmentColor:
+    case TevStageConfig::Source::Texture0:
+    case TevStageConfig::Source::Texture1:
+    case TevStageConfig::Source::Texture2:
+    case TevStageConfig::Source::Texture3:
+    case TevStageConfig::Source::PreviousBuffer:
+    case TevStageConfig::Source::Constant:
+    case TevStageConfig::Source::Previous:
+        return source;
+    default:
+        // Unknown sources are left unset in the source array, so they read as zero.
+        LOG_ERROR(HW_GPU, "Unknown color combiner source {}", source);
+        UNIMPLEMENTED();
+        return source;
+    }
+}
+
+} // Anonymous namespace
+
+FragmentConfig::FragmentConfig(const Pica::RegsInternal& regs) {
+    const auto& texturing = regs.texturing;
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+
+    const auto tev_stages = texturing.GetTevStages();
+    for (std::size_t i = 0; i < tev_stages.size(); i++) {
+        state.tev_stages[i].sources_raw = tev_stages[i].sources_raw;
+        state.tev_stages[i].modifiers_raw = tev_stages[i].modifiers_raw;
+        state.tev_stages[i].ops_raw = tev_stages[i].ops_raw;
+        state.tev_stages[i].scales_raw = tev_stages[i].scales_raw;
+    }
+    state.combiner_buffer_update_rgb = texturing.tev_combiner_buffer_input.update_mask_rgb;
+    state.combiner_buffer_update_a = texturing.tev_combiner_buffer_input.update_mask_a;
+    state.fog_mode = texturing.fog_mode;
+    state.fog_flip = texturing.fog_flip;
+
+    state.alpha_test_func = output_merger.alpha_test.enable ? output_merger.alpha_test.func.Value()
+                                                            : FramebufferRegs::CompareFunc::Always;
+    state.alphablend_enable = output_merger.alphablend_enable;
+    state.blend_equation_rgb = output_merger.alpha_blending.blend_equation_rgb;
+    state.blend_equation_a = output_merger.alpha_blending.blend_equation_a;
+    state.factor_source_rgb = output_merger.alpha_blending.factor_source_rgb;
+    state.factor_dest_rgb = output_merger.alpha_blending.factor_dest_rgb;
+    state.factor_source_a = output_merger.alpha_blending.factor_source_a;
+    state.factor_dest_a = output_merger.alpha_blending.factor_dest_a;
+    state.logic_op = output_merger.logic_op;
+    state.color_write_enable = framebuffer.allow_color_write != 0;
+    state.color_write_mask = output_merger.red_enable | output_merger.green_enable << 1 |
+                             output_merger.blue_enable << 2 | output_merger.alpha_enable << 3;
+
+    state.stencil_test_enable = output_merger.stencil_test.enable &&
+                                framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
+    state.stencil_test_func = output_merger.stencil_test.func;
+    state.stencil_fail_action = output_merger.stencil_test.action_stencil_fail;
+    state.depth_fail_action = output_merger.stencil_test.action_depth_fail;
+    state.depth_pass_action = output_merger.stencil_test.action_depth_pass;
+    state.depth_test_enable = output_merger.depth_test_enable;
+    state.depth_test_func = output_merger.depth_test_func;
+    state.depth_write_enable = output_merger.depth_write_enable;
+    state.depth_stencil_write_enable = framebuffer.allow_depth_stencil_write != 0;
+    state.depth_format = framebuffer.depth_format;
+    state.shadow_rendering = regs.framebuffer.IsShadowRendering();
+}
+
+FragmentPipeline::FragmentPipeline(const FragmentConfig& config) {
+    const auto& state = config.state;
+
+    for (u32 i = 0; i < tev_stages.size(); i++) {
+        TevStageConfig stage_config{};
+        stage_config.sources_raw = state.tev_stages[i].sources_raw;
+        stage_config.modifiers_raw = state.tev_stages[i].modifiers_raw;
+        stage_config.ops_raw = state.tev_stages[i].ops_raw;
+        stage_config.scales_raw = state.tev_stages[i].scales_raw;
+
+        // The first stage has no previous stage to read the color from, it uses the third
+        // source instead.
+        auto& stage = tev_stages[i];
+        const auto color_source3 = stage_config.color_source3.Value();
+        const auto color_source1 = stage_config.color_source1.Value();
+        const auto color_source2 = stage_config.color_source2.Value();
+        stage.color_sources = {
+            ValidateSource(i == 0 && color_source1 == TevStageConfig::Source::Previous
+                               ? color_source3
+                               : color_source1),
+            ValidateSource(i == 0 && color_source2 == TevStageConfig::Source::Previous
+                               ? color_source3
+                               : color_source2),
+            ValidateSource(color_source3),
+        };
+        stage.color_modifiers = {
+            ColorModifierTable::Get(stage_config.color_modifier1),
+            ColorModifierTable::Get(stage_config.color_modifier2),
+            ColorModifierTable::Get(stage_config.color_modifier3),
+        };
+        stage.color_combine = ColorCombineTable::Get(stage_config.color_op);
+
+        // The result of the Dot3_RGBA operation is also placed to the alpha component
+        if (stage_config.color_op != TevStageConfig::Operation::Dot3_RGBA) {
+            stage.alpha_sources = {
+                ValidateSource(stage_config.alpha_source1),
+                ValidateSource(stage_config.alpha_source2),
+                ValidateSource(stage_config.alpha_source3),
+            };
+            stage.alpha_modifiers = {
+                AlphaModifierTable::Get(stage_config.alpha_modifier1),
+                AlphaModifierTable::Get(stage_config.alpha_modifier2),
+                AlphaModifierTable::Get(stage_config.alpha_modifier3),
+            };
+            stage.alpha_combine = AlphaCombineTable::Get(stage_config.alpha_op);
+        }
+
+        stage.color_multiplier = stage_config.GetColorMultiplier();
+        stage.alpha_multiplier = stage_config.GetAlphaMultiplier();
+        stage.passthrough = i != 0 && IsPassThroughTevStage(stage_config);
+        stage.update_buffer_color = i < 4 && (state.combiner_buffer_update_rgb & (1 << i)) != 0;
+        stage.update_buffer_alpha = i < 4 && (state.combiner_buffer_update_a & (1 << i)) != 0;
+        if (!stage.passthrough) {
+            num_tev_stages = i + 1;
+        }
+    }
+
+    fog_enable = state.fog_mode == Pica::TexturingRegs::FogMode::Fog;
+    fog_flip = state.fog_flip != 0;
+
+    alpha_test = CompareTable::Get(state.alpha_test_func);
+
+    stencil_action_enable = state.stencil_test_enable != 0;
+    stencil_test = CompareTable::Get(state.stencil_test_func);
+    stencil_fail_action = state.stencil_fail_action;
+    depth_fail_action = state.depth_fail_action;
+    depth_pass_action = state.depth_pass_action;
+    depth_test = state.depth_test_enable ? CompareTable::Get(state.depth_test_func) : nullptr;
+    depth_test_func = state.depth_test_func;
+    stencil_write = state.depth_stencil_write_enable != 0;
+    depth_write = stencil_write && state.depth_write_enable != 0;
+    depth_stencil_enable = stencil_action_enable || depth_test || depth_write;
+    if (depth_stencil_enable) {
+        depth_max = (1 << FramebufferRegs::DepthBitsPerPixel(state.depth_format)) - 1;
+    }
+
+    // In shadow mode the output merger is bypassed entirely.
+    const bool shadow_rendering = state.shadow_rendering != 0;
+    early_depth_stencil = depth_stencil_enable && !shadow_rendering &&
+                          state.alpha_test_func == FramebufferRegs::CompareFunc::Always;
+    coarse_depth_test = depth_test && !stencil_action_enable && !shadow_rendering &&
+                        (state.depth_test_func == FramebufferRegs::CompareFunc::LessThan ||
+                         state.depth_test_func == FramebufferRegs::CompareFunc::LessThanOrEqual ||
+                         state.depth_test_func == FramebufferRegs::CompareFunc::GreaterThan ||
+                         state.depth_test_func == FramebufferRegs::CompareFunc::GreaterThanOrEqual);
+
+    color_write = state.color_write_enable != 0;
+    alphablend_enable = state.alphablend_enable != 0;
+    const auto src_rgb = BlendFactorTable::Get(state.factor_source_rgb);
+    const auto dst_rgb = BlendFactorTable::Get(state.factor_dest_rgb);
+    src_factors = {src_rgb, src_rgb, src_rgb, BlendFactorTable::Get(state.factor_source_a)};
+    dst_factors = {dst_rgb, dst_rgb, dst_rgb, BlendFactorTable::Get(state.factor_dest_a)};
+    blend_equation_rgb = state.blend_equation_rgb;
+    blend_equation_a = state.blend_equation_a;
+    logic_op = state.logic_op;
+    for (u32 i = 0; i < write_mask.size(); i++) {
+        write_mask[i] = (state.color_write_mask & (1 << i)) != 0;
+    }
+
+    // Without blending or masking, the logic op Copy writes the combiner output as is.
+    read_dest_color = alphablend_enable || logic_op != FramebufferRegs::LogicOp::Copy ||
+                      state.color_write_mask != 0xF;
+}
+
+Common::Vec4<u8> FragmentPipeline::CombineTev(std::span<Common::Vec4<u8>, NUM_TEV_SOURCES> sources,
+                                              std::span<const TevStageConfig, 6> stage_regs,
+                                              Common::Vec4<u8> next_combiner_buffer) const {
+    using Source = TevStageConfig::Source;
+    auto& combiner_output = sources[static_cast<u32>(Source::Previous)];
+    auto& combiner_buffer = sources[static_cast<u32>(Source::PreviousBuffer)];
+    auto& constant = sources[static_cast<u32>(Source::Constant)];
+
+    for (u32 tev_stage_index = 0; tev_stage_index < num_tev_stages; ++tev_stage_index) {
+        const auto& stage = tev_stages[tev_stage_index];
+
+        if (!stage.passthrough) {
+            const auto& tev_stage = stage_regs[tev_stage_index];
+            constant = Common::MakeVec(tev_stage.const_r.Value(), tev_stage.const_g.Value(),
+                                       tev_stage.const_b.Value(), tev_stage.const_a.Value())
+                           .Cast<u8>();
+
+            /**
+             * Color combiner
+             * NOTE: Not sure if the alpha combiner might use the color output of the previous
+             *       stage as input. Hence, we currently don't directly write the result to
+             *       combiner_output.rgb(), but instead store it in a temporary variable until
+             *       alpha combining has been done.
+             **/
+            const std::array<Common::Vec3<u8>, 3> color_result = {
+                stage.color_modifiers[0](sources[static_cast<u32>(stage.color_sources[0])]),
+                stage.color_modifiers[1](sources[static_cast<u32>(stage.color_sources[1])]),
+                stage.color_modifiers[2](sources[static_cast<u32>(stage.color_sources[2])]),
+            };
+            const Common::Vec3<u8> color_output = stage.color_combine(color_result);
+
+            u8 alpha_output;
+            if (!stage.alpha_combine) {
+                // result of Dot3_RGBA operation is also placed to the alpha component
+                alpha_output = color_output.x;
+            } else {
+                // alpha combiner
+                const std::array<u8, 3> alpha_result = {{
+                    stage.alpha_modifiers[0](sources[static_cast<u32>(stage.alpha_sources[0])]),
+                    stage.alpha_modifiers[1](sources[static_cast<u32>(stage.alpha_sources[1])]),
+                    stage.alpha_modifiers[2](sources[static_cast<u32>(stage.alpha_sources[2])]),
+                }};
+                alpha_output = stage.alpha_combine(alpha_result);
+            }
+
+            combiner_output[0] = std::min(255U, color_output.r() * stage.color_multiplier);
+            combiner_output[1] = std::min(255U, color_output.g() * stage.color_multiplier);
+            combiner_output[2] = std::min(255U, color_output.b() * stage.color_multiplier);
+            combiner_output[3] = std::min(255U, alpha_output * stage.alpha_multiplier);
+        }
+
+        combiner_buffer = next_combiner_buffer;
+
+        if (stage.update_buffer_color) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+
+        if (stage.update_buffer_alpha) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    }
+
+    return combiner_output;
+}
+
+const FragmentPipeline& FragmentPipelineCache::Get(const FragmentConfig& config) {
+    auto iter = pipelines.find(config);
+    if (iter != pipelines.end()) {
+        CachedPipeline& cached = iter->second;
+        pipeline_lru.splice(pipeline_lru.begin(), pipeline_lru, cached.lru_position);
+        return cached.pipeline;
+    }
+
+    if (pipelines.size() >= MAX_PIPELINES) {
+        pipelines.erase(pipeline_lru.back());
+        pipeline_lru.pop_back();
+    }
+
+    pipeline_lru.push_front(config);
+    return pipelines
+        .try_emplace(config, CachedPipeline{FragmentPipeline{config}, pipeline_lru.begin()})
+        .first->second.pipeline;
+}
+
+} // namespace SwRenderer
@@ -0,0 +1,199 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <list>
+#include <span>
+#include <unordered_map>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/pica/regs_framebuffer.h"
+#include "video_core/pica/regs_texturing.h"
+
+namespace Pica {
+struct RegsInternal;
+}
+
+namespace SwRenderer {
+
+/**
+ * Pipeline state the fragment routines are specialized on. Constants such as the TEV stage colors
+ * or the alpha test reference are not part of it and are read from the registers while shading.
+ */
+struct FragmentConfigState {
+    struct TevStage {
+        u32 sources_raw;
+        u32 modifiers_raw;
+        u32 ops_raw;
+        u32 scales_raw;
+    };
+
+    std::array<TevStage, 6> tev_stages;
+    u32 combiner_buffer_update_rgb;
+    u32 combiner_buffer_update_a;
+    Pica::TexturingRegs::FogMode fog_mode;
+    u32 fog_flip;
+
+    Pica::FramebufferRegs::CompareFunc alpha_test_func;
+    u32 alphablend_enable;
+    Pica::FramebufferRegs::BlendEquation blend_equation_rgb;
+    Pica::FramebufferRegs::BlendEquation blend_equation_a;
+    Pica::FramebufferRegs::BlendFactor factor_source_rgb;
+    Pica::FramebufferRegs::BlendFactor factor_dest_rgb;
+    Pica::FramebufferRegs::BlendFactor factor_source_a;
+    Pica::FramebufferRegs::BlendFactor factor_dest_a;
+    Pica::FramebufferRegs::LogicOp logic_op;
+    u32 color_write_enable;
+    u32 color_write_mask;
+
+    u32 stencil_test_enable;
+    Pica::FramebufferRegs::CompareFunc stencil_test_func;
+    Pica::FramebufferRegs::StencilAction stencil_fail_action;
+    Pica::FramebufferRegs::StencilAction depth_fail_action;
+    Pica::FramebufferRegs::StencilAction depth_pass_action;
+    u32 depth_test_enable;
+    Pica::FramebufferRegs::CompareFunc depth_test_func;
+    u32 depth_write_enable;
+    u32 depth_stencil_write_enable;
+    Pica::FramebufferRegs::DepthFormat depth_format;
+    u32 shadow_rendering;
+};
+
+/// Identifies a specialized fragment pipeline
+struct FragmentConfig : Common::HashableStruct<FragmentConfigState> {
+    explicit FragmentConfig(const Pica::RegsInternal& regs);
+};
+
+} // namespace SwRenderer
+
+namespace std {
+template <>
+struct hash<SwRenderer::FragmentConfig> {
+    std::size_t operator()(const SwRenderer::FragmentConfig& k) const noexcept {
+        return k.Hash();
+    }
+};
+} // namespace std
+
+namespace SwRenderer {
+
+/**
+ * Fragment operations specialized for a single FragmentConfig, the software equivalent of a
+ * generated fragment shader. The switches on the pipeline state are resolved once when the
+ * pipeline is built, leaving only table lookups and calls to functions specialized for the
+ * selected operation when shading a pixel.
+ */
+struct FragmentPipeline {
+    using TevStageConfig = Pica::TexturingRegs::TevStageConfig;
+    using ColorModifierFunc = Common::Vec3<u8> (*)(const Common::Vec4<u8>& values);
+    using AlphaModifierFunc = u8 (*)(const Common::Vec4<u8>& values);
+    using ColorCombineFunc = Common::Vec3<u8> (*)(std::span<const Common::Vec3<u8>, 3> input);
+    using AlphaCombineFunc = u8 (*)(const std::array<u8, 3>& input);
+    using CompareFunc = bool (*)(u32 lhs, u32 rhs);
+    using BlendFactorFunc = u8 (*)(u32 channel, const Common::Vec4<u8>& src,
+                                   const Common::Vec4<u8>& dest,
+                                   const Common::Vec4<u8>& blend_const);
+
+    struct TevStage {
+        /// Combiner inputs, as indices into the source array of the TEV
+        std::array<TevStageConfig::Source, 3> color_sources;
+        std::array<TevStageConfig::Source, 3> alpha_sources;
+        std::array<ColorModifierFunc, 3> color_modifiers;
+        std::array<AlphaModifierFunc, 3> alpha_modifiers;
+        ColorCombineFunc color_combine;
+        /// Null when the alpha output is taken from the color combiner (Dot3_RGBA)
+        AlphaCombineFunc alpha_combine;
+        u32 color_multiplier;
+        u32 alpha_multiplier;
+        /// The stage outputs the result of the previous stage unchanged
+        bool passthrough;
+        bool update_buffer_color;
+        bool update_buffer_alpha;
+    };
+
+    /// Number of combiner sources, the TEV source array is indexed by TevStageConfig::Source
+    static constexpr std::size_t NUM_TEV_SOURCES = 16;
+
+    explicit FragmentPipeline(const FragmentConfig& config);
+
+    /**
+     * Runs the TEV stages and returns the output of the last one. The slots of the previous
+     * stage output, the combiner buffer and the constant color in sources are overwritten.
+     * @param stage_regs TEV stage registers, which provide the constant color of each stage
+     * @param next_combiner_buffer Initial value of the combiner buffer
+     */
+    Common::Vec4<u8> CombineTev(std::span<Common::Vec4<u8>, NUM_TEV_SOURCES> sources,
+                                std::span<const TevStageConfig, 6> stage_regs,
+                                Common::Vec4<u8> next_combiner_buffer) const;
+
+    std::array<TevStage, 6> tev_stages{};
+    /// Number of stages to run, trailing passthrough stages are left out
+    u32 num_tev_stages{};
+
+    bool fog_enable{};
+    bool fog_flip{};
+
+    CompareFunc alpha_test{};
+
+    /// Whether the depth stencil test has to access the depth stencil buffer at all
+    bool depth_stencil_enable{};
+    bool stencil_action_enable{};
+    CompareFunc stencil_test{};
+    Pica::FramebufferRegs::StencilAction stencil_fail_action{};
+    Pica::FramebufferRegs::StencilAction depth_fail_action{};
+    Pica::FramebufferRegs::StencilAction depth_pass_action{};
+    /// Null when the depth test is disabled
+    CompareFunc depth_test{};
+    Pica::FramebufferRegs::CompareFunc depth_test_func{};
+    u32 depth_max{};
+    bool depth_write{};
+    bool stencil_write{};
+    /// The depth stencil test can run before shading, as nothing else can discard the fragment
+    bool early_depth_stencil{};
+    /// Blocks of pixels can be rejected using the depth bounds, failing has no side effects
+    bool coarse_depth_test{};
+
+    bool color_write{};
+    /// Whether the output merger needs the color of the destination pixel
+    bool read_dest_color{};
+    bool alphablend_enable{};
+    std::array<BlendFactorFunc, 4> src_factors{};
+    std::array<BlendFactorFunc, 4> dst_factors{};
+    Pica::FramebufferRegs::BlendEquation blend_equation_rgb{};
+    Pica::FramebufferRegs::BlendEquation blend_equation_a{};
+    Pica::FramebufferRegs::LogicOp logic_op{};
+    std::array<bool, 4> write_mask{};
+};
+
+/// Keeps the most recently used fragment pipelines, up to a fixed number of them.
+class FragmentPipelineCache {
+public:
+    /// Maximum number of pipelines kept, the least recently used one is freed once it is exceeded.
+    static constexpr std::size_t MAX_PIPELINES = 256;
+
+    /**
+     * Returns the pipeline specialized for the config, building it if it is not cached. The
+     * pipeline stays valid until MAX_PIPELINES other pipelines have been requested.
+     */
+    const FragmentPipeline& Get(const FragmentConfig& config);
+
+    /// Returns true if the pipeline of the config is cached.
+    bool Contains(const FragmentConfig& config) const {
+        return pipelines.contains(config);
+    }
+
+private:
+    struct CachedPipeline {
+        FragmentPipeline pipeline;
+        std::list<FragmentConfig>::iterator lru_position;
+    };
+    std::unordered_map<FragmentConfig, CachedPipeline> pipelines;
+    /// Pipeline configs ordered from the most to the least recently used
+    std::list<FragmentConfig> pipeline_lru;
+};
+
+} // namespace SwRenderer
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <limits>
 #include "common/color.h"
 #include "common/logging/log.h"
 #include "core/memory.h"
@@ -19,6 +20,11 @@ using Pica::FramebufferRegs;
 
 namespace {
 
+/// Width and height of the blocks the depth bounds are tracked for, in pixels.
+constexpr u32 DEPTH_BLOCK_SIZE = 8;
+/// Number of blocks in each direction, enough to cover the largest framebuffer.
+constexpr u32 NUM_DEPTH_BLOCKS = 1024 / DEPTH_BLOCK_SIZE;
+
 /// Decode/Encode for shadow map format. It is similar to D24S8 format,
 /// but the depth field is in big-endian.
 const Common::Vec2<u32> DecodeD24S8Shadow(const u8* bytes) {
@@ -37,7 +43,7 @@ void EncodeX24S8Shadow(u8 stencil, u8* bytes) {
 } // Anonymous namespace
 
 Framebuffer::Framebuffer(Memory::MemorySystem& memory_, const Pica::FramebufferRegs& regs_)
-    : memory{memory_}, regs{regs_} {}
+    : memory{memory_}, regs{regs_}, depth_blocks(NUM_DEPTH_BLOCKS * NUM_DEPTH_BLOCKS) {}
 
 Framebuffer::~Framebuffer() = default;
 
@@ -172,6 +178,16 @@ u8 Framebuffer::GetStencil(u32 x, u32 y) const {
 }
 
 void Framebuffer::SetDepth(u32 x, u32 y, u32 value) const {
+    // Widen the depth bounds of the block so that they still cover every value in it.
+    if (x < NUM_DEPTH_BLOCKS * DEPTH_BLOCK_SIZE && y < NUM_DEPTH_BLOCKS * DEPTH_BLOCK_SIZE) {
+        auto& block =
+            depth_blocks[(y / DEPTH_BLOCK_SIZE) * NUM_DEPTH_BLOCKS + x / DEPTH_BLOCK_SIZE];
+        if (block.generation == depth_generation) {
+            block.bounds.min = std::min(block.bounds.min, value);
+            block.bounds.max = std::max(block.bounds.max, value);
+        }
+    }
+
     const auto& framebuffer = regs.framebuffer;
     y = framebuffer.height - y;
 
@@ -227,6 +243,41 @@ void Framebuffer::SetStencil(u32 x, u32 y, u8 value) const {
     }
 }
 
+std::optional<DepthBounds> Framebuffer::GetDepthBounds(u32 x, u32 y) const {
+    const u32 block_x = x / DEPTH_BLOCK_SIZE;
+    const u32 block_y = y / DEPTH_BLOCK_SIZE;
+    if (block_x >= NUM_DEPTH_BLOCKS || block_y >= NUM_DEPTH_BLOCKS ||
+        (block_x + 1) * DEPTH_BLOCK_SIZE > regs.framebuffer.GetWidth() ||
+        (block_y + 1) * DEPTH_BLOCK_SIZE > regs.framebuffer.GetHeight()) {
+        return std::nullopt;
+    }
+
+    auto& block = depth_blocks[block_y * NUM_DEPTH_BLOCKS + block_x];
+    if (block.generation != depth_generation) {
+        block.bounds = {std::numeric_limits<u32>::max(), 0};
+        for (u32 j = 0; j < DEPTH_BLOCK_SIZE; j++) {
+            for (u32 i = 0; i < DEPTH_BLOCK_SIZE; i++) {
+                const u32 depth =
+                    GetDepth(block_x * DEPTH_BLOCK_SIZE + i, block_y * DEPTH_BLOCK_SIZE + j);
+                block.bounds.min = std::min(block.bounds.min, depth);
+                block.bounds.max = std::max(block.bounds.max, depth);
+            }
+        }
+        block.generation = depth_generation;
+    }
+    return block.bounds;
+}
+
+void Framebuffer::InvalidateDepthBounds() {
+    if (++depth_generation == 0) {
+        // Make sure no block is considered valid after the counter wraps around.
+        for (auto& block : depth_blocks) {
+            block.generation = 0;
+        }
+        depth_generation = 1;
+    }
+}
+
 void Framebuffer::DrawShadowMapPixel(u32 x, u32 y, u32 depth, u8 stencil) const {
     const auto& framebuffer = regs.framebuffer;
     const auto& shadow = regs.shadow;
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <optional>
+#include <vector>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/pica/regs_framebuffer.h"
@@ -18,6 +20,12 @@ struct FramebufferRegs;
 
 namespace SwRenderer {
 
+/// Range of the values stored in a block of the depth buffer.
+struct DepthBounds {
+    u32 min;
+    u32 max;
+};
+
 class Framebuffer {
 public:
     explicit Framebuffer(Memory::MemorySystem& memory, const Pica::FramebufferRegs& framebuffer);
@@ -47,13 +55,32 @@ public:
     /// Draws a pixel to the shadow buffer.
     void DrawShadowMapPixel(u32 x, u32 y, u32 depth, u8 stencil) const;
 
+    /**
+     * Returns the range of the depth values in the block containing the specified coordinates,
+     * or std::nullopt if the block is not entirely inside the framebuffer. The range is computed
+     * on first use and then kept up to date by SetDepth until the bounds are invalidated. Blocks
+     * are never shared by two screen tiles of the rasterizer.
+     */
+    [[nodiscard]] std::optional<DepthBounds> GetDepthBounds(u32 x, u32 y) const;
+
+    /// Discards the depth bounds, needed whenever the depth buffer may have changed elsewhere.
+    void InvalidateDepthBounds();
+
 private:
     Memory::MemorySystem& memory;
     const Pica::FramebufferRegs& regs;
-    PAddr color_addr;
+    PAddr color_addr{};
     u8* color_buffer{};
-    PAddr depth_addr;
+    PAddr depth_addr{};
     u8* depth_buffer{};
+
+    struct DepthBlock {
+        DepthBounds bounds;
+        /// The bounds are valid when this matches depth_generation
+        u32 generation;
+    };
+    mutable std::vector<DepthBlock> depth_blocks;
+    u32 depth_generation{1};
 };
 
 u8 PerformStencilAction(Pica::FramebufferRegs::StencilAction action, u8 old_stencil, u8 ref);
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <limits>
 #include <boost/container/static_vector.hpp>
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -23,7 +24,6 @@ using Pica::f24;
 using Pica::FramebufferRegs;
 using Pica::RasterizerRegs;
 using Pica::TexturingRegs;
-using Pica::Texture::LookupTexture;
 using Pica::Texture::TextureInfo;
 
 // Certain games render 2D elements very close to clip plane 0 resulting in very tiny
@@ -70,6 +70,24 @@ namespace {
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+/// Number of binned triangles after which they are rasterized regardless of other events.
+constexpr std::size_t MAX_BINNED_TRIANGLES = 4096;
+/// Number of pixels rasterized together, as a 2x2 quad in row order.
+constexpr u32 QUAD_SIZE = 4;
+/// Relative error allowed for the depth bounds of a triangle.
+constexpr float DEPTH_BOUNDS_EPSILON = 1e-5f;
+
+/// Offsets of the vertex attributes interpolated across a triangle.
+constexpr std::size_t ATTRIBUTE_COLOR = 0;
+constexpr std::size_t ATTRIBUTE_TC0 = 4;
+constexpr std::size_t ATTRIBUTE_TC1 = 6;
+constexpr std::size_t ATTRIBUTE_TC2 = 8;
+constexpr std::size_t ATTRIBUTE_TC0_W = 10;
+/// The attributes past this point are only used by fragment lighting.
+constexpr std::size_t ATTRIBUTE_QUAT = 11;
+constexpr std::size_t ATTRIBUTE_VIEW = 15;
+constexpr std::size_t NUM_ATTRIBUTES = 18;
+
 struct ClippingEdge {
 public:
     constexpr ClippingEdge(Common::Vec4<f24> coeffs,
@@ -100,10 +118,97 @@ private:
 
 } // Anonymous namespace
 
+/// Setup data of a triangle waiting to be rasterized.
+struct RasterizerSoftware::BinnedTriangle {
+    std::array<Vertex, 3> vertices;
+    std::array<Common::Vec3<Fix12P4>, 3> vtxpos;
+    std::array<int, 3> bias;
+    u16 min_x;
+    u16 min_y;
+    u16 max_x;
+    u16 max_y;
+    /// Perspective divided attributes of each vertex, laid out as described by ATTRIBUTE_*
+    std::array<std::array<f24, NUM_ATTRIBUTES>, 3> attributes;
+};
+
 RasterizerSoftware::RasterizerSoftware(Memory::MemorySystem& memory_, Pica::PicaCore& pica_)
     : memory{memory_}, pica{pica_}, regs{pica.regs.internal},
       num_sw_threads{std::max(std::thread::hardware_concurrency(), 2U)},
-      sw_workers{num_sw_threads, "SwRenderer workers"}, fb{memory, regs.framebuffer} {}
+      sw_workers{num_sw_threads, "SwRenderer workers"}, fb{memory, regs.framebuffer},
+      texture_cache{memory}, tile_bins(NUM_TILES_X * NUM_TILES_Y) {}
+
+RasterizerSoftware::~RasterizerSoftware() = default;
+
+void RasterizerSoftware::NotifyPicaRegisterWrite(u32 id, u32 value) {
+    // Vertex processing registers do not affect the binned triangles. Writes to the data port
+    // registers have side effects even if they do not change the register value.
+    if (triangles.empty() || id >= PICA_REG_INDEX(pipeline)) {
+        return;
+    }
+    const bool is_data_port = id == PICA_REG_INDEX(trigger_irq) ||
+                              (id >= PICA_REG_INDEX(lighting.lut_data) &&
+                               id < PICA_REG_INDEX(lighting.lut_data) + 8) ||
+                              (id >= PICA_REG_INDEX(texturing.fog_lut_data) &&
+                               id < PICA_REG_INDEX(texturing.fog_lut_data) + 8) ||
+                              (id >= PICA_REG_INDEX(texturing.proctex_lut_data) &&
+                               id < PICA_REG_INDEX(texturing.proctex_lut_data) + 8);
+    if (regs.reg_array[id] != value || is_data_port) {
+        FlushTriangles();
+    }
+}
+
+void RasterizerSoftware::FlushAll() {
+    FlushTriangles();
+}
+
+void RasterizerSoftware::FlushRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+}
+
+void RasterizerSoftware::InvalidateRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+    texture_cache.InvalidateRegion(addr, size);
+}
+
+void RasterizerSoftware::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+    texture_cache.InvalidateRegion(addr, size);
+}
+
+void RasterizerSoftware::ClearAll(bool flush) {
+    FlushTriangles();
+    texture_cache.Clear();
+}
+
+// The transfers themselves are done by the software blitter, only the textures they overwrite
+// have to be invalidated here.
+bool RasterizerSoftware::AccelerateDisplayTransfer(const Pica::DisplayTransferConfig& config) {
+    FlushTriangles();
+    const u32 output_size = config.output_width * config.output_height *
+                            Pica::BytesPerPixel(config.output_format);
+    texture_cache.InvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
+    return false;
+}
+
+bool RasterizerSoftware::AccelerateTextureCopy(const Pica::DisplayTransferConfig& config) {
+    FlushTriangles();
+    const u32 copy_size = config.texture_copy.size & ~0xF;
+    const u32 output_width = config.texture_copy.output_width * 16;
+    const u32 output_gap = config.texture_copy.output_gap * 16;
+    const u32 output_size =
+        output_width == 0
+            ? copy_size
+            : (copy_size + output_width - 1) / output_width * (output_width + output_gap);
+    texture_cache.InvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
+    return false;
+}
+
+bool RasterizerSoftware::AccelerateFill(const Pica::MemoryFillConfig& config) {
+    FlushTriangles();
+    texture_cache.InvalidateRegion(config.GetStartAddress(),
+                                   config.GetEndAddress() - config.GetStartAddress());
+    return false;
+}
 
 void RasterizerSoftware::AddTriangle(const Pica::OutputVertex& v0, const Pica::OutputVertex& v1,
                                      const Pica::OutputVertex& v2) {
@@ -229,8 +334,6 @@ void RasterizerSoftware::MakeScreenCoords(Vertex& vtx) {
 
 void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
                                          bool reversed) {
-    MICROPROFILE_SCOPE(GPU_Rasterization);
-
     // Vertex positions in rasterizer coordinates
     static auto screen_to_rasterizer_coords = [](const Common::Vec3<f24>& vec) {
         return Common::Vec3{Fix12P4::FromFloat24(vec.x), Fix12P4::FromFloat24(vec.y),
@@ -293,121 +396,362 @@ void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, con
     const int bias2 =
         IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
+    if (min_x >= max_x || min_y >= max_y) {
+        return;
+    }
+
+    // Sort the triangle into the bins of the tiles covered by its bounding box.
+    const u32 index = static_cast<u32>(triangles.size());
+    auto& triangle = triangles.emplace_back(BinnedTriangle{
+        {v0, v1, v2}, vtxpos, {bias0, bias1, bias2}, min_x, min_y, max_x, max_y, {}});
+    for (u32 i = 0; i < 3; i++) {
+        const Vertex& vtx = triangle.vertices[i];
+        triangle.attributes[i] = {
+            vtx.color.r(), vtx.color.g(), vtx.color.b(), vtx.color.a(), vtx.tc0.u(), vtx.tc0.v(),
+            vtx.tc1.u(),   vtx.tc1.v(),   vtx.tc2.u(),   vtx.tc2.v(),   vtx.tc0_w,   vtx.quat.x,
+            vtx.quat.y,    vtx.quat.z,    vtx.quat.w,    vtx.view.x,    vtx.view.y,  vtx.view.z,
+        };
+    }
+
+    const TileRange tiles = GetTileRange(min_x, min_y, max_x, max_y);
+    for (u32 tile_y = tiles.y1; tile_y < tiles.y2; tile_y++) {
+        for (u32 tile_x = tiles.x1; tile_x < tiles.x2; tile_x++) {
+            const u32 tile = tile_y * NUM_TILES_X + tile_x;
+            if (tile_bins[tile].empty()) {
+                active_tiles.push_back(tile);
+            }
+            tile_bins[tile].push_back(index);
+        }
+    }
+
+    if (triangles.size() == MAX_BINNED_TRIANGLES) {
+        FlushTriangles();
+    }
+}
+
+void RasterizerSoftware::FlushTriangles() {
+    if (triangles.empty()) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+
+    fb.Bind();
+    fb.InvalidateDepthBounds();
+    BindTextures();
+
+    // Look up the fragment routines specialized for the current pipeline state.
+    const FragmentConfig config{regs};
+    // The previous pipeline is no longer in use once the triangles have been flushed.
+    pipeline = &pipeline_cache.Get(config);
+
+    // Each tile is owned by a single worker, which rasterizes the binned triangles in submission
+    // order. This keeps the result identical to drawing the triangles one after another.
+    for (const u32 tile : active_tiles) {
+        sw_workers.QueueWork([this, tile] {
+            const u32 tile_x = tile % NUM_TILES_X;
+            const u32 tile_y = tile / NUM_TILES_X;
+            const u16 tile_min_x = static_cast<u16>((tile_x * TILE_SIZE) << 4);
+            const u16 tile_min_y = static_cast<u16>((tile_y * TILE_SIZE) << 4);
+            const u16 tile_max_x = tile_x == NUM_TILES_X - 1
+                                       ? std::numeric_limits<u16>::max()
+                                       : static_cast<u16>(((tile_x + 1) * TILE_SIZE) << 4);
+            const u16 tile_max_y = tile_y == NUM_TILES_Y - 1
+                                       ? std::numeric_limits<u16>::max()
+                                       : static_cast<u16>(((tile_y + 1) * TILE_SIZE) << 4);
+            for (const u32 index : tile_bins[tile]) {
+                RasterizeTriangle(triangles[index], tile_min_x, tile_min_y, tile_max_x,
+                                  tile_max_y);
+            }
+        });
+    }
+    sw_workers.WaitForRequests();
+
+    for (const u32 tile : active_tiles) {
+        tile_bins[tile].clear();
+    }
+    active_tiles.clear();
+    triangles.clear();
+
+    // Rendering to a texture makes its cached copy stale.
+    InvalidateFramebufferTextures();
+}
+
+void RasterizerSoftware::BindTextures() {
+    using TextureConfig = TexturingRegs::TextureConfig;
+
+    texture_cache.Trim();
+    unit_textures = {};
+    cube_textures = {};
+
+    const auto textures = regs.texturing.GetTextures();
+    for (u32 i = 0; i < 3; ++i) {
+        const auto& texture = textures[i];
+        if (!texture.enabled || texture.config.address == 0) {
+            continue;
+        }
+
+        auto info = TextureInfo::FromPicaRegister(texture.config, texture.format);
+        if (i == 0 && (texture.config.type == TextureConfig::TextureCube ||
+                       texture.config.type == TextureConfig::ShadowCube)) {
+            for (u32 face = 0; face < cube_textures.size(); ++face) {
+                info.physical_address = regs.texturing.GetCubePhysicalAddress(
+                    static_cast<TexturingRegs::CubeFace>(face));
+                cube_textures[face] = texture_cache.GetTexture(info);
+            }
+            continue;
+        }
+        unit_textures[i] = texture_cache.GetTexture(info);
+    }
+}
+
+void RasterizerSoftware::InvalidateFramebufferTextures() {
+    // Assume the largest pixel size, as the formats may not be valid if a buffer is unused.
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+    const u32 size = framebuffer.GetWidth() * framebuffer.GetHeight() * 4;
+    texture_cache.InvalidateRegion(framebuffer.GetColorBufferPhysicalAddress(), size);
+    texture_cache.InvalidateRegion(framebuffer.GetDepthBufferPhysicalAddress(), size);
+}
+
+void RasterizerSoftware::RasterizeTriangle(const BinnedTriangle& triangle, u16 tile_min_x,
+                                           u16 tile_min_y, u16 tile_max_x, u16 tile_max_y) {
+    const Vertex& v0 = triangle.vertices[0];
+    const Vertex& v1 = triangle.vertices[1];
+    const Vertex& v2 = triangle.vertices[2];
+    const auto& vtxpos = triangle.vtxpos;
+    const auto& bias = triangle.bias;
+
+    // Convert the scissor box coordinates to 12.4 fixed point
+    const u16 scissor_x1 = static_cast<u16>(regs.rasterizer.scissor_test.x1 << 4);
+    const u16 scissor_y1 = static_cast<u16>(regs.rasterizer.scissor_test.y1 << 4);
+    // x2,y2 have +1 added to cover the entire sub-pixel area
+    const u16 scissor_x2 = static_cast<u16>((regs.rasterizer.scissor_test.x2 + 1) << 4);
+    const u16 scissor_y2 = static_cast<u16>((regs.rasterizer.scissor_test.y2 + 1) << 4);
+    const bool scissor_exclude =
+        regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude;
+
     const auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
+    // Not fully accurate. About 3 bits in precision are missing.
+    // Z-Buffer (z / w * scale + offset)
+    const float depth_scale = f24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+    const float depth_offset =
+        f24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+    const bool w_buffering =
+        regs.rasterizer.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::WBuffering;
+
     const auto textures = regs.texturing.GetTextures();
     const auto tev_stages = regs.texturing.GetTevStages();
+    const std::size_t num_attributes = regs.lighting.disable ? ATTRIBUTE_QUAT : NUM_ATTRIBUTES;
+
+    // Pixels in blocks where the depth test fails for every depth of the triangle are rejected
+    // before any work is done for them. The depth of the triangle lies between the depths of its
+    // vertices, a small margin accounts for the rounding of the interpolation.
+    const bool coarse_depth_test = pipeline->coarse_depth_test && !w_buffering;
+    s64 reject_max_below = -1;
+    s64 reject_min_above = std::numeric_limits<s64>::max();
+    if (coarse_depth_test) {
+        float min_depth = std::numeric_limits<float>::max();
+        float max_depth = std::numeric_limits<float>::lowest();
+        for (const Vertex* vtx : {&v0, &v1, &v2}) {
+            const float depth = vtx->screenpos[2].ToFloat32() * depth_scale + depth_offset;
+            min_depth = std::min(min_depth, depth);
+            max_depth = std::max(max_depth, depth);
+        }
+        const float margin =
+            DEPTH_BOUNDS_EPSILON *
+            (1.0f + std::max(std::abs(min_depth), std::abs(max_depth)) + std::abs(depth_offset));
+        const float depth_max = static_cast<float>(pipeline->depth_max);
+        const s64 min_z = static_cast<u32>(std::clamp(min_depth - margin, 0.0f, 1.0f) * depth_max);
+        const s64 max_z = static_cast<u32>(std::clamp(max_depth + margin, 0.0f, 1.0f) * depth_max);
+        switch (pipeline->depth_test_func) {
+        case FramebufferRegs::CompareFunc::LessThan:
+            reject_max_below = min_z + 1;
+            break;
+        case FramebufferRegs::CompareFunc::LessThanOrEqual:
+            reject_max_below = min_z;
+            break;
+        case FramebufferRegs::CompareFunc::GreaterThan:
+            reject_min_above = max_z - 1;
+            break;
+        case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+            reject_min_above = max_z;
+            break;
+        default:
+            break;
+        }
+    }
 
-    fb.Bind();
+    // Only the part of the bounding box inside the tile is processed.
+    const u32 begin_x = std::max(triangle.min_x, tile_min_x);
+    const u32 begin_y = std::max(triangle.min_y, tile_min_y);
+    const u32 end_x = std::min(triangle.max_x, tile_max_x);
+    const u32 end_y = std::min(triangle.max_y, tile_max_y);
+
+    // The edge functions giving the barycentric coordinates w0, w1 and w2 are linear in the pixel
+    // position. They are evaluated exactly once per row of quads and then stepped by a constant.
+    static constexpr std::array<std::array<u32, 2>, 3> edge_vertices = {{{1, 2}, {2, 0}, {0, 1}}};
+    std::array<s32, 3> step_x;
+    std::array<std::array<s32, QUAD_SIZE>, 3> lane_offsets;
+    for (u32 i = 0; i < 3; i++) {
+        const auto& a = vtxpos[edge_vertices[i][0]];
+        const auto& b = vtxpos[edge_vertices[i][1]];
+        step_x[i] = -(static_cast<s32>(b.y) - static_cast<s32>(a.y)) * 0x10;
+        const s32 step_y = (static_cast<s32>(b.x) - static_cast<s32>(a.x)) * 0x10;
+        lane_offsets[i] = {0, step_x[i], step_y, step_x[i] + step_y};
+    }
 
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        const auto process_scanline = [&, y] {
-            for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-                // Do not process the pixel if it's inside the scissor box and the scissor mode is
-                // set to Exclude.
-                if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
-                    if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2) {
-                        continue;
+    // The pixels are processed in 2x2 quads whose lanes are computed together.
+    for (u32 y = begin_y + 8; y < end_y; y += 0x20) {
+        const Common::Vec2<Fix12P4> row_start{static_cast<u16>(begin_x + 8), static_cast<u16>(y)};
+        std::array<s32, 3> edges;
+        for (u32 i = 0; i < 3; i++) {
+            edges[i] = bias[i] + SignedArea(vtxpos[edge_vertices[i][0]].xy(),
+                                            vtxpos[edge_vertices[i][1]].xy(), row_start);
+        }
+
+        for (u32 x = begin_x + 8; x < end_x; x += 0x20) {
+            std::array<std::array<s32, QUAD_SIZE>, 3> w;
+            for (u32 i = 0; i < 3; i++) {
+                for (u32 lane = 0; lane < QUAD_SIZE; lane++) {
+                    w[i][lane] = edges[i] + lane_offsets[i][lane];
+                }
+                edges[i] += 2 * step_x[i];
+            }
+
+            // Skip the pixels that are not covered by the current primitive, lie outside the
+            // bounding box, or are inside the scissor box while the scissor mode is Exclude.
+            u32 coverage = 0;
+            for (u32 lane = 0; lane < QUAD_SIZE; lane++) {
+                const u32 px = x + (lane & 1) * 0x10;
+                const u32 py = y + (lane >> 1) * 0x10;
+                const bool excluded = scissor_exclude && px >= scissor_x1 && px < scissor_x2 &&
+                                      py >= scissor_y1 && py < scissor_y2;
+                const bool covered = w[0][lane] >= 0 && w[1][lane] >= 0 && w[2][lane] >= 0;
+                coverage |= (px < end_x && py < end_y && covered && !excluded) << lane;
+            }
+            if (coarse_depth_test) {
+                for (u32 lane = 0; lane < QUAD_SIZE; lane++) {
+                    const auto bounds = fb.GetDepthBounds((x + (lane & 1) * 0x10) >> 4,
+                                                          (y + (lane >> 1) * 0x10) >> 4);
+                    if (bounds && (bounds->max < reject_max_below ||
+                                   bounds->min > reject_min_above)) {
+                        coverage &= ~(1U << lane);
                     }
                 }
+            }
+            if (coverage == 0) {
+                continue;
+            }
 
-                // Calculate the barycentric coordinates w0, w1 and w2
-                const s32 w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-                const s32 w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-                const s32 w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
+            std::array<Common::Vec3<f24>, QUAD_SIZE> baricentric_coordinates;
+            std::array<f24, QUAD_SIZE> interpolated_w_inverse;
+            std::array<float, QUAD_SIZE> depths;
+            for (u32 lane = 0; lane < QUAD_SIZE; lane++) {
+                const s32 w0 = w[0][lane];
+                const s32 w1 = w[1][lane];
+                const s32 w2 = w[2][lane];
                 const s32 wsum = w0 + w1 + w2;
 
-                // If current pixel is not covered by the current primitive
-                if (w0 < 0 || w1 < 0 || w2 < 0) {
-                    continue;
-                }
-
-                const auto baricentric_coordinates = Common::MakeVec(
+                baricentric_coordinates[lane] = Common::MakeVec(
                     f24::FromFloat32(static_cast<f32>(w0)), f24::FromFloat32(static_cast<f32>(w1)),
                     f24::FromFloat32(static_cast<f32>(w2)));
-                const f24 interpolated_w_inverse =
-                    f24::One() / Common::Dot(w_inverse, baricentric_coordinates);
+                interpolated_w_inverse[lane] =
+                    f24::One() / Common::Dot(w_inverse, baricentric_coordinates[lane]);
 
                 // interpolated_z = z / w
                 const float interpolated_z_over_w =
                     (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
                      v2.screenpos[2].ToFloat32() * w2) /
                     wsum;
-
-                // Not fully accurate. About 3 bits in precision are missing.
-                // Z-Buffer (z / w * scale + offset)
-                const float depth_scale =
-                    f24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-                const float depth_offset =
-                    f24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
                 float depth = interpolated_z_over_w * depth_scale + depth_offset;
 
                 // Potentially switch to W-Buffer
-                if (regs.rasterizer.depthmap_enable ==
-                    Pica::RasterizerRegs::DepthBuffering::WBuffering) {
+                if (w_buffering) {
                     // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                    depth *= interpolated_w_inverse.ToFloat32() * wsum;
+                    depth *= interpolated_w_inverse[lane].ToFloat32() * wsum;
                 }
 
                 // Clamp the result
-                depth = std::clamp(depth, 0.0f, 1.0f);
-
-                /**
-                 * Perspective correct attribute interpolation:
-                 * Attribute values cannot be calculated by simple linear interpolation since
-                 * they are not linear in screen space. For example, when interpolating a
-                 * texture coordinate across two vertices, something simple like
-                 *     u = (u0*w0 + u1*w1)/(w0+w1)
-                 * will not work. However, the attribute value divided by the
-                 * clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-                 * in screenspace. Hence, we can linearly interpolate these two independently and
-                 * calculate the interpolated attribute by dividing the results.
-                 * I.e.
-                 *     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-                 *     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-                 *     u = u_over_w / one_over_w
-                 *
-                 * The generalization to three vertices is straightforward in baricentric
-                 *coordinates.
-                 **/
-                const auto get_interpolated_attribute = [&](f24 attr0, f24 attr1, f24 attr2) {
-                    auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
-                    f24 interpolated_attr_over_w =
-                        Common::Dot(attr_over_w, baricentric_coordinates);
-                    return interpolated_attr_over_w * interpolated_w_inverse;
+                depths[lane] = std::clamp(depth, 0.0f, 1.0f);
+            }
+
+            // Without anything that could discard the fragment later on, the depth stencil test
+            // is done before shading.
+            if (pipeline->early_depth_stencil) {
+                for (u32 lane = 0; lane < QUAD_SIZE; lane++) {
+                    if ((coverage & (1 << lane)) != 0 &&
+                        !DoDepthStencilTest(static_cast<u16>(x + (lane & 1) * 0x10),
+                                            static_cast<u16>(y + (lane >> 1) * 0x10),
+                                            depths[lane])) {
+                        coverage &= ~(1U << lane);
+                    }
+                }
+                if (coverage == 0) {
+                    continue;
+                }
+            }
+
+            /**
+             * Perspective correct attribute interpolation:
+             * Attribute values cannot be calculated by simple linear interpolation since
+             * they are not linear in screen space. For example, when interpolating a
+             * texture coordinate across two vertices, something simple like
+             *     u = (u0*w0 + u1*w1)/(w0+w1)
+             * will not work. However, the attribute value divided by the
+             * clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+             * in screenspace. Hence, we can linearly interpolate these two independently and
+             * calculate the interpolated attribute by dividing the results.
+             * I.e.
+             *     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+             *     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+             *     u = u_over_w / one_over_w
+             *
+             * The generalization to three vertices is straightforward in baricentric
+             *coordinates.
+             **/
+            std::array<std::array<f24, QUAD_SIZE>, NUM_ATTRIBUTES> attributes;
+            for (std::size_t attr = 0; attr < num_attributes; attr++) {
+                const auto attr_over_w =
+                    Common::MakeVec(triangle.attributes[0][attr], triangle.attributes[1][attr],
+                                    triangle.attributes[2][attr]);
+                for (u32 lane = 0; lane < QUAD_SIZE; lane++) {
+                    const f24 interpolated_attr_over_w =
+                        Common::Dot(attr_over_w, baricentric_coordinates[lane]);
+                    attributes[attr][lane] =
+                        interpolated_attr_over_w * interpolated_w_inverse[lane];
+                }
+            }
+
+            for (u32 lane = 0; lane < QUAD_SIZE; lane++) {
+                if ((coverage & (1 << lane)) == 0) {
+                    continue;
+                }
+                const u16 px = static_cast<u16>(x + (lane & 1) * 0x10);
+                const u16 py = static_cast<u16>(y + (lane >> 1) * 0x10);
+                const float depth = depths[lane];
+                const auto get_attribute = [&](std::size_t attr) {
+                    return attributes[attr][lane];
                 };
 
                 const Common::Vec4<u8> primary_color{
-                    static_cast<u8>(
-                        round(get_interpolated_attribute(v0.color.r(), v1.color.r(), v2.color.r())
-                                  .ToFloat32() *
-                              255)),
-                    static_cast<u8>(
-                        round(get_interpolated_attribute(v0.color.g(), v1.color.g(), v2.color.g())
-                                  .ToFloat32() *
-                              255)),
-                    static_cast<u8>(
-                        round(get_interpolated_attribute(v0.color.b(), v1.color.b(), v2.color.b())
-                                  .ToFloat32() *
-                              255)),
-                    static_cast<u8>(
-                        round(get_interpolated_attribute(v0.color.a(), v1.color.a(), v2.color.a())
-                                  .ToFloat32() *
-                              255)),
+                    static_cast<u8>(round(get_attribute(ATTRIBUTE_COLOR).ToFloat32() * 255)),
+                    static_cast<u8>(round(get_attribute(ATTRIBUTE_COLOR + 1).ToFloat32() * 255)),
+                    static_cast<u8>(round(get_attribute(ATTRIBUTE_COLOR + 2).ToFloat32() * 255)),
+                    static_cast<u8>(round(get_attribute(ATTRIBUTE_COLOR + 3).ToFloat32() * 255)),
                 };
 
                 std::array<Common::Vec2<f24>, 3> uv;
-                uv[0].u() = get_interpolated_attribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-                uv[0].v() = get_interpolated_attribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-                uv[1].u() = get_interpolated_attribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-                uv[1].v() = get_interpolated_attribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-                uv[2].u() = get_interpolated_attribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-                uv[2].v() = get_interpolated_attribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+                uv[0].u() = get_attribute(ATTRIBUTE_TC0);
+                uv[0].v() = get_attribute(ATTRIBUTE_TC0 + 1);
+                uv[1].u() = get_attribute(ATTRIBUTE_TC1);
+                uv[1].v() = get_attribute(ATTRIBUTE_TC1 + 1);
+                uv[2].u() = get_attribute(ATTRIBUTE_TC2);
+                uv[2].v() = get_attribute(ATTRIBUTE_TC2 + 1);
 
                 // Sample bound texture units.
-                const f24 tc0_w = get_interpolated_attribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+                const f24 tc0_w = get_attribute(ATTRIBUTE_TC0_W);
                 const auto texture_color = TextureColor(uv, textures, tc0_w);
 
                 Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
@@ -416,20 +760,17 @@ void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, con
                 if (!regs.lighting.disable) {
                     const auto normquat =
                         Common::Quaternion<f32>{
-                            {get_interpolated_attribute(v0.quat.x, v1.quat.x, v2.quat.x)
-                                 .ToFloat32(),
-                             get_interpolated_attribute(v0.quat.y, v1.quat.y, v2.quat.y)
-                                 .ToFloat32(),
-                             get_interpolated_attribute(v0.quat.z, v1.quat.z, v2.quat.z)
-                                 .ToFloat32()},
-                            get_interpolated_attribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
+                            {get_attribute(ATTRIBUTE_QUAT).ToFloat32(),
+                             get_attribute(ATTRIBUTE_QUAT + 1).ToFloat32(),
+                             get_attribute(ATTRIBUTE_QUAT + 2).ToFloat32()},
+                            get_attribute(ATTRIBUTE_QUAT + 3).ToFloat32(),
                         }
                             .Normalized();
 
                     const Common::Vec3f view{
-                        get_interpolated_attribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
-                        get_interpolated_attribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
-                        get_interpolated_attribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
+                        get_attribute(ATTRIBUTE_VIEW).ToFloat32(),
+                        get_attribute(ATTRIBUTE_VIEW + 1).ToFloat32(),
+                        get_attribute(ATTRIBUTE_VIEW + 2).ToFloat32(),
                     };
                     std::tie(primary_fragment_color, secondary_fragment_color) =
                         ComputeFragmentsColors(regs.lighting, pica.lighting, normquat, view,
@@ -438,8 +779,8 @@ void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, con
 
                 // Write the TEV stages.
                 auto combiner_output =
-                    WriteTevConfig(texture_color, tev_stages, primary_color, primary_fragment_color,
-                                   secondary_fragment_color);
+                    WriteTevConfig(texture_color, tev_stages, primary_color,
+                                   primary_fragment_color, secondary_fragment_color);
 
                 const auto& output_merger = regs.framebuffer.output_merger;
                 if (output_merger.fragment_operation_mode ==
@@ -447,7 +788,7 @@ void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, con
                     const u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
                     // Use green color as the shadow intensity
                     const u8 stencil = combiner_output.y;
-                    fb.DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
+                    fb.DrawShadowMapPixel(px >> 4, py >> 4, depth_int, stencil);
                     // Skip the normal output merger pipeline if it is in shadow mode
                     continue;
                 }
@@ -457,18 +798,15 @@ void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, con
                     continue;
                 }
                 WriteFog(depth, combiner_output);
-                if (!DoDepthStencilTest(x, y, depth)) {
+                if (!pipeline->early_depth_stencil && !DoDepthStencilTest(px, py, depth)) {
                     continue;
                 }
-                const auto result = PixelColor(x, y, combiner_output);
-                if (regs.framebuffer.framebuffer.allow_color_write != 0) {
-                    fb.DrawPixel(x >> 4, y >> 4, result);
+                if (pipeline->color_write) {
+                    fb.DrawPixel(px >> 4, py >> 4, PixelColor(px, py, combiner_output));
                 }
             }
-        };
-        sw_workers.QueueWork(std::move(process_scanline));
+        }
     }
-    sw_workers.WaitForRequests();
 }
 
 std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
@@ -557,11 +895,19 @@ std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
             t = texture.config.height - 1 -
                 GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
 
-            const u8* texture_data = memory.GetPhysicalPointer(texture_address);
-            const auto info = TextureInfo::FromPicaRegister(texture.config, texture.format);
+            // Cube map faces are told apart by the address of the sampled face.
+            const DecodedTexture* decoded = unit_textures[i];
+            if (i == 0 && !decoded) {
+                for (const DecodedTexture* face : cube_textures) {
+                    if (face && face->address == texture_address) {
+                        decoded = face;
+                        break;
+                    }
+                }
+            }
 
             // TODO: Apply the min and mag filters to the texture
-            texture_color[i] = LookupTexture(texture_data, s, t, info);
+            texture_color[i] = decoded ? decoded->GetTexel(s, t) : Common::Vec4<u8>{};
         }
 
         if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
@@ -593,90 +939,48 @@ std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
 
 Common::Vec4<u8> RasterizerSoftware::PixelColor(u16 x, u16 y,
                                                 Common::Vec4<u8> combiner_output) const {
+    if (!pipeline->read_dest_color) {
+        return combiner_output;
+    }
+
     const auto dest = fb.GetPixel(x >> 4, y >> 4);
     Common::Vec4<u8> blend_output = combiner_output;
 
-    const auto& output_merger = regs.framebuffer.output_merger;
-    if (output_merger.alphablend_enable) {
-        const auto params = output_merger.alpha_blending;
-        const auto lookup_factor = [&](u32 channel, FramebufferRegs::BlendFactor factor) -> u8 {
-            DEBUG_ASSERT(channel < 4);
-
-            const Common::Vec4<u8> blend_const =
-                Common::MakeVec(
-                    output_merger.blend_const.r.Value(), output_merger.blend_const.g.Value(),
-                    output_merger.blend_const.b.Value(), output_merger.blend_const.a.Value())
-                    .Cast<u8>();
-
-            switch (factor) {
-            case FramebufferRegs::BlendFactor::Zero:
-                return 0;
-            case FramebufferRegs::BlendFactor::One:
-                return 255;
-            case FramebufferRegs::BlendFactor::SourceColor:
-                return combiner_output[channel];
-            case FramebufferRegs::BlendFactor::OneMinusSourceColor:
-                return 255 - combiner_output[channel];
-            case FramebufferRegs::BlendFactor::DestColor:
-                return dest[channel];
-            case FramebufferRegs::BlendFactor::OneMinusDestColor:
-                return 255 - dest[channel];
-            case FramebufferRegs::BlendFactor::SourceAlpha:
-                return combiner_output.a();
-            case FramebufferRegs::BlendFactor::OneMinusSourceAlpha:
-                return 255 - combiner_output.a();
-            case FramebufferRegs::BlendFactor::DestAlpha:
-                return dest.a();
-            case FramebufferRegs::BlendFactor::OneMinusDestAlpha:
-                return 255 - dest.a();
-            case FramebufferRegs::BlendFactor::ConstantColor:
-                return blend_const[channel];
-            case FramebufferRegs::BlendFactor::OneMinusConstantColor:
-                return 255 - blend_const[channel];
-            case FramebufferRegs::BlendFactor::ConstantAlpha:
-                return blend_const.a();
-            case FramebufferRegs::BlendFactor::OneMinusConstantAlpha:
-                return 255 - blend_const.a();
-            case FramebufferRegs::BlendFactor::SourceAlphaSaturate:
-                // Returns 1.0 for the alpha channel
-                if (channel == 3) {
-                    return 255;
-                }
-                return std::min(combiner_output.a(), static_cast<u8>(255 - dest.a()));
-            default:
-                LOG_CRITICAL(HW_GPU, "Unknown blend factor {:x}", factor);
-                UNIMPLEMENTED();
-                break;
-            }
-            return combiner_output[channel];
+    if (pipeline->alphablend_enable) {
+        const auto& blend_const = regs.framebuffer.output_merger.blend_const;
+        const Common::Vec4<u8> blend_const_color =
+            Common::MakeVec(blend_const.r.Value(), blend_const.g.Value(), blend_const.b.Value(),
+                            blend_const.a.Value())
+                .Cast<u8>();
+        const auto lookup_factors = [&](const auto& factors) {
+            return Common::MakeVec(factors[0](0, combiner_output, dest, blend_const_color),
+                                   factors[1](1, combiner_output, dest, blend_const_color),
+                                   factors[2](2, combiner_output, dest, blend_const_color),
+                                   factors[3](3, combiner_output, dest, blend_const_color));
         };
 
-        const auto srcfactor = Common::MakeVec(
-            lookup_factor(0, params.factor_source_rgb), lookup_factor(1, params.factor_source_rgb),
-            lookup_factor(2, params.factor_source_rgb), lookup_factor(3, params.factor_source_a));
-
-        const auto dstfactor = Common::MakeVec(
-            lookup_factor(0, params.factor_dest_rgb), lookup_factor(1, params.factor_dest_rgb),
-            lookup_factor(2, params.factor_dest_rgb), lookup_factor(3, params.factor_dest_a));
+        const auto srcfactor = lookup_factors(pipeline->src_factors);
+        const auto dstfactor = lookup_factors(pipeline->dst_factors);
 
         blend_output = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor,
-                                             params.blend_equation_rgb);
+                                             pipeline->blend_equation_rgb);
         blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor,
-                                                 params.blend_equation_a)
+                                                 pipeline->blend_equation_a)
                                .a();
     } else {
-        blend_output =
-            Common::MakeVec(LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
-                            LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
-                            LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
-                            LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
+        const auto logic_op = pipeline->logic_op;
+        blend_output = Common::MakeVec(LogicOp(combiner_output.r(), dest.r(), logic_op),
+                                       LogicOp(combiner_output.g(), dest.g(), logic_op),
+                                       LogicOp(combiner_output.b(), dest.b(), logic_op),
+                                       LogicOp(combiner_output.a(), dest.a(), logic_op));
     }
 
+    const auto& write_mask = pipeline->write_mask;
     const Common::Vec4<u8> result = {
-        output_merger.red_enable ? blend_output.r() : dest.r(),
-        output_merger.green_enable ? blend_output.g() : dest.g(),
-        output_merger.blue_enable ? blend_output.b() : dest.b(),
-        output_merger.alpha_enable ? blend_output.a() : dest.a(),
+        write_mask[0] ? blend_output.r() : dest.r(),
+        write_mask[1] ? blend_output.g() : dest.g(),
+        write_mask[2] ? blend_output.b() : dest.b(),
+        write_mask[3] ? blend_output.a() : dest.a(),
     };
 
     return result;
@@ -695,105 +999,25 @@ Common::Vec4<u8> RasterizerSoftware::WriteTevConfig(
      * with some basic arithmetic. Alpha combiners can be configured separately but work
      * analogously.
      **/
-    Common::Vec4<u8> combiner_output = {0, 0, 0, 0};
-    Common::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
-    Common::Vec4<u8> next_combiner_buffer =
+    using Source = TexturingRegs::TevStageConfig::Source;
+
+    // Combiner inputs indexed by their source. The output of the previous stage and the combiner
+    // buffer are kept in their slots, unknown sources are never written and read as zero.
+    std::array<Common::Vec4<u8>, FragmentPipeline::NUM_TEV_SOURCES> sources{};
+    sources[static_cast<u32>(Source::PrimaryColor)] = primary_color;
+    sources[static_cast<u32>(Source::PrimaryFragmentColor)] = primary_fragment_color;
+    sources[static_cast<u32>(Source::SecondaryFragmentColor)] = secondary_fragment_color;
+    sources[static_cast<u32>(Source::Texture0)] = texture_color[0];
+    sources[static_cast<u32>(Source::Texture1)] = texture_color[1];
+    sources[static_cast<u32>(Source::Texture2)] = texture_color[2];
+    sources[static_cast<u32>(Source::Texture3)] = texture_color[3];
+    const Common::Vec4<u8> combiner_buffer_color =
         Common::MakeVec(regs.texturing.tev_combiner_buffer_color.r.Value(),
                         regs.texturing.tev_combiner_buffer_color.g.Value(),
                         regs.texturing.tev_combiner_buffer_color.b.Value(),
                         regs.texturing.tev_combiner_buffer_color.a.Value())
             .Cast<u8>();
-
-    for (u32 tev_stage_index = 0; tev_stage_index < tev_stages.size(); ++tev_stage_index) {
-        const auto& tev_stage = tev_stages[tev_stage_index];
-        using Source = TexturingRegs::TevStageConfig::Source;
-
-        auto get_source = [&](Source source) -> Common::Vec4<u8> {
-            switch (source) {
-            case Source::PrimaryColor:
-                return primary_color;
-            case Source::PrimaryFragmentColor:
-                return primary_fragment_color;
-            case Source::SecondaryFragmentColor:
-                return secondary_fragment_color;
-            case Source::Texture0:
-                return texture_color[0];
-            case Source::Texture1:
-                return texture_color[1];
-            case Source::Texture2:
-                return texture_color[2];
-            case Source::Texture3:
-                return texture_color[3];
-            case Source::PreviousBuffer:
-                return combiner_buffer;
-            case Source::Constant:
-                return Common::MakeVec(tev_stage.const_r.Value(), tev_stage.const_g.Value(),
-                                       tev_stage.const_b.Value(), tev_stage.const_a.Value())
-                    .Cast<u8>();
-            case Source::Previous:
-                return combiner_output;
-            default:
-                LOG_ERROR(HW_GPU, "Unknown color combiner source {}", (int)source);
-                UNIMPLEMENTED();
-                return {0, 0, 0, 0};
-            }
-        };
-
-        /**
-         * Color combiner
-         * NOTE: Not sure if the alpha combiner might use the color output of the previous
-         *       stage as input. Hence, we currently don't directly write the result to
-         *       combiner_output.rgb(), but instead store it in a temporary variable until
-         *       alpha combining has been done.
-         **/
-        const auto source1 = tev_stage_index == 0 && tev_stage.color_source1 == Source::Previous
-                                 ? tev_stage.color_source3.Value()
-                                 : tev_stage.color_source1.Value();
-        const auto source2 = tev_stage_index == 0 && tev_stage.color_source2 == Source::Previous
-                                 ? tev_stage.color_source3.Value()
-                                 : tev_stage.color_source2.Value();
-        const std::array<Common::Vec3<u8>, 3> color_result = {
-            GetColorModifier(tev_stage.color_modifier1, get_source(source1)),
-            GetColorModifier(tev_stage.color_modifier2, get_source(source2)),
-            GetColorModifier(tev_stage.color_modifier3, get_source(tev_stage.color_source3)),
-        };
-        const Common::Vec3<u8> color_output = ColorCombine(tev_stage.color_op, color_result);
-
-        u8 alpha_output;
-        if (tev_stage.color_op == TexturingRegs::TevStageConfig::Operation::Dot3_RGBA) {
-            // result of Dot3_RGBA operation is also placed to the alpha component
-            alpha_output = color_output.x;
-        } else {
-            // alpha combiner
-            const std::array<u8, 3> alpha_result = {{
-                GetAlphaModifier(tev_stage.alpha_modifier1, get_source(tev_stage.alpha_source1)),
-                GetAlphaModifier(tev_stage.alpha_modifier2, get_source(tev_stage.alpha_source2)),
-                GetAlphaModifier(tev_stage.alpha_modifier3, get_source(tev_stage.alpha_source3)),
-            }};
-            alpha_output = AlphaCombine(tev_stage.alpha_op, alpha_result);
-        }
-
-        combiner_output[0] = std::min(255U, color_output.r() * tev_stage.GetColorMultiplier());
-        combiner_output[1] = std::min(255U, color_output.g() * tev_stage.GetColorMultiplier());
-        combiner_output[2] = std::min(255U, color_output.b() * tev_stage.GetColorMultiplier());
-        combiner_output[3] = std::min(255U, alpha_output * tev_stage.GetAlphaMultiplier());
-
-        combiner_buffer = next_combiner_buffer;
-
-        if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(
-                tev_stage_index)) {
-            next_combiner_buffer.r() = combiner_output.r();
-            next_combiner_buffer.g() = combiner_output.g();
-            next_combiner_buffer.b() = combiner_output.b();
-        }
-
-        if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(
-                tev_stage_index)) {
-            next_combiner_buffer.a() = combiner_output.a();
-        }
-    }
-
-    return combiner_output;
+    return pipeline->CombineTev(sources, tev_stages, combiner_buffer_color);
 }
 
 void RasterizerSoftware::WriteFog(float depth, Common::Vec4<u8>& combiner_output) const {
@@ -801,14 +1025,14 @@ void RasterizerSoftware::WriteFog(float depth, Common::Vec4<u8>& combiner_output
      * Apply fog combiner. Not fully accurate. We'd have to know what data type is used to
      * store the depth etc. Using float for now until we know more about Pica datatypes.
      **/
-    if (regs.texturing.fog_mode == TexturingRegs::FogMode::Fog) {
+    if (pipeline->fog_enable) {
         const Common::Vec3<u8> fog_color =
             Common::MakeVec(regs.texturing.fog_color.r.Value(), regs.texturing.fog_color.g.Value(),
                             regs.texturing.fog_color.b.Value())
                 .Cast<u8>();
 
         float fog_index;
-        if (regs.texturing.fog_flip) {
+        if (pipeline->fog_flip) {
             fog_index = (1.0f - depth) * 128.0f;
         } else {
             fog_index = depth * 128.0f;
@@ -828,136 +1052,54 @@ void RasterizerSoftware::WriteFog(float depth, Common::Vec4<u8>& combiner_output
 }
 
 bool RasterizerSoftware::DoAlphaTest(u8 alpha) const {
-    const auto& output_merger = regs.framebuffer.output_merger;
-    if (!output_merger.alpha_test.enable) {
-        return true;
-    }
-    switch (output_merger.alpha_test.func) {
-    case FramebufferRegs::CompareFunc::Never:
-        return false;
-    case FramebufferRegs::CompareFunc::Always:
-        return true;
-    case FramebufferRegs::CompareFunc::Equal:
-        return alpha == output_merger.alpha_test.ref;
-    case FramebufferRegs::CompareFunc::NotEqual:
-        return alpha != output_merger.alpha_test.ref;
-    case FramebufferRegs::CompareFunc::LessThan:
-        return alpha < output_merger.alpha_test.ref;
-    case FramebufferRegs::CompareFunc::LessThanOrEqual:
-        return alpha <= output_merger.alpha_test.ref;
-    case FramebufferRegs::CompareFunc::GreaterThan:
-        return alpha > output_merger.alpha_test.ref;
-    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-        return alpha >= output_merger.alpha_test.ref;
-    default:
-        LOG_CRITICAL(Render_Software, "Unknown alpha test condition {}",
-                     output_merger.alpha_test.func.Value());
-        return false;
-    }
+    return pipeline->alpha_test(alpha, regs.framebuffer.output_merger.alpha_test.ref);
 }
 
 bool RasterizerSoftware::DoDepthStencilTest(u16 x, u16 y, float depth) const {
-    const auto& framebuffer = regs.framebuffer.framebuffer;
+    if (!pipeline->depth_stencil_enable) {
+        return true;
+    }
+
     const auto stencil_test = regs.framebuffer.output_merger.stencil_test;
     u8 old_stencil = 0;
 
     const auto update_stencil = [&](Pica::FramebufferRegs::StencilAction action) {
         const u8 new_stencil =
             PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-        if (framebuffer.allow_depth_stencil_write != 0) {
+        if (pipeline->stencil_write) {
             const u8 stencil =
                 (new_stencil & stencil_test.write_mask) | (old_stencil & ~stencil_test.write_mask);
             fb.SetStencil(x >> 4, y >> 4, stencil);
         }
     };
 
-    const bool stencil_action_enable =
-        regs.framebuffer.output_merger.stencil_test.enable &&
-        regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
-
-    if (stencil_action_enable) {
+    if (pipeline->stencil_action_enable) {
         old_stencil = fb.GetStencil(x >> 4, y >> 4);
         const u8 dest = old_stencil & stencil_test.input_mask;
         const u8 ref = stencil_test.reference_value & stencil_test.input_mask;
-        bool pass = false;
-        switch (stencil_test.func) {
-        case FramebufferRegs::CompareFunc::Never:
-            pass = false;
-            break;
-        case FramebufferRegs::CompareFunc::Always:
-            pass = true;
-            break;
-        case FramebufferRegs::CompareFunc::Equal:
-            pass = (ref == dest);
-            break;
-        case FramebufferRegs::CompareFunc::NotEqual:
-            pass = (ref != dest);
-            break;
-        case FramebufferRegs::CompareFunc::LessThan:
-            pass = (ref < dest);
-            break;
-        case FramebufferRegs::CompareFunc::LessThanOrEqual:
-            pass = (ref <= dest);
-            break;
-        case FramebufferRegs::CompareFunc::GreaterThan:
-            pass = (ref > dest);
-            break;
-        case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-            pass = (ref >= dest);
-            break;
-        }
-        if (!pass) {
-            update_stencil(stencil_test.action_stencil_fail);
+        if (!pipeline->stencil_test(ref, dest)) {
+            update_stencil(pipeline->stencil_fail_action);
             return false;
         }
     }
 
-    const u32 num_bits = FramebufferRegs::DepthBitsPerPixel(framebuffer.depth_format);
-    const u32 z = static_cast<u32>(depth * ((1 << num_bits) - 1));
+    const u32 z = static_cast<u32>(depth * pipeline->depth_max);
 
-    const auto& output_merger = regs.framebuffer.output_merger;
-    if (output_merger.depth_test_enable) {
+    if (pipeline->depth_test) {
         const u32 ref_z = fb.GetDepth(x >> 4, y >> 4);
-        bool pass = false;
-        switch (output_merger.depth_test_func) {
-        case FramebufferRegs::CompareFunc::Never:
-            pass = false;
-            break;
-        case FramebufferRegs::CompareFunc::Always:
-            pass = true;
-            break;
-        case FramebufferRegs::CompareFunc::Equal:
-            pass = z == ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::NotEqual:
-            pass = z != ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::LessThan:
-            pass = z < ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::LessThanOrEqual:
-            pass = z <= ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::GreaterThan:
-            pass = z > ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-            pass = z >= ref_z;
-            break;
-        }
-        if (!pass) {
-            if (stencil_action_enable) {
-                update_stencil(stencil_test.action_depth_fail);
+        if (!pipeline->depth_test(z, ref_z)) {
+            if (pipeline->stencil_action_enable) {
+                update_stencil(pipeline->depth_fail_action);
             }
             return false;
         }
     }
-    if (framebuffer.allow_depth_stencil_write != 0 && output_merger.depth_write_enable) {
+    if (pipeline->depth_write) {
         fb.SetDepth(x >> 4, y >> 4, z);
     }
     // The stencil depth_pass action is executed even if depth testing is disabled
-    if (stencil_action_enable) {
-        update_stencil(stencil_test.action_depth_pass);
+    if (pipeline->stencil_action_enable) {
+        update_stencil(pipeline->depth_pass_action);
     }
 
     return true;
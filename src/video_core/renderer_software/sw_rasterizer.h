@@ -4,12 +4,16 @@
 
 #pragma once
 
+#include <algorithm>
 #include <span>
+#include <vector>
 #include "common/thread_worker.h"
 #include "video_core/pica/regs_texturing.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_software/sw_clipper.h"
+#include "video_core/renderer_software/sw_fragment_pipeline.h"
 #include "video_core/renderer_software/sw_framebuffer.h"
+#include "video_core/renderer_software/sw_texture_cache.h"
 
 namespace Pica {
 struct RegsInternal;
@@ -20,28 +24,79 @@ namespace SwRenderer {
 
 struct Vertex;
 
+/// Width and height of the screen tiles triangles are binned into, in pixels.
+constexpr u32 TILE_SIZE = 32;
+/// Number of tiles in each direction, enough to cover the largest framebuffer.
+constexpr u32 NUM_TILES_X = 1024 / TILE_SIZE;
+constexpr u32 NUM_TILES_Y = 1024 / TILE_SIZE;
+
+/// Half-open range of screen tiles [x1, x2) x [y1, y2), which is empty if x1 >= x2 or y1 >= y2.
+struct TileRange {
+    u32 x1;
+    u32 y1;
+    u32 x2;
+    u32 y2;
+};
+
+/**
+ * Returns the tiles covered by a bounding box given in 12.4 fixed point, excluding its max edges.
+ * Pixels past the end of the tile grid belong to the last row or column.
+ */
+constexpr TileRange GetTileRange(u16 min_x, u16 min_y, u16 max_x, u16 max_y) {
+    const auto first_tile = [](u16 min, u32 num_tiles) {
+        return std::min<u32>((min >> 4) / TILE_SIZE, num_tiles - 1);
+    };
+    // Rounding the end up, instead of taking the tile of the last pixel, keeps boxes narrower
+    // than a pixel from wrapping around.
+    const auto end_tile = [](u16 max, u32 num_tiles) {
+        return std::min<u32>(((max >> 4) + TILE_SIZE - 1) / TILE_SIZE, num_tiles);
+    };
+    return {first_tile(min_x, NUM_TILES_X), first_tile(min_y, NUM_TILES_Y),
+            end_tile(max_x, NUM_TILES_X), end_tile(max_y, NUM_TILES_Y)};
+}
+
 class RasterizerSoftware : public VideoCore::RasterizerInterface {
 public:
     explicit RasterizerSoftware(Memory::MemorySystem& memory, Pica::PicaCore& pica);
+    ~RasterizerSoftware() override;
 
     void AddTriangle(const Pica::OutputVertex& v0, const Pica::OutputVertex& v1,
                      const Pica::OutputVertex& v2) override;
     void DrawTriangles() override {}
     void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushAll() override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
-    void ClearAll(bool flush) override {}
+    void NotifyPicaRegisterWrite(u32 id, u32 value) override;
+    void FlushAll() override;
+    void FlushRegion(PAddr addr, u32 size) override;
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    void ClearAll(bool flush) override;
+    bool AccelerateDisplayTransfer(const Pica::DisplayTransferConfig& config) override;
+    bool AccelerateTextureCopy(const Pica::DisplayTransferConfig& config) override;
+    bool AccelerateFill(const Pica::MemoryFillConfig& config) override;
 
 private:
+    struct BinnedTriangle;
+
     /// Computes the screen coordinates of the provided vertex.
     void MakeScreenCoords(Vertex& vtx);
 
-    /// Processes the triangle defined by the provided vertices.
+    /// Processes the triangle defined by the provided vertices and bins it for rasterization.
     void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
                          bool reversed = false);
 
+    /// Rasterizes all binned triangles, with each screen tile processed by a single worker.
+    void FlushTriangles();
+
+    /// Looks up the decoded textures of the enabled texture units in the texture cache.
+    void BindTextures();
+
+    /// Removes the cached textures that overlap the current framebuffer.
+    void InvalidateFramebufferTextures();
+
+    /// Rasterizes the part of the triangle that lies within the provided tile.
+    void RasterizeTriangle(const BinnedTriangle& triangle, u16 tile_min_x, u16 tile_min_y,
+                           u16 tile_max_x, u16 tile_max_y);
+
     /// Returns the texture color of the currently processed pixel.
     std::array<Common::Vec4<u8>, 4> TextureColor(
         std::span<const Common::Vec2<f24>, 3> uv,
@@ -73,6 +128,14 @@ private:
     std::size_t num_sw_threads;
     Common::ThreadWorker sw_workers;
     Framebuffer fb;
+    TextureCache texture_cache;
+    std::array<const DecodedTexture*, 3> unit_textures{};
+    std::array<const DecodedTexture*, 6> cube_textures{};
+    FragmentPipelineCache pipeline_cache;
+    const FragmentPipeline* pipeline{};
+    std::vector<BinnedTriangle> triangles;
+    std::vector<std::vector<u32>> tile_bins;
+    std::vector<u32> active_tiles;
 };
 
 } // namespace SwRenderer
@@ -0,0 +1,10 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "video_core/rasterizer_cache/rasterizer_cache.h"
+#include "video_core/renderer_software/sw_texture_runtime.h"
+
+namespace VideoCore {
+template class RasterizerCache<SwRenderer::Traits>;
+} // namespace VideoCore
@@ -0,0 +1,128 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "core/memory.h"
+#include "video_core/renderer_software/sw_texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+
+namespace SwRenderer {
+
+namespace {
+
+/// Number of decoded texels the cache is trimmed to, 64MB worth of RGBA8 data
+constexpr std::size_t MAX_CACHED_TEXELS = 16 * 1024 * 1024;
+
+u64 MakeKey(const Pica::Texture::TextureInfo& info) {
+    return static_cast<u64>(info.physical_address) | static_cast<u64>(info.width) << 32 |
+           static_cast<u64>(info.height) << 43 | static_cast<u64>(info.format) << 54;
+}
+
+} // Anonymous namespace
+
+TextureCache::TextureCache(Memory::MemorySystem& memory_) : memory{memory_} {}
+
+TextureCache::~TextureCache() {
+    Clear();
+}
+
+const DecodedTexture* TextureCache::GetTexture(const Pica::Texture::TextureInfo& info) {
+    const u64 key = MakeKey(info);
+    if (const auto it = textures.find(key); it != textures.end()) {
+        CachedTexture& cached = it->second;
+        texture_lru.splice(texture_lru.begin(), texture_lru, cached.lru_position);
+        return &cached.texture;
+    }
+
+    const u8* source = memory.GetPhysicalPointer(info.physical_address);
+    if (!source || info.width == 0 || info.height == 0) {
+        return nullptr;
+    }
+
+    DecodedTexture texture{
+        .address = info.physical_address,
+        .width = info.width,
+        .height = info.height,
+        .size = static_cast<u32>(info.stride * ((info.height + 7) / 8)),
+    };
+    texture.texels.resize(info.width * info.height);
+
+    // Decode the texture one 8x8 tile at a time.
+    const std::size_t tile_size = Pica::Texture::CalculateTileSize(info.format);
+    for (u32 y = 0; y < info.height; y += 8) {
+        const u8* line = source + (y / 8) * info.stride;
+        for (u32 x = 0; x < info.width; x += 8) {
+            const u8* tile = line + (x / 8) * tile_size;
+            for (u32 fine_y = 0; fine_y < std::min(8U, info.height - y); fine_y++) {
+                for (u32 fine_x = 0; fine_x < std::min(8U, info.width - x); fine_x++) {
+                    texture.texels[(y + fine_y) * info.width + x + fine_x] =
+                        Pica::Texture::LookupTexelInTile(tile, fine_x, fine_y, info, false);
+                }
+            }
+        }
+    }
+
+    UpdatePagesCachedCount(texture.address, texture.size, 1);
+    cached_texels += texture.texels.size();
+    texture_lru.push_front(key);
+    return &textures.try_emplace(key, CachedTexture{std::move(texture), texture_lru.begin()})
+                .first->second.texture;
+}
+
+void TextureCache::InvalidateRegion(PAddr addr, u32 size) {
+    const PAddr end = addr + size;
+    for (auto it = textures.begin(); it != textures.end();) {
+        const DecodedTexture& texture = it->second.texture;
+        if (texture.address < end && addr < texture.address + texture.size) {
+            RemoveTexture(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TextureCache::Trim() {
+    while (cached_texels > MAX_CACHED_TEXELS) {
+        RemoveTexture(textures.find(texture_lru.back()));
+    }
+}
+
+void TextureCache::Clear() {
+    for (const auto& [key, cached] : textures) {
+        UpdatePagesCachedCount(cached.texture.address, cached.texture.size, -1);
+    }
+    textures.clear();
+    texture_lru.clear();
+    cached_texels = 0;
+}
+
+void TextureCache::RemoveTexture(std::unordered_map<u64, CachedTexture>::iterator it) {
+    const DecodedTexture& texture = it->second.texture;
+    UpdatePagesCachedCount(texture.address, texture.size, -1);
+    cached_texels -= texture.texels.size();
+    texture_lru.erase(it->second.lru_position);
+    textures.erase(it);
+}
+
+void TextureCache::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
+    if (size == 0) {
+        return;
+    }
+
+    const u32 page_start = addr >> Memory::CITRA_PAGE_BITS;
+    const u32 page_end = ((addr + size - 1) >> Memory::CITRA_PAGE_BITS) + 1;
+    for (u32 page = page_start; page < page_end; page++) {
+        u32& count = cached_pages[page];
+        if (delta > 0 && count++ == 0) {
+            memory.RasterizerMarkRegionCached(page << Memory::CITRA_PAGE_BITS,
+                                              Memory::CITRA_PAGE_SIZE, true);
+        } else if (delta < 0 && --count == 0) {
+            memory.RasterizerMarkRegionCached(page << Memory::CITRA_PAGE_BITS,
+                                              Memory::CITRA_PAGE_SIZE, false);
+            cached_pages.erase(page);
+        }
+    }
+}
+
+} // namespace SwRenderer
@@ -0,0 +1,80 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace Pica::Texture {
+struct TextureInfo;
+}
+
+namespace SwRenderer {
+
+/// Texture decoded to RGBA8 texels that are stored in linear order.
+struct DecodedTexture {
+    PAddr address;
+    u32 width;
+    u32 height;
+    u32 size; ///< Size of the texture in guest memory
+    std::vector<Common::Vec4<u8>> texels;
+
+    /// Returns the texel at the provided coordinates, which are the same as for LookupTexture.
+    Common::Vec4<u8> GetTexel(u32 x, u32 y) const {
+        return texels[y * width + x];
+    }
+};
+
+/**
+ * Caches the decoded textures sampled by the software rasterizer, so that texel fetches do not
+ * have to go through the Morton swizzle and format decode every time. The pages holding cached
+ * textures are marked as rasterizer cached, so CPU writes to them invalidate the textures.
+ */
+class TextureCache {
+public:
+    explicit TextureCache(Memory::MemorySystem& memory);
+    ~TextureCache();
+
+    /**
+     * Returns the decoded texture described by info, decoding it if it is not cached yet.
+     * Returned pointers are valid until the texture is invalidated or the cache is trimmed.
+     */
+    const DecodedTexture* GetTexture(const Pica::Texture::TextureInfo& info);
+
+    /// Removes all textures that overlap the provided region.
+    void InvalidateRegion(PAddr addr, u32 size);
+
+    /// Removes the least recently used textures until the cache is within its size limit.
+    void Trim();
+
+    /// Removes all textures.
+    void Clear();
+
+private:
+    struct CachedTexture {
+        DecodedTexture texture;
+        std::list<u64>::iterator lru_position;
+    };
+
+    void RemoveTexture(std::unordered_map<u64, CachedTexture>::iterator it);
+
+    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+
+    Memory::MemorySystem& memory;
+    std::unordered_map<u64, CachedTexture> textures;
+    /// Texture keys ordered from the most to the least recently used
+    std::list<u64> texture_lru;
+    std::unordered_map<u32, u32> cached_pages;
+    std::size_t cached_texels{};
+};
+
+} // namespace SwRenderer
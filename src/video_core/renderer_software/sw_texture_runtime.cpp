@@ -0,0 +1,480 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include "common/assert.h"
+#include "common/color.h"
+#include "common/literals.h"
+#include "common/logging/log.h"
+#include "video_core/custom_textures/material.h"
+#include "video_core/renderer_software/sw_texture_runtime.h"
+
+namespace SwRenderer {
+
+namespace {
+
+using namespace Common::Literals;
+using VideoCore::PixelFormat;
+using VideoCore::SurfaceType;
+
+/// Number of frames a surface is kept alive after being removed from the cache
+constexpr u32 REMOVE_THRESHOLD = 3;
+
+/// Size of the staging buffer used for asynchronous downloads
+constexpr u32 DOWNLOAD_STAGING_SIZE = 16_MiB;
+
+u8* PixelAt(std::span<u8> pixels, u32 width, u32 x, u32 y, u32 bytes_per_pixel) {
+    return pixels.data() + (static_cast<std::size_t>(y) * width + x) * bytes_per_pixel;
+}
+
+/// Decodes a color pixel stored in the internal format of the surface
+Common::Vec4<u8> DecodeColor(PixelFormat format, const u8* pixel) {
+    using namespace Common::Color;
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return DecodeRGBA8(pixel);
+    case PixelFormat::RGB8:
+        return DecodeRGB8(pixel);
+    case PixelFormat::RGB565:
+        return DecodeRGB565(pixel);
+    case PixelFormat::RGB5A1:
+        return DecodeRGB5A1(pixel);
+    case PixelFormat::RGBA4:
+        return DecodeRGBA4(pixel);
+    default: {
+        // Texture formats are decoded to RGBA8 when uploaded
+        Common::Vec4<u8> color;
+        std::memcpy(color.AsArray(), pixel, 4);
+        return color;
+    }
+    }
+}
+
+/// Encodes a color pixel to the internal format of the surface
+void EncodeColor(PixelFormat format, const Common::Vec4<u8>& color, u8* pixel) {
+    using namespace Common::Color;
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return EncodeRGBA8(color, pixel);
+    case PixelFormat::RGB8:
+        return EncodeRGB8(color, pixel);
+    case PixelFormat::RGB565:
+        return EncodeRGB565(color, pixel);
+    case PixelFormat::RGB5A1:
+        return EncodeRGB5A1(color, pixel);
+    case PixelFormat::RGBA4:
+        return EncodeRGBA4(color, pixel);
+    default:
+        std::memcpy(pixel, color.AsArray(), 4);
+        return;
+    }
+}
+
+/// Returns the clear value encoded in the internal format of the surface
+std::array<u8, 4> MakeClearPixel(PixelFormat format, const VideoCore::ClearValue& value) {
+    std::array<u8, 4> pixel{};
+    switch (VideoCore::GetFormatType(format)) {
+    case SurfaceType::Color:
+    case SurfaceType::Texture: {
+        Common::Vec4<u8> color;
+        for (u32 i = 0; i < 4; i++) {
+            color[i] = static_cast<u8>(std::lround(std::clamp(value.color[i], 0.f, 1.f) * 255.f));
+        }
+        EncodeColor(format, color, pixel.data());
+        break;
+    }
+    case SurfaceType::Depth:
+        if (format == PixelFormat::D16) {
+            Common::Color::EncodeD16(static_cast<u32>(std::lround(value.depth * 0xFFFF)),
+                                     pixel.data());
+        } else {
+            Common::Color::EncodeD24(static_cast<u32>(std::lround(value.depth * 0xFFFFFF)),
+                                     pixel.data());
+        }
+        break;
+    case SurfaceType::DepthStencil: {
+        // The depth is stored in the upper 24 bits after upload, see DecodePixel
+        const u32 depth = static_cast<u32>(std::lround(value.depth * 0xFFFFFF));
+        const u32 d24s8 = (depth << 8) | value.stencil;
+        std::memcpy(pixel.data(), &d24s8, sizeof(u32));
+        break;
+    }
+    default:
+        UNREACHABLE_MSG("Invalid surface type!");
+    }
+    return pixel;
+}
+
+/// Returns true if the internal format of the surface stores the guest pixels unchanged,
+/// apart from the rotation applied to D24S8.
+bool StoresGuestPixels(PixelFormat format) {
+    const SurfaceType type = VideoCore::GetFormatType(format);
+    return (type == SurfaceType::Color || type == SurfaceType::Depth ||
+            type == SurfaceType::DepthStencil) &&
+           VideoCore::GetFormatBpp(format) / 8 == VideoCore::GetFormatBytesPerPixel(format);
+}
+
+} // Anonymous namespace
+
+TextureRuntime::TextureRuntime() = default;
+
+TextureRuntime::~TextureRuntime() = default;
+
+u32 TextureRuntime::RemoveThreshold() {
+    return REMOVE_THRESHOLD;
+}
+
+VideoCore::StagingData TextureRuntime::FindStaging(u32 size, bool upload) {
+    if (size > staging_buffer.size()) {
+        staging_buffer.resize(size);
+    }
+    return VideoCore::StagingData{
+        .size = size,
+        .offset = 0,
+        .mapped = std::span{staging_buffer.data(), size},
+    };
+}
+
+VideoCore::StagingData TextureRuntime::FindDownloadStaging(u32 size) {
+    ASSERT(size <= DOWNLOAD_STAGING_SIZE);
+    if (download_staging.empty()) {
+        download_staging.resize(DOWNLOAD_STAGING_SIZE);
+    }
+    if (download_offset + size > DOWNLOAD_STAGING_SIZE) {
+        download_offset = 0;
+    }
+    const u32 offset = download_offset;
+    download_offset += size;
+    return VideoCore::StagingData{
+        .size = size,
+        .offset = offset,
+        .mapped = std::span{download_staging.data() + offset, size},
+    };
+}
+
+u32 TextureRuntime::DownloadStagingSize() const {
+    return DOWNLOAD_STAGING_SIZE;
+}
+
+bool TextureRuntime::Reinterpret(Surface& source, Surface& dest,
+                                 const VideoCore::TextureCopy& copy) {
+    const PixelFormat src_format = source.pixel_format;
+    const PixelFormat dst_format = dest.pixel_format;
+    ASSERT_MSG(src_format != dst_format, "Reinterpretation with the same format is invalid");
+    if (!StoresGuestPixels(src_format) || !StoresGuestPixels(dst_format) ||
+        VideoCore::GetFormatBpp(src_format) != VideoCore::GetFormatBpp(dst_format)) {
+        LOG_WARNING(Render_Software, "Unimplemented reinterpretation {} -> {}",
+                    VideoCore::PixelFormatAsString(src_format),
+                    VideoCore::PixelFormatAsString(dst_format));
+        return false;
+    }
+
+    // Both surfaces hold the guest pixels, so reinterpreting them only has to undo the rotation
+    // of the depth stencil pixels.
+    const u32 bytes_per_pixel = source.GetInternalBytesPerPixel();
+    const u32 src_width = source.LevelWidth(copy.src_level);
+    const u32 dst_width = dest.LevelWidth(copy.dst_level);
+    const auto src_pixels = source.Pixels(copy.src_level, copy.src_layer);
+    const auto dst_pixels = dest.Pixels(copy.dst_level, copy.dst_layer);
+    for (u32 y = 0; y < copy.extent.height; y++) {
+        for (u32 x = 0; x < copy.extent.width; x++) {
+            const u8* src = PixelAt(src_pixels, src_width, copy.src_offset.x + x,
+                                    copy.src_offset.y + y, bytes_per_pixel);
+            u8* dst = PixelAt(dst_pixels, dst_width, copy.dst_offset.x + x, copy.dst_offset.y + y,
+                              bytes_per_pixel);
+            if (src_format != PixelFormat::D24S8 && dst_format != PixelFormat::D24S8) {
+                std::memcpy(dst, src, bytes_per_pixel);
+                continue;
+            }
+            u32 value;
+            std::memcpy(&value, src, sizeof(u32));
+            value = src_format == PixelFormat::D24S8 ? std::rotr(value, 8) : std::rotl(value, 8);
+            std::memcpy(dst, &value, sizeof(u32));
+        }
+    }
+    return true;
+}
+
+void TextureRuntime::ClearTexture(Surface& surface, const VideoCore::TextureClear& clear) {
+    const u32 bytes_per_pixel = surface.GetInternalBytesPerPixel();
+    const std::array clear_pixel = MakeClearPixel(surface.pixel_format, clear.value);
+    const u32 width = surface.LevelWidth(clear.texture_level);
+    const auto pixels = surface.Pixels(clear.texture_level);
+    const auto& rect = clear.texture_rect;
+    for (u32 y = rect.bottom; y < rect.top; y++) {
+        u8* row = PixelAt(pixels, width, rect.left, y, bytes_per_pixel);
+        for (u32 x = 0; x < rect.GetWidth(); x++) {
+            std::memcpy(row + x * bytes_per_pixel, clear_pixel.data(), bytes_per_pixel);
+        }
+    }
+}
+
+bool TextureRuntime::CopyTextures(Surface& source, Surface& dest,
+                                  const VideoCore::TextureCopy& copy) {
+    const u32 bytes_per_pixel = source.GetInternalBytesPerPixel();
+    if (bytes_per_pixel != dest.GetInternalBytesPerPixel()) {
+        LOG_WARNING(Render_Software, "Unable to copy {} to {}",
+                    VideoCore::PixelFormatAsString(source.pixel_format),
+                    VideoCore::PixelFormatAsString(dest.pixel_format));
+        return false;
+    }
+
+    const u32 src_width = source.LevelWidth(copy.src_level);
+    const u32 dst_width = dest.LevelWidth(copy.dst_level);
+    const auto src_pixels = source.Pixels(copy.src_level, copy.src_layer);
+    const auto dst_pixels = dest.Pixels(copy.dst_level, copy.dst_layer);
+    const std::size_t row_size = copy.extent.width * bytes_per_pixel;
+    for (u32 y = 0; y < copy.extent.height; y++) {
+        std::memcpy(PixelAt(dst_pixels, dst_width, copy.dst_offset.x, copy.dst_offset.y + y,
+                            bytes_per_pixel),
+                    PixelAt(src_pixels, src_width, copy.src_offset.x, copy.src_offset.y + y,
+                            bytes_per_pixel),
+                    row_size);
+    }
+    num_copies++;
+    return true;
+}
+
+bool TextureRuntime::BlitTextures(Surface& source, Surface& dest,
+                                  const VideoCore::TextureBlit& blit) {
+    const PixelFormat src_format = source.pixel_format;
+    const PixelFormat dst_format = dest.pixel_format;
+    const bool is_color = [](SurfaceType type) {
+        return type == SurfaceType::Color || type == SurfaceType::Texture;
+    }(source.type);
+    if (src_format != dst_format && (!is_color || source.type != dest.type)) {
+        LOG_WARNING(Render_Software, "Unable to blit {} to {}",
+                    VideoCore::PixelFormatAsString(src_format),
+                    VideoCore::PixelFormatAsString(dst_format));
+        return false;
+    }
+
+    const u32 src_bytes_per_pixel = source.GetInternalBytesPerPixel();
+    const u32 dst_bytes_per_pixel = dest.GetInternalBytesPerPixel();
+    const u32 src_width = source.LevelWidth(blit.src_level);
+    const u32 dst_width = dest.LevelWidth(blit.dst_level);
+    const auto src_pixels = source.Pixels(blit.src_level, blit.src_layer);
+    const auto dst_pixels = dest.Pixels(blit.dst_level, blit.dst_layer);
+
+    // The source rectangle is flipped when the blit mirrors the image, so the mapping from
+    // destination to source coordinates is done with signed values. Pixels are sampled at their
+    // center with nearest filtering.
+    const auto& src_rect = blit.src_rect;
+    const auto& dst_rect = blit.dst_rect;
+    const s64 src_x0 = src_rect.left;
+    const s64 src_y0 = src_rect.bottom;
+    const s64 src_dx = static_cast<s64>(src_rect.right) - src_x0;
+    const s64 src_dy = static_cast<s64>(src_rect.top) - src_y0;
+    const s64 dst_w = static_cast<s64>(dst_rect.right) - dst_rect.left;
+    const s64 dst_h = static_cast<s64>(dst_rect.top) - dst_rect.bottom;
+    if (dst_w <= 0 || dst_h <= 0) {
+        return false;
+    }
+
+    const auto map = [](s64 dst, s64 dst_size, s64 src_start, s64 src_size) {
+        const s64 numerator = (2 * dst + 1) * src_size;
+        const s64 denominator = 2 * dst_size;
+        const s64 offset = numerator / denominator - (numerator % denominator < 0 ? 1 : 0);
+        return static_cast<u32>(src_start + offset);
+    };
+    for (s64 y = 0; y < dst_h; y++) {
+        const u32 src_y = map(y, dst_h, src_y0, src_dy);
+        const u32 dst_y = static_cast<u32>(dst_rect.bottom + y);
+        for (s64 x = 0; x < dst_w; x++) {
+            const u32 src_x = map(x, dst_w, src_x0, src_dx);
+            const u32 dst_x = static_cast<u32>(dst_rect.left + x);
+            const u8* src = PixelAt(src_pixels, src_width, src_x, src_y, src_bytes_per_pixel);
+            u8* dst = PixelAt(dst_pixels, dst_width, dst_x, dst_y, dst_bytes_per_pixel);
+            if (src_format == dst_format) {
+                std::memcpy(dst, src, src_bytes_per_pixel);
+            } else {
+                EncodeColor(dst_format, DecodeColor(src_format, src), dst);
+            }
+        }
+    }
+    return true;
+}
+
+void TextureRuntime::GenerateMipmaps(Surface& surface) {
+    // Mipmaps are generated with nearest filtering, as averaging the packed formats would need
+    // decoding every pixel.
+    const u32 bytes_per_pixel = surface.GetInternalBytesPerPixel();
+    const u32 layers = surface.texture_type == VideoCore::TextureType::CubeMap ? 6 : 1;
+    for (u32 layer = 0; layer < layers; layer++) {
+        for (u32 level = 1; level < surface.levels; level++) {
+            const u32 src_width = surface.LevelWidth(level - 1);
+            const u32 src_height = surface.LevelHeight(level - 1);
+            const u32 width = surface.LevelWidth(level);
+            const u32 height = surface.LevelHeight(level);
+            const auto src_pixels = surface.Pixels(level - 1, layer);
+            const auto dst_pixels = surface.Pixels(level, layer);
+            for (u32 y = 0; y < height; y++) {
+                for (u32 x = 0; x < width; x++) {
+                    const u32 src_x = std::min(x * 2, src_width - 1);
+                    const u32 src_y = std::min(y * 2, src_height - 1);
+                    std::memcpy(PixelAt(dst_pixels, width, x, y, bytes_per_pixel),
+                                PixelAt(src_pixels, src_width, src_x, src_y, bytes_per_pixel),
+                                bytes_per_pixel);
+                }
+            }
+        }
+    }
+}
+
+Surface::Surface(TextureRuntime& runtime_, const VideoCore::SurfaceParams& params)
+    : SurfaceBase{params}, runtime{&runtime_} {
+    if (pixel_format == PixelFormat::Invalid) {
+        return;
+    }
+    Allocate();
+}
+
+Surface::Surface(TextureRuntime& runtime_, const VideoCore::SurfaceBase& surface,
+                 const VideoCore::Material* mat)
+    : SurfaceBase{surface}, runtime{&runtime_} {
+    custom_format = mat->format;
+    material = mat;
+    Allocate();
+}
+
+Surface::~Surface() = default;
+
+std::span<u8> Surface::Pixels(u32 level, u32 layer) noexcept {
+    const std::size_t size = static_cast<std::size_t>(LevelWidth(level)) * LevelHeight(level) *
+                             GetInternalBytesPerPixel();
+    return std::span{pixels}.subspan(layer * layer_size + level_offsets[level], size);
+}
+
+void Surface::Upload(const VideoCore::BufferTextureCopy& upload,
+                     const VideoCore::StagingData& staging) {
+    const u32 bytes_per_pixel = GetInternalBytesPerPixel();
+    const u32 width = LevelWidth(upload.texture_level);
+    const auto dst_pixels = Pixels(upload.texture_level);
+    const auto& rect = upload.texture_rect;
+    const u32 rect_width = rect.GetWidth();
+    const std::size_t row_size = rect_width * bytes_per_pixel;
+
+    // Each pixel of the staging buffer covers a block of res_scale pixels on each axis
+    for (u32 y = 0; y < rect.GetHeight(); y++) {
+        const u8* src_row = staging.mapped.data() + y * row_size;
+        for (u32 block_y = 0; block_y < res_scale; block_y++) {
+            const u32 dst_y = (rect.bottom + y) * res_scale + block_y;
+            u8* dst_row = PixelAt(dst_pixels, width, rect.left * res_scale, dst_y, bytes_per_pixel);
+            if (res_scale == 1) {
+                std::memcpy(dst_row, src_row, row_size);
+                continue;
+            }
+            for (u32 x = 0; x < rect_width * res_scale; x++) {
+                std::memcpy(dst_row + x * bytes_per_pixel,
+                            src_row + (x / res_scale) * bytes_per_pixel, bytes_per_pixel);
+            }
+        }
+    }
+}
+
+void Surface::UploadCustom(const VideoCore::Material* material, u32 level) {
+    // Replacement textures are only meant to be displayed, so they are not decoded here and the
+    // surface keeps its current contents.
+}
+
+void Surface::Download(const VideoCore::BufferTextureCopy& download,
+                       const VideoCore::StagingData& staging) {
+    runtime->num_downloads++;
+    CopyToStaging(download, staging);
+}
+
+u64 Surface::DownloadAsync(const VideoCore::BufferTextureCopy& download,
+                           const VideoCore::StagingData& staging) {
+    CopyToStaging(download, staging);
+    return 0;
+}
+
+void Surface::CopyToStaging(const VideoCore::BufferTextureCopy& download,
+                            const VideoCore::StagingData& staging) {
+    const u32 bytes_per_pixel = GetInternalBytesPerPixel();
+    const u32 width = LevelWidth(download.texture_level);
+    const auto src_pixels = Pixels(download.texture_level);
+    const auto& rect = download.texture_rect;
+    const u32 rect_width = rect.GetWidth();
+    const std::size_t row_size = rect_width * bytes_per_pixel;
+
+    // Scale down upscaled data by taking a single pixel of each block
+    for (u32 y = 0; y < rect.GetHeight(); y++) {
+        u8* dst_row = staging.mapped.data() + y * row_size;
+        const u8* src_row = PixelAt(src_pixels, width, rect.left * res_scale,
+                                    (rect.bottom + y) * res_scale, bytes_per_pixel);
+        if (res_scale == 1) {
+            std::memcpy(dst_row, src_row, row_size);
+            continue;
+        }
+        for (u32 x = 0; x < rect_width; x++) {
+            std::memcpy(dst_row + x * bytes_per_pixel, src_row + x * res_scale * bytes_per_pixel,
+                        bytes_per_pixel);
+        }
+    }
+}
+
+void Surface::ScaleUp(u32 new_scale) {
+    if (res_scale == new_scale || new_scale == 1) {
+        return;
+    }
+
+    const u32 old_scale = res_scale;
+    const std::vector<u8> old_pixels = std::exchange(pixels, {});
+    const std::vector<std::size_t> old_level_offsets = level_offsets;
+    const std::size_t old_layer_size = layer_size;
+
+    res_scale = new_scale;
+    Allocate();
+
+    const u32 bytes_per_pixel = GetInternalBytesPerPixel();
+    const u32 layers = texture_type == VideoCore::TextureType::CubeMap ? 6 : 1;
+    for (u32 layer = 0; layer < layers; layer++) {
+        for (u32 level = 0; level < levels; level++) {
+            const u32 old_width = std::max((width * old_scale) >> level, 1U);
+            const u32 old_height = std::max((height * old_scale) >> level, 1U);
+            const u8* src = old_pixels.data() + layer * old_layer_size + old_level_offsets[level];
+            const u32 new_width = LevelWidth(level);
+            const auto dst_pixels = Pixels(level, layer);
+            for (u32 y = 0; y < LevelHeight(level); y++) {
+                const u32 src_y = std::min(y * old_scale / new_scale, old_height - 1);
+                for (u32 x = 0; x < new_width; x++) {
+                    const u32 src_x = std::min(x * old_scale / new_scale, old_width - 1);
+                    std::memcpy(PixelAt(dst_pixels, new_width, x, y, bytes_per_pixel),
+                                src + (src_y * old_width + src_x) * bytes_per_pixel,
+                                bytes_per_pixel);
+                }
+            }
+        }
+    }
+}
+
+u32 Surface::GetInternalBytesPerPixel() const {
+    return VideoCore::GetFormatBytesPerPixel(pixel_format);
+}
+
+void Surface::Allocate() {
+    const u32 bytes_per_pixel = GetInternalBytesPerPixel();
+    level_offsets.resize(levels);
+    layer_size = 0;
+    for (u32 level = 0; level < levels; level++) {
+        level_offsets[level] = layer_size;
+        layer_size += static_cast<std::size_t>(LevelWidth(level)) * LevelHeight(level) *
+                      bytes_per_pixel;
+    }
+    const u32 layers = texture_type == VideoCore::TextureType::CubeMap ? 6 : 1;
+    pixels.resize(layer_size * layers);
+}
+
+Framebuffer::Framebuffer(TextureRuntime& runtime, const VideoCore::FramebufferParams& params,
+                         const Surface* color, const Surface* depth)
+    : VideoCore::FramebufferParams{params}, res_scale{color ? color->res_scale
+                                                            : (depth ? depth->res_scale : 1u)} {}
+
+Framebuffer::~Framebuffer() = default;
+
+} // namespace SwRenderer
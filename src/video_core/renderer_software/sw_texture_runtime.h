@@ -0,0 +1,202 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+#include "video_core/rasterizer_cache/framebuffer_base.h"
+#include "video_core/rasterizer_cache/rasterizer_cache_base.h"
+#include "video_core/rasterizer_cache/surface_base.h"
+
+namespace VideoCore {
+struct Material;
+}
+
+namespace SwRenderer {
+
+class Surface;
+
+/**
+ * Provides texture manipulation functions to the rasterizer cache without a graphics device.
+ * Surfaces live in host memory and every operation is performed on the CPU, which allows the
+ * rasterizer cache to run headless in tests and benchmarks.
+ */
+class TextureRuntime {
+public:
+    explicit TextureRuntime();
+    ~TextureRuntime();
+
+    /// Returns the removal threshold ticks for the garbage collector
+    u32 RemoveThreshold();
+
+    /// Submits and waits for current GPU work.
+    void Finish() {}
+
+    /// Returns true if the provided pixel format cannot be used natively by the runtime.
+    bool NeedsConversion(VideoCore::PixelFormat pixel_format) const {
+        return false;
+    }
+
+    /// Maps an internal staging buffer of the provided size of pixel uploads/downloads
+    VideoCore::StagingData FindStaging(u32 size, bool upload);
+
+    /// Maps an internal staging buffer of the provided size for downloads that are read later
+    VideoCore::StagingData FindDownloadStaging(u32 size);
+
+    /// Returns the size of the staging buffer of asynchronous downloads, zero if not supported
+    u32 DownloadStagingSize() const;
+
+    /// Waits for an asynchronous download to complete. Downloads are performed immediately.
+    void WaitDownload(u64 fence, const VideoCore::StagingData& staging) {}
+
+    /// Attempts to reinterpret a rectangle of source to another rectangle of dest
+    bool Reinterpret(Surface& source, Surface& dest, const VideoCore::TextureCopy& copy);
+
+    /// Fills the rectangle of the texture with the clear value provided
+    void ClearTexture(Surface& surface, const VideoCore::TextureClear& clear);
+
+    /// Copies a rectangle of source to another rectange of dest
+    bool CopyTextures(Surface& source, Surface& dest, const VideoCore::TextureCopy& copy);
+
+    /// Blits a rectangle of source to another rectange of dest
+    bool BlitTextures(Surface& source, Surface& dest, const VideoCore::TextureBlit& blit);
+
+    /// Generates mipmaps for all the available levels of the texture
+    void GenerateMipmaps(Surface& surface);
+
+    /// Returns the number of texture copies performed so far
+    u64 NumCopies() const {
+        return num_copies;
+    }
+
+    /// Returns the number of synchronous surface downloads performed so far
+    u64 NumDownloads() const {
+        return num_downloads;
+    }
+
+private:
+    friend class Surface;
+
+    u64 num_copies{};
+    u64 num_downloads{};
+    std::vector<u8> staging_buffer;
+    std::vector<u8> download_staging;
+    u32 download_offset{};
+};
+
+class Surface : public VideoCore::SurfaceBase {
+public:
+    explicit Surface(TextureRuntime& runtime, const VideoCore::SurfaceParams& params);
+    explicit Surface(TextureRuntime& runtime, const VideoCore::SurfaceBase& surface,
+                     const VideoCore::Material* material);
+    ~Surface();
+
+    Surface(const Surface&) = delete;
+    Surface& operator=(const Surface&) = delete;
+
+    Surface(Surface&& o) noexcept = default;
+    Surface& operator=(Surface&& o) noexcept = default;
+
+    /// Returns the pixels of a level of the scaled image, rows are stored from bottom to top
+    std::span<u8> Pixels(u32 level, u32 layer = 0) noexcept;
+
+    /// Returns the width of a level of the scaled image
+    [[nodiscard]] u32 LevelWidth(u32 level) const noexcept {
+        return std::max(GetScaledWidth() >> level, 1U);
+    }
+
+    /// Returns the height of a level of the scaled image
+    [[nodiscard]] u32 LevelHeight(u32 level) const noexcept {
+        return std::max(GetScaledHeight() >> level, 1U);
+    }
+
+    /// Uploads pixel data in staging to a rectangle region of the surface texture
+    void Upload(const VideoCore::BufferTextureCopy& upload, const VideoCore::StagingData& staging);
+
+    /// Uploads the custom material to the surface allocation.
+    void UploadCustom(const VideoCore::Material* material, u32 level);
+
+    /// Downloads pixel data to staging from a rectangle region of the surface texture
+    void Download(const VideoCore::BufferTextureCopy& download,
+                  const VideoCore::StagingData& staging);
+
+    /// Downloads pixel data to staging without waiting for it, returns the fence to wait on
+    u64 DownloadAsync(const VideoCore::BufferTextureCopy& download,
+                      const VideoCore::StagingData& staging);
+
+    /// Scales up the surface to match the new resolution scale.
+    void ScaleUp(u32 new_scale);
+
+    /// Returns the bpp of the internal surface format
+    u32 GetInternalBytesPerPixel() const;
+
+private:
+    /// Allocates the pixels of all levels and layers at the current resolution scale
+    void Allocate();
+
+    /// Copies a rectangle region of the surface texture to staging
+    void CopyToStaging(const VideoCore::BufferTextureCopy& download,
+                       const VideoCore::StagingData& staging);
+
+private:
+    TextureRuntime* runtime;
+    std::vector<u8> pixels;
+    std::vector<std::size_t> level_offsets;
+    std::size_t layer_size{};
+};
+
+class Framebuffer : public VideoCore::FramebufferParams {
+public:
+    explicit Framebuffer(TextureRuntime& runtime, const VideoCore::FramebufferParams& params,
+                         const Surface* color, const Surface* depth_stencil);
+    ~Framebuffer();
+
+    Framebuffer(const Framebuffer&) = delete;
+    Framebuffer& operator=(const Framebuffer&) = delete;
+
+    Framebuffer(Framebuffer&& o) noexcept = default;
+    Framebuffer& operator=(Framebuffer&& o) noexcept = default;
+
+    [[nodiscard]] u32 Scale() const noexcept {
+        return res_scale;
+    }
+
+private:
+    u32 res_scale{1};
+};
+
+class Sampler {
+public:
+    explicit Sampler(TextureRuntime&, VideoCore::SamplerParams params_) : params{params_} {}
+
+    [[nodiscard]] const VideoCore::SamplerParams& Params() const noexcept {
+        return params;
+    }
+
+private:
+    VideoCore::SamplerParams params;
+};
+
+class DebugScope {
+public:
+    template <typename... T>
+    explicit DebugScope(TextureRuntime&, Common::Vec4f, fmt::format_string<T...>, T...) {}
+    explicit DebugScope(TextureRuntime&, Common::Vec4f, std::string_view) {}
+};
+
+struct Traits {
+    using Runtime = SwRenderer::TextureRuntime;
+    using Sampler = SwRenderer::Sampler;
+    using Surface = SwRenderer::Surface;
+    using Framebuffer = SwRenderer::Framebuffer;
+    using DebugScope = SwRenderer::DebugScope;
+};
+
+using RasterizerCache = VideoCore::RasterizerCache<Traits>;
+
+} // namespace SwRenderer
@@ -14,15 +14,4 @@ namespace SwRenderer {
 
 int GetWrappedTexCoord(Pica::TexturingRegs::TextureConfig::WrapMode mode, s32 val, u32 size);
 
-Common::Vec3<u8> GetColorModifier(Pica::TexturingRegs::TevStageConfig::ColorModifier factor,
-                                  const Common::Vec4<u8>& values);
-
-u8 GetAlphaModifier(Pica::TexturingRegs::TevStageConfig::AlphaModifier factor,
-                    const Common::Vec4<u8>& values);
-
-Common::Vec3<u8> ColorCombine(Pica::TexturingRegs::TevStageConfig::Operation op,
-                              std::span<const Common::Vec3<u8>, 3> input);
-
-u8 AlphaCombine(Pica::TexturingRegs::TevStageConfig::Operation op, const std::array<u8, 3>& input);
-
 } // namespace SwRenderer
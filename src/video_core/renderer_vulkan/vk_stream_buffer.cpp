@@ -145,6 +145,22 @@ void StreamBuffer::Commit(u64 size) {
     watch.tick = scheduler.CurrentTick();
 }
 
+void StreamBuffer::Invalidate(u64 region_offset, u64 size) {
+    if (is_coherent) {
+        return;
+    }
+
+    const u64 atom_size = instance.NonCoherentAtomSize();
+    const u64 start = Common::AlignDown(region_offset, atom_size);
+    const u64 end = std::min(Common::AlignUp(region_offset + size, atom_size), stream_buffer_size);
+    const vk::MappedMemoryRange range = {
+        .memory = memory,
+        .offset = start,
+        .size = end - start,
+    };
+    device.invalidateMappedMemoryRanges(range);
+}
+
 void StreamBuffer::CreateBuffers(u64 prefered_size) {
     const vk::Device device = instance.GetDevice();
     const auto memory_properties = instance.GetPhysicalDevice().getMemoryProperties();
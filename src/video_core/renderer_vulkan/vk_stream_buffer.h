@@ -40,6 +40,9 @@ public:
     /// Ensures that "size" bytes of memory are available to the GPU, potentially recording a copy.
     void Commit(u64 size);
 
+    /// Makes GPU writes to a committed region visible to the host once they have completed.
+    void Invalidate(u64 region_offset, u64 size);
+
     vk::Buffer Handle() const noexcept {
         return buffer;
     }
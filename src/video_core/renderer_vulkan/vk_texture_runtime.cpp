@@ -259,6 +259,10 @@ TextureRuntime::TextureRuntime(const Instance& instance, Scheduler& scheduler,
                       vk::BufferUsageFlagBits::eTransferDst |
                           vk::BufferUsageFlagBits::eStorageBuffer,
                       DOWNLOAD_BUFFER_SIZE, BufferType::Download},
+      async_download_buffer{instance, scheduler,
+                            vk::BufferUsageFlagBits::eTransferDst |
+                                vk::BufferUsageFlagBits::eStorageBuffer,
+                            DOWNLOAD_BUFFER_SIZE, BufferType::Download},
       num_swapchain_images{num_swapchain_images_} {}
 
 TextureRuntime::~TextureRuntime() = default;
@@ -273,6 +277,25 @@ VideoCore::StagingData TextureRuntime::FindStaging(u32 size, bool upload) {
     };
 }
 
+VideoCore::StagingData TextureRuntime::FindDownloadStaging(u32 size) {
+    const auto [data, offset, invalidate] = async_download_buffer.Map(size, 16);
+    async_download_buffer.Commit(size);
+    return VideoCore::StagingData{
+        .size = size,
+        .offset = static_cast<u32>(offset),
+        .mapped = std::span{data, size},
+    };
+}
+
+u32 TextureRuntime::DownloadStagingSize() const {
+    return static_cast<u32>(DOWNLOAD_BUFFER_SIZE);
+}
+
+void TextureRuntime::WaitDownload(u64 fence, const VideoCore::StagingData& staging) {
+    scheduler.Wait(fence);
+    async_download_buffer.Invalidate(staging.offset, staging.size);
+}
+
 u32 TextureRuntime::RemoveThreshold() {
     return num_swapchain_images;
 }
@@ -979,11 +1002,20 @@ void Surface::Download(const VideoCore::BufferTextureCopy& download,
         scheduler->Finish();
         runtime->download_buffer.Commit(staging.size);
     });
+    DownloadToBuffer(download, runtime->download_buffer.Handle());
+}
 
+u64 Surface::DownloadAsync(const VideoCore::BufferTextureCopy& download,
+                           const VideoCore::StagingData& staging) {
+    DownloadToBuffer(download, runtime->async_download_buffer.Handle());
+    return scheduler->CurrentTick();
+}
+
+void Surface::DownloadToBuffer(const VideoCore::BufferTextureCopy& download, vk::Buffer buffer) {
     runtime->renderpass_cache.EndRendering();
 
     if (pixel_format == PixelFormat::D24S8) {
-        runtime->blit_helper.DepthToBuffer(*this, runtime->download_buffer.Handle(), download);
+        runtime->blit_helper.DepthToBuffer(*this, buffer, download);
         return;
     }
 
@@ -1005,58 +1037,57 @@ void Surface::Download(const VideoCore::BufferTextureCopy& download,
         .src_image = Image(0),
     };
 
-    scheduler->Record(
-        [buffer = runtime->download_buffer.Handle(), params, download](vk::CommandBuffer cmdbuf) {
-            const auto rect = download.texture_rect;
-            const vk::BufferImageCopy buffer_image_copy = {
-                .bufferOffset = download.buffer_offset,
-                .bufferRowLength = rect.GetWidth(),
-                .bufferImageHeight = rect.GetHeight(),
-                .imageSubresource{
-                    .aspectMask = params.aspect,
-                    .mipLevel = download.texture_level,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-                .imageOffset = {static_cast<s32>(rect.left), static_cast<s32>(rect.bottom), 0},
-                .imageExtent = {rect.GetWidth(), rect.GetHeight(), 1},
-            };
+    scheduler->Record([buffer, params, download](vk::CommandBuffer cmdbuf) {
+        const auto rect = download.texture_rect;
+        const vk::BufferImageCopy buffer_image_copy = {
+            .bufferOffset = download.buffer_offset,
+            .bufferRowLength = rect.GetWidth(),
+            .bufferImageHeight = rect.GetHeight(),
+            .imageSubresource{
+                .aspectMask = params.aspect,
+                .mipLevel = download.texture_level,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageOffset = {static_cast<s32>(rect.left), static_cast<s32>(rect.bottom), 0},
+            .imageExtent = {rect.GetWidth(), rect.GetHeight(), 1},
+        };
 
-            const vk::ImageMemoryBarrier read_barrier = {
-                .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
-                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
-                .oldLayout = vk::ImageLayout::eGeneral,
-                .newLayout = vk::ImageLayout::eTransferSrcOptimal,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = params.src_image,
-                .subresourceRange = MakeSubresourceRange(params.aspect, download.texture_level),
-            };
-            const vk::ImageMemoryBarrier image_write_barrier = {
-                .srcAccessMask = vk::AccessFlagBits::eNone,
-                .dstAccessMask = vk::AccessFlagBits::eMemoryWrite,
-                .oldLayout = vk::ImageLayout::eTransferSrcOptimal,
-                .newLayout = vk::ImageLayout::eGeneral,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = params.src_image,
-                .subresourceRange = MakeSubresourceRange(params.aspect, download.texture_level),
-            };
-            const vk::MemoryBarrier memory_write_barrier = {
-                .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
-                .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
-            };
+        const vk::ImageMemoryBarrier read_barrier = {
+            .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+            .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+            .oldLayout = vk::ImageLayout::eGeneral,
+            .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = params.src_image,
+            .subresourceRange = MakeSubresourceRange(params.aspect, download.texture_level),
+        };
+        const vk::ImageMemoryBarrier image_write_barrier = {
+            .srcAccessMask = vk::AccessFlagBits::eNone,
+            .dstAccessMask = vk::AccessFlagBits::eMemoryWrite,
+            .oldLayout = vk::ImageLayout::eTransferSrcOptimal,
+            .newLayout = vk::ImageLayout::eGeneral,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = params.src_image,
+            .subresourceRange = MakeSubresourceRange(params.aspect, download.texture_level),
+        };
+        const vk::MemoryBarrier memory_write_barrier = {
+            .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+            .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+        };
 
-            cmdbuf.pipelineBarrier(params.pipeline_flags, vk::PipelineStageFlagBits::eTransfer,
-                                   vk::DependencyFlagBits::eByRegion, {}, {}, read_barrier);
+        cmdbuf.pipelineBarrier(params.pipeline_flags, vk::PipelineStageFlagBits::eTransfer,
+                               vk::DependencyFlagBits::eByRegion, {}, {}, read_barrier);
 
-            cmdbuf.copyImageToBuffer(params.src_image, vk::ImageLayout::eTransferSrcOptimal, buffer,
-                                     buffer_image_copy);
+        cmdbuf.copyImageToBuffer(params.src_image, vk::ImageLayout::eTransferSrcOptimal, buffer,
+                                 buffer_image_copy);
 
-            cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, params.pipeline_flags,
-                                   vk::DependencyFlagBits::eByRegion, memory_write_barrier, {},
-                                   image_write_barrier);
-        });
+        cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, params.pipeline_flags,
+                               vk::DependencyFlagBits::eByRegion, memory_write_barrier, {},
+                               image_write_barrier);
+    });
 }
 
 void Surface::ScaleUp(u32 new_scale) {
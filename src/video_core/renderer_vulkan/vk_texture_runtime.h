@@ -67,6 +67,15 @@ public:
     /// Maps an internal staging buffer of the provided size for pixel uploads/downloads
     VideoCore::StagingData FindStaging(u32 size, bool upload);
 
+    /// Maps an internal staging buffer of the provided size for downloads that are read later
+    VideoCore::StagingData FindDownloadStaging(u32 size);
+
+    /// Returns the size of the staging buffer of asynchronous downloads, zero if not supported
+    u32 DownloadStagingSize() const;
+
+    /// Waits for an asynchronous download to staging to complete
+    void WaitDownload(u64 fence, const VideoCore::StagingData& staging);
+
     /// Attempts to reinterpret a rectangle of source to another rectangle of dest
     bool Reinterpret(Surface& source, Surface& dest, const VideoCore::TextureCopy& copy);
 
@@ -100,6 +109,7 @@ private:
     BlitHelper blit_helper;
     StreamBuffer upload_buffer;
     StreamBuffer download_buffer;
+    StreamBuffer async_download_buffer;
     u32 num_swapchain_images;
 };
 
@@ -156,6 +166,10 @@ public:
     void Download(const VideoCore::BufferTextureCopy& download,
                   const VideoCore::StagingData& staging);
 
+    /// Downloads pixel data to staging without waiting for it, returns the fence to wait on
+    u64 DownloadAsync(const VideoCore::BufferTextureCopy& download,
+                      const VideoCore::StagingData& staging);
+
     /// Scales up the surface to match the new resolution scale.
     void ScaleUp(u32 new_scale);
 
@@ -172,6 +186,9 @@ private:
     /// Performs blit between the scaled/unscaled images
     void BlitScale(const VideoCore::TextureBlit& blit, bool up_scale);
 
+    /// Records a copy of a rectangle region of the surface texture to the buffer
+    void DownloadToBuffer(const VideoCore::BufferTextureCopy& download, vk::Buffer buffer);
+
     /// Downloads scaled depth stencil data
     void DepthStencilDownload(const VideoCore::BufferTextureCopy& download,
                               const VideoCore::StagingData& staging);
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/arch.h"
+#include "video_core/pica/shader_unit.h"
 #include "video_core/shader/shader_interpreter.h"
 #if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
 #include "video_core/shader/shader_jit.h"
@@ -11,10 +12,20 @@
 
 namespace Pica {
 
-std::unique_ptr<ShaderEngine> CreateEngine(bool use_jit) {
+void ShaderEngine::RunBatch(const ShaderSetup& setup, const ShaderRegs& config, ShaderUnit& state,
+                            std::span<const AttributeBuffer> inputs,
+                            std::span<AttributeBuffer> outputs) const {
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        state.LoadInput(config, inputs[i]);
+        Run(setup, state);
+        state.WriteOutput(config, outputs[i]);
+    }
+}
+
+std::unique_ptr<ShaderEngine> CreateEngine(bool use_jit, u64 program_id) {
 #if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
     if (use_jit) {
-        return std::make_unique<Shader::JitEngine>();
+        return std::make_unique<Shader::JitEngine>(program_id);
     }
 #endif
 
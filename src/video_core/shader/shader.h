@@ -5,10 +5,13 @@
 #pragma once
 
 #include <memory>
+#include <span>
 #include "common/common_types.h"
+#include "video_core/pica/output_vertex.h"
 
 namespace Pica {
 
+struct ShaderRegs;
 struct ShaderSetup;
 struct ShaderUnit;
 
@@ -29,8 +32,27 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, ShaderUnit& state) const = 0;
+
+    /**
+     * Runs the currently setup shader on a batch of vertices. Engines that can process several
+     * vertices at once override this, by default the vertices are run one after another.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param config Shader configuration, used to map the attributes to the shader registers.
+     * @param state Shader unit state, carried from one vertex to the next as if they ran in order.
+     * @param inputs Input attributes of each vertex.
+     * @param outputs Receives the output attributes of each vertex, same size as `inputs`.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, const ShaderRegs& config, ShaderUnit& state,
+                          std::span<const AttributeBuffer> inputs,
+                          std::span<AttributeBuffer> outputs) const;
 };
 
-std::unique_ptr<ShaderEngine> CreateEngine(bool use_jit);
+/**
+ * Creates the shader engine of the PICA.
+ * @param program_id Program id of the running title, which names the on-disk cache of the JIT.
+ * Zero disables the on-disk cache.
+ */
+std::unique_ptr<ShaderEngine> CreateEngine(bool use_jit, u64 program_id);
 
 } // namespace Pica
@@ -0,0 +1,395 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <nihstro/shader_bytecode.h>
+#include "video_core/shader/shader_analysis.h"
+
+namespace Pica::Shader {
+
+using nihstro::DestRegister;
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::RegisterType;
+using nihstro::SourceRegister;
+using nihstro::SwizzlePattern;
+
+namespace {
+
+constexpr u32 MAX_SCOPE_DEPTH = 32;
+constexpr u32 MAX_SCANNED_INSTRUCTIONS = 1 << 16;
+
+constexpr u8 ADDRESS_X = 1 << 0;
+constexpr u8 ADDRESS_Y = 1 << 1;
+constexpr u8 LOOP_COUNTER = 1 << 2;
+constexpr u8 CONDITION_X = 1 << 3;
+constexpr u8 CONDITION_Y = 1 << 4;
+
+/// Written register components, four bits per temporary and output register.
+struct RegisterMask {
+    u64 temporaries{};
+    u64 outputs{};
+    u8 misc{};
+
+    RegisterMask operator&(const RegisterMask& other) const {
+        return {temporaries & other.temporaries, outputs & other.outputs, u8(misc & other.misc)};
+    }
+
+    RegisterMask operator|(const RegisterMask& other) const {
+        return {temporaries | other.temporaries, outputs | other.outputs, u8(misc | other.misc)};
+    }
+};
+
+/// State of the code paths reaching an instruction.
+struct PathState {
+    RegisterMask must_write{}; ///< Components written on every path
+    RegisterMask may_write{};  ///< Components written on at least one path
+    bool live = true;          ///< False once every path has reached END
+
+    void Write(const RegisterMask& mask) {
+        must_write = must_write | mask;
+        may_write = may_write | mask;
+    }
+
+    /// Joins the paths of two branches that continue at the same instruction.
+    static PathState Merge(const PathState& a, const PathState& b) {
+        if (!a.live) {
+            return b;
+        }
+        if (!b.live) {
+            return a;
+        }
+        return {a.must_write & b.must_write, a.may_write | b.may_write, true};
+    }
+};
+
+class IsolationAnalyzer {
+public:
+    IsolationAnalyzer(const ProgramCode& program_code, const SwizzleData& swizzle_data)
+        : program_code{program_code}, swizzle_data{swizzle_data} {}
+
+    std::optional<u16> Analyze(u32 entry_point) {
+        PathState path{};
+        if (!Scan(entry_point, MAX_PROGRAM_CODE_LENGTH, path, 0) || path.live || !reached_end) {
+            return std::nullopt;
+        }
+        // State written on some paths only would make the unit state after a vertex depend on
+        // which vertex wrote it last.
+        const RegisterMask& must = end_state.must_write;
+        const RegisterMask& may = end_state.may_write;
+        if (must.temporaries != may.temporaries || must.misc != may.misc) {
+            return std::nullopt;
+        }
+        u16 outputs_written{};
+        for (u32 reg = 0; reg < 16; ++reg) {
+            if (((must.outputs >> (reg * 4)) & 0xF) == 0xF) {
+                outputs_written |= 1 << reg;
+            }
+        }
+        return outputs_written;
+    }
+
+private:
+    /// Follows the instructions in [begin, end), returns false if the program is not isolated.
+    bool Scan(u32 begin, u32 end, PathState& path, u32 depth) {
+        if (depth > MAX_SCOPE_DEPTH || begin >= end || end > MAX_PROGRAM_CODE_LENGTH) {
+            return false;
+        }
+        u32 offset = begin;
+        while (offset != end && path.live) {
+            if (++scanned_instructions > MAX_SCANNED_INSTRUCTIONS) {
+                return false;
+            }
+            const Instruction instr = {program_code[offset]};
+            switch (instr.opcode.Value().GetInfo().type) {
+            case OpCode::Type::Arithmetic:
+                if (!ScanArithmetic(instr, path)) {
+                    return false;
+                }
+                ++offset;
+                break;
+            case OpCode::Type::MultiplyAdd:
+                if (!ScanMultiplyAdd(instr, path)) {
+                    return false;
+                }
+                ++offset;
+                break;
+            default:
+                if (!ScanFlowControl(instr, offset, end, path, depth)) {
+                    return false;
+                }
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool ScanFlowControl(Instruction instr, u32& offset, u32 end, PathState& path, u32 depth) {
+        const auto& flow_control = instr.flow_control;
+        const u32 dest_offset = flow_control.dest_offset;
+        const u32 block_end = dest_offset + flow_control.num_instructions;
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::NOP:
+            break;
+
+        case OpCode::Id::END:
+            end_state = reached_end ? PathState::Merge(end_state, path) : path;
+            reached_end = true;
+            path.live = false;
+            return true;
+
+        case OpCode::Id::CALL:
+            if (!Scan(dest_offset, block_end, path, depth + 1)) {
+                return false;
+            }
+            break;
+
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU: {
+            if (instr.opcode.Value() == OpCode::Id::CALLC && !ReadCondition(instr, path)) {
+                return false;
+            }
+            PathState called = path;
+            if (!Scan(dest_offset, block_end, called, depth + 1)) {
+                return false;
+            }
+            path = PathState::Merge(path, called);
+            break;
+        }
+
+        case OpCode::Id::IFC:
+        case OpCode::Id::IFU: {
+            if (instr.opcode.Value() == OpCode::Id::IFC && !ReadCondition(instr, path)) {
+                return false;
+            }
+            if (dest_offset <= offset || block_end > end) {
+                return false;
+            }
+            PathState if_path = path;
+            if (dest_offset != offset + 1 && !Scan(offset + 1, dest_offset, if_path, depth + 1)) {
+                return false;
+            }
+            PathState else_path = path;
+            if (flow_control.num_instructions != 0 &&
+                !Scan(dest_offset, block_end, else_path, depth + 1)) {
+                return false;
+            }
+            path = PathState::Merge(if_path, else_path);
+            offset = block_end;
+            return true;
+        }
+
+        case OpCode::Id::LOOP: {
+            if (dest_offset < offset || dest_offset + 1 > end) {
+                return false;
+            }
+            // The body runs at least once, later iterations only see more written state.
+            path.Write({.misc = LOOP_COUNTER});
+            PathState body = path;
+            const u32 breaks_before = breaks;
+            if (!Scan(offset + 1, dest_offset + 1, body, depth + 1)) {
+                return false;
+            }
+            path = breaks != breaks_before ? PathState::Merge(path, body) : body;
+            offset = dest_offset + 1;
+            return true;
+        }
+
+        case OpCode::Id::BREAKC:
+            if (!ReadCondition(instr, path)) {
+                return false;
+            }
+            [[fallthrough]];
+        case OpCode::Id::BREAK:
+            ++breaks;
+            break;
+
+        default:
+            // JMPC/JMPU may form arbitrary loops and EMIT/SETEMIT are geometry shader only.
+            return false;
+        }
+
+        ++offset;
+        return true;
+    }
+
+    bool ScanArithmetic(Instruction instr, PathState& path) const {
+        const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+        const bool is_inverted =
+            (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+        const u32 dest_lanes = GetDestLanes(swizzle);
+
+        u32 src1_lanes = dest_lanes;
+        u32 src2_lanes = 0;
+        switch (opcode) {
+        case OpCode::Id::ADD:
+        case OpCode::Id::MUL:
+        case OpCode::Id::MAX:
+        case OpCode::Id::MIN:
+        case OpCode::Id::SGE:
+        case OpCode::Id::SGEI:
+        case OpCode::Id::SLT:
+        case OpCode::Id::SLTI:
+            src2_lanes = dest_lanes;
+            break;
+        case OpCode::Id::FLR:
+        case OpCode::Id::MOV:
+            break;
+        case OpCode::Id::DP3:
+            src1_lanes = src2_lanes = 0x7;
+            break;
+        case OpCode::Id::DP4:
+            src1_lanes = src2_lanes = 0xF;
+            break;
+        case OpCode::Id::DPH:
+        case OpCode::Id::DPHI:
+            src1_lanes = 0x7;
+            src2_lanes = 0xF;
+            break;
+        case OpCode::Id::RCP:
+        case OpCode::Id::RSQ:
+        case OpCode::Id::EX2:
+        case OpCode::Id::LG2:
+            src1_lanes = 0x1;
+            break;
+        case OpCode::Id::MOVA:
+            src1_lanes = dest_lanes & 0x3;
+            break;
+        case OpCode::Id::CMP:
+            src1_lanes = src2_lanes = 0x3;
+            break;
+        default:
+            return false;
+        }
+
+        const u32 address_index = instr.common.address_register_index;
+        if (!ReadSource(path, instr.common.GetSrc1(is_inverted),
+                        GetComponents(swizzle, 1, src1_lanes), !is_inverted * address_index) ||
+            !ReadSource(path, instr.common.GetSrc2(is_inverted),
+                        GetComponents(swizzle, 2, src2_lanes), is_inverted * address_index)) {
+            return false;
+        }
+
+        if (opcode == OpCode::Id::MOVA) {
+            path.Write({.misc = u8(dest_lanes & (ADDRESS_X | ADDRESS_Y))});
+        } else if (opcode == OpCode::Id::CMP) {
+            path.Write({.misc = CONDITION_X | CONDITION_Y});
+        } else {
+            WriteDest(path, instr.common.dest.Value(), dest_lanes);
+        }
+        return true;
+    }
+
+    bool ScanMultiplyAdd(Instruction instr, PathState& path) const {
+        const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+        if (opcode != OpCode::Id::MAD && opcode != OpCode::Id::MADI) {
+            return false;
+        }
+        const bool is_inverted = opcode == OpCode::Id::MADI;
+        const SwizzlePattern swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+        const u32 lanes = GetDestLanes(swizzle);
+        const u32 address_index = instr.mad.address_register_index;
+
+        if (!ReadSource(path, instr.mad.GetSrc1(is_inverted), GetComponents(swizzle, 1, lanes),
+                        0) ||
+            !ReadSource(path, instr.mad.GetSrc2(is_inverted), GetComponents(swizzle, 2, lanes),
+                        !is_inverted * address_index) ||
+            !ReadSource(path, instr.mad.GetSrc3(is_inverted), GetComponents(swizzle, 3, lanes),
+                        is_inverted * address_index)) {
+            return false;
+        }
+        WriteDest(path, instr.mad.dest.Value(), lanes);
+        return true;
+    }
+
+    static u32 GetDestLanes(const SwizzlePattern& swizzle) {
+        u32 lanes = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (swizzle.DestComponentEnabled(i)) {
+                lanes |= 1 << i;
+            }
+        }
+        return lanes;
+    }
+
+    /// Maps the lanes an instruction computes to the source components its swizzle selects.
+    static u32 GetComponents(const SwizzlePattern& swizzle, u32 source, u32 lanes) {
+        u32 components = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (!(lanes & (1 << i))) {
+                continue;
+            }
+            const auto selector = source == 1   ? swizzle.GetSelectorSrc1(i)
+                                  : source == 2 ? swizzle.GetSelectorSrc2(i)
+                                                : swizzle.GetSelectorSrc3(i);
+            components |= 1 << static_cast<u32>(selector);
+        }
+        return components;
+    }
+
+    static bool ReadSource(const PathState& path, const SourceRegister& source,
+                           u32 components, u32 address_index) {
+        switch (source.GetRegisterType()) {
+        case RegisterType::Temporary: {
+            const u64 mask = u64{components} << (source.GetIndex() * 4);
+            return (path.must_write.temporaries & mask) == mask;
+        }
+        case RegisterType::FloatUniform: {
+            // Relative addressing reads a0.x, a0.y or aL.
+            if (address_index == 0 || components == 0) {
+                return true;
+            }
+            const u8 address_bit = 1 << (address_index - 1);
+            return (path.must_write.misc & address_bit) != 0;
+        }
+        default:
+            // Inputs are either loaded for every vertex or left as they were before the batch.
+            return true;
+        }
+    }
+
+    static bool ReadCondition(Instruction instr, const PathState& path) {
+        using Op = Instruction::FlowControlType::Op;
+
+        u8 mask{};
+        switch (instr.flow_control.op) {
+        case Op::JustX:
+            mask = CONDITION_X;
+            break;
+        case Op::JustY:
+            mask = CONDITION_Y;
+            break;
+        default:
+            mask = CONDITION_X | CONDITION_Y;
+            break;
+        }
+        return (path.must_write.misc & mask) == mask;
+    }
+
+    static void WriteDest(PathState& path, const DestRegister& dest, u32 lanes) {
+        if (dest < 0x10) {
+            path.Write({.outputs = u64{lanes} << (dest.GetIndex() * 4)});
+        } else if (dest < 0x20) {
+            path.Write({.temporaries = u64{lanes} << (dest.GetIndex() * 4)});
+        }
+    }
+
+    const ProgramCode& program_code;
+    const SwizzleData& swizzle_data;
+    PathState end_state{};
+    bool reached_end{};
+    u32 breaks{};
+    u32 scanned_instructions{};
+};
+
+} // Anonymous namespace
+
+std::optional<u16> AnalyzeIsolation(const ProgramCode& program_code,
+                                    const SwizzleData& swizzle_data, u32 entry_point) {
+    IsolationAnalyzer analyzer{program_code, swizzle_data};
+    return analyzer.Analyze(entry_point);
+}
+
+} // namespace Pica::Shader
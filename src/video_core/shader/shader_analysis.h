@@ -0,0 +1,26 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <optional>
+#include "common/common_types.h"
+#include "video_core/pica/shader_setup.h"
+
+namespace Pica::Shader {
+
+/**
+ * Checks whether every invocation of a shader program only depends on its own inputs.
+ * An invocation is isolated when, on every path from the entry point to END, it writes each
+ * temporary component, address register and condition code before reading it, and every path
+ * leaves the same set of them written. Such a program gives the same outputs no matter which
+ * vertex ran before it on the shader unit, and the unit state after a vertex only depends on
+ * that vertex and the state before the first one.
+ * @return Mask of the output registers written completely on every path, or std::nullopt if the
+ * program is not isolated or its control flow can not be followed (JMPC/JMPU, EMIT, recursion).
+ */
+std::optional<u16> AnalyzeIsolation(const ProgramCode& program_code,
+                                    const SwizzleData& swizzle_data, u32 entry_point);
+
+} // namespace Pica::Shader
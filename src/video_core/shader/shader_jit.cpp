@@ -5,23 +5,146 @@
 #include "common/arch.h"
 #if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
 
+#include <algorithm>
+#include <atomic>
 #include "common/assert.h"
 #include "common/hash.h"
 #include "common/microprofile.h"
+#include "common/settings.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit.h"
+#include "video_core/shader/shader_jit_disk_cache.h"
 #if CITRA_ARCH(arm64)
 #include "video_core/shader/shader_jit_a64_compiler.h"
 #endif
 #if CITRA_ARCH(x86_64)
 #include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/shader/shader_jit_x64_soa_compiler.h"
 #endif
 
 namespace Pica::Shader {
 
-JitEngine::JitEngine() = default;
+/**
+ * Maximum number of compiled programs kept in the cache, the least recently used ones are freed
+ * once it is exceeded. This must be at least two, so that the programs of the vertex and geometry
+ * shader of the current draw are never freed while they are in use.
+ */
+constexpr std::size_t MAX_CACHED_PROGRAMS = 256;
+static_assert(MAX_CACHED_PROGRAMS >= 2);
+
+/// Maximum number of programs from the disk cache that are compiled ahead of their first use
+constexpr std::size_t MAX_PRECOMPILED_PROGRAMS = 64;
+static_assert(MAX_PRECOMPILED_PROGRAMS <= MAX_CACHED_PROGRAMS);
+
+struct JitEngine::CacheEntry {
+    /// Compiles the program, or waits for the thread that already started to compile it
+    void Compile(const ProgramCode& program_code, const SwizzleData& swizzle_data) {
+        if (!TryCompile(program_code, swizzle_data)) {
+            ready.wait(false, std::memory_order_acquire);
+        }
+    }
+
+    /// Compiles the program unless another thread already started to, returns false if so
+    bool TryCompile(const ProgramCode& program_code, const SwizzleData& swizzle_data) {
+        if (compile_started.exchange(true, std::memory_order_acq_rel)) {
+            return false;
+        }
+        shader = std::make_unique<JitShader>();
+        shader->Compile(&program_code, &swizzle_data);
+#if CITRA_ARCH(x86_64)
+        if (JitShaderSoA::IsSupported()) {
+            batch_shader = std::make_unique<JitShaderSoA>();
+            batch_shader->Compile(&program_code, &swizzle_data);
+        }
+#endif
+        ready.store(true, std::memory_order_release);
+        ready.notify_all();
+        return true;
+    }
+
+    std::unique_ptr<JitShader> shader;
+#if CITRA_ARCH(x86_64)
+    std::unique_ptr<JitShaderSoA> batch_shader;
+#endif
+    /// Set once the shaders have been compiled, they must not be accessed before
+    std::atomic<bool> ready{false};
+    std::atomic<bool> compile_started{false};
+    std::list<u64>::iterator lru_position;
+};
+
+JitEngine::JitEngine(u64 program_id)
+    : async_compile{Settings::values.async_shader_jit.GetValue()} {
+    // Skip games without title id
+    if (Settings::values.use_disk_shader_cache && program_id != 0) {
+        disk_cache = std::make_unique<JitDiskCache>(program_id);
+    }
+    auto stored_programs = disk_cache ? disk_cache->Load() : std::vector<JitDiskCache::Entry>{};
+
+    if (async_compile || !stored_programs.empty()) {
+        compile_worker = std::make_unique<Common::ThreadWorker>(1, "ShaderJIT");
+    }
+
+    // Only the most recently stored programs are compiled ahead of time, in the background so
+    // that they don't hold up the boot. A program that is needed before the worker got to it is
+    // compiled on first use as usual.
+    const std::size_t first =
+        stored_programs.size() - std::min(stored_programs.size(), MAX_PRECOMPILED_PROGRAMS);
+    for (std::size_t i = first; i < stored_programs.size(); ++i) {
+        auto& program = stored_programs[i];
+        auto entry = std::make_shared<CacheEntry>();
+        lru_list.push_front(program.cache_key);
+        entry->lru_position = lru_list.begin();
+        cache.emplace(program.cache_key, entry);
+        compile_worker->QueueWork([entry, program = std::move(program)] {
+            entry->TryCompile(program.program_code, program.swizzle_data);
+        });
+    }
+}
+
 JitEngine::~JitEngine() = default;
 
+const JitEngine::CacheEntry& JitEngine::GetCacheEntry(const ShaderSetup& setup, u64 cache_key) {
+    auto iter = cache.find(cache_key);
+    if (iter != cache.end()) {
+        CacheEntry& entry = *iter->second;
+        lru_list.splice(lru_list.begin(), lru_list, entry.lru_position);
+        if (!async_compile && !entry.ready.load(std::memory_order_acquire)) {
+            // Precompiled from the disk cache, but not yet done
+            entry.Compile(setup.program_code, setup.swizzle_data);
+        }
+        return entry;
+    }
+
+    if (disk_cache) {
+        disk_cache->Save(cache_key, setup.program_code, setup.swizzle_data);
+    }
+    return CreateCacheEntry(cache_key, setup.program_code, setup.swizzle_data);
+}
+
+const JitEngine::CacheEntry& JitEngine::CreateCacheEntry(u64 cache_key,
+                                                         const ProgramCode& program_code,
+                                                         const SwizzleData& swizzle_data) {
+    if (cache.size() >= MAX_CACHED_PROGRAMS) {
+        // Programs that are still being compiled are kept alive by their compile job.
+        cache.erase(lru_list.back());
+        lru_list.pop_back();
+    }
+
+    auto entry = std::make_shared<CacheEntry>();
+    lru_list.push_front(cache_key);
+    entry->lru_position = lru_list.begin();
+    cache.emplace(cache_key, entry);
+
+    if (async_compile) {
+        // The program may be overwritten while it is compiled, so the job works on a copy.
+        compile_worker->QueueWork(
+            [entry, program_code, swizzle_data] { entry->Compile(program_code, swizzle_data); });
+    } else {
+        entry->Compile(program_code, swizzle_data);
+    }
+    return *entry;
+}
+
 void JitEngine::SetupBatch(ShaderSetup& setup, u32 entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.entry_point = entry_point;
@@ -30,21 +153,30 @@ void JitEngine::SetupBatch(ShaderSetup& setup, u32 entry_point) {
     const u64 swizzle_hash = setup.GetSwizzleDataHash();
 
     const u64 cache_key = Common::HashCombine(code_hash, swizzle_hash);
-    auto iter = cache.find(cache_key);
-    if (iter != cache.end()) {
-        setup.cached_shader = iter->second.get();
-    } else {
-        auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
-        setup.cached_shader = shader.get();
-        cache.emplace_hint(iter, cache_key, std::move(shader));
+    const CacheEntry& entry = GetCacheEntry(setup, cache_key);
+
+    // Programs that are still being compiled run with the interpreter. The compiled code is picked
+    // up by the first batch set up after it is ready.
+    setup.cached_shader = nullptr;
+    setup.cached_batch_shader = nullptr;
+    if (entry.ready.load(std::memory_order_acquire)) {
+        setup.cached_shader = entry.shader.get();
+#if CITRA_ARCH(x86_64)
+        setup.cached_batch_shader = entry.batch_shader.get();
+#endif
     }
+
+    // Lanes of the batch shader can only run side by side if the program is isolated.
+    setup.AnalyzeProgram();
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
 
 void JitEngine::Run(const ShaderSetup& setup, ShaderUnit& state) const {
-    ASSERT(setup.cached_shader != nullptr);
+    if (setup.cached_shader == nullptr) {
+        interpreter.Run(setup, state);
+        return;
+    }
 
     MICROPROFILE_SCOPE(GPU_Shader);
 
@@ -52,6 +184,32 @@ void JitEngine::Run(const ShaderSetup& setup, ShaderUnit& state) const {
     shader->Run(setup, state, setup.entry_point);
 }
 
+void JitEngine::RunBatch(const ShaderSetup& setup, const ShaderRegs& config, ShaderUnit& state,
+                         std::span<const AttributeBuffer> inputs,
+                         std::span<AttributeBuffer> outputs) const {
+#if CITRA_ARCH(x86_64)
+    if (setup.cached_batch_shader != nullptr && setup.IsIsolated(config)) {
+        MICROPROFILE_SCOPE(GPU_Shader);
+
+        const JitShaderSoA* shader = static_cast<const JitShaderSoA*>(setup.cached_batch_shader);
+        // Scratch state of the compiled code, Run seeds it from the shader unit for each batch
+        thread_local ShaderUnitSoA soa_state;
+
+        for (std::size_t i = 0; i < inputs.size(); i += SOA_LANES) {
+            const std::size_t count = std::min(SOA_LANES, inputs.size() - i);
+            const auto batch_inputs = inputs.subspan(i, count);
+            const auto batch_outputs = outputs.subspan(i, count);
+            if (!shader->Run(setup, config, soa_state, state, batch_inputs, batch_outputs)) {
+                ShaderEngine::RunBatch(setup, config, state, batch_inputs, batch_outputs);
+            }
+        }
+        return;
+    }
+#endif
+
+    ShaderEngine::RunBatch(setup, config, state, inputs, outputs);
+}
+
 } // namespace Pica::Shader
 
 #endif // CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
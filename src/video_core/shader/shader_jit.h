@@ -7,25 +7,53 @@
 #include "common/arch.h"
 #if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
 
+#include <list>
 #include <memory>
 #include <unordered_map>
 #include "common/common_types.h"
+#include "common/thread_worker.h"
+#include "video_core/pica/shader_setup.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
 
 namespace Pica::Shader {
 
+class JitDiskCache;
 class JitShader;
+class JitShaderSoA;
 
 class JitEngine final : public ShaderEngine {
 public:
-    JitEngine();
+    explicit JitEngine(u64 program_id);
     ~JitEngine() override;
 
     void SetupBatch(ShaderSetup& setup, u32 entry_point) override;
     void Run(const ShaderSetup& setup, ShaderUnit& state) const override;
+    void RunBatch(const ShaderSetup& setup, const ShaderRegs& config, ShaderUnit& state,
+                  std::span<const AttributeBuffer> inputs,
+                  std::span<AttributeBuffer> outputs) const override;
 
 private:
-    std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+    struct CacheEntry;
+
+    /// Returns the cache entry of the program, compiling it if it is not cached yet
+    const CacheEntry& GetCacheEntry(const ShaderSetup& setup, u64 cache_key);
+
+    /// Adds a program to the cache and compiles it, evicting the least recently used program
+    const CacheEntry& CreateCacheEntry(u64 cache_key, const ProgramCode& program_code,
+                                       const SwizzleData& swizzle_data);
+
+    /// Whether programs are compiled in the background, running them with the interpreter until
+    /// the compiled code is ready
+    bool async_compile;
+    InterpreterEngine interpreter;
+
+    std::unordered_map<u64, std::shared_ptr<CacheEntry>> cache;
+    /// Cache keys ordered from the most to the least recently used
+    std::list<u64> lru_list;
+    std::unique_ptr<Common::ThreadWorker> compile_worker;
+    /// Programs of the running title, the most recent ones are compiled in the background at boot
+    std::unique_ptr<JitDiskCache> disk_cache;
 };
 
 } // namespace Pica::Shader
@@ -0,0 +1,162 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "video_core/shader/shader_jit_disk_cache.h"
+
+namespace Pica::Shader {
+
+namespace {
+
+/// Version of the file format, files with a different version are discarded
+constexpr u32 NativeVersion = 1;
+
+/// Size of a stored program once it is decompressed
+constexpr std::size_t PROGRAM_DATA_SIZE = sizeof(ProgramCode) + sizeof(SwizzleData);
+
+u64 ComputeCacheKey(const ProgramCode& program_code, const SwizzleData& swizzle_data) {
+    return Common::HashCombine(Common::ComputeHash64(&program_code, sizeof(program_code)),
+                               Common::ComputeHash64(&swizzle_data, sizeof(swizzle_data)));
+}
+
+} // Anonymous namespace
+
+JitDiskCache::JitDiskCache(u64 program_id) : program_id{program_id} {
+    const std::string shader_dir = FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir);
+    const std::string base_dir = shader_dir + DIR_SEP "jit";
+    if (!FileUtil::CreateDir(shader_dir) || !FileUtil::CreateDir(base_dir)) {
+        LOG_ERROR(HW_GPU, "Failed to create directory={}", base_dir);
+        return;
+    }
+    path = FileUtil::SanitizePath(fmt::format("{}" DIR_SEP "{:016X}.bin", base_dir, program_id));
+    file = OpenFile();
+}
+
+JitDiskCache::~JitDiskCache() = default;
+
+std::vector<JitDiskCache::Entry> JitDiskCache::Load() {
+    if (!file.IsOpen() || file.GetSize() <= sizeof(NativeVersion)) {
+        LOG_INFO(HW_GPU, "No shader JIT cache found for game with title id={:016X}", program_id);
+        return {};
+    }
+
+    // Writes always go to the end of the file, reading starts from the beginning.
+    u32 version{};
+    if (!file.Seek(0, SEEK_SET) || file.ReadBytes(&version, sizeof(version)) != sizeof(version)) {
+        LOG_ERROR(HW_GPU, "Failed to get shader JIT cache version - removing");
+        Invalidate();
+        return {};
+    }
+    if (version < NativeVersion) {
+        LOG_INFO(HW_GPU, "Shader JIT cache is old - removing");
+        Invalidate();
+        return {};
+    }
+    if (version > NativeVersion) {
+        LOG_WARNING(HW_GPU, "Shader JIT cache was generated with a newer version of the emulator "
+                            "- skipping");
+        file.Close();
+        return {};
+    }
+
+    std::vector<Entry> entries;
+    std::vector<u8> compressed;
+    while (file.Tell() < file.GetSize()) {
+        u64 cache_key{};
+        u32 size{};
+        if (file.ReadBytes(&cache_key, sizeof(cache_key)) != sizeof(cache_key) ||
+            file.ReadBytes(&size, sizeof(size)) != sizeof(size)) {
+            LOG_ERROR(HW_GPU, "Failed to read shader JIT cache - removing");
+            Invalidate();
+            return {};
+        }
+
+        compressed.resize(size);
+        if (file.ReadBytes(compressed.data(), size) != size) {
+            LOG_ERROR(HW_GPU, "Failed to read shader JIT cache entry - removing");
+            Invalidate();
+            return {};
+        }
+
+        const std::vector<u8> data = Common::Compression::DecompressDataZSTD(compressed);
+        if (data.size() != PROGRAM_DATA_SIZE) {
+            LOG_ERROR(HW_GPU, "Invalid shader JIT cache entry - removing");
+            Invalidate();
+            return {};
+        }
+
+        Entry& entry = entries.emplace_back();
+        entry.cache_key = cache_key;
+        std::memcpy(entry.program_code.data(), data.data(), sizeof(ProgramCode));
+        std::memcpy(entry.swizzle_data.data(), data.data() + sizeof(ProgramCode),
+                    sizeof(SwizzleData));
+        if (ComputeCacheKey(entry.program_code, entry.swizzle_data) != cache_key) {
+            LOG_ERROR(HW_GPU, "Shader JIT cache entry does not match its key - removing");
+            Invalidate();
+            return {};
+        }
+
+        // Two sessions of the same title may both have appended a program, keep it only once
+        if (!stored_keys.insert(cache_key).second) {
+            entries.pop_back();
+        }
+    }
+
+    LOG_INFO(HW_GPU, "Found a shader JIT cache with {} entries", entries.size());
+    return entries;
+}
+
+void JitDiskCache::Save(u64 cache_key, const ProgramCode& program_code,
+                        const SwizzleData& swizzle_data) {
+    if (!file.IsOpen() || !stored_keys.insert(cache_key).second) {
+        return;
+    }
+
+    std::array<u8, PROGRAM_DATA_SIZE> data;
+    std::memcpy(data.data(), program_code.data(), sizeof(ProgramCode));
+    std::memcpy(data.data() + sizeof(ProgramCode), swizzle_data.data(), sizeof(SwizzleData));
+    const std::vector<u8> compressed = Common::Compression::CompressDataZSTDDefault(data);
+
+    const u32 size = static_cast<u32>(compressed.size());
+    if (file.WriteObject(cache_key) != 1 || file.WriteObject(size) != 1 ||
+        file.WriteBytes(compressed.data(), size) != size) {
+        LOG_ERROR(HW_GPU, "Failed to write shader JIT cache entry in path={}", path);
+        return;
+    }
+    file.Flush();
+}
+
+FileUtil::IOFile JitDiskCache::OpenFile() const {
+    const bool existed = FileUtil::Exists(path);
+
+    FileUtil::IOFile new_file(path, "ab+");
+    if (!new_file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Failed to open shader JIT cache in path={}", path);
+        return {};
+    }
+    if (!existed || new_file.GetSize() == 0) {
+        // If the file didn't exist, write its version
+        if (new_file.WriteObject(NativeVersion) != 1) {
+            LOG_ERROR(HW_GPU, "Failed to write shader JIT cache version in path={}", path);
+            return {};
+        }
+    }
+    return new_file;
+}
+
+void JitDiskCache::Invalidate() {
+    file.Close();
+    stored_keys.clear();
+    if (!FileUtil::Delete(path)) {
+        LOG_ERROR(HW_GPU, "Failed to invalidate shader JIT cache file={}", path);
+    }
+    file = OpenFile();
+}
+
+} // namespace Pica::Shader
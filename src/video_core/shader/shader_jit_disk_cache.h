@@ -0,0 +1,51 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "video_core/pica/shader_setup.h"
+
+namespace Pica::Shader {
+
+/**
+ * Per-title record of the programs compiled by the shader JIT. The compiled code refers to host
+ * addresses that differ between sessions, so the programs themselves are stored instead and
+ * compiled again when the title boots, before they are first used.
+ */
+class JitDiskCache {
+public:
+    struct Entry {
+        u64 cache_key;
+        ProgramCode program_code;
+        SwizzleData swizzle_data;
+    };
+
+    explicit JitDiskCache(u64 program_id);
+    ~JitDiskCache();
+
+    /// Returns the programs stored for the title. An invalid cache file is removed.
+    std::vector<Entry> Load();
+
+    /// Stores a program, unless it is already stored
+    void Save(u64 cache_key, const ProgramCode& program_code, const SwizzleData& swizzle_data);
+
+private:
+    /// Opens the cache file for appending, writing the version if the file is new
+    FileUtil::IOFile OpenFile() const;
+
+    /// Removes the cache file and starts a new one
+    void Invalidate();
+
+    u64 program_id;
+    std::string path;
+    FileUtil::IOFile file;
+    std::unordered_set<u64> stored_keys;
+};
+
+} // namespace Pica::Shader
@@ -0,0 +1,1253 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/arch.h"
+#if CITRA_ARCH(x86_64)
+
+#include <algorithm>
+#include <nihstro/shader_bytecode.h>
+#include <smmintrin.h>
+#include <xbyak/xbyak_util.h>
+#include "common/assert.h"
+#include "common/bit_set.h"
+#include "common/logging/log.h"
+#include "common/x64/xbyak_abi.h"
+#include "common/x64/xbyak_util.h"
+#include "video_core/pica/regs_shader.h"
+#include "video_core/pica/shader_unit.h"
+#include "video_core/shader/shader_jit_x64_soa_compiler.h"
+
+using namespace Common::X64;
+using namespace Xbyak::util;
+using Xbyak::Label;
+using Xbyak::Reg32;
+using Xbyak::Reg64;
+using Xbyak::Xmm;
+using Xbyak::Ymm;
+
+using nihstro::DestRegister;
+using nihstro::RegisterType;
+
+static const Xbyak::util::Cpu host_caps;
+
+namespace Pica::Shader {
+
+typedef void (JitShaderSoA::*JitFunction)(Instruction instr);
+
+const JitFunction instr_table[64] = {
+    &JitShaderSoA::Compile_ADD,    // add
+    &JitShaderSoA::Compile_DP3,    // dp3
+    &JitShaderSoA::Compile_DP4,    // dp4
+    &JitShaderSoA::Compile_DPH,    // dph
+    nullptr,                       // unknown
+    &JitShaderSoA::Compile_EX2,    // ex2
+    &JitShaderSoA::Compile_LG2,    // lg2
+    nullptr,                       // unknown
+    &JitShaderSoA::Compile_MUL,    // mul
+    &JitShaderSoA::Compile_SGE,    // sge
+    &JitShaderSoA::Compile_SLT,    // slt
+    &JitShaderSoA::Compile_FLR,    // flr
+    &JitShaderSoA::Compile_MAX,    // max
+    &JitShaderSoA::Compile_MIN,    // min
+    &JitShaderSoA::Compile_RCP,    // rcp
+    &JitShaderSoA::Compile_RSQ,    // rsq
+    nullptr,                       // unknown
+    nullptr,                       // unknown
+    &JitShaderSoA::Compile_MOVA,   // mova
+    &JitShaderSoA::Compile_MOV,    // mov
+    nullptr,                       // unknown
+    nullptr,                       // unknown
+    nullptr,                       // unknown
+    nullptr,                       // unknown
+    &JitShaderSoA::Compile_DPH,    // dphi
+    nullptr,                       // unknown
+    &JitShaderSoA::Compile_SGE,    // sgei
+    &JitShaderSoA::Compile_SLT,    // slti
+    nullptr,                       // unknown
+    nullptr,                       // unknown
+    nullptr,                       // unknown
+    nullptr,                       // unknown
+    nullptr,                       // unknown
+    &JitShaderSoA::Compile_NOP,    // nop
+    &JitShaderSoA::Compile_END,    // end
+    &JitShaderSoA::Compile_BREAKC, // breakc
+    &JitShaderSoA::Compile_CALL,   // call
+    &JitShaderSoA::Compile_CALLC,  // callc
+    &JitShaderSoA::Compile_CALLU,  // callu
+    &JitShaderSoA::Compile_IF,     // ifu
+    &JitShaderSoA::Compile_IF,     // ifc
+    &JitShaderSoA::Compile_LOOP,   // loop
+    &JitShaderSoA::Compile_EMIT,   // emit
+    &JitShaderSoA::Compile_SETE,   // sete
+    &JitShaderSoA::Compile_JMP,    // jmpc
+    &JitShaderSoA::Compile_JMP,    // jmpu
+    &JitShaderSoA::Compile_CMP,    // cmp
+    &JitShaderSoA::Compile_CMP,    // cmp
+    &JitShaderSoA::Compile_MAD,    // madi
+    &JitShaderSoA::Compile_MAD,    // madi
+    &JitShaderSoA::Compile_MAD,    // madi
+    &JitShaderSoA::Compile_MAD,    // madi
+    &JitShaderSoA::Compile_MAD,    // madi
+    &JitShaderSoA::Compile_MAD,    // madi
+    &JitShaderSoA::Compile_MAD,    // madi
+    &JitShaderSoA::Compile_MAD,    // madi
+    &JitShaderSoA::Compile_MAD,    // mad
+    &JitShaderSoA::Compile_MAD,    // mad
+    &JitShaderSoA::Compile_MAD,    // mad
+    &JitShaderSoA::Compile_MAD,    // mad
+    &JitShaderSoA::Compile_MAD,    // mad
+    &JitShaderSoA::Compile_MAD,    // mad
+    &JitShaderSoA::Compile_MAD,    // mad
+    &JitShaderSoA::Compile_MAD,    // mad
+};
+
+// The following is used to alias some commonly used registers. Generally, RAX-RDX and YMM0-YMM10
+// can be used as scratch registers within a compiler function. The other registers have designated
+// purposes, as documented below:
+
+/// Pointer to the uniform memory
+constexpr Reg64 UNIFORMS = r9;
+/// VS loop count register
+constexpr Reg32 LOOPCOUNT_REG = r12d;
+/// Current VS loop iteration number (we could probably use LOOPCOUNT_REG, but this quicker)
+constexpr Reg32 LOOPCOUNT = esi;
+/// Number to increment LOOPCOUNT_REG by on each loop iteration
+constexpr Reg32 LOOPINC = edi;
+/// Pointer to the ShaderUnitSoA instance
+constexpr Reg64 STATE = r15;
+/// Result of the instruction for the X-component, or for all components of scalar results. The
+/// results of the Y, Z and W components are in YMM1-YMM3.
+constexpr Ymm RESULT = ymm0;
+/// Loaded with a component of the first swizzled source register
+constexpr Ymm SRC1 = ymm4;
+/// Loaded with a component of the second swizzled source register
+constexpr Ymm SRC2 = ymm5;
+/// Loaded with a component of the third swizzled source register
+constexpr Ymm SRC3 = ymm6;
+/// SIMD scratch registers
+constexpr Ymm SCRATCH = ymm7;
+constexpr Ymm SCRATCH2 = ymm8;
+constexpr Ymm SCRATCH3 = ymm9;
+constexpr Ymm SCRATCH4 = ymm10;
+/// Mask of the lanes that are currently executing
+constexpr Ymm EXEC = ymm11;
+/// Per-lane uniform offset of the relatively addressed source of the current instruction
+constexpr Ymm REL_INDEX = ymm12;
+/// Per-lane mask of the lanes whose relatively addressed uniform is in range
+constexpr Ymm REL_VALID = ymm13;
+/// Constant vector of 1.0f in every lane, used to efficiently set a vector to one
+constexpr Ymm ONE = ymm14;
+/// Constant vector of -0.f in every lane, used to efficiently negate a vector with XOR
+constexpr Ymm NEGBIT = ymm15;
+
+/// Lane mask with all lanes executing, as returned by VMOVMSKPS
+constexpr u32 ALL_LANES = (1U << SOA_LANES) - 1;
+
+/// Maximum number of bytes emitted for a single Pica instruction
+constexpr std::size_t MAX_INSTRUCTION_SIZE = 2048;
+/// Bytes reserved for each instruction that is no longer compiled once the code buffer is full
+constexpr std::size_t BAIL_INSTRUCTION_SIZE = 32;
+
+/// Number of times a shader may bail out before its vertices are always run by the scalar shader
+constexpr u32 MAX_FALLBACKS = 64;
+
+bool JitShaderSoA::IsSupported() {
+    return host_caps.has(Cpu::tAVX2 | Cpu::tFMA);
+}
+
+SwizzlePattern JitShaderSoA::GetSwizzlePattern(Instruction instr) const {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        return {(*swizzle_data)[instr.mad.operand_desc_id]};
+    }
+    return {(*swizzle_data)[instr.common.operand_desc_id]};
+}
+
+const void* JitShaderSoA::Compile_VectorConstant(u32 value) {
+    const void* address = getCurr();
+    for (std::size_t lane = 0; lane < SOA_LANES; ++lane) {
+        dd(value);
+    }
+    return address;
+}
+
+void JitShaderSoA::Compile_RelativeIndex(u32 address_register_index, u32 base_index) {
+    // s32 offset = address_reg >= -128 && address_reg <= 127 ? address_reg : 0;
+    // u32 index = (base_index + offset) & 0x7f;
+    if (address_register_index == 3) {
+        // The loop register is the same for all lanes, so the index is computed once in RBX,
+        // multiplied by the size of a uniform.
+        lea(eax, ptr[LOOPCOUNT_REG.cvt64() + 128]);
+        mov(ebx, base_index);
+        mov(ecx, LOOPCOUNT_REG);
+        add(ecx, ebx);
+        cmp(eax, 256);
+        cmovb(ebx, ecx);
+        and_(ebx, 0x7f);
+        shl(ebx, 4);
+        return;
+    }
+
+    const std::size_t offset = ShaderUnitSoA::AddressRegisterOffset(address_register_index - 1);
+    vmovdqa(REL_INDEX, yword[STATE + offset]);
+    vpcmpgtd(SCRATCH, REL_INDEX, yword[rip + relative_min_constant]);
+    vmovdqa(SCRATCH2, yword[rip + relative_max_constant]);
+    vpcmpgtd(SCRATCH2, SCRATCH2, REL_INDEX);
+    vpand(SCRATCH, SCRATCH, SCRATCH2);
+    vpand(REL_INDEX, REL_INDEX, SCRATCH);
+
+    mov(eax, base_index);
+    vmovd(Xmm(SCRATCH.getIdx()), eax);
+    vpbroadcastd(SCRATCH, Xmm(SCRATCH.getIdx()));
+    vpaddd(REL_INDEX, REL_INDEX, SCRATCH);
+    vpand(REL_INDEX, REL_INDEX, yword[rip + index_mask_constant]);
+
+    // index > 95 ? vec4(1.0) : uniforms.f[index];
+    vmovdqa(REL_VALID, yword[rip + uniform_count_constant]);
+    vpcmpgtd(REL_VALID, REL_VALID, REL_INDEX);
+    vpslld(REL_INDEX, REL_INDEX, 4);
+}
+
+/**
+ * Loads and swizzles one component of a source register into the specified YMM register.
+ * @param instr VS instruction, used for determining how to load the source register
+ * @param src_num Number indicating which source register to load (1 = src1, 2 = src2, 3 = src3)
+ * @param src_reg SourceRegister object corresponding to the source register to load
+ * @param component Destination component, selects the source component through the swizzle
+ * @param dest Destination YMM register to store the loaded, swizzled source component
+ */
+void JitShaderSoA::Compile_SwizzleSrc(Instruction instr, u32 src_num, SourceRegister src_reg,
+                                      u32 component, Ymm dest) {
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+    u32 address_register_index;
+    u32 offset_src;
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        offset_src = is_inverted ? 3 : 2;
+        address_register_index = instr.mad.address_register_index;
+    } else {
+        offset_src = is_inverted ? 2 : 1;
+        address_register_index = instr.common.address_register_index;
+    }
+
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    const u32 src_component = (swiz.GetRawSelector(src_num) >> (6 - 2 * component)) & 3;
+
+    switch (src_reg.GetRegisterType()) {
+    case RegisterType::FloatUniform: {
+        const int disp = static_cast<int>(offsetof(Uniforms, f) + src_component * sizeof(f24));
+        if (src_num == offset_src && address_register_index != 0) {
+            if (!relative_index_loaded) {
+                Compile_RelativeIndex(address_register_index, src_reg.GetIndex());
+                relative_index_loaded = true;
+            }
+
+            vmovaps(dest, ONE);
+            if (address_register_index == 3) {
+                Label load_end;
+                cmp(ebx, 95 << 4);
+                jg(load_end);
+                vbroadcastss(dest, dword[UNIFORMS + rbx + disp]);
+                L(load_end);
+            } else {
+                // The gather clears its mask, so it has to operate on a copy
+                vmovaps(SCRATCH, REL_VALID);
+                vgatherdps(dest, ptr[UNIFORMS + REL_INDEX + disp], SCRATCH);
+            }
+        } else {
+            const std::size_t offset = Uniforms::GetFloatUniformOffset(src_reg.GetIndex());
+            vbroadcastss(dest, dword[UNIFORMS + offset + src_component * sizeof(f24)]);
+        }
+        break;
+    }
+    case RegisterType::Input:
+        vmovaps(dest, yword[STATE + ShaderUnitSoA::InputOffset(src_reg.GetIndex(), src_component)]);
+        break;
+    case RegisterType::Temporary:
+        vmovaps(dest,
+                yword[STATE + ShaderUnitSoA::TemporaryOffset(src_reg.GetIndex(), src_component)]);
+        break;
+    default:
+        UNREACHABLE_MSG("Encountered unknown source register type: {}", src_reg.GetRegisterType());
+        break;
+    }
+
+    // If the source register should be negated, flip the negative bit using XOR
+    const bool negate[] = {swiz.negate_src1, swiz.negate_src2, swiz.negate_src3};
+    if (negate[src_num - 1]) {
+        vxorps(dest, dest, NEGBIT);
+    }
+}
+
+void JitShaderSoA::Compile_DestEnable(Instruction instr, bool scalar_result) {
+    DestRegister dest;
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        dest = instr.mad.dest.Value();
+    } else {
+        dest = instr.common.dest.Value();
+    }
+
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (!swiz.DestComponentEnabled(component)) {
+            continue;
+        }
+
+        std::size_t dest_offset;
+        switch (dest.GetRegisterType()) {
+        case RegisterType::Output:
+            dest_offset = ShaderUnitSoA::OutputOffset(dest.GetIndex(), component);
+            break;
+        case RegisterType::Temporary:
+            dest_offset = ShaderUnitSoA::TemporaryOffset(dest.GetIndex(), component);
+            break;
+        default:
+            UNREACHABLE_MSG("Encountered unknown destination register type: {}",
+                            dest.GetRegisterType());
+            break;
+        }
+
+        Compile_MaskedStore(dest_offset, scalar_result ? RESULT : Ymm(component));
+    }
+}
+
+void JitShaderSoA::Compile_MaskedStore(std::size_t offset, Ymm value) {
+    if (!NeedsMask()) {
+        vmovaps(yword[STATE + offset], value);
+        return;
+    }
+
+    vmovaps(SCRATCH, yword[STATE + offset]);
+    vblendvps(SCRATCH, SCRATCH, value, EXEC);
+    vmovaps(yword[STATE + offset], SCRATCH);
+}
+
+void JitShaderSoA::Compile_SanitizedMul(Ymm dest, Ymm src1, Ymm src2, Ymm scratch) {
+    // 0 * inf and inf * 0 in the PICA should return 0 instead of NaN. This can be implemented by
+    // checking for NaNs before and after the multiplication.  If the multiplication result is NaN
+    // where neither source was, this NaN was generated by a 0 * inf multiplication, and so the
+    // result should be transformed to 0 to match PICA fp rules.
+
+    // Set scratch to mask of (src1 != NaN and src2 != NaN)
+    vcmpordps(scratch, src1, src2);
+
+    vmulps(dest, src1, src2);
+
+    // Set src2 to mask of (result == NaN)
+    vcmpunordps(src2, dest, dest);
+
+    // Clear lanes where scratch != src2 (i.e. if result is NaN where neither source was NaN)
+    vxorps(scratch, scratch, src2);
+    vandps(dest, dest, scratch);
+}
+
+void JitShaderSoA::Compile_EvaluateCondition(Instruction instr, Ymm dest) {
+    // Loads a conditional code, inverted when it is compared against false
+    const auto load_condition = [this](u32 index, u32 reference, Ymm reg) {
+        vmovaps(reg, yword[STATE + ShaderUnitSoA::ConditionalCodeOffset(index)]);
+        if (reference == 0) {
+            vpcmpeqd(SCRATCH4, SCRATCH4, SCRATCH4);
+            vxorps(reg, reg, SCRATCH4);
+        }
+    };
+
+    switch (instr.flow_control.op) {
+    case Instruction::FlowControlType::Or:
+        load_condition(0, instr.flow_control.refx.Value(), dest);
+        load_condition(1, instr.flow_control.refy.Value(), SCRATCH2);
+        vorps(dest, dest, SCRATCH2);
+        break;
+
+    case Instruction::FlowControlType::And:
+        load_condition(0, instr.flow_control.refx.Value(), dest);
+        load_condition(1, instr.flow_control.refy.Value(), SCRATCH2);
+        vandps(dest, dest, SCRATCH2);
+        break;
+
+    case Instruction::FlowControlType::JustX:
+        load_condition(0, instr.flow_control.refx.Value(), dest);
+        break;
+
+    case Instruction::FlowControlType::JustY:
+        load_condition(1, instr.flow_control.refy.Value(), dest);
+        break;
+    }
+}
+
+void JitShaderSoA::Compile_UniformCondition(Instruction instr) {
+    std::size_t offset = Uniforms::GetBoolUniformOffset(instr.flow_control.bool_uniform_id);
+    cmp(byte[UNIFORMS + offset], 0);
+}
+
+void JitShaderSoA::Compile_RequireAllLanes() {
+    if (!NeedsMask()) {
+        return;
+    }
+    vmovmskps(eax, EXEC);
+    cmp(eax, ALL_LANES);
+    jne(bail_label, T_NEAR);
+}
+
+bool JitShaderSoA::NeedsMask() const {
+    return mask_depth > 0 || subroutine_code[program_counter - 1];
+}
+
+void JitShaderSoA::Compile_ADD(Instruction instr) {
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+            Compile_SwizzleSrc(instr, 2, instr.common.src2, component, SRC2);
+            vaddps(Ymm(component), SRC1, SRC2);
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_DP3(Instruction instr) {
+    for (u32 component = 0; component < 3; ++component) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, component, SRC2);
+        Compile_SanitizedMul(Ymm(component), SRC1, SRC2, SCRATCH);
+    }
+
+    vaddps(RESULT, RESULT, ymm1);
+    vaddps(RESULT, RESULT, ymm2);
+
+    Compile_DestEnable(instr, true);
+}
+
+void JitShaderSoA::Compile_DP4(Instruction instr) {
+    for (u32 component = 0; component < 4; ++component) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, component, SRC2);
+        Compile_SanitizedMul(Ymm(component), SRC1, SRC2, SCRATCH);
+    }
+
+    // Sum in the same order as the HADDPS sequence of the scalar JIT
+    vaddps(RESULT, RESULT, ymm1);
+    vaddps(ymm2, ymm2, ymm3);
+    vaddps(RESULT, RESULT, ymm2);
+
+    Compile_DestEnable(instr, true);
+}
+
+void JitShaderSoA::Compile_DPH(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI;
+    const SourceRegister src1 = is_inverted ? instr.common.src1i : instr.common.src1;
+    const SourceRegister src2 = is_inverted ? instr.common.src2i : instr.common.src2;
+
+    for (u32 component = 0; component < 4; ++component) {
+        if (component == 3) {
+            // The 4th component of the first source is replaced with 1.0
+            vmovaps(SRC1, ONE);
+        } else {
+            Compile_SwizzleSrc(instr, 1, src1, component, SRC1);
+        }
+        Compile_SwizzleSrc(instr, 2, src2, component, SRC2);
+        Compile_SanitizedMul(Ymm(component), SRC1, SRC2, SCRATCH);
+    }
+
+    vaddps(RESULT, RESULT, ymm1);
+    vaddps(ymm2, ymm2, ymm3);
+    vaddps(RESULT, RESULT, ymm2);
+
+    Compile_DestEnable(instr, true);
+}
+
+void JitShaderSoA::Compile_EX2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+    call(exp2_subroutine);
+    vmovaps(RESULT, SRC1);
+    Compile_DestEnable(instr, true);
+}
+
+void JitShaderSoA::Compile_LG2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+    call(log2_subroutine);
+    vmovaps(RESULT, SRC1);
+    Compile_DestEnable(instr, true);
+}
+
+void JitShaderSoA::Compile_MUL(Instruction instr) {
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+            Compile_SwizzleSrc(instr, 2, instr.common.src2, component, SRC2);
+            Compile_SanitizedMul(Ymm(component), SRC1, SRC2, SCRATCH);
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_SGE(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI;
+    const SourceRegister src1 = is_inverted ? instr.common.src1i : instr.common.src1;
+    const SourceRegister src2 = is_inverted ? instr.common.src2i : instr.common.src2;
+
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, src1, component, SRC1);
+            Compile_SwizzleSrc(instr, 2, src2, component, SRC2);
+            vcmpleps(SCRATCH, SRC2, SRC1);
+            vandps(Ymm(component), SCRATCH, ONE);
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_SLT(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI;
+    const SourceRegister src1 = is_inverted ? instr.common.src1i : instr.common.src1;
+    const SourceRegister src2 = is_inverted ? instr.common.src2i : instr.common.src2;
+
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, src1, component, SRC1);
+            Compile_SwizzleSrc(instr, 2, src2, component, SRC2);
+            vcmpltps(SCRATCH, SRC1, SRC2);
+            vandps(Ymm(component), SCRATCH, ONE);
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_FLR(Instruction instr) {
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+            vroundps(Ymm(component), SRC1, _MM_FROUND_FLOOR);
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_MAX(Instruction instr) {
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+            Compile_SwizzleSrc(instr, 2, instr.common.src2, component, SRC2);
+            // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+            vmaxps(Ymm(component), SRC1, SRC2);
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_MIN(Instruction instr) {
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+            Compile_SwizzleSrc(instr, 2, instr.common.src2, component, SRC2);
+            // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+            vminps(Ymm(component), SRC1, SRC2);
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_MOVA(Instruction instr) {
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+
+    // Convert floats to integers using truncation (only care about X and Y components)
+    for (u32 component = 0; component < 2; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+            vcvttps2dq(SRC1, SRC1);
+            Compile_MaskedStore(ShaderUnitSoA::AddressRegisterOffset(component), SRC1);
+        }
+    }
+}
+
+void JitShaderSoA::Compile_MOV(Instruction instr) {
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, instr.common.src1, component, Ymm(component));
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_RCP(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+
+    if (host_caps.has(Cpu::tAVX512F | Cpu::tAVX512VL)) {
+        // Accurate to 14 bits of precisions rather than 12 bits of rcpps
+        vrcp14ps(RESULT, SRC1);
+    } else {
+        vrcpps(RESULT, SRC1);
+    }
+
+    Compile_DestEnable(instr, true);
+}
+
+void JitShaderSoA::Compile_RSQ(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0, SRC1);
+
+    if (host_caps.has(Cpu::tAVX512F | Cpu::tAVX512VL)) {
+        // Accurate to 14 bits of precisions rather than 12 bits of rsqrtps
+        vrsqrt14ps(RESULT, SRC1);
+    } else {
+        vrsqrtps(RESULT, SRC1);
+    }
+
+    Compile_DestEnable(instr, true);
+}
+
+void JitShaderSoA::Compile_NOP(Instruction instr) {}
+
+void JitShaderSoA::Compile_END(Instruction instr) {
+    // Lanes cannot end separately, the scalar shader has to handle an END reached by some of them
+    Compile_RequireAllLanes();
+
+    mov(dword[STATE + offsetof(ShaderUnitSoA, loop_register)], LOOPCOUNT_REG);
+    xor_(eax, eax);
+    jmp(exit_label, T_NEAR);
+}
+
+void JitShaderSoA::Compile_BREAKC(Instruction instr) {
+    if (!loop_depth) {
+        // BREAKC must be inside a LOOP
+        jmp(bail_label, T_NEAR);
+        return;
+    }
+
+    Label no_break;
+    Compile_EvaluateCondition(instr, SCRATCH3);
+    vandps(SCRATCH3, SCRATCH3, EXEC);
+    vmovmskps(eax, SCRATCH3);
+    test(eax, eax);
+    jz(no_break, T_NEAR);
+
+    if (mask_depth != loop_mask_depths.back()) {
+        // Breaking out of a divergent IF block would skip restoring the lane mask
+        jmp(bail_label, T_NEAR);
+    } else {
+        // The loop can only be left if all executing lanes break out of it
+        vmovmskps(ecx, EXEC);
+        cmp(eax, ecx);
+        jne(bail_label, T_NEAR);
+        jmp(loop_break_labels.back(), T_NEAR);
+    }
+
+    L(no_break);
+}
+
+void JitShaderSoA::Compile_CALL(Instruction instr) {
+    // Push offset of the return
+    push(qword, (instr.flow_control.dest_offset + instr.flow_control.num_instructions));
+
+    // Call the subroutine
+    call(instruction_labels[instr.flow_control.dest_offset]);
+
+    // Skip over the return offset that's on the stack
+    add(rsp, 8);
+}
+
+void JitShaderSoA::Compile_CALLC(Instruction instr) {
+    Label b;
+    Compile_EvaluateCondition(instr, SCRATCH3);
+    vandps(SCRATCH3, SCRATCH3, EXEC);
+    vmovmskps(eax, SCRATCH3);
+    test(eax, eax);
+    jz(b, T_NEAR);
+
+    // Call the subroutine with only the lanes that passed the condition executing
+    sub(rsp, 32);
+    vmovups(yword[rsp], EXEC);
+    vmovaps(EXEC, SCRATCH3);
+    Compile_CALL(instr);
+    vmovups(EXEC, yword[rsp]);
+    add(rsp, 32);
+
+    L(b);
+}
+
+void JitShaderSoA::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    Label b;
+    jz(b);
+    Compile_CALL(instr);
+    L(b);
+}
+
+void JitShaderSoA::Compile_CMP(Instruction instr) {
+    using Op = Instruction::Common::CompareOpType::Op;
+    const Op ops[] = {instr.common.compare_op.x, instr.common.compare_op.y};
+
+    // AVX doesn't have greater-than (GT) or greater-equal (GE) comparison operators. You need to
+    // emulate them by swapping the lhs and rhs and using LT and LE. NLT and NLE can't be used here
+    // because they don't match when used with NaNs.
+    static const u8 cmp[] = {CMP_EQ, CMP_NEQ, CMP_LT, CMP_LE, CMP_LT, CMP_LE};
+
+    for (u32 component = 0; component < 2; ++component) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, component, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, component, SRC2);
+
+        const Op op = ops[component];
+        const bool invert_op = (op == Op::GreaterThan || op == Op::GreaterEqual);
+        vcmpps(Ymm(component), invert_op ? SRC2 : SRC1, invert_op ? SRC1 : SRC2, cmp[op]);
+    }
+
+    Compile_MaskedStore(ShaderUnitSoA::ConditionalCodeOffset(0), ymm0);
+    Compile_MaskedStore(ShaderUnitSoA::ConditionalCodeOffset(1), ymm1);
+}
+
+void JitShaderSoA::Compile_MAD(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+    const SourceRegister src2 = is_inverted ? instr.mad.src2i : instr.mad.src2;
+    const SourceRegister src3 = is_inverted ? instr.mad.src3i : instr.mad.src3;
+
+    const SwizzlePattern swiz = GetSwizzlePattern(instr);
+    for (u32 component = 0; component < 4; ++component) {
+        if (swiz.DestComponentEnabled(component)) {
+            Compile_SwizzleSrc(instr, 1, instr.mad.src1, component, SRC1);
+            Compile_SwizzleSrc(instr, 2, src2, component, SRC2);
+            Compile_SwizzleSrc(instr, 3, src3, component, SRC3);
+            Compile_SanitizedMul(Ymm(component), SRC1, SRC2, SCRATCH);
+            vaddps(Ymm(component), Ymm(component), SRC3);
+        }
+    }
+    Compile_DestEnable(instr);
+}
+
+void JitShaderSoA::Compile_IF(Instruction instr) {
+    if (instr.flow_control.dest_offset < program_counter) {
+        // Backwards if-statements are not supported
+        jmp(bail_label, T_NEAR);
+        return;
+    }
+
+    Label l_else, l_endif;
+
+    if (instr.opcode.Value() == OpCode::Id::IFU) {
+        // The condition is the same for all lanes, so this is a plain branch
+        Compile_UniformCondition(instr);
+        jz(l_else, T_NEAR);
+
+        Compile_Block(instr.flow_control.dest_offset);
+
+        if (instr.flow_control.num_instructions == 0) {
+            L(l_else);
+            return;
+        }
+
+        jmp(l_endif, T_NEAR);
+
+        L(l_else);
+        Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+        L(l_endif);
+        return;
+    }
+
+    // Lanes may disagree on the condition, so both blocks are run with the lanes that don't take
+    // them masked off. A block is skipped entirely when none of the lanes take it. The enclosing
+    // lane mask and the mask of the ELSE block are kept on the stack.
+    Compile_EvaluateCondition(instr, SCRATCH3);
+    vandps(SCRATCH3, SCRATCH3, EXEC);
+    vandnps(SCRATCH4, SCRATCH3, EXEC);
+    sub(rsp, 64);
+    vmovups(yword[rsp], EXEC);
+    vmovups(yword[rsp + 32], SCRATCH4);
+    vmovaps(EXEC, SCRATCH3);
+    ++mask_depth;
+
+    vmovmskps(eax, EXEC);
+    test(eax, eax);
+    jz(l_else, T_NEAR);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset);
+
+    L(l_else);
+
+    if (instr.flow_control.num_instructions != 0) {
+        // Compile the code that corresponds to the condition evaluating as false
+        vmovups(EXEC, yword[rsp + 32]);
+        vmovmskps(eax, EXEC);
+        test(eax, eax);
+        jz(l_endif, T_NEAR);
+
+        Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+        L(l_endif);
+    }
+
+    --mask_depth;
+    vmovups(EXEC, yword[rsp]);
+    add(rsp, 64);
+}
+
+void JitShaderSoA::Compile_LOOP(Instruction instr) {
+    if (instr.flow_control.dest_offset < program_counter) {
+        // Backwards loops are not supported
+        jmp(bail_label, T_NEAR);
+        return;
+    }
+
+    if (loop_depth++) {
+        const auto loop_save_regs = BuildRegSet({LOOPCOUNT_REG, LOOPINC, LOOPCOUNT});
+        ABI_PushRegistersAndAdjustStack(*this, loop_save_regs, 0);
+    }
+
+    // This decodes the fields from the integer uniform at index instr.flow_control.int_uniform_id.
+    // The loop only depends on uniforms, so all lanes run the same number of iterations.
+    std::size_t offset = Uniforms::GetIntUniformOffset(instr.flow_control.int_uniform_id);
+    mov(LOOPCOUNT, dword[UNIFORMS + offset]);
+    mov(LOOPCOUNT_REG, LOOPCOUNT);
+    shr(LOOPCOUNT_REG, 8);
+    and_(LOOPCOUNT_REG, 0xFF); // Y-component is the start
+    mov(LOOPINC, LOOPCOUNT);
+    shr(LOOPINC, 16);
+    and_(LOOPINC, 0xFF);                // Z-component is the incrementer
+    movzx(LOOPCOUNT, LOOPCOUNT.cvt8()); // X-component is iteration count
+    add(LOOPCOUNT, 1);                  // Iteration count is X-component + 1
+
+    Label l_loop_start;
+    L(l_loop_start);
+
+    loop_break_labels.emplace_back(Xbyak::Label());
+    loop_mask_depths.push_back(mask_depth);
+    Compile_Block(instr.flow_control.dest_offset + 1);
+
+    add(LOOPCOUNT_REG, LOOPINC); // Increment LOOPCOUNT_REG by Z-component
+    sub(LOOPCOUNT, 1);           // Increment loop count by 1
+    jnz(l_loop_start, T_NEAR);   // Loop if not equal
+
+    L(loop_break_labels.back());
+    loop_break_labels.pop_back();
+    loop_mask_depths.pop_back();
+
+    if (--loop_depth) {
+        const auto loop_save_regs = BuildRegSet({LOOPCOUNT_REG, LOOPINC, LOOPCOUNT});
+        ABI_PopRegistersAndAdjustStack(*this, loop_save_regs, 0);
+    }
+}
+
+void JitShaderSoA::Compile_JMP(Instruction instr) {
+    Label b;
+
+    if (instr.opcode.Value() == OpCode::Id::JMPC) {
+        Compile_EvaluateCondition(instr, SCRATCH3);
+        vandps(SCRATCH3, SCRATCH3, EXEC);
+        vmovmskps(eax, SCRATCH3);
+        test(eax, eax);
+        jz(b, T_NEAR);
+
+        // The jump can only be taken if all executing lanes take it
+        vmovmskps(ecx, EXEC);
+        cmp(eax, ecx);
+        jne(bail_label, T_NEAR);
+    } else if (instr.opcode.Value() == OpCode::Id::JMPU) {
+        Compile_UniformCondition(instr);
+
+        const bool inverted_condition = (instr.flow_control.num_instructions & 1) != 0;
+        if (inverted_condition) {
+            jnz(b, T_NEAR);
+        } else {
+            jz(b, T_NEAR);
+        }
+    } else {
+        UNREACHABLE();
+    }
+
+    if (mask_depth > 0) {
+        // Jumping out of a divergent IF block would skip restoring the lane mask
+        jmp(bail_label, T_NEAR);
+    } else {
+        // The target may be executed by all lanes, such as when jumping out of a subroutine
+        Compile_RequireAllLanes();
+        jmp(instruction_labels[instr.flow_control.dest_offset], T_NEAR);
+    }
+
+    L(b);
+}
+
+void JitShaderSoA::Compile_EMIT(Instruction instr) {
+    // Geometry shaders are always run by the scalar shader
+    jmp(bail_label, T_NEAR);
+}
+
+void JitShaderSoA::Compile_SETE(Instruction instr) {
+    // Geometry shaders are always run by the scalar shader
+    jmp(bail_label, T_NEAR);
+}
+
+void JitShaderSoA::Compile_Block(u32 end) {
+    while (program_counter < end) {
+        Compile_NextInstr();
+    }
+}
+
+void JitShaderSoA::Compile_Return() {
+    // Peek return offset on the stack and check if we're at that offset
+    mov(rax, qword[rsp + 8]);
+    cmp(eax, (program_counter));
+
+    // If so, jump back to before CALL
+    Label b;
+    jnz(b);
+    ret();
+    L(b);
+}
+
+void JitShaderSoA::Compile_NextInstr() {
+    if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
+        Compile_Return();
+    }
+
+    L(instruction_labels[program_counter]);
+
+    // Once the code buffer is close to full, the remaining instructions only bail out
+    const std::size_t reserved_size =
+        MAX_INSTRUCTION_SIZE + (MAX_PROGRAM_CODE_LENGTH - program_counter) * BAIL_INSTRUCTION_SIZE;
+    if (getSize() + reserved_size > MAX_SOA_SHADER_SIZE) {
+        ++program_counter;
+        jmp(bail_label, T_NEAR);
+        return;
+    }
+
+    Instruction instr = {(*program_code)[program_counter++]};
+    relative_index_loaded = false;
+
+    OpCode::Id opcode = instr.opcode.Value();
+    auto instr_func = instr_table[static_cast<u32>(opcode)];
+
+    if (instr_func) {
+        // JIT the instruction!
+        ((*this).*instr_func)(instr);
+    } else {
+        // Unhandled instruction, the scalar shader reports it
+        jmp(bail_label, T_NEAR);
+    }
+}
+
+void JitShaderSoA::FindReturnOffsets() {
+    return_offsets.clear();
+    subroutine_code.reset();
+
+    for (std::size_t offset = 0; offset < program_code->size(); ++offset) {
+        Instruction instr = {(*program_code)[offset]};
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU: {
+            const u32 begin = instr.flow_control.dest_offset;
+            const u32 end = begin + instr.flow_control.num_instructions;
+            return_offsets.push_back(end);
+            for (u32 i = begin; i < std::min<u32>(end, MAX_PROGRAM_CODE_LENGTH); ++i) {
+                subroutine_code.set(i);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Sort for efficient binary search later
+    std::sort(return_offsets.begin(), return_offsets.end());
+}
+
+void JitShaderSoA::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
+                           const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+    program_code = program_code_;
+    swizzle_data = swizzle_data_;
+
+    // Reset flow control state
+    program = (CompiledShader*)getCurr();
+    program_counter = 0;
+    loop_depth = 0;
+    mask_depth = 0;
+    instruction_labels.fill(Xbyak::Label());
+
+    // Find all `CALL` instructions and identify return locations
+    FindReturnOffsets();
+
+    // The stack pointer is 8 modulo 16 at the entry of a procedure
+    // We reserve 16 bytes and assign a dummy value to the first 8 bytes, to catch any potential
+    // return checks (see Compile_Return) that happen in shader main routine.
+    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    mov(qword[rsp + 8], 0xFFFFFFFFFFFFFFFFULL);
+
+    mov(UNIFORMS, ABI_PARAM1);
+    mov(STATE, ABI_PARAM2);
+
+    // Remember the stack pointer, so that END and bailing out can leave from within subroutines
+    mov(qword[STATE + offsetof(ShaderUnitSoA, saved_stack_pointer)], rsp);
+
+    // Load loop register
+    mov(LOOPCOUNT_REG, dword[STATE + offsetof(ShaderUnitSoA, loop_register)]);
+
+    vmovaps(ONE, yword[rip + one_constant]);
+    vmovaps(NEGBIT, yword[rip + negbit_constant]);
+
+    // All lanes start out executing, unused lanes of a short batch repeat its last vertex
+    vpcmpeqd(EXEC, EXEC, EXEC);
+
+    // Jump to start of the shader program
+    jmp(ABI_PARAM3);
+
+    // Compile entire program
+    Compile_Block(static_cast<u32>(program_code->size()));
+
+    // Bail out path, returns 1 so that the caller runs the scalar shader instead
+    L(bail_label);
+    mov(eax, 1);
+
+    // Exit path, the return value is in EAX
+    L(exit_label);
+    mov(rsp, qword[STATE + offsetof(ShaderUnitSoA, saved_stack_pointer)]);
+    vzeroupper();
+    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    ret();
+
+    // Free memory that's no longer needed
+    program_code = nullptr;
+    swizzle_data = nullptr;
+    return_offsets.clear();
+    return_offsets.shrink_to_fit();
+
+    ready();
+
+    ASSERT_MSG(getSize() <= MAX_SOA_SHADER_SIZE,
+               "Compiled a shader that exceeds the allocated size!");
+    LOG_DEBUG(HW_GPU, "Compiled SoA shader size={}", getSize());
+}
+
+bool JitShaderSoA::Run(const ShaderSetup& setup, const ShaderRegs& config,
+                       ShaderUnitSoA& soa_state, ShaderUnit& unit,
+                       std::span<const AttributeBuffer> inputs,
+                       std::span<AttributeBuffer> outputs) const {
+    const std::size_t count = inputs.size();
+    ASSERT(count > 0 && count <= SOA_LANES && outputs.size() == count);
+
+    if (fallback_count.load(std::memory_order_relaxed) >= MAX_FALLBACKS) {
+        return false;
+    }
+
+    // Seed every lane with the registers of the shader unit. An isolated program never reads a
+    // register it did not write first, so this only provides the input registers that are not
+    // loaded for each vertex and the registers the program does not touch.
+    const auto broadcast = [](auto& soa_registers, const auto& registers) {
+        for (std::size_t index = 0; index < registers.size(); ++index) {
+            for (std::size_t component = 0; component < 4; ++component) {
+                soa_registers[index][component].fill(registers[index][component]);
+            }
+        }
+    };
+    broadcast(soa_state.input, unit.input);
+    broadcast(soa_state.temporary, unit.temporary);
+    broadcast(soa_state.output, unit.output);
+    for (std::size_t i = 0; i < 2; ++i) {
+        soa_state.conditional_code[i].fill(unit.conditional_code[i] ? 0xFFFFFFFF : 0);
+        soa_state.address_registers[i].fill(unit.address_registers[i]);
+    }
+    soa_state.loop_register = unit.address_registers[2];
+
+    // Transpose the attributes into the input registers. The unused lanes of a short batch repeat
+    // its last vertex, so that they never diverge from the other lanes.
+    const u32 max_attribute = config.max_input_attribute_index;
+    for (u32 attr = 0; attr <= max_attribute; ++attr) {
+        auto& reg = soa_state.input[config.GetRegisterForAttribute(attr)];
+        for (std::size_t lane = 0; lane < SOA_LANES; ++lane) {
+            const auto& value = inputs[std::min(lane, count - 1)][attr];
+            for (std::size_t component = 0; component < 4; ++component) {
+                reg[component][lane] = value[component];
+            }
+        }
+    }
+
+    const auto entry = instruction_labels[setup.entry_point].getAddress();
+    if (program(&setup.uniforms, &soa_state, entry) != 0) {
+        fallback_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    u32 output_index{};
+    for (u32 reg : Common::BitSet<u32>(config.output_mask)) {
+        const auto& value = soa_state.output[reg];
+        for (std::size_t lane = 0; lane < count; ++lane) {
+            auto& output = outputs[lane][output_index];
+            for (std::size_t component = 0; component < 4; ++component) {
+                output[component] = value[component][lane];
+            }
+        }
+        ++output_index;
+    }
+
+    // An isolated program writes the same registers for every vertex, so the last lane holds
+    // what the scalar shader would leave in the unit after running the vertices in order.
+    const std::size_t last = count - 1;
+    const auto extract = [last](auto& registers, const auto& soa_registers) {
+        for (std::size_t index = 0; index < registers.size(); ++index) {
+            for (std::size_t component = 0; component < 4; ++component) {
+                registers[index][component] = soa_registers[index][component][last];
+            }
+        }
+    };
+    extract(unit.input, soa_state.input);
+    extract(unit.temporary, soa_state.temporary);
+    extract(unit.output, soa_state.output);
+    for (std::size_t i = 0; i < 2; ++i) {
+        unit.conditional_code[i] = soa_state.conditional_code[i][last] != 0;
+        unit.address_registers[i] = soa_state.address_registers[i][last];
+    }
+    unit.address_registers[2] = soa_state.loop_register;
+    return true;
+}
+
+JitShaderSoA::JitShaderSoA() : Xbyak::CodeGenerator(MAX_SOA_SHADER_SIZE) {
+    CompilePrelude();
+}
+
+void JitShaderSoA::CompilePrelude() {
+    align(32);
+    one_constant = Compile_VectorConstant(0x3f800000);
+    negbit_constant = Compile_VectorConstant(0x80000000);
+    relative_min_constant = Compile_VectorConstant(static_cast<u32>(-129));
+    relative_max_constant = Compile_VectorConstant(128);
+    index_mask_constant = Compile_VectorConstant(0x7f);
+    uniform_count_constant = Compile_VectorConstant(96);
+
+    log2_subroutine = CompilePrelude_Log2();
+    exp2_subroutine = CompilePrelude_Exp2();
+}
+
+Xbyak::Label JitShaderSoA::CompilePrelude_Log2() {
+    Xbyak::Label subroutine;
+
+    // AVX does not have a log instruction, thus we must approximate. This is the same
+    // approximation as the one of the scalar JIT, see JitShader::CompilePrelude_Log2, evaluated
+    // for all lanes at once and taking the same AVX-512 path so that results are bit-identical.
+    // The edge cases are then patched in with blends.
+
+    // Coefficients for the minimax polynomial.
+    // f(x) computes approximately log2(x) / (x - 1).
+    // f(x) = c4 + x * (c3 + x * (c2 + x * (c1 + x * c0)).
+    align(32);
+    const void* c0 = Compile_VectorConstant(0x3d74552f);
+    const void* c1 = Compile_VectorConstant(0xbeee7397);
+    const void* c2 = Compile_VectorConstant(0x3fbd96dd);
+    const void* c3 = Compile_VectorConstant(0xc02153f6);
+    const void* c4 = Compile_VectorConstant(0x4038d96c);
+    const void* exponent_bias = Compile_VectorConstant(0x7f);
+    const void* mantissa_mask = Compile_VectorConstant(0x007fffff);
+    const void* negative_infinity_vector = Compile_VectorConstant(0xff800000);
+    const void* default_qnan_vector = Compile_VectorConstant(0x7fc00000);
+
+    align(16);
+    L(subroutine);
+
+    // Split input: SCRATCH2=MANT[1,2) SCRATCH=Exponent
+    if (host_caps.has(Cpu::tAVX512F | Cpu::tAVX512VL)) {
+        vgetexpps(SCRATCH, SRC1);
+        vgetmantps(SCRATCH2, SRC1, 0x0'0);
+    } else {
+        vpsrld(SCRATCH, SRC1, 23);
+        vpsubd(SCRATCH, SCRATCH, yword[rip + exponent_bias]);
+        vcvtdq2ps(SCRATCH, SCRATCH);
+        vpand(SCRATCH2, SRC1, yword[rip + mantissa_mask]);
+        vpor(SCRATCH2, SCRATCH2, ONE);
+    }
+
+    // Complete computation of polynomial
+    vmovaps(SCRATCH3, yword[rip + c0]);
+    vfmadd213ps(SCRATCH3, SCRATCH2, yword[rip + c1]);
+    vfmadd213ps(SCRATCH3, SCRATCH2, yword[rip + c2]);
+    vfmadd213ps(SCRATCH3, SCRATCH2, yword[rip + c3]);
+    vfmadd213ps(SCRATCH3, SCRATCH2, yword[rip + c4]);
+    vsubps(SCRATCH2, SCRATCH2, ONE);
+    vfmadd231ps(SCRATCH, SCRATCH3, SCRATCH2);
+
+    // Here we handle edge cases: input in {NaN, 0, -Inf, Negative}.
+    vxorps(SCRATCH2, SCRATCH2, SCRATCH2);
+    vcmpleps(SCRATCH3, SRC1, SCRATCH2);
+    vblendvps(SCRATCH, SCRATCH, yword[rip + default_qnan_vector], SCRATCH3);
+    vcmpeqps(SCRATCH3, SRC1, SCRATCH2);
+    vblendvps(SCRATCH, SCRATCH, yword[rip + negative_infinity_vector], SCRATCH3);
+    vcmpunordps(SCRATCH3, SRC1, SRC1);
+    vblendvps(SRC1, SCRATCH, SRC1, SCRATCH3);
+
+    ret();
+
+    return subroutine;
+}
+
+Xbyak::Label JitShaderSoA::CompilePrelude_Exp2() {
+    Xbyak::Label subroutine;
+
+    // AVX does not have a exp instruction, thus we must approximate. This is the same
+    // approximation as the one of the scalar JIT, see JitShader::CompilePrelude_Exp2, evaluated
+    // for all lanes at once and taking the same AVX-512 path so that results are bit-identical.
+    // NaN inputs are then patched in with a blend.
+
+    align(32);
+    const void* input_max = Compile_VectorConstant(0x43010000);
+    const void* input_min = Compile_VectorConstant(0xc2fdffff);
+    const void* c0 = Compile_VectorConstant(0x3c5dbe69);
+    const void* half = Compile_VectorConstant(0x3f000000);
+    const void* c1 = Compile_VectorConstant(0x3d5509f9);
+    const void* c2 = Compile_VectorConstant(0x3e773cc5);
+    const void* c3 = Compile_VectorConstant(0x3f3168b3);
+    const void* c4 = Compile_VectorConstant(0x3f800016);
+    const void* exponent_bias = Compile_VectorConstant(0x7f);
+
+    align(16);
+    L(subroutine);
+
+    // Decompose input:
+    // SCRATCH3=2^round(input)
+    // SCRATCH=input-round(input) [-0.5, 0.5)
+    if (host_caps.has(Cpu::tAVX512F | Cpu::tAVX512VL)) {
+        vsubps(SCRATCH2, SRC1, yword[rip + half]);
+        vroundps(SCRATCH2, SCRATCH2, _MM_FROUND_TRUNC);
+        vscalefps(SCRATCH3, ONE, SCRATCH2);
+        vsubps(SCRATCH, SRC1, SCRATCH2);
+    } else {
+        // Clamp to maximum range since we shift the value directly into the exponent.
+        vminps(SCRATCH, SRC1, yword[rip + input_max]);
+        vmaxps(SCRATCH, SCRATCH, yword[rip + input_min]);
+
+        vsubps(SCRATCH2, SCRATCH, yword[rip + half]);
+        vroundps(SCRATCH2, SCRATCH2, _MM_FROUND_TRUNC);
+        vcvtps2dq(SCRATCH3, SCRATCH2);
+        vsubps(SCRATCH, SCRATCH, SCRATCH2);
+        vpaddd(SCRATCH3, SCRATCH3, yword[rip + exponent_bias]);
+        vpslld(SCRATCH3, SCRATCH3, 23);
+    }
+
+    // Complete computation of polynomial.
+    vmovaps(SCRATCH2, yword[rip + c0]);
+    vfmadd213ps(SCRATCH2, SCRATCH, yword[rip + c1]);
+    vfmadd213ps(SCRATCH2, SCRATCH, yword[rip + c2]);
+    vfmadd213ps(SCRATCH2, SCRATCH, yword[rip + c3]);
+    vfmadd213ps(SCRATCH, SCRATCH2, yword[rip + c4]);
+    vmulps(SCRATCH, SCRATCH, SCRATCH3);
+
+    // NaN inputs are returned unchanged
+    vcmpunordps(SCRATCH2, SRC1, SRC1);
+    vblendvps(SRC1, SCRATCH, SRC1, SCRATCH2);
+
+    ret();
+
+    return subroutine;
+}
+
+} // namespace Pica::Shader
+
+#endif // CITRA_ARCH(x86_64)
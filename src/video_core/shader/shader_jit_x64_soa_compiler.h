@@ -0,0 +1,255 @@
+// Copyright 2024 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/arch.h"
+#if CITRA_ARCH(x86_64)
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <nihstro/shader_bytecode.h>
+#include <xbyak/xbyak.h>
+#include "common/common_types.h"
+#include "video_core/pica/output_vertex.h"
+#include "video_core/pica/shader_setup.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::SourceRegister;
+using nihstro::SwizzlePattern;
+
+namespace Pica {
+struct ShaderRegs;
+struct ShaderUnit;
+} // namespace Pica
+
+namespace Pica::Shader {
+
+/// Number of vertices processed at once by a SoA shader, one per 32-bit lane of an AVX register
+constexpr std::size_t SOA_LANES = 8;
+
+/// Memory allocated for each compiled SoA shader
+constexpr std::size_t MAX_SOA_SHADER_SIZE = MAX_PROGRAM_CODE_LENGTH * 128;
+
+/**
+ * Shader unit state in structure-of-arrays layout. Each register component holds the value of
+ * that component for all lanes, so a single AVX register covers one component of every vertex.
+ */
+struct ShaderUnitSoA {
+    using Component = std::array<f24, SOA_LANES>;
+    using Register = std::array<Component, 4>;
+
+    static constexpr std::size_t InputOffset(s32 register_index, u32 component) {
+        return offsetof(ShaderUnitSoA, input) + register_index * sizeof(Register) +
+               component * sizeof(Component);
+    }
+
+    static constexpr std::size_t OutputOffset(s32 register_index, u32 component) {
+        return offsetof(ShaderUnitSoA, output) + register_index * sizeof(Register) +
+               component * sizeof(Component);
+    }
+
+    static constexpr std::size_t TemporaryOffset(s32 register_index, u32 component) {
+        return offsetof(ShaderUnitSoA, temporary) + register_index * sizeof(Register) +
+               component * sizeof(Component);
+    }
+
+    static constexpr std::size_t ConditionalCodeOffset(u32 index) {
+        return offsetof(ShaderUnitSoA, conditional_code) + index * sizeof(Component);
+    }
+
+    static constexpr std::size_t AddressRegisterOffset(u32 index) {
+        return offsetof(ShaderUnitSoA, address_registers) + index * sizeof(Component);
+    }
+
+public:
+    alignas(32) std::array<Register, 16> input{};
+    alignas(32) std::array<Register, 16> temporary{};
+    alignas(32) std::array<Register, 16> output{};
+    /// Per-lane result of the last CMP instruction, as all-ones or all-zeros masks
+    alignas(32) std::array<std::array<u32, SOA_LANES>, 2> conditional_code{};
+    /// Per-lane values of the a0 and a1 address registers
+    alignas(32) std::array<std::array<s32, SOA_LANES>, 2> address_registers{};
+    /// The loop register aL, which is the same for all lanes since loops only depend on uniforms
+    s32 loop_register{};
+    /// Stack pointer on entry of the compiled code, used to leave from within subroutines
+    u64 saved_stack_pointer{};
+};
+
+/**
+ * This class implements the SoA mode of the shader JIT compiler. It recompiles a Pica shader
+ * program into x86_64 AVX2 code that runs SOA_LANES vertices at once, one per vector lane.
+ * Divergent conditional code is executed under a lane mask. Control flow that cannot be expressed
+ * that way, such as a conditional jump taken by only some of the lanes, makes the compiled code
+ * bail out so that the vertices can be run by the scalar JitShader instead.
+ */
+class JitShaderSoA : public Xbyak::CodeGenerator {
+public:
+    JitShaderSoA();
+
+    /// Returns whether the host supports the instructions required by SoA shaders
+    static bool IsSupported();
+
+    /**
+     * Runs the shader on up to SOA_LANES vertices.
+     * Every lane starts from the registers of the given shader unit, which receives the registers
+     * of the last lane afterwards. The lanes do not see the registers left by the previous vertex,
+     * so this matches the scalar shader only for programs for which ShaderSetup::IsIsolated holds.
+     * @param soa_state scratch state the compiled code runs on, it is fully overwritten
+     * @returns false if the shader bailed out, in which case the outputs and the shader unit are
+     * left untouched and the vertices have to be run by the scalar shader instead.
+     */
+    bool Run(const ShaderSetup& setup, const ShaderRegs& config, ShaderUnitSoA& soa_state,
+             ShaderUnit& unit, std::span<const AttributeBuffer> inputs,
+             std::span<AttributeBuffer> outputs) const;
+
+    void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
+                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
+
+    void Compile_ADD(Instruction instr);
+    void Compile_DP3(Instruction instr);
+    void Compile_DP4(Instruction instr);
+    void Compile_DPH(Instruction instr);
+    void Compile_EX2(Instruction instr);
+    void Compile_LG2(Instruction instr);
+    void Compile_MUL(Instruction instr);
+    void Compile_SGE(Instruction instr);
+    void Compile_SLT(Instruction instr);
+    void Compile_FLR(Instruction instr);
+    void Compile_MAX(Instruction instr);
+    void Compile_MIN(Instruction instr);
+    void Compile_RCP(Instruction instr);
+    void Compile_RSQ(Instruction instr);
+    void Compile_MOVA(Instruction instr);
+    void Compile_MOV(Instruction instr);
+    void Compile_NOP(Instruction instr);
+    void Compile_END(Instruction instr);
+    void Compile_BREAKC(Instruction instr);
+    void Compile_CALL(Instruction instr);
+    void Compile_CALLC(Instruction instr);
+    void Compile_CALLU(Instruction instr);
+    void Compile_IF(Instruction instr);
+    void Compile_LOOP(Instruction instr);
+    void Compile_JMP(Instruction instr);
+    void Compile_CMP(Instruction instr);
+    void Compile_MAD(Instruction instr);
+    void Compile_EMIT(Instruction instr);
+    void Compile_SETE(Instruction instr);
+
+private:
+    void Compile_Block(u32 end);
+    void Compile_NextInstr();
+
+    SwizzlePattern GetSwizzlePattern(Instruction instr) const;
+
+    /// Emits a vector with `value` in every lane and returns its address
+    const void* Compile_VectorConstant(u32 value);
+
+    /**
+     * Loads one component of a swizzled source register for all lanes.
+     * @param component Destination component the loaded value is used for
+     */
+    void Compile_SwizzleSrc(Instruction instr, u32 src_num, SourceRegister src_reg, u32 component,
+                            Xbyak::Ymm dest);
+
+    /// Emits the per-lane uniform index of a relatively addressed source, see Compile_SwizzleSrc
+    void Compile_RelativeIndex(u32 address_register_index, u32 base_index);
+
+    /**
+     * Stores the results of an instruction to the enabled components of its destination register.
+     * The result of each component is expected in the register with the same index (ymm0-ymm3),
+     * or in ymm0 for all of them if `scalar_result` is set.
+     */
+    void Compile_DestEnable(Instruction instr, bool scalar_result = false);
+
+    /// Stores `value` to the state, only modifying the lanes that are currently executing
+    void Compile_MaskedStore(std::size_t offset, Xbyak::Ymm value);
+
+    /**
+     * Compiles a `MUL src1, src2` operation into `dest`, properly handling the PICA semantics when
+     * multiplying zero by inf. Clobbers `src2` and `scratch`.
+     */
+    void Compile_SanitizedMul(Xbyak::Ymm dest, Xbyak::Ymm src1, Xbyak::Ymm src2,
+                              Xbyak::Ymm scratch);
+
+    /// Evaluates the conditional code test of a flow control instruction into a lane mask
+    void Compile_EvaluateCondition(Instruction instr, Xbyak::Ymm dest);
+    void Compile_UniformCondition(Instruction instr);
+
+    /**
+     * Emits the code to conditionally return from a subroutine envoked by the `CALL` instruction.
+     */
+    void Compile_Return();
+
+    /// Emits a jump to the bail out path if some of the lanes may be masked off
+    void Compile_RequireAllLanes();
+
+    /// Returns whether the instruction being compiled may run with some of the lanes masked off
+    bool NeedsMask() const;
+
+    /**
+     * Analyzes the entire shader program for `CALL` instructions before emitting any code,
+     * identifying the locations where a return needs to be inserted and the subroutine code.
+     */
+    void FindReturnOffsets();
+
+    /**
+     * Emits data and code for utility functions.
+     */
+    void CompilePrelude();
+    Xbyak::Label CompilePrelude_Log2();
+    Xbyak::Label CompilePrelude_Exp2();
+
+    const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code = nullptr;
+    const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data = nullptr;
+
+    /// Mapping of Pica VS instructions to pointers in the emitted code
+    std::array<Xbyak::Label, MAX_PROGRAM_CODE_LENGTH> instruction_labels;
+
+    /// Labels pointing to the end of each nested LOOP block. Used by the BREAKC instruction to
+    /// break out of a loop.
+    std::vector<Xbyak::Label> loop_break_labels;
+
+    /// Masking depth at the start of each nested LOOP block
+    std::vector<u32> loop_mask_depths;
+
+    /// Offsets in code where a return needs to be inserted
+    std::vector<u32> return_offsets;
+
+    /// Instructions that are part of a subroutine, which may be called with some lanes masked off
+    std::bitset<MAX_PROGRAM_CODE_LENGTH> subroutine_code;
+
+    u32 program_counter = 0; ///< Offset of the next instruction to decode
+    u8 loop_depth = 0;       ///< Depth of the (nested) loops currently compiled
+    u32 mask_depth = 0;      ///< Depth of the (nested) divergent IF blocks currently compiled
+    bool relative_index_loaded = false; ///< Relative index of the current instruction is loaded
+
+    Xbyak::Label exit_label;
+    Xbyak::Label bail_label;
+    Xbyak::Label log2_subroutine;
+    Xbyak::Label exp2_subroutine;
+
+    /// Constant vectors emitted by the prelude
+    const void* one_constant = nullptr;
+    const void* negbit_constant = nullptr;
+    const void* relative_min_constant = nullptr;
+    const void* relative_max_constant = nullptr;
+    const void* index_mask_constant = nullptr;
+    const void* uniform_count_constant = nullptr;
+
+    /// Number of times the compiled code bailed out, after too many the scalar shader is used
+    mutable std::atomic<u32> fallback_count{0};
+
+    using CompiledShader = u32(const void* setup, void* state, const u8* start_addr);
+    CompiledShader* program = nullptr;
+};
+
+} // namespace Pica::Shader
+
+#endif // CITRA_ARCH(x86_64)